@@ -75,6 +75,9 @@ oskar_Imager* oskar_settings_to_imager(oskar::SettingsTree* s,
             s->to_int("scale_norm_with_num_input_files", status));
     oskar_imager_set_ms_column(h,
             s->to_string("ms_column", status), status);
+    oskar_imager_set_coords_index(h, s->to_int("use_coords_index", status));
+    oskar_imager_set_memory_budget_gb(h,
+            s->to_double("memory_budget_gb", status));
     oskar_imager_set_output_root(h, s->to_string("root_path", status));
 
     // Set remaining imager options.
@@ -91,12 +94,15 @@ oskar_Imager* oskar_settings_to_imager(oskar::SettingsTree* s,
     oskar_imager_set_freq_max_hz(h, s->to_double("freq_max_hz", status));
     oskar_imager_set_time_min_utc(h, s->to_double("time_min_utc", status));
     oskar_imager_set_time_max_utc(h, s->to_double("time_max_utc", status));
+    oskar_imager_set_time_snapshot_interval_sec(h,
+            s->to_double("time_snapshot_interval_sec", status));
     oskar_imager_set_uv_filter_min(h, s->to_double("uv_filter_min", status));
     oskar_imager_set_uv_filter_max(h, s->to_double("uv_filter_max", status));
     oskar_imager_set_algorithm(h,
             s->to_string("algorithm", status), status);
     oskar_imager_set_weighting(h,
             s->to_string("weighting", status), status);
+    oskar_imager_set_robustness(h, s->to_double("robustness", status));
     if (s->starts_with("algorithm", "FFT", status) ||
             s->starts_with("algorithm", "fft", status))
     {
@@ -104,13 +110,23 @@ oskar_Imager* oskar_settings_to_imager(oskar::SettingsTree* s,
                 s->to_string("fft/kernel_type", status),
                 s->to_int("fft/support", status),
                 s->to_int("fft/oversample", status), status);
+        oskar_imager_set_grid_kernel_accuracy(h,
+                s->to_double("fft/kernel_accuracy", status));
     }
+    if (s->starts_with("algorithm", "NUFFT", status) ||
+            s->starts_with("algorithm", "nufft", status))
+        oskar_imager_set_grid_kernel_accuracy(h,
+                s->to_double("nufft/accuracy", status));
     if (!s->starts_with("wproj/num_w_planes", "auto", status))
         oskar_imager_set_num_w_planes(h,
                 s->to_int("wproj/num_w_planes", status));
     oskar_imager_set_fft_on_gpu(h, s->to_int("fft/use_gpu", status));
+    oskar_imager_set_grid_half_plane(h,
+            s->to_int("fft/half_plane", status));
     oskar_imager_set_generate_w_kernels_on_gpu(h,
             s->to_int("wproj/generate_w_kernels_on_gpu", status));
+    oskar_imager_set_w_kernel_cache_dir(h,
+            s->to_string("wproj/kernel_cache_dir", status));
     if (s->first_letter("direction", status) == 'R')
         oskar_imager_set_direction(h,
                 s->to_double("direction/ra_deg", status),
@@ -27,12 +27,17 @@
  */
 
 #include "apps/oskar_settings_to_interferometer.h"
+#include "convert/oskar_convert_brightness_to_jy.h"
+#include "math/oskar_cmath.h"
 
 #include <cstdlib>
 #include <cstring>
 
 using namespace std;
 
+static void set_up_sky_image(oskar_Interferometer* h, oskar::SettingsTree* s,
+        oskar_Log* log, int* status);
+
 oskar_Interferometer* oskar_settings_to_interferometer(oskar::SettingsTree* s,
         oskar_Log* log, int* status)
 {
@@ -96,12 +101,17 @@ oskar_Interferometer* oskar_settings_to_interferometer(oskar::SettingsTree* s,
             s->to_int("num_channels", status));
     s->end_group();
 
+    // Set up a sky model image to predict using the FFT, if required.
+    set_up_sky_image(h, s, log, status);
+
     // Set interferometer settings.
     s->begin_group("interferometer");
     oskar_interferometer_set_correlation_type(h,
             s->to_string("correlation_type", status), status);
     oskar_interferometer_set_max_times_per_block(h,
             s->to_int("max_time_samples_per_block", status));
+    oskar_interferometer_set_beam_interp_factor(h,
+            s->to_int("station_beam_interp_factor", status));
     oskar_interferometer_set_output_vis_file(h,
             s->to_string("oskar_vis_filename", status));
     oskar_interferometer_set_output_measurement_set(h,
@@ -114,3 +124,62 @@ oskar_Interferometer* oskar_settings_to_interferometer(oskar::SettingsTree* s,
     s->clear_group();
     return h;
 }
+
+static void set_up_sky_image(oskar_Interferometer* h, oskar::SettingsTree* s,
+        oskar_Log* log, int* status)
+{
+    int num_files = 0, size[2];
+    double crval_deg[2], crpix[2], cellsize_deg = 0.0, freq_hz = 0.0;
+    double beam_area_pixels = 0.0;
+    char* units = 0;
+    if (*status) return;
+    double ra0 = s->to_double("observation/phase_centre_ra_deg", status);
+    double dec0 = s->to_double("observation/phase_centre_dec_deg", status);
+    s->begin_group("sky/fits_image");
+    if (!s->to_int("predict_fft", status))
+    {
+        s->end_group();
+        return;
+    }
+    const char* const* files = s->to_string_list("file", &num_files, status);
+    if (num_files == 0 || !files[0] || strlen(files[0]) == 0)
+    {
+        s->end_group();
+        return;
+    }
+    if (num_files > 1)
+        oskar_log_warning(log, "Only the first FITS image will be predicted.");
+
+    // Read the image and convert it to Jy/pixel.
+    oskar_Mem* image = oskar_mem_read_fits_image_plane(files[0], 0, 0, 0,
+            size, crval_deg, crpix, &cellsize_deg, 0, &freq_hz,
+            &beam_area_pixels, &units, status);
+    if (freq_hz == 0.0)
+        freq_hz = s->to_double("observation/start_frequency_hz", status);
+    oskar_convert_brightness_to_jy(image, beam_area_pixels,
+            pow(cellsize_deg * M_PI / 180.0, 2.0), freq_hz,
+            s->to_double("min_peak_fraction", status),
+            s->to_double("min_abs_val", status), units,
+            s->to_string("default_map_units", status),
+            s->to_int("override_map_units", status), status);
+    free(units);
+    if (*status == OSKAR_ERR_BAD_UNITS)
+        oskar_log_error(log, "Units error: Need K, mK, Jy/pixel or "
+                "Jy/beam and beam size.");
+
+    // The image must be square and centred on the phase centre.
+    if (!*status && (size[0] != size[1] ||
+            crpix[0] != size[0] / 2 + 1 || crpix[1] != size[1] / 2 + 1 ||
+            fabs(crval_deg[0] - ra0) > 1e-6 ||
+            fabs(crval_deg[1] - dec0) > 1e-6))
+    {
+        oskar_log_error(log, "FITS image to predict must be square "
+                "and centred on the phase centre.");
+        *status = OSKAR_ERR_SETUP_FAIL_SKY;
+    }
+    if (!*status)
+        oskar_interferometer_set_sky_image(h, image, size[0],
+                cellsize_deg * 3600.0, "FFT", status);
+    oskar_mem_free(image, status);
+    s->end_group();
+}
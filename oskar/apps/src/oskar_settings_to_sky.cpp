@@ -249,6 +249,12 @@ static void load_fits_image(oskar_Sky* sky, oskar_Log* log, SettingsTree* s,
 {
     int num_files = 0;
     s->begin_group("fits_image");
+    if (s->to_int("predict_fft", status))
+    {
+        /* The image is predicted by the simulator instead. */
+        s->end_group();
+        return;
+    }
     const char* const* files = s->to_string_list("file", &num_files, status);
     const char* default_map_units = s->to_string("default_map_units", status);
     int override_map_units = s->to_int("override_map_units", status);
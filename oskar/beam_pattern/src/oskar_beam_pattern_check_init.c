@@ -30,8 +30,10 @@
 #include "beam_pattern/private_beam_pattern.h"
 #include "beam_pattern/private_beam_pattern_generate_coordinates.h"
 #include "convert/oskar_convert_fov_to_cellsize.h"
+#include "convert/oskar_convert_mjd_to_gast_fast.h"
 #include "math/oskar_cmath.h"
 #include "math/private_cond2_2x2.h"
+#include "telescope/station/oskar_evaluate_element_weights_block.h"
 #include "utility/oskar_device_utils.h"
 #include "utility/oskar_file_exists.h"
 #include "oskar_version.h"
@@ -54,6 +56,8 @@ static void set_up_host_data(oskar_BeamPattern* h, int *status);
 static void create_averaged_products(oskar_BeamPattern* h, int ta, int ca,
         int* status);
 static void set_up_device_data(oskar_BeamPattern* h, int* status);
+static void set_up_block_weights(oskar_BeamPattern* h, DeviceData* d,
+        int* status);
 static void write_axis(fitsfile* fptr, int axis_id, const char* ctype,
         const char* ctype_comment, double crval, double cdelt, double crpix,
         int* status);
@@ -606,6 +610,10 @@ static void set_up_device_data(oskar_BeamPattern* h, int* status)
             d->work = oskar_station_work_create(h->prec, dev_loc, status);
         }
 
+        /* Beamforming weights for all times and channels, which are reused
+         * for every pixel chunk. */
+        set_up_block_weights(h, d, status);
+
         /* Host memory. */
         if (!d->jones_data_cpu[0] && raw_data)
         {
@@ -687,6 +695,26 @@ static void set_up_device_data(oskar_BeamPattern* h, int* status)
     }
 }
 
+static void set_up_block_weights(oskar_BeamPattern* h, DeviceData* d,
+        int* status)
+{
+    int i;
+    double *gast, *freq_hz, dt_dump;
+    gast = (double*) malloc(h->num_time_steps * sizeof(double));
+    freq_hz = (double*) malloc(h->num_channels * sizeof(double));
+    dt_dump = h->time_inc_sec / 86400.0;
+    for (i = 0; i < h->num_time_steps; ++i)
+        gast[i] = oskar_convert_mjd_to_gast_fast(
+                h->time_start_mjd_utc + dt_dump * (i + 0.5));
+    for (i = 0; i < h->num_channels; ++i)
+        freq_hz[i] = h->freq_start_hz + i * h->freq_inc_hz;
+    oskar_evaluate_element_weights_block(d->work, d->tel,
+            h->num_active_stations, h->station_ids, h->num_channels,
+            freq_hz, 0, h->num_time_steps, gast, status);
+    free(gast);
+    free(freq_hz);
+}
+
 #ifdef __cplusplus
 }
 #endif
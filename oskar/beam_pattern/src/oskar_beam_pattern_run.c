@@ -298,6 +298,11 @@ static void sim_chunks(oskar_BeamPattern* h, int i_chunk_start, int i_time,
                 i_chunk * h->max_chunk_size, chunk_size, status);
         oskar_mem_copy_contents(d->z, h->z, 0,
                 i_chunk * h->max_chunk_size, chunk_size, status);
+
+        /* If channels are on the inner loop, evaluate array patterns
+         * for all channels at once. */
+        oskar_station_work_set_multi_channel(d->work,
+                h->average_single_axis != 'T' && h->num_channels > 1);
     }
 
     /* Generate beam for this pixel chunk, for all active stations. */
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_GRID_FUNCTIONS_ES_H_
+#define OSKAR_GRID_FUNCTIONS_ES_H_
+
+/**
+ * @file oskar_grid_functions_es.h
+ */
+
+#include <oskar_global.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Generates exponential of semicircle (ES) grid convolution function (GCF).
+ *
+ * @details
+ * Generates the exponential of semicircle grid convolution function,
+ * exp(beta * (sqrt(1 - nu^2) - 1)), where nu is the distance from the
+ * centre in units of (support + 0.5) grid cells, so that the kernel
+ * covers all 2 * support + 1 cells.
+ *
+ * @param[in] support    GCF support size (width = 2 * support + 1).
+ * @param[in] oversample GCF oversample factor, or values per grid cell.
+ * @param[in] beta       Shape parameter (see oskar_grid_beta_es()).
+ * @param[in,out] fn     GCF array, length oversample * (support + 1).
+ */
+OSKAR_EXPORT
+void oskar_grid_convolution_function_es(const int support,
+        const int oversample, const double beta, double* fn);
+
+/**
+ * @brief
+ * Generates grid correction function for ES convolution function.
+ *
+ * @details
+ * Generates the grid correction function for the exponential of semicircle
+ * convolution function, which is the reciprocal of its Fourier transform.
+ * The transform is evaluated numerically, as it has no closed form.
+ *
+ * @param[in] image_size  Side length of image.
+ * @param[in] padding_gcf GCF oversample factor, if the GCF is evaluated
+ *                        at the nearest sample, otherwise 0.
+ * @param[in] support     GCF support size.
+ * @param[in] beta        Shape parameter.
+ * @param[in,out] fn      Array holding correction function,
+ *                        length image_size.
+ */
+OSKAR_EXPORT
+void oskar_grid_correction_function_es(const int image_size,
+        const int padding_gcf, const int support, const double beta,
+        double* fn);
+
+/**
+ * @brief
+ * Evaluates the Fourier transform of the ES convolution function.
+ *
+ * @details
+ * Evaluates the Fourier transform of the continuous exponential of
+ * semicircle kernel, which covers 2 * support + 1 grid cells, at the
+ * given frequencies. The transform is evaluated by Gauss-Legendre
+ * quadrature. Its value at zero frequency is the integral of the kernel,
+ * in units of grid cells.
+ *
+ * @param[in] support     GCF support size.
+ * @param[in] beta        Shape parameter.
+ * @param[in] num_points  Number of frequencies.
+ * @param[in] freq        Frequencies, in cycles per grid cell.
+ * @param[out] ft         Values of the transform at each frequency.
+ */
+OSKAR_EXPORT
+void oskar_grid_fourier_transform_es(const int support, const double beta,
+        const int num_points, const double* freq, double* ft);
+
+/**
+ * @brief
+ * Returns the ES shape parameter for a given support size.
+ *
+ * @param[in] support     GCF support size.
+ */
+OSKAR_EXPORT
+double oskar_grid_beta_es(const int support);
+
+/**
+ * @brief
+ * Returns the ES support size needed for a given accuracy.
+ *
+ * @details
+ * Returns the smallest support size for which the aliasing error of the
+ * exponential of semicircle kernel is expected to be below \p accuracy,
+ * relative to the peak, in the inner half of a grid padded by a factor
+ * of 2.
+ *
+ * @param[in] accuracy    Required accuracy (for example, 1e-5).
+ */
+OSKAR_EXPORT
+int oskar_grid_support_es(const double accuracy);
+
+/**
+ * @brief
+ * Internal function.
+ */
+OSKAR_EXPORT
+double oskar_grid_function_es(const double nu, const double beta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_GRID_FUNCTIONS_ES_H_ */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_GRID_IDG_H_
+#define OSKAR_GRID_IDG_H_
+
+/**
+ * @file oskar_grid_idg.h
+ */
+
+#include <oskar_global.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Returns the size of the work buffer needed by the IDG gridder
+ * (double precision).
+ *
+ * @details
+ * Returns the size, in bytes, of the work buffer needed by
+ * oskar_grid_idg_d() when called with the same visibilities, from the
+ * same OpenMP context. The size depends on the largest |w| value.
+ *
+ * @param[in] num_points     Number of visibility points.
+ * @param[in] ww             Visibility baseline ww coordinates, in wavelengths.
+ * @param[in] cell_size_rad  Cell size, in radians.
+ * @param[in] grid_size      Side length of grid.
+ */
+OSKAR_EXPORT
+size_t oskar_grid_idg_work_size_d(
+        const size_t num_points,
+        const double* restrict ww,
+        const double cell_size_rad,
+        const int grid_size);
+
+/**
+ * @brief
+ * Returns the size of the work buffer needed by the IDG gridder
+ * (single precision).
+ *
+ * @details
+ * Returns the size, in bytes, of the work buffer needed by
+ * oskar_grid_idg_f() when called with the same visibilities, from the
+ * same OpenMP context. The size depends on the largest |w| value.
+ *
+ * @param[in] num_points     Number of visibility points.
+ * @param[in] ww             Visibility baseline ww coordinates, in wavelengths.
+ * @param[in] cell_size_rad  Cell size, in radians.
+ * @param[in] grid_size      Side length of grid.
+ */
+OSKAR_EXPORT
+size_t oskar_grid_idg_work_size_f(
+        const size_t num_points,
+        const float* restrict ww,
+        const float cell_size_rad,
+        const int grid_size);
+
+/**
+ * @brief
+ * Gridding function for image-domain gridding (double precision).
+ *
+ * @details
+ * Gridding function for image-domain gridding (IDG).
+ *
+ * Visibilities are sorted into tiles of the grid. The visibilities in each
+ * tile are summed in the image domain of a small subgrid, where the
+ * W-term and a spheroidal taper are applied exactly, before the subgrid is
+ * transformed back to the uv-plane and added to the grid.
+ * No W-kernels need to be generated.
+ *
+ * The subgrid size is chosen from the largest |w| value, so that each
+ * subgrid holds the full W-kernel support. Tiles are gridded in parallel
+ * using OpenMP, and the result does not depend on the number of threads.
+ *
+ * The grid correction function is the spheroidal function
+ * across the whole grid.
+ *
+ * @param[in] num_points     Number of visibility points.
+ * @param[in] uu             Visibility baseline uu coordinates, in wavelengths.
+ * @param[in] vv             Visibility baseline vv coordinates, in wavelengths.
+ * @param[in] ww             Visibility baseline ww coordinates, in wavelengths.
+ * @param[in] vis            Complex visibilities for each baseline.
+ * @param[in] weight         Visibility weight for each baseline.
+ * @param[in] cell_size_rad  Cell size, in radians.
+ * @param[in] grid_size      Side length of grid.
+ * @param[in] work           Work buffer (see oskar_grid_idg_work_size_d()).
+ * @param[out] num_skipped   Number of visibilities that fell outside the grid.
+ * @param[in,out] norm       Updated grid normalisation factor.
+ * @param[in,out] grid       Updated complex visibility grid.
+ */
+OSKAR_EXPORT
+void oskar_grid_idg_d(
+        const size_t num_points,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict ww,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const int grid_size,
+        void* restrict work,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        double* restrict grid);
+
+/**
+ * @brief
+ * Gridding function for image-domain gridding (single precision).
+ *
+ * @details
+ * Gridding function for image-domain gridding (IDG).
+ *
+ * Visibilities are sorted into tiles of the grid. The visibilities in each
+ * tile are summed in the image domain of a small subgrid, where the
+ * W-term and a spheroidal taper are applied exactly, before the subgrid is
+ * transformed back to the uv-plane and added to the grid.
+ * No W-kernels need to be generated.
+ *
+ * The subgrid size is chosen from the largest |w| value, so that each
+ * subgrid holds the full W-kernel support. Tiles are gridded in parallel
+ * using OpenMP, and the result does not depend on the number of threads.
+ *
+ * The grid correction function is the spheroidal function
+ * across the whole grid.
+ *
+ * @param[in] num_points     Number of visibility points.
+ * @param[in] uu             Visibility baseline uu coordinates, in wavelengths.
+ * @param[in] vv             Visibility baseline vv coordinates, in wavelengths.
+ * @param[in] ww             Visibility baseline ww coordinates, in wavelengths.
+ * @param[in] vis            Complex visibilities for each baseline.
+ * @param[in] weight         Visibility weight for each baseline.
+ * @param[in] cell_size_rad  Cell size, in radians.
+ * @param[in] grid_size      Side length of grid.
+ * @param[in] work           Work buffer (see oskar_grid_idg_work_size_f()).
+ * @param[out] num_skipped   Number of visibilities that fell outside the grid.
+ * @param[in,out] norm       Updated grid normalisation factor.
+ * @param[in,out] grid       Updated complex visibility grid.
+ */
+OSKAR_EXPORT
+void oskar_grid_idg_f(
+        const size_t num_points,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict ww,
+        const float* restrict vis,
+        const float* restrict weight,
+        const float cell_size_rad,
+        const int grid_size,
+        void* restrict work,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        float* restrict grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_GRID_IDG_H_ */
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_GRID_NUFFT_H_
+#define OSKAR_GRID_NUFFT_H_
+
+/**
+ * @file oskar_grid_nufft.h
+ */
+
+#include <oskar_global.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Gridding function for the non-uniform FFT (double precision).
+ *
+ * @details
+ * Spreads visibilities onto the grid using the exponential of semicircle
+ * kernel, which is evaluated exactly at each grid cell instead of being
+ * looked up in an oversampled table. Together with a grid padded by a
+ * factor of 2 and the exact grid correction, this gives a type-1
+ * non-uniform FFT with an accuracy set by the kernel support size.
+ *
+ * If \p ww is not NULL, visibilities are also spread in the W direction
+ * onto \p num_w_planes W-planes, the first of which is at
+ * W = -support / w_scale. Visibilities with negative W are replaced by
+ * their complex conjugate at (-u, -v, -w).
+ *
+ * The normalisation factor is the sum of the visibility weights.
+ *
+ * Visibilities are sorted into tiles of the grid, and tiles are gridded
+ * in parallel using OpenMP. The result does not depend on the number
+ * of threads.
+ *
+ * @param[in] support       Kernel support size (width = 2 * support + 1).
+ * @param[in] beta          Kernel shape parameter.
+ * @param[in] num_w_planes  Number of W-planes, if \p ww is not NULL.
+ * @param[in] num_points    Number of visibility points.
+ * @param[in] uu            Visibility baseline uu coordinates, in wavelengths.
+ * @param[in] vv            Visibility baseline vv coordinates, in wavelengths.
+ * @param[in] ww            Visibility baseline ww coordinates, or NULL.
+ * @param[in] vis           Complex visibilities for each baseline.
+ * @param[in] weight        Visibility weight for each baseline.
+ * @param[in] cell_size_rad Cell size, in radians.
+ * @param[in] w_scale       Number of W-planes per wavelength.
+ * @param[in] grid_size     Side length of grid.
+ * @param[out] num_skipped  Number of visibilities that fell outside the grid.
+ * @param[in,out] norm      Updated grid normalisation factor.
+ * @param[in,out] grid      Updated complex visibility grid (or W-planes).
+ */
+OSKAR_EXPORT
+void oskar_grid_nufft_d(
+        const int support,
+        const double beta,
+        const int num_w_planes,
+        const size_t num_points,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict ww,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const double w_scale,
+        const int grid_size,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        double* restrict grid);
+
+/**
+ * @brief
+ * Gridding function for the non-uniform FFT (single precision).
+ *
+ * @details
+ * Spreads visibilities onto the grid using the exponential of semicircle
+ * kernel, which is evaluated exactly at each grid cell instead of being
+ * looked up in an oversampled table. Together with a grid padded by a
+ * factor of 2 and the exact grid correction, this gives a type-1
+ * non-uniform FFT with an accuracy set by the kernel support size.
+ *
+ * If \p ww is not NULL, visibilities are also spread in the W direction
+ * onto \p num_w_planes W-planes, the first of which is at
+ * W = -support / w_scale. Visibilities with negative W are replaced by
+ * their complex conjugate at (-u, -v, -w).
+ *
+ * The normalisation factor is the sum of the visibility weights.
+ *
+ * Visibilities are sorted into tiles of the grid, and tiles are gridded
+ * in parallel using OpenMP. The result does not depend on the number
+ * of threads.
+ *
+ * @param[in] support       Kernel support size (width = 2 * support + 1).
+ * @param[in] beta          Kernel shape parameter.
+ * @param[in] num_w_planes  Number of W-planes, if \p ww is not NULL.
+ * @param[in] num_points    Number of visibility points.
+ * @param[in] uu            Visibility baseline uu coordinates, in wavelengths.
+ * @param[in] vv            Visibility baseline vv coordinates, in wavelengths.
+ * @param[in] ww            Visibility baseline ww coordinates, or NULL.
+ * @param[in] vis           Complex visibilities for each baseline.
+ * @param[in] weight        Visibility weight for each baseline.
+ * @param[in] cell_size_rad Cell size, in radians.
+ * @param[in] w_scale       Number of W-planes per wavelength.
+ * @param[in] grid_size     Side length of grid.
+ * @param[out] num_skipped  Number of visibilities that fell outside the grid.
+ * @param[in,out] norm      Updated grid normalisation factor.
+ * @param[in,out] grid      Updated complex visibility grid (or W-planes).
+ */
+OSKAR_EXPORT
+void oskar_grid_nufft_f(
+        const int support,
+        const double beta,
+        const int num_w_planes,
+        const size_t num_points,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict ww,
+        const float* restrict vis,
+        const float* restrict weight,
+        const double cell_size_rad,
+        const double w_scale,
+        const int grid_size,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        float* restrict grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_GRID_NUFFT_H_ */
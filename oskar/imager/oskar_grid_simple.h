@@ -40,6 +40,27 @@
 extern "C" {
 #endif
 
+/**
+ * @brief
+ * Returns the size of the work buffer needed by the simple gridder.
+ *
+ * @details
+ * Returns the size, in bytes, of the work buffer needed by
+ * oskar_grid_simple_d() or oskar_grid_simple_f() when called with the
+ * same parameters, from the same OpenMP context.
+ *
+ * @param[in] support       GCF support size (typ. 3; width = 2 * support + 1).
+ * @param[in] num_points    Number of visibility points.
+ * @param[in] grid_size     Side length of image and grid.
+ * @param[in] element_size  Size of one real grid value, in bytes.
+ */
+OSKAR_EXPORT
+size_t oskar_grid_simple_work_size(
+        const int support,
+        const size_t num_points,
+        const int grid_size,
+        const size_t element_size);
+
 /**
  * @brief
  * Simple gridding function for 1D real convolution kernel (double precision).
@@ -47,6 +68,10 @@ extern "C" {
  * @details
  * Simple gridding function for 1D real convolution kernel.
  *
+ * Visibilities are sorted into tiles of the grid, and tiles are gridded
+ * into private subgrids in parallel using OpenMP. The result does not
+ * depend on the number of threads.
+ *
  * @param[in] support       GCF support size (typ. 3; width = 2 * support + 1).
  * @param[in] oversample    GCF oversample factor, or values per grid cell.
  * @param[in] conv_func     GCF array, length oversample * (support + 1).
@@ -57,6 +82,7 @@ extern "C" {
  * @param[in] weight        Visibility weight for each baseline.
  * @param[in] cell_size_rad Cell size, in radians.
  * @param[in] grid_size     Side length of image and grid.
+ * @param[in] work          Work buffer (see oskar_grid_simple_work_size()).
  * @param[out] num_skipped  Number of visibilities that fell outside the grid.
  * @param[in,out] norm      Updated grid normalisation factor.
  * @param[in,out] grid      Updated complex visibility grid.
@@ -73,6 +99,7 @@ void oskar_grid_simple_d(
         const double* restrict weight,
         const double cell_size_rad,
         const int grid_size,
+        void* restrict work,
         size_t* restrict num_skipped,
         double* restrict norm,
         double* restrict grid);
@@ -84,6 +111,10 @@ void oskar_grid_simple_d(
  * @details
  * Simple gridding function for 1D real convolution kernel.
  *
+ * Visibilities are sorted into tiles of the grid, and tiles are gridded
+ * into private subgrids in parallel using OpenMP. The result does not
+ * depend on the number of threads.
+ *
  * @param[in] support       GCF support size (typ. 3; width = 2 * support + 1).
  * @param[in] oversample    GCF oversample factor, or values per grid cell.
  * @param[in] conv_func     GCF array, length oversample * (support + 1).
@@ -94,6 +125,7 @@ void oskar_grid_simple_d(
  * @param[in] weight        Visibility weight for each baseline.
  * @param[in] cell_size_rad Cell size, in radians.
  * @param[in] grid_size     Side length of image and grid.
+ * @param[in] work          Work buffer (see oskar_grid_simple_work_size()).
  * @param[out] num_skipped  Number of visibilities that fell outside the grid.
  * @param[in,out] norm      Updated grid normalisation factor.
  * @param[in,out] grid      Updated complex visibility grid.
@@ -110,6 +142,7 @@ void oskar_grid_simple_f(
         const float* restrict weight,
         const float cell_size_rad,
         const int grid_size,
+        void* restrict work,
         size_t* restrict num_skipped,
         double* restrict norm,
         float* restrict grid);
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_GRID_TILES_H_
+#define OSKAR_GRID_TILES_H_
+
+/**
+ * @file oskar_grid_tiles.h
+ */
+
+#include <oskar_global.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Returns the side length of grid tiles used for parallel gridding.
+ *
+ * @details
+ * Returns the side length of the square tiles that the grid is divided into
+ * for parallel gridding.
+ *
+ * Tiles are gridded in four passes, so that tiles processed at the same time
+ * are separated by at least one other tile. The tile size is therefore
+ * at least twice the maximum kernel support, so that the convolution
+ * footprints of tiles processed at the same time never overlap.
+ *
+ * @param[in] max_support  Maximum kernel support size (half-width).
+ */
+OSKAR_EXPORT
+int oskar_grid_tile_size(int max_support);
+
+/**
+ * @brief
+ * Sorts visibilities into grid tiles.
+ *
+ * @details
+ * Returns a list of visibility indices sorted by tile, using a stable
+ * counting sort so that visibilities within each tile stay in their
+ * original order.
+ *
+ * Visibilities with a negative tile index are not included in the list,
+ * and their number is returned.
+ *
+ * @param[in] num_points   Number of visibility points.
+ * @param[in] tile_index   Tile index of each visibility, or -1 to skip it.
+ * @param[in] num_tiles    Total number of tiles.
+ * @param[out] tile_start  Start of each tile in list, length num_tiles + 1.
+ * @param[out] sorted      Visibility indices, sorted by tile.
+ *
+ * @return The number of skipped visibilities.
+ */
+OSKAR_EXPORT
+size_t oskar_grid_tiles_sort(size_t num_points, const int* tile_index,
+        int num_tiles, size_t* tile_start, size_t* sorted);
+
+/**
+ * @brief
+ * Returns the number of threads used by the tiled gridders.
+ *
+ * @details
+ * Returns the number of OpenMP threads that a tiled gridder called from
+ * here would use. This is 1 if called from a parallel region that cannot
+ * be nested.
+ */
+OSKAR_EXPORT
+int oskar_grid_tiles_num_threads(void);
+
+/**
+ * @brief
+ * Returns the size of the work buffer needed by a tiled gridder.
+ *
+ * @details
+ * Returns the size, in bytes, of the work buffer used by a tiled gridder
+ * to sort visibilities into tiles, and to hold the complex subgrids of
+ * each thread returned by oskar_grid_tiles_num_threads().
+ *
+ * @param[in] num_points    Number of visibility points.
+ * @param[in] num_tiles     Total number of tiles.
+ * @param[in] sub_size      Side length of subgrids.
+ * @param[in] num_subgrids  Number of complex subgrids for each thread.
+ * @param[in] element_size  Size of one real grid value, in bytes.
+ */
+OSKAR_EXPORT
+size_t oskar_grid_tiles_work_size(size_t num_points, int num_tiles,
+        int sub_size, int num_subgrids, size_t element_size);
+
+/**
+ * @brief
+ * Splits the work buffer used by a tiled gridder.
+ *
+ * @details
+ * Returns pointers to the arrays in a work buffer of the size given by
+ * oskar_grid_tiles_work_size(). The return value points to the subgrids,
+ * which are stored one after the other for each thread.
+ *
+ * @param[in] work         Work buffer.
+ * @param[in] num_points   Number of visibility points.
+ * @param[in] num_tiles    Total number of tiles.
+ * @param[out] tile_index  Tile index of each visibility, length num_points.
+ * @param[out] tile_start  Start of each tile in list, length num_tiles + 1.
+ * @param[out] sorted      Sorted visibility indices, length num_points + 1.
+ * @param[out] tile_norm   Normalisation of each tile, length num_tiles.
+ *
+ * @return Pointer to the first subgrid.
+ */
+OSKAR_EXPORT
+void* oskar_grid_tiles_work_split(void* work, size_t num_points,
+        int num_tiles, int** tile_index, size_t** tile_start,
+        size_t** sorted, double** tile_norm);
+
+/**
+ * @brief
+ * Adds a complex subgrid into the main grid (double precision).
+ *
+ * @details
+ * Adds a square complex subgrid into the main grid, with the subgrid
+ * origin at the given grid coordinates. Parts of the subgrid that lie
+ * outside the main grid are ignored.
+ *
+ * @param[in] sub_size     Side length of subgrid.
+ * @param[in] origin_u     Grid u-coordinate of first subgrid column.
+ * @param[in] origin_v     Grid v-coordinate of first subgrid row.
+ * @param[in] subgrid      Complex subgrid.
+ * @param[in] grid_size    Side length of main grid.
+ * @param[in,out] grid     Complex main grid.
+ */
+OSKAR_EXPORT
+void oskar_grid_tiles_add_d(const int sub_size, const int origin_u,
+        const int origin_v, const double* restrict subgrid,
+        const int grid_size, double* restrict grid);
+
+/**
+ * @brief
+ * Adds a complex subgrid into the main grid (single precision).
+ *
+ * @details
+ * Adds a square complex subgrid into the main grid, with the subgrid
+ * origin at the given grid coordinates. Parts of the subgrid that lie
+ * outside the main grid are ignored.
+ *
+ * @param[in] sub_size     Side length of subgrid.
+ * @param[in] origin_u     Grid u-coordinate of first subgrid column.
+ * @param[in] origin_v     Grid v-coordinate of first subgrid row.
+ * @param[in] subgrid      Complex subgrid.
+ * @param[in] grid_size    Side length of main grid.
+ * @param[in,out] grid     Complex main grid.
+ */
+OSKAR_EXPORT
+void oskar_grid_tiles_add_f(const int sub_size, const int origin_u,
+        const int origin_v, const float* restrict subgrid,
+        const int grid_size, float* restrict grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_GRID_TILES_H_ */
@@ -55,13 +55,14 @@ extern "C" {
  * @param[in] grid_size         Side length of grid.
  * @param[out] num_skipped      Number of points that fell outside the grid.
  * @param[in,out] grid          Gridded weights.
+ * @param[in,out] status        Status return code.
  */
 OSKAR_EXPORT
 void oskar_grid_weights_write_d(const size_t num_points,
         const double* restrict uu, const double* restrict vv,
         const double* restrict weight, const double cell_size_rad,
         const int grid_size, size_t* restrict num_skipped,
-        double* restrict grid);
+        double* restrict grid, int* status);
 
 /**
  * @brief
@@ -87,6 +88,25 @@ void oskar_grid_weights_read_d(const size_t num_points,
         const double cell_size_rad, const int grid_size,
         size_t* restrict num_skipped, const double* restrict grid);
 
+/**
+ * @brief
+ * Converts gridded weights for Briggs weighting (double precision).
+ *
+ * @details
+ * Replaces each cell of a grid of summed weights W with the denominator
+ * 1 + W f^2 used for Briggs (robust) weighting, where
+ * f^2 = (5 * 10^-robustness)^2 / (sum(W^2) / sum(W)).
+ * The converted grid can then be used with oskar_grid_weights_read_d().
+ *
+ * @param[in] grid_size         Side length of grid.
+ * @param[in] robustness        Briggs robustness parameter.
+ * @param[in,out] grid          Gridded weights.
+ * @param[in,out] status        Status return code.
+ */
+OSKAR_EXPORT
+void oskar_grid_weights_briggs_d(const int grid_size,
+        const double robustness, double* restrict grid, int* status);
+
 /**
  * @brief
  * Updates gridded weights (single precision).
@@ -102,13 +122,14 @@ void oskar_grid_weights_read_d(const size_t num_points,
  * @param[in] grid_size         Side length of grid.
  * @param[out] num_skipped      Number of points that fell outside the grid.
  * @param[in,out] grid          Gridded weights.
+ * @param[in,out] status        Status return code.
  */
 OSKAR_EXPORT
 void oskar_grid_weights_write_f(const size_t num_points,
         const float* restrict uu, const float* restrict vv,
         const float* restrict weight, const float cell_size_rad,
         const int grid_size, size_t* restrict num_skipped,
-        float* restrict grid);
+        float* restrict grid, int* status);
 
 /**
  * @brief
@@ -134,6 +155,25 @@ void oskar_grid_weights_read_f(const size_t num_points,
         const float cell_size_rad, const int grid_size,
         size_t* restrict num_skipped, const float* restrict grid);
 
+/**
+ * @brief
+ * Converts gridded weights for Briggs weighting (single precision).
+ *
+ * @details
+ * Replaces each cell of a grid of summed weights W with the denominator
+ * 1 + W f^2 used for Briggs (robust) weighting, where
+ * f^2 = (5 * 10^-robustness)^2 / (sum(W^2) / sum(W)).
+ * The converted grid can then be used with oskar_grid_weights_read_f().
+ *
+ * @param[in] grid_size         Side length of grid.
+ * @param[in] robustness        Briggs robustness parameter.
+ * @param[in,out] grid          Gridded weights.
+ * @param[in,out] status        Status return code.
+ */
+OSKAR_EXPORT
+void oskar_grid_weights_briggs_f(const int grid_size,
+        const double robustness, float* restrict grid, int* status);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,29 @@
 extern "C" {
 #endif
 
+/**
+ * @brief
+ * Returns the size of the work buffer needed by the W-projection gridder.
+ *
+ * @details
+ * Returns the size, in bytes, of the work buffer needed by
+ * oskar_grid_wproj_d() or oskar_grid_wproj_f() when called with the
+ * same parameters, from the same OpenMP context.
+ *
+ * @param[in] num_w_planes   Number of W-projection planes.
+ * @param[in] support        GCF support size per W-plane.
+ * @param[in] num_points     Number of visibility points.
+ * @param[in] grid_size      Side length of grid.
+ * @param[in] element_size   Size of one real grid value, in bytes.
+ */
+OSKAR_EXPORT
+size_t oskar_grid_wproj_work_size(
+        const size_t num_w_planes,
+        const int* restrict support,
+        const size_t num_points,
+        const int grid_size,
+        const size_t element_size);
+
 /**
  * @brief
  * Gridding function for W-projection (double precision).
@@ -47,6 +70,10 @@ extern "C" {
  * @details
  * Gridding function for W-projection.
  *
+ * Visibilities are sorted into tiles of the grid, and tiles are gridded
+ * into private subgrids in parallel using OpenMP. The result does not
+ * depend on the number of threads.
+ *
  * @param[in] num_w_planes   Number of W-projection planes.
  * @param[in] support        GCF support size per W-plane.
  * @param[in] oversample     GCF oversample factor.
@@ -61,6 +88,7 @@ extern "C" {
  * @param[in] cell_size_rad  Cell size, in radians.
  * @param[in] w_scale        Scaling factor used to find W-plane index.
  * @param[in] grid_size      Side length of grid.
+ * @param[in] work           Work buffer (see oskar_grid_wproj_work_size()).
  * @param[out] num_skipped   Number of visibilities that fell outside the grid.
  * @param[in,out] norm       Updated grid normalisation factor.
  * @param[in,out] grid       Updated complex visibility grid.
@@ -81,6 +109,7 @@ void oskar_grid_wproj_d(
         const double cell_size_rad,
         const double w_scale,
         const int grid_size,
+        void* restrict work,
         size_t* restrict num_skipped,
         double* restrict norm,
         double* restrict grid);
@@ -92,6 +121,10 @@ void oskar_grid_wproj_d(
  * @details
  * Gridding function for W-projection.
  *
+ * Visibilities are sorted into tiles of the grid, and tiles are gridded
+ * into private subgrids in parallel using OpenMP. The result does not
+ * depend on the number of threads.
+ *
  * @param[in] num_w_planes   Number of W-projection planes.
  * @param[in] support        GCF support size per W-plane.
  * @param[in] oversample     GCF oversample factor.
@@ -106,6 +139,7 @@ void oskar_grid_wproj_d(
  * @param[in] cell_size_rad  Cell size, in radians.
  * @param[in] w_scale        Scaling factor used to find W-plane index.
  * @param[in] grid_size      Side length of grid.
+ * @param[in] work           Work buffer (see oskar_grid_wproj_work_size()).
  * @param[out] num_skipped   Number of visibilities that fell outside the grid.
  * @param[in,out] norm       Updated grid normalisation factor.
  * @param[in,out] grid       Updated complex visibility grid.
@@ -126,6 +160,7 @@ void oskar_grid_wproj_f(
         const float cell_size_rad,
         const float w_scale,
         const int grid_size,
+        void* restrict work,
         size_t* restrict num_skipped,
         double* restrict norm,
         float* restrict grid);
@@ -66,7 +66,11 @@ enum OSKAR_IMAGE_ALGORITHM
     OSKAR_ALGORITHM_DFT_2D,
     OSKAR_ALGORITHM_DFT_3D,
     OSKAR_ALGORITHM_WPROJ,
-    OSKAR_ALGORITHM_AWPROJ
+    OSKAR_ALGORITHM_AWPROJ,
+    OSKAR_ALGORITHM_IDG,
+    OSKAR_ALGORITHM_WSTACK,
+    OSKAR_ALGORITHM_NUFFT_2D,
+    OSKAR_ALGORITHM_NUFFT_3D
 };
 
 enum OSKAR_IMAGE_WEIGHTING
@@ -74,7 +78,8 @@ enum OSKAR_IMAGE_WEIGHTING
     OSKAR_WEIGHTING_NATURAL,
     OSKAR_WEIGHTING_RADIAL,
     OSKAR_WEIGHTING_UNIFORM,
-    OSKAR_WEIGHTING_GRIDLESS_UNIFORM
+    OSKAR_WEIGHTING_GRIDLESS_UNIFORM,
+    OSKAR_WEIGHTING_BRIGGS
 };
 
 #ifdef __cplusplus
@@ -87,6 +92,7 @@ enum OSKAR_IMAGE_WEIGHTING
 #include <imager/oskar_imager_finalise.h>
 #include <imager/oskar_imager_free.h>
 #include <imager/oskar_imager_linear_to_stokes.h>
+#include <imager/oskar_imager_predict.h>
 #include <imager/oskar_imager_reset_cache.h>
 #include <imager/oskar_imager_rotate_coords.h>
 #include <imager/oskar_imager_rotate_vis.h>
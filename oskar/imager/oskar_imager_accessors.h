@@ -76,6 +76,18 @@ double oskar_imager_cellsize(const oskar_Imager* h);
 OSKAR_EXPORT
 int oskar_imager_channel_snapshots(const oskar_Imager* h);
 
+/**
+ * @brief
+ * Returns the flag specifying whether to use coordinate index files.
+ *
+ * @details
+ * Returns the flag specifying whether to use coordinate index files.
+ *
+ * @param[in] h  Handle to imager.
+ */
+OSKAR_EXPORT
+int oskar_imager_coords_index(const oskar_Imager* h);
+
 /**
  * @brief
  * Returns the flag specifying whether the imager is in coordinate-only mode.
@@ -150,6 +162,31 @@ double oskar_imager_freq_min_hz(const oskar_Imager* h);
 OSKAR_EXPORT
 int oskar_imager_generate_w_kernels_on_gpu(const oskar_Imager* h);
 
+/**
+ * @brief
+ * Returns the flag specifying whether to grid only half of the UV plane.
+ *
+ * @details
+ * Returns the flag specifying whether to grid only half of the UV plane.
+ *
+ * @param[in] h  Handle to imager.
+ */
+OSKAR_EXPORT
+int oskar_imager_grid_half_plane(const oskar_Imager* h);
+
+/**
+ * @brief
+ * Returns the accuracy used to choose the gridding kernel support size.
+ *
+ * @details
+ * Returns the accuracy used to choose the support size of the
+ * exponential of semicircle gridding kernel, or 0 if not set.
+ *
+ * @param[in] h  Handle to imager.
+ */
+OSKAR_EXPORT
+double oskar_imager_grid_kernel_accuracy(const oskar_Imager* h);
+
 /**
  * @brief
  * Returns the image side length.
@@ -187,6 +224,18 @@ const char* oskar_imager_image_type(const oskar_Imager* h);
 OSKAR_EXPORT
 char* const* oskar_imager_input_files(const oskar_Imager* h);
 
+/**
+ * @brief
+ * Returns the memory budget for the imager, in GB.
+ *
+ * @details
+ * Returns the memory budget for the imager, in GB, or 0 if not set.
+ *
+ * @param[in] h  Handle to imager.
+ */
+OSKAR_EXPORT
+double oskar_imager_memory_budget_gb(const oskar_Imager* h);
+
 /**
  * @brief
  * Returns the Measurement Set column to use.
@@ -250,7 +299,8 @@ const char* oskar_imager_output_root(const oskar_Imager* h);
  *
  * @details
  * Returns the grid size required by the algorithm.
- * This will be different to the image size when using W-projection.
+ * This will be different to the image size when using W-projection
+ * or IDG.
  */
 OSKAR_EXPORT
 int oskar_imager_plane_size(oskar_Imager* h);
@@ -275,6 +325,18 @@ int oskar_imager_plane_type(const oskar_Imager* h);
 OSKAR_EXPORT
 int oskar_imager_precision(const oskar_Imager* h);
 
+/**
+ * @brief
+ * Returns the Briggs robustness parameter.
+ *
+ * @details
+ * Returns the robustness parameter used for Briggs weighting.
+ *
+ * @param[in] h  Handle to imager.
+ */
+OSKAR_EXPORT
+double oskar_imager_robustness(const oskar_Imager* h);
+
 /**
  * @brief
  * Returns the option to scale image normalisation by the number of input files.
@@ -295,6 +357,9 @@ int oskar_imager_scale_norm_with_num_input_files(const oskar_Imager* h);
  * The \p type string can be:
  * - "FFT" to use standard gridding followed by a FFT.
  * - "W-projection" to use W-projection gridding followed by a FFT.
+ * - "W-stacking" to grid onto W-layers, which are transformed and
+ *   corrected for the W-term in the image plane.
+ * - "IDG" to use image-domain gridding followed by a FFT.
  * - "DFT 2D" to use a 2D Direct Fourier Transform, without gridding.
  * - "DFT 3D" to use a 3D Direct Fourier Transform, without gridding.
  *
@@ -337,6 +402,26 @@ void oskar_imager_set_cellsize(oskar_Imager* h, double cellsize_arcsec);
 OSKAR_EXPORT
 void oskar_imager_set_channel_snapshots(oskar_Imager* h, int value);
 
+/**
+ * @brief
+ * Sets whether to use coordinate index files for Measurement Sets.
+ *
+ * @details
+ * If set, the baseline coordinates, weights and time centroids read from
+ * a Measurement Set in the coordinate-only pass of oskar_imager_run()
+ * are saved to an index file alongside it, with the suffix ".coords".
+ * If the index file already exists and matches the dimensions of the
+ * Measurement Set, it is read instead of the Measurement Set.
+ *
+ * The coordinate-only pass is needed for uniform weighting, W-projection
+ * and W-stacking.
+ *
+ * @param[in,out] h          Handle to imager.
+ * @param[in]     value      If true, use coordinate index files.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_coords_index(oskar_Imager* h, int value);
+
 /**
  * @brief
  * Sets the imager to ignore visibility data and only update weights grids.
@@ -361,6 +446,9 @@ void oskar_imager_set_channel_snapshots(oskar_Imager* h, int value);
  *     oskar_imager_set_coords_only(false)
  *     (repeat) oskar_imager_update()
  *
+ * For Briggs weighting, the weights grids are converted by the first
+ * call to oskar_imager_update() after this mode is turned off.
+ *
  * @param[in,out] h          Handle to imager.
  * @param[in]     flag       If set, ignore visibilities and only update
  *                           weights grids.
@@ -461,6 +549,34 @@ void oskar_imager_set_freq_min_hz(oskar_Imager* h, double freq_min_hz);
 OSKAR_EXPORT
 void oskar_imager_set_generate_w_kernels_on_gpu(oskar_Imager* h, int value);
 
+/**
+ * @brief
+ * Sets whether to grid only half of the UV plane.
+ *
+ * @details
+ * Sets whether to grid only half of the UV plane, using the Hermitian
+ * symmetry of visibilities from a real sky.
+ *
+ * If set, visibilities with negative V-coordinates are replaced by their
+ * complex conjugates at (-u, -v, -w) before they are gridded, and the
+ * images are made using an FFT that computes only the real part of the
+ * result, skipping rows of the grid that are empty. The images are
+ * the same, but the FFT does about half the work.
+ *
+ * Planes updated by oskar_imager_update() then hold only the rows of the
+ * grid with V >= 0, so they need about half the memory. Each thread
+ * grids into its own full grid, which is folded into the plane after
+ * each update. Grids returned by oskar_imager_finalise() have
+ * plane_size / 2 + 1 rows, starting at V = 0. Uniform weighting counts
+ * each visibility and its conjugate as being in the same cell. This has
+ * no effect for the DFT, W-stacking and 3D NUFFT algorithms.
+ *
+ * @param[in,out] h          Handle to imager.
+ * @param[in]     value      If true, grid only half of the UV plane.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_grid_half_plane(oskar_Imager* h, int value);
+
 /**
  * @brief
  * Sets which GPUs will be used by the imager.
@@ -486,6 +602,14 @@ void oskar_imager_set_gpus(oskar_Imager* h, int num, const int* ids,
  *
  * The \p type string can be:
  * - "Spheroidal" to use the spheroidal kernel from CASA.
+ * - "Pillbox" to use a pillbox kernel.
+ * - "ES" or "Exponential of semicircle" to use the exponential of
+ *   semicircle kernel, which needs a smaller support size than the
+ *   spheroidal kernel for the same accuracy.
+ *
+ * The exponential of semicircle kernel is also used to taper the
+ * W-projection kernels, if selected. Other types use the spheroidal
+ * function for W-projection.
  *
  * @param[in,out] h          Handle to imager.
  * @param[in]     type       Type of kernel to use.
@@ -497,6 +621,23 @@ OSKAR_EXPORT
 void oskar_imager_set_grid_kernel(oskar_Imager* h, const char* type,
         int support, int oversample, int* status);
 
+/**
+ * @brief
+ * Sets the accuracy used to choose the gridding kernel support size.
+ *
+ * @details
+ * If greater than zero, the support size of the exponential of semicircle
+ * gridding kernel is chosen to give this accuracy (for example, 1e-5),
+ * relative to the peak, instead of using the support size given to
+ * oskar_imager_set_grid_kernel(). Set to 0 to use that support size
+ * (the default). This has no effect for other kernel types.
+ *
+ * @param[in,out] h          Handle to imager.
+ * @param[in]     value      Required accuracy, or 0.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_grid_kernel_accuracy(oskar_Imager* h, double value);
+
 /**
  * @brief
  * Sets image side length.
@@ -570,6 +711,26 @@ void oskar_imager_set_input_files(oskar_Imager* h, int num_files,
 OSKAR_EXPORT
 void oskar_imager_set_log(oskar_Imager* h, oskar_Log* log);
 
+/**
+ * @brief
+ * Sets the memory budget for the imager, in GB.
+ *
+ * @details
+ * If greater than zero, oskar_imager_run() makes the image channels in
+ * batches, so that the image planes and weights grids of each batch fit
+ * within this amount of memory. The input data are then read once for
+ * each batch. Set to 0 to make all the channels at once (the default).
+ *
+ * The estimate also includes the memory used regardless of the batch size:
+ * the scratch arrays for each thread, the W-kernels, and the buffers used
+ * to read the input data.
+ *
+ * @param[in,out] h          Handle to imager.
+ * @param[in]     value      Memory budget in GB, or 0.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_memory_budget_gb(oskar_Imager* h, double value);
+
 /**
  * @brief
  * Sets the data column to use from a Measurement Set.
@@ -627,6 +788,21 @@ void oskar_imager_set_output_root(oskar_Imager* h, const char* filename);
 OSKAR_EXPORT
 void oskar_imager_set_oversample(oskar_Imager* h, int value);
 
+/**
+ * @brief
+ * Sets the Briggs robustness parameter.
+ *
+ * @details
+ * Sets the robustness parameter used for Briggs weighting.
+ * Values are typically between -2 (close to uniform weighting)
+ * and 2 (close to natural weighting). The default is 0.
+ *
+ * @param[in,out] h          Handle to imager.
+ * @param[in]     value      Robustness parameter.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_robustness(oskar_Imager* h, double value);
+
 /**
  * @brief
  * Sets the option to scale image normalisation with number of input files.
@@ -691,6 +867,26 @@ void oskar_imager_set_time_max_utc(oskar_Imager* h, double time_max_mjd_utc);
 OSKAR_EXPORT
 void oskar_imager_set_time_min_utc(oskar_Imager* h, double time_min_mjd_utc);
 
+/**
+ * @brief
+ * Sets the interval used to make time snapshots.
+ *
+ * @details
+ * If greater than zero, visibilities are binned into intervals of this
+ * length, starting from the earliest time in the data (or the minimum
+ * time, if set), and each interval is imaged separately.
+ * The time range must be known before the image planes are allocated:
+ * see oskar_imager_set_vis_time().
+ * The snapshots are written along the fourth axis of the FITS image cube.
+ * A value less than or equal to zero means no time snapshots.
+ *
+ * @param[in] h         Handle to imager.
+ * @param[in] value     The length of each time interval, in seconds.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_time_snapshot_interval_sec(oskar_Imager* h,
+        double value);
+
 /**
  * @brief
  * Sets the maximum UV baseline length to image.
@@ -753,12 +949,36 @@ OSKAR_EXPORT
 void oskar_imager_set_vis_phase_centre(oskar_Imager* h,
         double ra_deg, double dec_deg);
 
+/**
+ * @brief
+ * Sets the visibility time range.
+ *
+ * @details
+ * Sets the start time and the time increment of the visibility data.
+ * This is required only if making time snapshots, to set the range of
+ * time intervals to image. If called more than once before the image
+ * planes are allocated, the range covers all the data.
+ *
+ * Callers of oskar_imager_update() must call this function (or set the
+ * minimum and maximum times) before the first update when making time
+ * snapshots; otherwise an error is returned.
+ *
+ * @param[in,out] h            Handle to imager.
+ * @param[in]     ref_mjd_utc  Start time of the data, as MJD(UTC).
+ * @param[in]     inc_sec      Time increment, in seconds.
+ * @param[in]     num          Number of time samples in visibility data.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_vis_time(oskar_Imager* h,
+        double ref_mjd_utc, double inc_sec, int num);
+
 /**
  * @brief
  * Sets the number of W planes to use.
  *
  * @details
- * Sets the number of W planes, used only for W-projection.
+ * Sets the number of W planes, used only for W-projection,
+ * or the number of W-layers if using W-stacking.
  * A value of 0 or less means 'automatic'.
  *
  * @param[in,out] h            Handle to imager.
@@ -767,13 +987,30 @@ void oskar_imager_set_vis_phase_centre(oskar_Imager* h,
 OSKAR_EXPORT
 void oskar_imager_set_num_w_planes(oskar_Imager* h, int value);
 
+/**
+ * @brief
+ * Sets the directory used to cache W-projection kernels.
+ *
+ * @details
+ * If set, W-projection kernels are saved to a file in this directory
+ * after they have been generated, and are loaded from it on subsequent
+ * runs that use the same kernel parameters.
+ *
+ * Set to NULL or an empty string to disable the cache (the default).
+ *
+ * @param[in,out] h     Handle to imager.
+ * @param[in]     dir   Path to an existing directory.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_w_kernel_cache_dir(oskar_Imager* h, const char* dir);
+
 /**
  * @brief
  * Sets the visibility weighting scheme to use.
  *
  * @details
  * Sets the visibility weighting scheme to use,
- * either "Natural", "Radial" or "Uniform".
+ * either "Natural", "Radial", "Uniform" or "Briggs".
  *
  * @param[in,out] h            Handle to imager.
  * @param[in] type             Visibility weighting type string, as above.
@@ -820,6 +1057,19 @@ double oskar_imager_time_max_utc(const oskar_Imager* h);
 OSKAR_EXPORT
 double oskar_imager_time_min_utc(const oskar_Imager* h);
 
+/**
+ * @brief
+ * Returns the interval used to make time snapshots.
+ *
+ * @details
+ * Returns the length of each time snapshot, in seconds.
+ * A value less than or equal to zero means no time snapshots.
+ *
+ * @param[in] h  Handle to imager.
+ */
+OSKAR_EXPORT
+double oskar_imager_time_snapshot_interval_sec(const oskar_Imager* h);
+
 /**
  * @brief
  * Returns the maximum UV baseline length to image.
@@ -844,6 +1094,19 @@ double oskar_imager_uv_filter_max(const oskar_Imager* h);
 OSKAR_EXPORT
 double oskar_imager_uv_filter_min(const oskar_Imager* h);
 
+/**
+ * @brief
+ * Returns the directory used to cache W-projection kernels.
+ *
+ * @details
+ * Returns the directory used to cache W-projection kernels,
+ * or NULL if the cache is disabled.
+ *
+ * @param[in] h  Handle to imager.
+ */
+OSKAR_EXPORT
+const char* oskar_imager_w_kernel_cache_dir(const oskar_Imager* h);
+
 /**
  * @brief
  * Returns the visibility weighting scheme.
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_IMAGER_PREDICT_H_
+#define OSKAR_IMAGER_PREDICT_H_
+
+/**
+ * @file oskar_imager_predict.h
+ */
+
+#include <oskar_global.h>
+#include <mem/oskar_mem.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Sets the model image used to predict visibilities.
+ *
+ * @details
+ * Sets the model image used by oskar_imager_predict().
+ *
+ * The model image must be real, and have the same size, pixel size and
+ * pixel ordering as the images made by the imager, with the phase centre
+ * at the centre of the image. Pixel values are in Jy/pixel.
+ * A copy of the image is kept by the imager.
+ *
+ * @param[in,out] h      Handle to imager.
+ * @param[in] image      Model image, length image_size * image_size.
+ * @param[in,out] status Status return code.
+ */
+OSKAR_EXPORT
+void oskar_imager_set_model_image(oskar_Imager* h, const oskar_Mem* image,
+        int* status);
+
+/**
+ * @brief
+ * Predicts visibilities from the model image.
+ *
+ * @details
+ * Predicts visibilities of the model image set using
+ * oskar_imager_set_model_image(), by degridding its Fourier transform
+ * at the given baseline coordinates. This uses the same gridding kernels
+ * and grid correction as the imager, applied in reverse, so it is much
+ * faster than a direct Fourier transform of every pixel for large images.
+ *
+ * The algorithm must be either "FFT" or "W-projection".
+ * The model image is transformed the first time this function is called,
+ * and the transformed grid is reused by subsequent calls.
+ *
+ * The predicted visibilities are added to the values in \p amps.
+ *
+ * @param[in,out] h      Handle to imager.
+ * @param[in] num_vis    Number of visibilities.
+ * @param[in] uu         Baseline uu coordinates, in wavelengths.
+ * @param[in] vv         Baseline vv coordinates, in wavelengths.
+ * @param[in] ww         Baseline ww coordinates, in wavelengths.
+ * @param[in,out] amps   Complex visibilities, updated with the prediction.
+ * @param[in,out] status Status return code.
+ */
+OSKAR_EXPORT
+void oskar_imager_predict(oskar_Imager* h, size_t num_vis,
+        const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* ww,
+        oskar_Mem* amps, int* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_IMAGER_PREDICT_H_ */
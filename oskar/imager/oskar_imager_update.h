@@ -82,6 +82,13 @@ void oskar_imager_update_from_block(oskar_Imager* h,
  * The visibility weight data dimension order must be:
  * (slowest) time/baseline, polarisation (fastest).
  *
+ * If making time snapshots, the visibility time range must be set
+ * before the first call to this function, using
+ * oskar_imager_set_vis_time() or oskar_imager_set_time_min_utc() and
+ * oskar_imager_set_time_max_utc(), as the image planes are allocated here.
+ * (oskar_imager_update_from_block() and oskar_imager_run() do this
+ * automatically.)
+ *
  * Call finalise() to finalise the images after calling this function.
  *
  * @param[in,out] h             Handle to imager.
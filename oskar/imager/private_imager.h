@@ -26,16 +26,19 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef OSKAR_HAVE_CUDA
-#include <cufft.h>
-#endif
-
 #include <fitsio.h>
+#include <math/oskar_fft.h>
 #include <mem/oskar_mem.h>
 #include <log/oskar_log.h>
 #include <utility/oskar_thread.h>
 #include <utility/oskar_timer.h>
 
+/* Tolerance added to each end of the time filter range, in seconds. */
+#define OSKAR_IMAGER_TIME_TOL_SEC 0.01
+
+/* Number of visibility blocks held in memory while reading input files. */
+#define OSKAR_IMAGER_READ_SLOTS 2
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -48,6 +51,16 @@ struct DeviceData
 };
 typedef struct DeviceData DeviceData;
 
+/* Scratch arrays used to update one image plane. */
+struct ScratchData
+{
+    oskar_Mem *uu_im, *vv_im, *ww_im, *vis_im, *weight_im, *time_im;
+    oskar_Mem *uu_tmp, *vv_tmp, *ww_tmp, *weight_tmp;
+    oskar_Mem *grid; /* Full grid, if planes hold only half of it. */
+    oskar_Mem *grid_work; /* Work buffer used by the gridder. */
+};
+typedef struct ScratchData ScratchData;
+
 struct oskar_Imager
 {
     char* output_name[4];
@@ -61,27 +74,40 @@ struct oskar_Imager
     int chan_snaps, im_type, num_im_channels, num_im_pols, pol_offset;
     int algorithm, image_size, use_stokes, support, oversample;
     int generate_w_kernels_on_gpu, set_cellsize, set_fov, weighting;
-    int num_files, scale_norm_with_num_input_files;
+    int num_files, scale_norm_with_num_input_files, use_coords_index;
+    int grid_half_plane;
     char direction_type, kernel_type;
     char **input_files, *input_root, *output_root, *ms_column;
+    char *w_kernel_cache_dir;
     double cellsize_rad, fov_deg, image_padding, im_centre_deg[2];
-    double uv_filter_min, uv_filter_max;
+    double kernel_accuracy, memory_budget_gb, time_snap_interval_sec;
+    double robustness, uv_filter_min, uv_filter_max;
     double time_min_utc, time_max_utc, freq_min_hz, freq_max_hz;
 
     /* Visibility meta-data. */
-    int num_sel_freqs;
+    int num_sel_freqs, num_im_times;
     double *im_freqs, *sel_freqs;
     double vis_freq_start_hz, freq_inc_hz;
+    double vis_time_start_utc, vis_time_end_utc, im_time_start_utc;
+    size_t vis_block_rows, vis_block_chans, vis_block_bytes; /* Largest. */
 
     /* State. */
     int status, i_block;
     oskar_Mutex* mutex;
 
-    /* Scratch data. */
-    oskar_Mem *uu_im, *vv_im, *ww_im, *vis_im, *weight_im, *time_im;
-    oskar_Mem *uu_tmp, *vv_tmp, *ww_tmp, *stokes, *weight_tmp;
+    /* Scratch data (one set for each plane updated concurrently). */
+    int num_scratch;
+    ScratchData* scratch;
+    oskar_Mem *stokes;
+
+    /* Grow-only workspaces reused by every block update. */
+    oskar_Mem *block_vis, *block_weight, *block_time;
+    oskar_Mem *conv_uu, *conv_vv, *conv_ww, *conv_amp, *conv_weight;
+
     int coords_only; /* Set if doing a first pass for uniform weighting. */
+    int weights_grids_pending; /* Set if grids need Briggs conversion. */
     int num_planes; /* For each output channel and polarisation. */
+    int batch_start, batch_end; /* Range of planes in the current batch. */
     double *plane_norm, delta_l, delta_m, delta_n, M[9];
     oskar_Mem **planes, **weights_grids;
 
@@ -90,16 +116,22 @@ struct oskar_Imager
 
     /* FFT imager data. */
     int grid_size;
-    oskar_Mem *conv_func, *corr_func, *fftpack_wsave, *fftpack_work;
-#ifdef OSKAR_HAVE_CUDA
-    cufftHandle cufft_plan;
-#endif
+    oskar_Mem *conv_func, *corr_func;
+    oskar_FFT* fft;
 
     /* W-projection imager data. */
     size_t ww_points;
     int num_w_planes, conv_size_half;
     double w_scale, ww_min, ww_max, ww_rms;
     oskar_Mem *w_kernels, *w_support, *w_kernels_compact, *w_kernel_start;
+    void* w_kernel_map;
+    size_t w_kernel_map_size;
+
+    /* W-stacking and 3D NUFFT imager data. */
+    oskar_Mem *n_minus_1;
+
+    /* Prediction data. */
+    oskar_Mem *model_image, *model_grid;
 
     /* Memory allocated per GPU (array of DeviceData structures). */
     DeviceData* d;
@@ -47,9 +47,12 @@ extern "C" {
  *
  * @details
  * Filters supplied visibility data using the time range,
- * if it has been set. If not set, this function returns immediately.
+ * if it has been set. If making time snapshots, only the visibilities in
+ * the specified time interval are kept.
+ * If neither is set, this function returns immediately.
  *
  * @param[in,out] h             Handle to imager.
+ * @param[in]     im_time       Index of time snapshot to keep.
  * @param[in,out] num_vis       On input, number of supplied visibilities;
  *                              on output, number of visibilities remaining.
  * @param[in,out] uu            Baseline uu coordinates, in wavelengths.
@@ -62,8 +65,8 @@ extern "C" {
  * @param[in,out] status        Status return code.
  */
 OSKAR_EXPORT
-void oskar_imager_filter_time(const oskar_Imager* h, size_t* num_vis,
-        oskar_Mem* uu, oskar_Mem* vv, oskar_Mem* ww, oskar_Mem* amp,
+void oskar_imager_filter_time(const oskar_Imager* h, int im_time,
+        size_t* num_vis, oskar_Mem* uu, oskar_Mem* vv, oskar_Mem* ww, oskar_Mem* amp,
         oskar_Mem* weight, oskar_Mem* time_centroid, int* status);
 
 #ifdef __cplusplus
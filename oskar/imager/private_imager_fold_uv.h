@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_IMAGER_FOLD_UV_H_
+#define OSKAR_IMAGER_FOLD_UV_H_
+
+/**
+ * @file private_imager_fold_uv.h
+ */
+
+#include <oskar_global.h>
+#include <mem/oskar_mem.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Folds visibility data into one half of the UV plane.
+ *
+ * @details
+ * Replaces visibilities with negative V-coordinates by their complex
+ * conjugates at (-u, -v, -w), if only half of the UV plane is being
+ * gridded. Otherwise, this function returns immediately.
+ *
+ * The amplitudes may be NULL if only the coordinates are needed.
+ *
+ * @param[in] h              Handle to imager.
+ * @param[in] num_vis        Number of supplied visibilities.
+ * @param[in,out] uu         Baseline uu coordinates, in wavelengths.
+ * @param[in,out] vv         Baseline vv coordinates, in wavelengths.
+ * @param[in,out] ww         Baseline ww coordinates, in wavelengths.
+ * @param[in,out] amp        Baseline complex visibility amplitudes.
+ * @param[in,out] status     Status return code.
+ */
+OSKAR_EXPORT
+void oskar_imager_fold_uv(const oskar_Imager* h, size_t num_vis,
+        oskar_Mem* uu, oskar_Mem* vv, oskar_Mem* ww, oskar_Mem* amp,
+        int* status);
+
+/**
+ * @brief
+ * Returns the number of cells in a plane that holds half the UV plane.
+ *
+ * @details
+ * Returns the number of complex cells, plane_size * (plane_size / 2 + 1),
+ * in a grid that holds only the rows with V >= 0, if only half of the
+ * UV plane is being gridded. Otherwise, this function returns 0.
+ *
+ * @param[in] h              Handle to imager.
+ */
+OSKAR_EXPORT
+size_t oskar_imager_half_plane_cells(oskar_Imager* h);
+
+/**
+ * @brief
+ * Adds a full grid into a plane that holds half the UV plane.
+ *
+ * @details
+ * Adds the rows of a full complex grid with V >= 0 into the half plane.
+ * Rows with V < 0, which contain the parts of the convolution kernels that
+ * spill across the V = 0 line, are added as complex conjugates into the
+ * cells at (-u, -v). Only the real part of the image is needed, so this
+ * does not change it.
+ *
+ * The full grid is cleared, ready to be used again.
+ *
+ * @param[in] h              Handle to imager.
+ * @param[in,out] grid       Full complex grid, cleared on exit.
+ * @param[in,out] plane      Half plane to update.
+ * @param[in,out] status     Status return code.
+ */
+OSKAR_EXPORT
+void oskar_imager_fold_grid(oskar_Imager* h, oskar_Mem* grid,
+        oskar_Mem* plane, int* status);
+
+/**
+ * @brief
+ * Expands a plane that holds half the UV plane into a full grid.
+ *
+ * @details
+ * Resizes the plane in place to hold a full complex grid, with the rows
+ * with V < 0 set to zero. The real part of its transform is the image.
+ *
+ * @param[in] h              Handle to imager.
+ * @param[in,out] plane      Half plane to expand.
+ * @param[in,out] status     Status return code.
+ */
+OSKAR_EXPORT
+void oskar_imager_unfold_grid(oskar_Imager* h, oskar_Mem* plane,
+        int* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_IMAGER_FOLD_UV_H_ */
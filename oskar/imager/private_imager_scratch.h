@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_IMAGER_SCRATCH_H_
+#define OSKAR_IMAGER_SCRATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Ensures at least num_sets sets of scratch arrays exist, and resizes
+ * the first num_sets of them to hold at least num_vis elements. */
+void oskar_imager_scratch_resize(oskar_Imager* h, int num_sets,
+        size_t num_vis, int* status);
+
+/* Ensures *mem is a CPU array of the given type holding at least num
+ * elements, creating or growing it as required.
+ * Returns the length of the array before it was grown. */
+size_t oskar_imager_scratch_ensure(oskar_Mem** mem, int type,
+        size_t num, int* status);
+
+/* Returns in if it already has the imager precision; otherwise converts
+ * the first num elements into the workspace *work and returns that. */
+const oskar_Mem* oskar_imager_scratch_convert(const oskar_Imager* h,
+        const oskar_Mem* in, oskar_Mem** work, size_t num, int* status);
+
+/* Shrinks all scratch arrays to zero length and frees the workspaces. */
+void oskar_imager_scratch_collapse(oskar_Imager* h, int* status);
+
+/* Frees all sets of scratch arrays. */
+void oskar_imager_scratch_free(oskar_Imager* h, int* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_IMAGER_SCRATCH_H_ */
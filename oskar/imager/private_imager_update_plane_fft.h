@@ -39,7 +39,7 @@ extern "C" {
 void oskar_imager_update_plane_fft(oskar_Imager* h, size_t num_vis,
         const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* amps,
         const oskar_Mem* weight, oskar_Mem* plane, double* plane_norm,
-        size_t* num_skipped, int* status);
+        oskar_Mem** work, size_t* num_skipped, int* status);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/oskar_grid_functions_es.h"
+
+#include "math/oskar_cmath.h"
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of intervals used to integrate the kernel (must be even). */
+#define NUM_INTERVALS 512
+
+static void gauss_legendre(const int n, double* x, double* w);
+
+void oskar_grid_convolution_function_es(const int support,
+        const int oversample, const double beta, double* fn)
+{
+    int i, gcf_size;
+    double nu, extent;
+
+    /* The kernel extends to the edge of the outermost cells. */
+    gcf_size = oversample * (support + 1);
+    extent = (support + 0.5) * oversample;
+    for (i = 0; i < gcf_size; ++i)
+    {
+        nu = (double)i / extent;
+        fn[i] = oskar_grid_function_es(nu, beta);
+    }
+}
+
+
+void oskar_grid_correction_function_es(const int image_size,
+        const int padding_gcf, const int support, const double beta,
+        double* fn)
+{
+    int i, k, extent;
+    double inc = 0.0, norm = 0.0, *kernel;
+    const double h = 1.0 / NUM_INTERVALS;
+
+    /* Get Simpson's rule weights multiplied by the kernel. */
+    kernel = (double*) malloc((NUM_INTERVALS + 1) * sizeof(double));
+    for (k = 0; k <= NUM_INTERVALS; ++k)
+    {
+        const double w = (k == 0 || k == NUM_INTERVALS) ? 1.0 :
+                ((k % 2) ? 4.0 : 2.0);
+        kernel[k] = w * oskar_grid_function_es(k * h, beta);
+        norm += kernel[k];
+    }
+
+    /* Evaluate the Fourier transform of the kernel at each pixel,
+     * relative to its value at the centre. The kernel is real and
+     * symmetric, so only the cosine part is needed. */
+    extent = image_size / 2;
+    if (padding_gcf > 0)
+        inc = 1.0 / (image_size * padding_gcf);
+    for (i = 0; i < image_size; ++i)
+    {
+        double sinc_cor = 1.0, sum = 0.0, val;
+        const double nu = (double)(i - extent) / (double)extent;
+        const double f = M_PI * (support + 0.5) * nu;
+        for (k = 0; k <= NUM_INTERVALS; ++k)
+            sum += kernel[k] * cos(f * k * h);
+        if (padding_gcf > 0 && i != extent)
+        {
+            const double x = M_PI * (i - extent) * inc;
+            sinc_cor = sin(x) / x;
+        }
+        val = (sum / norm) * (sinc_cor * sinc_cor);
+        fn[i] = (val != 0.0) ? 1.0 / val : 1.0;
+    }
+    free(kernel);
+}
+
+
+void oskar_grid_fourier_transform_es(const int support, const double beta,
+        const int num_points, const double* freq, double* ft)
+{
+    int i, k, num_nodes;
+    double *x, *w;
+    const double extent = support + 0.5;
+
+    /* The kernel is smooth apart from its (very small) values at the
+     * edges, so a modest number of quadrature nodes is enough. */
+    num_nodes = 2 + 3 * (2 * support + 1);
+    x = (double*) malloc(num_nodes * sizeof(double));
+    w = (double*) malloc(num_nodes * sizeof(double));
+    gauss_legendre(num_nodes, x, w);
+    for (k = 0; k < num_nodes; ++k)
+        w[k] *= extent * oskar_grid_function_es(x[k], beta);
+
+    /* The kernel is real and symmetric, so only the cosine part is needed. */
+    #pragma omp parallel for private(i, k)
+    for (i = 0; i < num_points; ++i)
+    {
+        double sum = 0.0;
+        const double f = 2.0 * M_PI * extent * freq[i];
+        for (k = 0; k < num_nodes; ++k)
+            sum += w[k] * cos(f * x[k]);
+        ft[i] = sum;
+    }
+    free(x);
+    free(w);
+}
+
+
+double oskar_grid_beta_es(const int support)
+{
+    /* Suitable for a grid padded by a factor of 2
+     * (Barnett et al. 2019, SIAM J. Sci. Comput. 41, C479). */
+    return 2.3 * (2 * support + 1);
+}
+
+
+int oskar_grid_support_es(const double accuracy)
+{
+    /* The error falls by about a factor of 10 for each extra grid cell
+     * in the kernel width, which is 2 * support + 1. */
+    int width;
+    if (accuracy <= 0.0 || accuracy >= 1.0) return 1;
+    width = (int)ceil(log10(1.0 / accuracy)) + 1;
+    return (width < 3) ? 1 : width / 2;
+}
+
+
+double oskar_grid_function_es(const double nu, const double beta)
+{
+    if (nu < -1.0 || nu > 1.0) return 0.0;
+    return exp(beta * (sqrt(1.0 - nu * nu) - 1.0));
+}
+
+
+/* Nodes and weights of n-point Gauss-Legendre quadrature on [-1, 1],
+ * found using Newton's method on the Legendre polynomial. */
+void gauss_legendre(const int n, double* x, double* w)
+{
+    int i, j, iter;
+    for (i = 0; i < (n + 1) / 2; ++i)
+    {
+        double z = cos(M_PI * (i + 0.75) / (n + 0.5)), dp = 1.0;
+        for (iter = 0; iter < 100; ++iter)
+        {
+            double p0 = 1.0, p1 = 0.0, dz;
+            for (j = 0; j < n; ++j)
+            {
+                const double p2 = p1;
+                p1 = p0;
+                p0 = ((2.0 * j + 1.0) * z * p1 - j * p2) / (j + 1.0);
+            }
+            dp = n * (z * p0 - p1) / (z * z - 1.0);
+            dz = p0 / dp;
+            z -= dz;
+            if (fabs(dz) < 1e-15) break;
+        }
+        x[i] = -z;
+        x[n - 1 - i] = z;
+        w[i] = w[n - 1 - i] = 2.0 / ((1.0 - z * z) * dp * dp);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
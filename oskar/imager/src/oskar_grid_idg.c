@@ -0,0 +1,556 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/oskar_grid_idg.h"
+#include "imager/oskar_grid_functions_spheroidal.h"
+#include "imager/oskar_grid_tiles.h"
+#include "math/oskar_cmath.h"
+#include "math/oskar_fftpack_cfft.h"
+#include "math/oskar_fftpack_cfft_f.h"
+#include "math/oskar_fftphase.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Support size (half-width) of the spheroidal taper in the uv-plane. */
+#define TAPER_SUPPORT 3
+
+/* Minimum subgrid side length. */
+#define MIN_SUBGRID_SIZE 32
+
+/* Returns the subgrid size, and the margin needed around each tile to hold
+ * the taper and the W-kernel for the largest |w|. The margin is a bound on
+ * the local frequency of the W-term phase at the edge of the field. */
+static int subgrid_size(const double w_max, const double cell_size_rad,
+        const int grid_size, int* margin)
+{
+    int size;
+    double r_max, w_support;
+    r_max = sqrt(2.0) * (grid_size / 2) * fabs(cell_size_rad);
+    if (r_max > 0.99) r_max = 0.99;
+    w_support = w_max * grid_size * fabs(cell_size_rad) *
+            r_max / sqrt(1.0 - r_max * r_max);
+    *margin = TAPER_SUPPORT + 1 + (int)ceil(w_support);
+
+    /* Tiles gridded concurrently must not overlap,
+     * so the tile size must be at least twice the margin. */
+    size = 4 * (*margin);
+    if (size < MIN_SUBGRID_SIZE) size = MIN_SUBGRID_SIZE;
+    return 4 * ((size + 3) / 4);
+}
+
+/* Returns the length of the FFTPACK work array for the subgrid. */
+static int wsave_size(const int sub_size)
+{
+    return 4 * sub_size + 2 * (int)(log((double)sub_size) / log(2.0)) + 8;
+}
+
+/* Returns the size of the work buffer for the largest |w| value. */
+static size_t work_size(const double w_max, const double cell_size_rad,
+        const size_t num_points, const int grid_size,
+        const size_t element_size)
+{
+    int margin, sub_size, tile_size, num_tiles_side;
+    size_t num_cells;
+    sub_size = subgrid_size(w_max, cell_size_rad, grid_size, &margin);
+    tile_size = sub_size - 2 * margin;
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_cells = (size_t)sub_size * sub_size;
+    return oskar_grid_tiles_work_size(num_points,
+            num_tiles_side * num_tiles_side, sub_size, 2, element_size) +
+            (2 * num_cells + wsave_size(sub_size)) * element_size;
+}
+
+size_t oskar_grid_idg_work_size_d(const size_t num_points,
+        const double* restrict ww, const double cell_size_rad,
+        const int grid_size)
+{
+    size_t i;
+    double w_max = 0.0;
+    for (i = 0; i < num_points; ++i)
+        if (fabs(ww[i]) > w_max) w_max = fabs(ww[i]);
+    return work_size(w_max, cell_size_rad, num_points, grid_size,
+            sizeof(double));
+}
+
+size_t oskar_grid_idg_work_size_f(const size_t num_points,
+        const float* restrict ww, const float cell_size_rad,
+        const int grid_size)
+{
+    size_t i;
+    double w_max = 0.0;
+    for (i = 0; i < num_points; ++i)
+        if (fabs(ww[i]) > w_max) w_max = fabs(ww[i]);
+    return work_size(w_max, cell_size_rad, num_points, grid_size,
+            sizeof(float));
+}
+
+/* Evaluate the separable spheroidal taper and n - 1 at each pixel of the
+ * subgrid image, which covers the whole field of view at low resolution.
+ * The taper is zero for pixels beyond the horizon. */
+static void subgrid_image_d(const int sub_size, const int grid_size,
+        const double cell_size_rad, double* restrict taper,
+        double* restrict n_minus_1)
+{
+    int j, k;
+    const int sub_half = sub_size / 2;
+    const double sampling = cell_size_rad * grid_size / sub_size;
+    for (k = 0; k < sub_size; ++k)
+    {
+        const double m = sampling * (k - sub_half);
+        const double taper_v = oskar_grid_function_spheroidal(
+                fabs((double)(k - sub_half) / sub_half));
+        for (j = 0; j < sub_size; ++j)
+        {
+            const int p = k * sub_size + j;
+            const double l = sampling * (j - sub_half);
+            const double r2 = l*l + m*m;
+            if (r2 < 1.0)
+            {
+                taper[p] = taper_v * oskar_grid_function_spheroidal(
+                        fabs((double)(j - sub_half) / sub_half));
+                n_minus_1[p] = sqrt(1.0 - r2) - 1.0;
+            }
+            else
+            {
+                taper[p] = 0.0;
+                n_minus_1[p] = 0.0;
+            }
+        }
+    }
+}
+
+/* Evaluate the separable spheroidal taper and n - 1 at each pixel of the
+ * subgrid image, which covers the whole field of view at low resolution.
+ * The taper is zero for pixels beyond the horizon. */
+static void subgrid_image_f(const int sub_size, const int grid_size,
+        const float cell_size_rad, float* restrict taper,
+        float* restrict n_minus_1)
+{
+    int j, k;
+    const int sub_half = sub_size / 2;
+    const float sampling = cell_size_rad * grid_size / sub_size;
+    for (k = 0; k < sub_size; ++k)
+    {
+        const float m = sampling * (k - sub_half);
+        const float taper_v = oskar_grid_function_spheroidal(
+                fabs((double)(k - sub_half) / sub_half));
+        for (j = 0; j < sub_size; ++j)
+        {
+            const int p = k * sub_size + j;
+            const float l = sampling * (j - sub_half);
+            const float r2 = l*l + m*m;
+            if (r2 < 1.0f)
+            {
+                taper[p] = taper_v * oskar_grid_function_spheroidal(
+                        fabs((double)(j - sub_half) / sub_half));
+                n_minus_1[p] = sqrtf(1.0f - r2) - 1.0f;
+            }
+            else
+            {
+                taper[p] = 0.0f;
+                n_minus_1[p] = 0.0f;
+            }
+        }
+    }
+}
+
+/* Grid the visibilities in one tile using image-domain gridding:
+ * sum the visibilities in the image domain of a small subgrid, apply the
+ * taper, and transform back to the uv-plane. */
+static void grid_tile_idg_d(
+        const size_t num_points,
+        const size_t* restrict indices,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict ww,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double grid_scale,
+        const double centre_u,
+        const double centre_v,
+        const int sub_size,
+        const double* restrict taper,
+        const double* restrict n_minus_1,
+        double* restrict wsave,
+        double* restrict work,
+        double* restrict subgrid)
+{
+    size_t n;
+    int j, k;
+    const int sub_half = sub_size / 2;
+    const int num_cells = sub_size * sub_size;
+    const double inv_size = 1.0 / sub_size;
+
+    /* Loop over visibilities in the tile. */
+    memset(subgrid, 0, 2 * sizeof(double) * num_cells);
+    for (n = 0; n < num_points; ++n)
+    {
+        const size_t i = indices[n];
+
+        /* Offset of visibility from subgrid centre, as a fraction of
+         * the subgrid size. */
+        const double du = (-uu[i] * grid_scale - centre_u) * inv_size;
+        const double dv = (vv[i] * grid_scale - centre_v) * inv_size;
+        const double w = ww[i];
+
+        /* Get visibility data. */
+        const double weight_i = weight[i];
+        const double v_re = weight_i * vis[2 * i];
+        const double v_im = weight_i * vis[2 * i + 1];
+
+        /* Add the visibility to each pixel of the subgrid image. */
+        for (k = 0; k < sub_size; ++k)
+        {
+            const double phase_v = dv * (k - sub_half);
+            const int row = k * sub_size;
+            for (j = 0; j < sub_size; ++j)
+            {
+                double phase, phase_re, phase_im;
+                const int p = row + j;
+                if (taper[p] == 0.0) continue;
+                phase = -2.0 * M_PI * (w * n_minus_1[p] +
+                        du * (j - sub_half) + phase_v);
+                phase_re = cos(phase);
+                phase_im = sin(phase);
+                subgrid[2 * p]     += v_re * phase_re - v_im * phase_im;
+                subgrid[2 * p + 1] += v_im * phase_re + v_re * phase_im;
+            }
+        }
+    }
+
+    /* Apply the taper and transform the subgrid to the uv-plane. */
+    for (j = 0; j < num_cells; ++j)
+    {
+        subgrid[2 * j]     *= taper[j] * inv_size * inv_size;
+        subgrid[2 * j + 1] *= taper[j] * inv_size * inv_size;
+    }
+    oskar_fftphase_cd(sub_size, sub_size, subgrid);
+    oskar_fftpack_cfft2b(sub_size, sub_size, sub_size, subgrid, wsave, work);
+    oskar_fftphase_cd(sub_size, sub_size, subgrid);
+}
+
+void oskar_grid_idg_d(
+        const size_t num_points,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict ww,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const int grid_size,
+        void* restrict work,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        double* restrict grid)
+{
+    int c, margin, tile_size, num_tiles_side, num_tiles, sub_size;
+    int num_threads;
+    int* tile_index;
+    size_t i, num_cells, *tile_start, *sorted;
+    double *tile_norm, *subgrids, *taper, *n_minus_1, *wsave, w_max = 0.0;
+    const int grid_centre = grid_size / 2;
+    const double grid_scale = grid_size * cell_size_rad;
+
+    /* Get the subgrid size from the maximum W-kernel support. */
+    for (i = 0; i < num_points; ++i)
+        if (fabs(ww[i]) > w_max) w_max = fabs(ww[i]);
+    sub_size = subgrid_size(w_max, cell_size_rad, grid_size, &margin);
+    tile_size = sub_size - 2 * margin;
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_tiles = num_tiles_side * num_tiles_side;
+    num_cells = (size_t)sub_size * sub_size;
+
+    /* Get the arrays from the work buffer. Each thread uses a subgrid
+     * and an FFT work array, followed by the arrays for all threads. */
+    num_threads = oskar_grid_tiles_num_threads();
+    subgrids = (double*) oskar_grid_tiles_work_split(work, num_points,
+            num_tiles, &tile_index, &tile_start, &sorted, &tile_norm);
+    taper = subgrids + 4 * num_cells * num_threads;
+    n_minus_1 = taper + num_cells;
+    wsave = n_minus_1 + num_cells;
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        const int grid_u = (int)round(-uu[i] * grid_scale) + grid_centre;
+        const int grid_v = (int)round(vv[i] * grid_scale) + grid_centre;
+        if (grid_u + margin >= grid_size || grid_u - margin < 0 ||
+                grid_v + margin >= grid_size || grid_v - margin < 0)
+            tile_index[i] = -1;
+        else
+            tile_index[i] = (grid_v / tile_size) * num_tiles_side +
+                    grid_u / tile_size;
+    }
+
+    /* Sort visibilities by tile. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Evaluate the taper and the W-term in the subgrid image domain. */
+    subgrid_image_d(sub_size, grid_size, cell_size_rad, taper, n_minus_1);
+    oskar_fftpack_cfft2i(sub_size, sub_size, wsave);
+
+    /* Grid tiles in four passes, so that tiles gridded concurrently
+     * never overlap, and the order of summation is always the same. */
+    for (c = 0; c < 4; ++c)
+    {
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int t;
+            double *subgrid = subgrids, *fft_work;
+#ifdef _OPENMP
+            subgrid += 4 * num_cells * omp_get_thread_num();
+#endif
+            fft_work = subgrid + 2 * num_cells;
+            #pragma omp for schedule(dynamic)
+            for (t = 0; t < num_tiles; ++t)
+            {
+                const size_t* indices = sorted + tile_start[t];
+                const size_t num = tile_start[t + 1] - tile_start[t];
+                const int tile_u = t % num_tiles_side;
+                const int tile_v = t / num_tiles_side;
+                const int origin_u = tile_u * tile_size - margin;
+                const int origin_v = tile_v * tile_size - margin;
+                if ((tile_u & 1) + 2 * (tile_v & 1) != c || num == 0)
+                    continue;
+                grid_tile_idg_d(num, indices, uu, vv, ww, vis, weight,
+                        grid_scale, origin_u + sub_size / 2 - grid_centre,
+                        origin_v + sub_size / 2 - grid_centre, sub_size,
+                        taper, n_minus_1, wsave, fft_work, subgrid);
+                oskar_grid_tiles_add_d(sub_size, origin_u, origin_v,
+                        subgrid, grid_size, grid);
+            }
+        }
+    }
+
+    /* The sum of each gridded kernel is the taper at the phase centre,
+     * which is 1. */
+    for (i = 0; i < (size_t)num_tiles; ++i)
+    {
+        size_t n;
+        for (n = tile_start[i]; n < tile_start[i + 1]; ++n)
+            *norm += weight[sorted[n]];
+    }
+}
+
+
+/* Grid the visibilities in one tile using image-domain gridding:
+ * sum the visibilities in the image domain of a small subgrid, apply the
+ * taper, and transform back to the uv-plane. */
+static void grid_tile_idg_f(
+        const size_t num_points,
+        const size_t* restrict indices,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict ww,
+        const float* restrict vis,
+        const float* restrict weight,
+        const float grid_scale,
+        const float centre_u,
+        const float centre_v,
+        const int sub_size,
+        const float* restrict taper,
+        const float* restrict n_minus_1,
+        float* restrict wsave,
+        float* restrict work,
+        float* restrict subgrid)
+{
+    size_t n;
+    int j, k;
+    const int sub_half = sub_size / 2;
+    const int num_cells = sub_size * sub_size;
+    const float inv_size = 1.0f / sub_size;
+
+    /* Loop over visibilities in the tile. */
+    memset(subgrid, 0, 2 * sizeof(float) * num_cells);
+    for (n = 0; n < num_points; ++n)
+    {
+        const size_t i = indices[n];
+
+        /* Offset of visibility from subgrid centre, as a fraction of
+         * the subgrid size. */
+        const float du = (-uu[i] * grid_scale - centre_u) * inv_size;
+        const float dv = (vv[i] * grid_scale - centre_v) * inv_size;
+        const float w = ww[i];
+
+        /* Get visibility data. */
+        const float weight_i = weight[i];
+        const float v_re = weight_i * vis[2 * i];
+        const float v_im = weight_i * vis[2 * i + 1];
+
+        /* Add the visibility to each pixel of the subgrid image. */
+        for (k = 0; k < sub_size; ++k)
+        {
+            const float phase_v = dv * (k - sub_half);
+            const int row = k * sub_size;
+            for (j = 0; j < sub_size; ++j)
+            {
+                float phase, phase_re, phase_im;
+                const int p = row + j;
+                if (taper[p] == 0.0f) continue;
+                phase = -2.0f * (float)M_PI * (w * n_minus_1[p] +
+                        du * (j - sub_half) + phase_v);
+                phase_re = cosf(phase);
+                phase_im = sinf(phase);
+                subgrid[2 * p]     += v_re * phase_re - v_im * phase_im;
+                subgrid[2 * p + 1] += v_im * phase_re + v_re * phase_im;
+            }
+        }
+    }
+
+    /* Apply the taper and transform the subgrid to the uv-plane. */
+    for (j = 0; j < num_cells; ++j)
+    {
+        subgrid[2 * j]     *= taper[j] * inv_size * inv_size;
+        subgrid[2 * j + 1] *= taper[j] * inv_size * inv_size;
+    }
+    oskar_fftphase_cf(sub_size, sub_size, subgrid);
+    oskar_fftpack_cfft2b_f(sub_size, sub_size, sub_size, subgrid, wsave, work);
+    oskar_fftphase_cf(sub_size, sub_size, subgrid);
+}
+
+void oskar_grid_idg_f(
+        const size_t num_points,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict ww,
+        const float* restrict vis,
+        const float* restrict weight,
+        const float cell_size_rad,
+        const int grid_size,
+        void* restrict work,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        float* restrict grid)
+{
+    int c, margin, tile_size, num_tiles_side, num_tiles, sub_size;
+    int num_threads;
+    int* tile_index;
+    size_t i, num_cells, *tile_start, *sorted;
+    float *subgrids, *taper, *n_minus_1, *wsave;
+    double *tile_norm, w_max = 0.0;
+    const int grid_centre = grid_size / 2;
+    const float grid_scale = grid_size * cell_size_rad;
+
+    /* Get the subgrid size from the maximum W-kernel support. */
+    for (i = 0; i < num_points; ++i)
+        if (fabs(ww[i]) > w_max) w_max = fabs(ww[i]);
+    sub_size = subgrid_size(w_max, cell_size_rad, grid_size, &margin);
+    tile_size = sub_size - 2 * margin;
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_tiles = num_tiles_side * num_tiles_side;
+    num_cells = (size_t)sub_size * sub_size;
+
+    /* Get the arrays from the work buffer. Each thread uses a subgrid
+     * and an FFT work array, followed by the arrays for all threads. */
+    num_threads = oskar_grid_tiles_num_threads();
+    subgrids = (float*) oskar_grid_tiles_work_split(work, num_points,
+            num_tiles, &tile_index, &tile_start, &sorted, &tile_norm);
+    taper = subgrids + 4 * num_cells * num_threads;
+    n_minus_1 = taper + num_cells;
+    wsave = n_minus_1 + num_cells;
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        const int grid_u = (int)round(-uu[i] * grid_scale) + grid_centre;
+        const int grid_v = (int)round(vv[i] * grid_scale) + grid_centre;
+        if (grid_u + margin >= grid_size || grid_u - margin < 0 ||
+                grid_v + margin >= grid_size || grid_v - margin < 0)
+            tile_index[i] = -1;
+        else
+            tile_index[i] = (grid_v / tile_size) * num_tiles_side +
+                    grid_u / tile_size;
+    }
+
+    /* Sort visibilities by tile. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Evaluate the taper and the W-term in the subgrid image domain. */
+    subgrid_image_f(sub_size, grid_size, cell_size_rad, taper, n_minus_1);
+    oskar_fftpack_cfft2i_f(sub_size, sub_size, wsave);
+
+    /* Grid tiles in four passes, so that tiles gridded concurrently
+     * never overlap, and the order of summation is always the same. */
+    for (c = 0; c < 4; ++c)
+    {
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int t;
+            float *subgrid = subgrids, *fft_work;
+#ifdef _OPENMP
+            subgrid += 4 * num_cells * omp_get_thread_num();
+#endif
+            fft_work = subgrid + 2 * num_cells;
+            #pragma omp for schedule(dynamic)
+            for (t = 0; t < num_tiles; ++t)
+            {
+                const size_t* indices = sorted + tile_start[t];
+                const size_t num = tile_start[t + 1] - tile_start[t];
+                const int tile_u = t % num_tiles_side;
+                const int tile_v = t / num_tiles_side;
+                const int origin_u = tile_u * tile_size - margin;
+                const int origin_v = tile_v * tile_size - margin;
+                if ((tile_u & 1) + 2 * (tile_v & 1) != c || num == 0)
+                    continue;
+                grid_tile_idg_f(num, indices, uu, vv, ww, vis, weight,
+                        grid_scale, origin_u + sub_size / 2 - grid_centre,
+                        origin_v + sub_size / 2 - grid_centre, sub_size,
+                        taper, n_minus_1, wsave, fft_work, subgrid);
+                oskar_grid_tiles_add_f(sub_size, origin_u, origin_v,
+                        subgrid, grid_size, grid);
+            }
+        }
+    }
+
+    /* The sum of each gridded kernel is the taper at the phase centre,
+     * which is 1. */
+    for (i = 0; i < (size_t)num_tiles; ++i)
+    {
+        size_t n;
+        for (n = tile_start[i]; n < tile_start[i + 1]; ++n)
+            *norm += weight[sorted[n]];
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "imager/oskar_grid_nufft.h"
+#include "imager/oskar_grid_functions_es.h"
+#include "imager/oskar_grid_tiles.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Spread the visibilities in one tile directly onto the grid using the
+ * exactly-evaluated kernel, and return the sum of their weights. */
+static double grid_tile_nufft_d(
+        const int support,
+        const double beta,
+        const size_t num_points,
+        const size_t* restrict indices,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict ww,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const double w_scale,
+        const int grid_size,
+        double* restrict grid)
+{
+    size_t n;
+    double norm = 0.0, *ku, *kv, *kw;
+    const int width = 2 * support + 1;
+    const int grid_centre = grid_size / 2;
+    const double grid_scale = grid_size * cell_size_rad;
+    const double inv_extent = 1.0 / (support + 0.5);
+    const size_t num_cells = (size_t)grid_size * grid_size;
+    ku = (double*) malloc(3 * width * sizeof(double));
+    kv = ku + width;
+    kw = kv + width;
+    kw[support] = 1.0;
+
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
+    {
+        int j, k, l, w_support = 0, grid_w = 0;
+        const size_t i = indices[n];
+
+        /* Visibilities with negative W are replaced by their complex
+         * conjugate at (-u, -v, -w). */
+        const double f = (ww && ww[i] < 0) ? -1.0 : 1.0;
+
+        /* Convert UVW coordinates to grid coordinates. */
+        const double pos_u = -f * uu[i] * grid_scale;
+        const double pos_v = f * vv[i] * grid_scale;
+        const int grid_u = (int)round(pos_u);
+        const int grid_v = (int)round(pos_v);
+
+        /* Get visibility data. */
+        const double weight_i = weight[i];
+        const double v_re = weight_i * vis[2 * i];
+        const double v_im = f * weight_i * vis[2 * i + 1];
+
+        /* Evaluate the kernel at each grid cell it covers. */
+        for (j = -support; j <= support; ++j)
+        {
+            ku[j + support] = oskar_grid_function_es(
+                    (grid_u + j - pos_u) * inv_extent, beta);
+            kv[j + support] = oskar_grid_function_es(
+                    (grid_v + j - pos_v) * inv_extent, beta);
+        }
+        if (ww)
+        {
+            const double pos_w = fabs(ww[i]) * w_scale + support;
+            grid_w = (int)round(pos_w);
+            w_support = support;
+            for (j = -support; j <= support; ++j)
+                kw[j + support] = oskar_grid_function_es(
+                        (grid_w + j - pos_w) * inv_extent, beta);
+        }
+
+        /* Convolve this point onto the grid. */
+        for (l = -w_support; l <= w_support; ++l)
+        {
+            const double c2 = kw[l + support];
+            double* restrict plane = grid + 2 * (grid_w + l) * num_cells;
+            for (j = -support; j <= support; ++j)
+            {
+                size_t p1;
+                const double c1 = kv[j + support] * c2;
+                p1 = grid_v + j + grid_centre;
+                p1 *= grid_size;
+                p1 += grid_u + grid_centre;
+                for (k = -support; k <= support; ++k)
+                {
+                    const size_t p = (p1 + k) << 1;
+                    const double c = ku[k + support] * c1;
+                    plane[p]     += (double) (v_re * c);
+                    plane[p + 1] += (double) (v_im * c);
+                }
+            }
+        }
+        norm += weight_i;
+    }
+    free(ku);
+    return norm;
+}
+
+void oskar_grid_nufft_d(
+        const int support,
+        const double beta,
+        const int num_w_planes,
+        const size_t num_points,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict ww,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const double w_scale,
+        const int grid_size,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        double* restrict grid)
+{
+    int c, tile_size, num_tiles_side, num_tiles, num_slabs, num_colours;
+    int* tile_index;
+    size_t i, *tile_start, *sorted;
+    double* tile_norm;
+    const int grid_centre = grid_size / 2;
+    const int slab_depth = 2 * support;
+    const double grid_scale = grid_size * cell_size_rad;
+
+    /* Get the tile size. In 3D, the W-planes are also divided into
+     * slabs, each twice the kernel support deep. */
+    tile_size = oskar_grid_tile_size(support);
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_slabs = ww ? (num_w_planes + slab_depth - 1) / slab_depth : 1;
+    num_tiles = num_tiles_side * num_tiles_side * num_slabs;
+    num_colours = ww ? 8 : 4;
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    tile_index = (int*) malloc(num_points * sizeof(int));
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        int slab = 0;
+        const double f = (ww && ww[i] < 0) ? -1.0 : 1.0;
+        const int grid_u = (int)round(-f * uu[i] * grid_scale) + grid_centre;
+        const int grid_v = (int)round(f * vv[i] * grid_scale) + grid_centre;
+        tile_index[i] = -1;
+        if (ww)
+        {
+            const int grid_w = (int)round(fabs(ww[i]) * w_scale + support);
+            if (grid_w + support >= num_w_planes) continue;
+            slab = grid_w / slab_depth;
+        }
+        if (grid_u + support >= grid_size || grid_u - support < 0 ||
+                grid_v + support >= grid_size || grid_v - support < 0)
+            continue;
+        tile_index[i] = (slab * num_tiles_side + grid_v / tile_size) *
+                num_tiles_side + grid_u / tile_size;
+    }
+
+    /* Sort visibilities by tile. */
+    tile_start = (size_t*) malloc((num_tiles + 1) * sizeof(size_t));
+    sorted = (size_t*) malloc((num_points + 1) * sizeof(size_t));
+    tile_norm = (double*) calloc(num_tiles, sizeof(double));
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Grid tiles in four (or, in 3D, eight) passes, so that tiles gridded
+     * concurrently never overlap, and the order of summation is always
+     * the same. This allows them to be gridded without subgrids. */
+    for (c = 0; c < num_colours; ++c)
+    {
+        int t;
+        #pragma omp parallel for schedule(dynamic)
+        for (t = 0; t < num_tiles; ++t)
+        {
+            const size_t* indices = sorted + tile_start[t];
+            const size_t num = tile_start[t + 1] - tile_start[t];
+            const int tile_u = t % num_tiles_side;
+            const int tile_v = (t / num_tiles_side) % num_tiles_side;
+            const int slab = t / (num_tiles_side * num_tiles_side);
+            if ((tile_u & 1) + 2 * (tile_v & 1) + 4 * (slab & 1) != c ||
+                    num == 0)
+                continue;
+            tile_norm[t] = grid_tile_nufft_d(support, beta, num, indices,
+                    uu, vv, ww, vis, weight, cell_size_rad, w_scale,
+                    grid_size, grid);
+        }
+    }
+
+    /* Sum the normalisation factors in tile order. */
+    for (i = 0; i < (size_t)num_tiles; ++i) *norm += tile_norm[i];
+    free(tile_index);
+    free(tile_start);
+    free(sorted);
+    free(tile_norm);
+}
+
+/* Spread the visibilities in one tile directly onto the grid using the
+ * exactly-evaluated kernel, and return the sum of their weights. */
+static double grid_tile_nufft_f(
+        const int support,
+        const double beta,
+        const size_t num_points,
+        const size_t* restrict indices,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict ww,
+        const float* restrict vis,
+        const float* restrict weight,
+        const double cell_size_rad,
+        const double w_scale,
+        const int grid_size,
+        float* restrict grid)
+{
+    size_t n;
+    double norm = 0.0, *ku, *kv, *kw;
+    const int width = 2 * support + 1;
+    const int grid_centre = grid_size / 2;
+    const double grid_scale = grid_size * cell_size_rad;
+    const double inv_extent = 1.0 / (support + 0.5);
+    const size_t num_cells = (size_t)grid_size * grid_size;
+    ku = (double*) malloc(3 * width * sizeof(double));
+    kv = ku + width;
+    kw = kv + width;
+    kw[support] = 1.0;
+
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
+    {
+        int j, k, l, w_support = 0, grid_w = 0;
+        const size_t i = indices[n];
+
+        /* Visibilities with negative W are replaced by their complex
+         * conjugate at (-u, -v, -w). */
+        const double f = (ww && ww[i] < 0) ? -1.0 : 1.0;
+
+        /* Convert UVW coordinates to grid coordinates. */
+        const double pos_u = -f * uu[i] * grid_scale;
+        const double pos_v = f * vv[i] * grid_scale;
+        const int grid_u = (int)round(pos_u);
+        const int grid_v = (int)round(pos_v);
+
+        /* Get visibility data. */
+        const double weight_i = weight[i];
+        const double v_re = weight_i * vis[2 * i];
+        const double v_im = f * weight_i * vis[2 * i + 1];
+
+        /* Evaluate the kernel at each grid cell it covers. */
+        for (j = -support; j <= support; ++j)
+        {
+            ku[j + support] = oskar_grid_function_es(
+                    (grid_u + j - pos_u) * inv_extent, beta);
+            kv[j + support] = oskar_grid_function_es(
+                    (grid_v + j - pos_v) * inv_extent, beta);
+        }
+        if (ww)
+        {
+            const double pos_w = fabs(ww[i]) * w_scale + support;
+            grid_w = (int)round(pos_w);
+            w_support = support;
+            for (j = -support; j <= support; ++j)
+                kw[j + support] = oskar_grid_function_es(
+                        (grid_w + j - pos_w) * inv_extent, beta);
+        }
+
+        /* Convolve this point onto the grid. */
+        for (l = -w_support; l <= w_support; ++l)
+        {
+            const double c2 = kw[l + support];
+            float* restrict plane = grid + 2 * (grid_w + l) * num_cells;
+            for (j = -support; j <= support; ++j)
+            {
+                size_t p1;
+                const double c1 = kv[j + support] * c2;
+                p1 = grid_v + j + grid_centre;
+                p1 *= grid_size;
+                p1 += grid_u + grid_centre;
+                for (k = -support; k <= support; ++k)
+                {
+                    const size_t p = (p1 + k) << 1;
+                    const double c = ku[k + support] * c1;
+                    plane[p]     += (float) (v_re * c);
+                    plane[p + 1] += (float) (v_im * c);
+                }
+            }
+        }
+        norm += weight_i;
+    }
+    free(ku);
+    return norm;
+}
+
+void oskar_grid_nufft_f(
+        const int support,
+        const double beta,
+        const int num_w_planes,
+        const size_t num_points,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict ww,
+        const float* restrict vis,
+        const float* restrict weight,
+        const double cell_size_rad,
+        const double w_scale,
+        const int grid_size,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        float* restrict grid)
+{
+    int c, tile_size, num_tiles_side, num_tiles, num_slabs, num_colours;
+    int* tile_index;
+    size_t i, *tile_start, *sorted;
+    double* tile_norm;
+    const int grid_centre = grid_size / 2;
+    const int slab_depth = 2 * support;
+    const double grid_scale = grid_size * cell_size_rad;
+
+    /* Get the tile size. In 3D, the W-planes are also divided into
+     * slabs, each twice the kernel support deep. */
+    tile_size = oskar_grid_tile_size(support);
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_slabs = ww ? (num_w_planes + slab_depth - 1) / slab_depth : 1;
+    num_tiles = num_tiles_side * num_tiles_side * num_slabs;
+    num_colours = ww ? 8 : 4;
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    tile_index = (int*) malloc(num_points * sizeof(int));
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        int slab = 0;
+        const double f = (ww && ww[i] < 0) ? -1.0 : 1.0;
+        const int grid_u = (int)round(-f * uu[i] * grid_scale) + grid_centre;
+        const int grid_v = (int)round(f * vv[i] * grid_scale) + grid_centre;
+        tile_index[i] = -1;
+        if (ww)
+        {
+            const int grid_w = (int)round(fabs(ww[i]) * w_scale + support);
+            if (grid_w + support >= num_w_planes) continue;
+            slab = grid_w / slab_depth;
+        }
+        if (grid_u + support >= grid_size || grid_u - support < 0 ||
+                grid_v + support >= grid_size || grid_v - support < 0)
+            continue;
+        tile_index[i] = (slab * num_tiles_side + grid_v / tile_size) *
+                num_tiles_side + grid_u / tile_size;
+    }
+
+    /* Sort visibilities by tile. */
+    tile_start = (size_t*) malloc((num_tiles + 1) * sizeof(size_t));
+    sorted = (size_t*) malloc((num_points + 1) * sizeof(size_t));
+    tile_norm = (double*) calloc(num_tiles, sizeof(double));
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Grid tiles in four (or, in 3D, eight) passes, so that tiles gridded
+     * concurrently never overlap, and the order of summation is always
+     * the same. This allows them to be gridded without subgrids. */
+    for (c = 0; c < num_colours; ++c)
+    {
+        int t;
+        #pragma omp parallel for schedule(dynamic)
+        for (t = 0; t < num_tiles; ++t)
+        {
+            const size_t* indices = sorted + tile_start[t];
+            const size_t num = tile_start[t + 1] - tile_start[t];
+            const int tile_u = t % num_tiles_side;
+            const int tile_v = (t / num_tiles_side) % num_tiles_side;
+            const int slab = t / (num_tiles_side * num_tiles_side);
+            if ((tile_u & 1) + 2 * (tile_v & 1) + 4 * (slab & 1) != c ||
+                    num == 0)
+                continue;
+            tile_norm[t] = grid_tile_nufft_f(support, beta, num, indices,
+                    uu, vv, ww, vis, weight, cell_size_rad, w_scale,
+                    grid_size, grid);
+        }
+    }
+
+    /* Sum the normalisation factors in tile order. */
+    for (i = 0; i < (size_t)num_tiles; ++i) *norm += tile_norm[i];
+    free(tile_index);
+    free(tile_start);
+    free(sorted);
+    free(tile_norm);
+}
+
+#ifdef __cplusplus
+}
+#endif
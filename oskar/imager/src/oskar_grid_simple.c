@@ -27,8 +27,14 @@
  */
 
 #include "imager/oskar_grid_simple.h"
+#include "imager/oskar_grid_tiles.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,35 +43,40 @@ extern "C" {
 #define D_SUPPORT 3
 #define D_OVERSAMPLE 100
 
-static void oskar_grid_simple_default_d(
+/* Grid the visibilities in one tile into a subgrid, and return the
+ * normalisation factor for the tile. */
+static double grid_tile_simple_default_d(
         const double* restrict conv_func,
         const size_t num_points,
+        const size_t* restrict indices,
         const double* restrict uu,
         const double* restrict vv,
         const double* restrict vis,
         const double* restrict weight,
         const double cell_size_rad,
         const int grid_size,
-        size_t* restrict num_skipped,
-        double* restrict norm,
-        double* restrict grid)
+        const int origin_u,
+        const int origin_v,
+        const int sub_size,
+        double* restrict subgrid)
 {
-    size_t i;
+    size_t n;
+    double norm = 0.0;
     const int grid_centre = grid_size / 2;
     const double grid_scale = grid_size * cell_size_rad;
 
-    /* Loop over visibilities. */
-    *num_skipped = 0;
-    for (i = 0; i < num_points; ++i)
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
     {
         double sum = 0.0;
         int j, k;
+        const size_t i = indices[n];
 
-        /* Convert UV coordinates to grid coordinates. */
+        /* Convert UV coordinates to subgrid coordinates. */
         const double pos_u = -uu[i] * grid_scale;
         const double pos_v = vv[i] * grid_scale;
-        const int grid_u = (int)round(pos_u) + grid_centre;
-        const int grid_v = (int)round(pos_v) + grid_centre;
+        const int grid_u = (int)round(pos_u) + grid_centre - origin_u;
+        const int grid_v = (int)round(pos_v) + grid_centre - origin_v;
 
         /* Get visibility data. */
         const double weight_i = weight[i];
@@ -76,65 +87,127 @@ static void oskar_grid_simple_default_d(
         const int off_u = (int)round((round(pos_u) - pos_u) * D_OVERSAMPLE);
         const int off_v = (int)round((round(pos_v) - pos_v) * D_OVERSAMPLE);
 
-        /* Catch points that would lie outside the grid. */
-        if (grid_u + D_SUPPORT >= grid_size || grid_u - D_SUPPORT < 0 ||
-                grid_v + D_SUPPORT >= grid_size || grid_v - D_SUPPORT < 0)
-        {
-            *num_skipped += 1;
-            continue;
-        }
-
-        /* Convolve this point onto the grid. */
+        /* Convolve this point onto the subgrid. */
         for (j = -D_SUPPORT; j <= D_SUPPORT; ++j)
         {
             size_t p1;
             const double c1 = conv_func[abs(off_v + j * D_OVERSAMPLE)];
             p1 = grid_v + j;
-            p1 *= grid_size; /* Tested to avoid int overflow. */
+            p1 *= sub_size;
             p1 += grid_u;
             for (k = -D_SUPPORT; k <= D_SUPPORT; ++k)
             {
                 const size_t p = (p1 + k) << 1;
                 const double c = conv_func[abs(off_u + k * D_OVERSAMPLE)] * c1;
-                grid[p]     += v_re * c;
-                grid[p + 1] += v_im * c;
+                subgrid[p]     += v_re * c;
+                subgrid[p + 1] += v_im * c;
                 sum += c;
             }
         }
-        *norm += sum * weight_i;
+        norm += sum * weight_i;
     }
+    return norm;
 }
 
 
-static void oskar_grid_simple_default_f(
+static double grid_tile_simple_d(
+        const int support,
+        const int oversample,
+        const double* restrict conv_func,
+        const size_t num_points,
+        const size_t* restrict indices,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const int grid_size,
+        const int origin_u,
+        const int origin_v,
+        const int sub_size,
+        double* restrict subgrid)
+{
+    size_t n;
+    double norm = 0.0;
+    const int grid_centre = grid_size / 2;
+    const double grid_scale = grid_size * cell_size_rad;
+
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
+    {
+        double sum = 0.0;
+        int j, k;
+        const size_t i = indices[n];
+
+        /* Convert UV coordinates to subgrid coordinates. */
+        const double pos_u = -uu[i] * grid_scale;
+        const double pos_v = vv[i] * grid_scale;
+        const int grid_u = (int)round(pos_u) + grid_centre - origin_u;
+        const int grid_v = (int)round(pos_v) + grid_centre - origin_v;
+
+        /* Get visibility data. */
+        const double weight_i = weight[i];
+        const double v_re = weight_i * vis[2 * i];
+        const double v_im = weight_i * vis[2 * i + 1];
+
+        /* Scaled distance from nearest grid point. */
+        const int off_u = (int)round((round(pos_u) - pos_u) * oversample);
+        const int off_v = (int)round((round(pos_v) - pos_v) * oversample);
+
+        /* Convolve this point onto the subgrid. */
+        for (j = -support; j <= support; ++j)
+        {
+            size_t p1;
+            const double c1 = conv_func[abs(off_v + j * oversample)];
+            p1 = grid_v + j;
+            p1 *= sub_size;
+            p1 += grid_u;
+            for (k = -support; k <= support; ++k)
+            {
+                const size_t p = (p1 + k) << 1;
+                const double c = conv_func[abs(off_u + k * oversample)] * c1;
+                subgrid[p]     += v_re * c;
+                subgrid[p + 1] += v_im * c;
+                sum += c;
+            }
+        }
+        norm += sum * weight_i;
+    }
+    return norm;
+}
+
+static double grid_tile_simple_default_f(
         const float* restrict conv_func,
         const size_t num_points,
+        const size_t* restrict indices,
         const float* restrict uu,
         const float* restrict vv,
         const float* restrict vis,
         const float* restrict weight,
         const float cell_size_rad,
         const int grid_size,
-        size_t* restrict num_skipped,
-        double* restrict norm,
-        float* restrict grid)
+        const int origin_u,
+        const int origin_v,
+        const int sub_size,
+        float* restrict subgrid)
 {
-    size_t i;
+    size_t n;
+    double norm = 0.0;
     const int grid_centre = grid_size / 2;
     const float grid_scale = grid_size * cell_size_rad;
 
-    /* Loop over visibilities. */
-    *num_skipped = 0;
-    for (i = 0; i < num_points; ++i)
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
     {
         double sum = 0.0;
         int j, k;
+        const size_t i = indices[n];
 
-        /* Convert UV coordinates to grid coordinates. */
+        /* Convert UV coordinates to subgrid coordinates. */
         const float pos_u = -uu[i] * grid_scale;
         const float pos_v = vv[i] * grid_scale;
-        const int grid_u = (int)roundf(pos_u) + grid_centre;
-        const int grid_v = (int)roundf(pos_v) + grid_centre;
+        const int grid_u = (int)roundf(pos_u) + grid_centre - origin_u;
+        const int grid_v = (int)roundf(pos_v) + grid_centre - origin_v;
 
         /* Get visibility data. */
         const float weight_i = weight[i];
@@ -145,112 +218,206 @@ static void oskar_grid_simple_default_f(
         const int off_u = (int)roundf((roundf(pos_u) - pos_u) * D_OVERSAMPLE);
         const int off_v = (int)roundf((roundf(pos_v) - pos_v) * D_OVERSAMPLE);
 
-        /* Catch points that would lie outside the grid. */
-        if (grid_u + D_SUPPORT >= grid_size || grid_u - D_SUPPORT < 0 ||
-                grid_v + D_SUPPORT >= grid_size || grid_v - D_SUPPORT < 0)
-        {
-            *num_skipped += 1;
-            continue;
-        }
-
-        /* Convolve this point onto the grid. */
+        /* Convolve this point onto the subgrid. */
         for (j = -D_SUPPORT; j <= D_SUPPORT; ++j)
         {
             size_t p1;
             const float c1 = conv_func[abs(off_v + j * D_OVERSAMPLE)];
             p1 = grid_v + j;
-            p1 *= grid_size; /* Tested to avoid int overflow. */
+            p1 *= sub_size;
             p1 += grid_u;
             for (k = -D_SUPPORT; k <= D_SUPPORT; ++k)
             {
                 const size_t p = (p1 + k) << 1;
                 const float c = conv_func[abs(off_u + k * D_OVERSAMPLE)] * c1;
-                grid[p]     += v_re * c;
-                grid[p + 1] += v_im * c;
+                subgrid[p]     += v_re * c;
+                subgrid[p + 1] += v_im * c;
                 sum += c;
             }
         }
-        *norm += sum * weight_i;
+        norm += sum * weight_i;
     }
+    return norm;
 }
 
 
-void oskar_grid_simple_d(
+static double grid_tile_simple_f(
         const int support,
         const int oversample,
-        const double* restrict conv_func,
+        const float* restrict conv_func,
         const size_t num_points,
-        const double* restrict uu,
-        const double* restrict vv,
-        const double* restrict vis,
-        const double* restrict weight,
-        const double cell_size_rad,
+        const size_t* restrict indices,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict vis,
+        const float* restrict weight,
+        const float cell_size_rad,
         const int grid_size,
-        size_t* restrict num_skipped,
-        double* restrict norm,
-        double* restrict grid)
+        const int origin_u,
+        const int origin_v,
+        const int sub_size,
+        float* restrict subgrid)
 {
-    size_t i;
+    size_t n;
+    double norm = 0.0;
     const int grid_centre = grid_size / 2;
-    const double grid_scale = grid_size * cell_size_rad;
-
-    /* Use slightly more efficient version for default parameters. */
-    if (support == D_SUPPORT && oversample == D_OVERSAMPLE)
-    {
-        oskar_grid_simple_default_d(conv_func, num_points, uu, vv, vis,
-                weight, cell_size_rad, grid_size, num_skipped, norm, grid);
-        return;
-    }
+    const float grid_scale = grid_size * cell_size_rad;
 
-    /* Loop over visibilities. */
-    *num_skipped = 0;
-    for (i = 0; i < num_points; ++i)
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
     {
         double sum = 0.0;
         int j, k;
+        const size_t i = indices[n];
 
-        /* Convert UV coordinates to grid coordinates. */
-        const double pos_u = -uu[i] * grid_scale;
-        const double pos_v = vv[i] * grid_scale;
-        const int grid_u = (int)round(pos_u) + grid_centre;
-        const int grid_v = (int)round(pos_v) + grid_centre;
+        /* Convert UV coordinates to subgrid coordinates. */
+        const float pos_u = -uu[i] * grid_scale;
+        const float pos_v = vv[i] * grid_scale;
+        const int grid_u = (int)roundf(pos_u) + grid_centre - origin_u;
+        const int grid_v = (int)roundf(pos_v) + grid_centre - origin_v;
 
         /* Get visibility data. */
-        const double weight_i = weight[i];
-        const double v_re = weight_i * vis[2 * i];
-        const double v_im = weight_i * vis[2 * i + 1];
+        const float weight_i = weight[i];
+        const float v_re = weight_i * vis[2 * i];
+        const float v_im = weight_i * vis[2 * i + 1];
 
         /* Scaled distance from nearest grid point. */
-        const int off_u = (int)round((round(pos_u) - pos_u) * oversample);
-        const int off_v = (int)round((round(pos_v) - pos_v) * oversample);
-
-        /* Catch points that would lie outside the grid. */
-        if (grid_u + support >= grid_size || grid_u - support < 0 ||
-                grid_v + support >= grid_size || grid_v - support < 0)
-        {
-            *num_skipped += 1;
-            continue;
-        }
+        const int off_u = (int)roundf((roundf(pos_u) - pos_u) * oversample);
+        const int off_v = (int)roundf((roundf(pos_v) - pos_v) * oversample);
 
-        /* Convolve this point onto the grid. */
+        /* Convolve this point onto the subgrid. */
         for (j = -support; j <= support; ++j)
         {
             size_t p1;
-            const double c1 = conv_func[abs(off_v + j * oversample)];
+            const float c1 = conv_func[abs(off_v + j * oversample)];
             p1 = grid_v + j;
-            p1 *= grid_size; /* Tested to avoid int overflow. */
+            p1 *= sub_size;
             p1 += grid_u;
             for (k = -support; k <= support; ++k)
             {
                 const size_t p = (p1 + k) << 1;
-                const double c = conv_func[abs(off_u + k * oversample)] * c1;
-                grid[p]     += v_re * c;
-                grid[p + 1] += v_im * c;
+                const float c = conv_func[abs(off_u + k * oversample)] * c1;
+                subgrid[p]     += v_re * c;
+                subgrid[p + 1] += v_im * c;
                 sum += c;
             }
         }
-        *norm += sum * weight_i;
+        norm += sum * weight_i;
     }
+    return norm;
+}
+
+size_t oskar_grid_simple_work_size(
+        const int support,
+        const size_t num_points,
+        const int grid_size,
+        const size_t element_size)
+{
+    const int tile_size = oskar_grid_tile_size(support);
+    const int num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    return oskar_grid_tiles_work_size(num_points,
+            num_tiles_side * num_tiles_side, tile_size + 2 * support, 1,
+            element_size);
+}
+
+void oskar_grid_simple_d(
+        const int support,
+        const int oversample,
+        const double* restrict conv_func,
+        const size_t num_points,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const int grid_size,
+        void* restrict work,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        double* restrict grid)
+{
+    int c, tile_size, num_tiles_side, num_tiles, sub_size, num_threads;
+    int* tile_index;
+    size_t i, *tile_start, *sorted;
+    double *tile_norm, *subgrids;
+    const int grid_centre = grid_size / 2;
+    const double grid_scale = grid_size * cell_size_rad;
+
+    /* Get the tile size. */
+    tile_size = oskar_grid_tile_size(support);
+    sub_size = tile_size + 2 * support;
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_tiles = num_tiles_side * num_tiles_side;
+
+    /* Get the arrays from the work buffer. */
+    num_threads = oskar_grid_tiles_num_threads();
+    subgrids = (double*) oskar_grid_tiles_work_split(work, num_points,
+            num_tiles, &tile_index, &tile_start, &sorted, &tile_norm);
+    memset(tile_norm, 0, num_tiles * sizeof(double));
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        const int grid_u = (int)round(-uu[i] * grid_scale) + grid_centre;
+        const int grid_v = (int)round(vv[i] * grid_scale) + grid_centre;
+        if (grid_u + support >= grid_size || grid_u - support < 0 ||
+                grid_v + support >= grid_size || grid_v - support < 0)
+            tile_index[i] = -1;
+        else
+            tile_index[i] = (grid_v / tile_size) * num_tiles_side +
+                    grid_u / tile_size;
+    }
+
+    /* Sort visibilities by tile. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Grid tiles in four passes, so that tiles gridded concurrently
+     * never overlap, and the order of summation is always the same. */
+    for (c = 0; c < 4; ++c)
+    {
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int t;
+            double* subgrid = subgrids;
+#ifdef _OPENMP
+            subgrid += 2 * (size_t)sub_size * sub_size * omp_get_thread_num();
+#endif
+            #pragma omp for schedule(dynamic)
+            for (t = 0; t < num_tiles; ++t)
+            {
+                const size_t* indices = sorted + tile_start[t];
+                const size_t num = tile_start[t + 1] - tile_start[t];
+                const int tile_u = t % num_tiles_side;
+                const int tile_v = t / num_tiles_side;
+                const int origin_u = tile_u * tile_size - support;
+                const int origin_v = tile_v * tile_size - support;
+                if ((tile_u & 1) + 2 * (tile_v & 1) != c || num == 0)
+                    continue;
+                memset(subgrid, 0, 2 * sizeof(double) * sub_size * sub_size);
+
+                /* Use slightly more efficient version for default
+                 * parameters. */
+                if (support == D_SUPPORT && oversample == D_OVERSAMPLE)
+                    tile_norm[t] = grid_tile_simple_default_d(conv_func,
+                            num, indices, uu, vv, vis, weight,
+                            cell_size_rad, grid_size, origin_u, origin_v,
+                            sub_size, subgrid);
+                else
+                    tile_norm[t] = grid_tile_simple_d(support, oversample,
+                            conv_func, num, indices, uu, vv, vis, weight,
+                            cell_size_rad, grid_size, origin_u, origin_v,
+                            sub_size, subgrid);
+                oskar_grid_tiles_add_d(sub_size, origin_u, origin_v,
+                        subgrid, grid_size, grid);
+            }
+        }
+    }
+
+    /* Sum the normalisation factors in tile order. */
+    for (i = 0; i < (size_t)num_tiles; ++i) *norm += tile_norm[i];
 }
 
 
@@ -265,71 +432,94 @@ void oskar_grid_simple_f(
         const float* restrict weight,
         const float cell_size_rad,
         const int grid_size,
+        void* restrict work,
         size_t* restrict num_skipped,
         double* restrict norm,
         float* restrict grid)
 {
-    size_t i;
+    int c, tile_size, num_tiles_side, num_tiles, sub_size, num_threads;
+    int* tile_index;
+    size_t i, *tile_start, *sorted;
+    double* tile_norm;
+    float* subgrids;
     const int grid_centre = grid_size / 2;
     const float grid_scale = grid_size * cell_size_rad;
 
-    /* Use slightly more efficient version for default parameters. */
-    if (support == D_SUPPORT && oversample == D_OVERSAMPLE)
-    {
-        oskar_grid_simple_default_f(conv_func, num_points, uu, vv, vis,
-                weight, cell_size_rad, grid_size, num_skipped, norm, grid);
-        return;
-    }
-
-    /* Loop over visibilities. */
-    *num_skipped = 0;
+    /* Get the tile size. */
+    tile_size = oskar_grid_tile_size(support);
+    sub_size = tile_size + 2 * support;
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_tiles = num_tiles_side * num_tiles_side;
+
+    /* Get the arrays from the work buffer. */
+    num_threads = oskar_grid_tiles_num_threads();
+    subgrids = (float*) oskar_grid_tiles_work_split(work, num_points,
+            num_tiles, &tile_index, &tile_start, &sorted, &tile_norm);
+    memset(tile_norm, 0, num_tiles * sizeof(double));
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    #pragma omp parallel for private(i)
     for (i = 0; i < num_points; ++i)
     {
-        double sum = 0.0;
-        int j, k;
-
-        /* Convert UV coordinates to grid coordinates. */
-        const float pos_u = -uu[i] * grid_scale;
-        const float pos_v = vv[i] * grid_scale;
-        const int grid_u = (int)roundf(pos_u) + grid_centre;
-        const int grid_v = (int)roundf(pos_v) + grid_centre;
-
-        /* Get visibility data. */
-        const float weight_i = weight[i];
-        const float v_re = weight_i * vis[2 * i];
-        const float v_im = weight_i * vis[2 * i + 1];
-
-        /* Scaled distance from nearest grid point. */
-        const int off_u = (int)roundf((roundf(pos_u) - pos_u) * oversample);
-        const int off_v = (int)roundf((roundf(pos_v) - pos_v) * oversample);
-
-        /* Catch points that would lie outside the grid. */
+        const int grid_u = (int)roundf(-uu[i] * grid_scale) + grid_centre;
+        const int grid_v = (int)roundf(vv[i] * grid_scale) + grid_centre;
         if (grid_u + support >= grid_size || grid_u - support < 0 ||
                 grid_v + support >= grid_size || grid_v - support < 0)
-        {
-            *num_skipped += 1;
-            continue;
-        }
+            tile_index[i] = -1;
+        else
+            tile_index[i] = (grid_v / tile_size) * num_tiles_side +
+                    grid_u / tile_size;
+    }
 
-        /* Convolve this point onto the grid. */
-        for (j = -support; j <= support; ++j)
+    /* Sort visibilities by tile. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Grid tiles in four passes, so that tiles gridded concurrently
+     * never overlap, and the order of summation is always the same. */
+    for (c = 0; c < 4; ++c)
+    {
+        #pragma omp parallel num_threads(num_threads)
         {
-            size_t p1;
-            const float c1 = conv_func[abs(off_v + j * oversample)];
-            p1 = grid_v + j;
-            p1 *= grid_size; /* Tested to avoid int overflow. */
-            p1 += grid_u;
-            for (k = -support; k <= support; ++k)
+            int t;
+            float* subgrid = subgrids;
+#ifdef _OPENMP
+            subgrid += 2 * (size_t)sub_size * sub_size * omp_get_thread_num();
+#endif
+            #pragma omp for schedule(dynamic)
+            for (t = 0; t < num_tiles; ++t)
             {
-                const size_t p = (p1 + k) << 1;
-                const float c = conv_func[abs(off_u + k * oversample)] * c1;
-                grid[p]     += v_re * c;
-                grid[p + 1] += v_im * c;
-                sum += c;
+                const size_t* indices = sorted + tile_start[t];
+                const size_t num = tile_start[t + 1] - tile_start[t];
+                const int tile_u = t % num_tiles_side;
+                const int tile_v = t / num_tiles_side;
+                const int origin_u = tile_u * tile_size - support;
+                const int origin_v = tile_v * tile_size - support;
+                if ((tile_u & 1) + 2 * (tile_v & 1) != c || num == 0)
+                    continue;
+                memset(subgrid, 0, 2 * sizeof(float) * sub_size * sub_size);
+
+                /* Use slightly more efficient version for default
+                 * parameters. */
+                if (support == D_SUPPORT && oversample == D_OVERSAMPLE)
+                    tile_norm[t] = grid_tile_simple_default_f(conv_func,
+                            num, indices, uu, vv, vis, weight,
+                            cell_size_rad, grid_size, origin_u, origin_v,
+                            sub_size, subgrid);
+                else
+                    tile_norm[t] = grid_tile_simple_f(support, oversample,
+                            conv_func, num, indices, uu, vv, vis, weight,
+                            cell_size_rad, grid_size, origin_u, origin_v,
+                            sub_size, subgrid);
+                oskar_grid_tiles_add_f(sub_size, origin_u, origin_v,
+                        subgrid, grid_size, grid);
             }
         }
-        *norm += sum * weight_i;
     }
+
+    /* Sum the normalisation factors in tile order. */
+    for (i = 0; i < (size_t)num_tiles; ++i) *norm += tile_norm[i];
 }
 
 #ifdef __cplusplus
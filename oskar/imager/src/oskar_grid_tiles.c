@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/oskar_grid_tiles.h"
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Minimum tile side length, chosen so a subgrid fits in cache. */
+#define MIN_TILE_SIZE 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int oskar_grid_tile_size(int max_support)
+{
+    return (2 * max_support > MIN_TILE_SIZE) ?
+            2 * max_support : MIN_TILE_SIZE;
+}
+
+/* Round up to a whole number of doubles, so the next array is aligned. */
+static size_t aligned(size_t bytes)
+{
+    return sizeof(double) * ((bytes + sizeof(double) - 1) / sizeof(double));
+}
+
+int oskar_grid_tiles_num_threads(void)
+{
+#ifdef _OPENMP
+    if (omp_get_active_level() >= omp_get_max_active_levels()) return 1;
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+size_t oskar_grid_tiles_work_size(size_t num_points, int num_tiles,
+        int sub_size, int num_subgrids, size_t element_size)
+{
+    const size_t subgrid_bytes =
+            2 * element_size * (size_t)sub_size * sub_size;
+    return aligned((num_tiles + 1) * sizeof(size_t)) +
+            aligned((num_points + 1) * sizeof(size_t)) +
+            aligned(num_tiles * sizeof(double)) +
+            aligned(num_points * sizeof(int)) +
+            (size_t)oskar_grid_tiles_num_threads() * num_subgrids *
+            subgrid_bytes;
+}
+
+void* oskar_grid_tiles_work_split(void* work, size_t num_points,
+        int num_tiles, int** tile_index, size_t** tile_start,
+        size_t** sorted, double** tile_norm)
+{
+    char* p = (char*) work;
+    *tile_start = (size_t*) p;
+    p += aligned((num_tiles + 1) * sizeof(size_t));
+    *sorted = (size_t*) p;
+    p += aligned((num_points + 1) * sizeof(size_t));
+    *tile_norm = (double*) p;
+    p += aligned(num_tiles * sizeof(double));
+    *tile_index = (int*) p;
+    p += aligned(num_points * sizeof(int));
+    return p;
+}
+
+size_t oskar_grid_tiles_sort(size_t num_points, const int* tile_index,
+        int num_tiles, size_t* tile_start, size_t* sorted)
+{
+    size_t i, num_skipped = 0;
+    int t;
+
+    /* Count visibilities in each tile. */
+    memset(tile_start, 0, (num_tiles + 1) * sizeof(size_t));
+    for (i = 0; i < num_points; ++i)
+    {
+        if (tile_index[i] < 0)
+            num_skipped++;
+        else
+            tile_start[tile_index[i] + 1]++;
+    }
+
+    /* Convert counts to start positions. */
+    for (t = 0; t < num_tiles; ++t)
+        tile_start[t + 1] += tile_start[t];
+
+    /* Fill the sorted list, using tile_start as a cursor
+     * and then shifting it back. */
+    for (i = 0; i < num_points; ++i)
+        if (tile_index[i] >= 0)
+            sorted[tile_start[tile_index[i]]++] = i;
+    for (t = num_tiles; t > 0; --t)
+        tile_start[t] = tile_start[t - 1];
+    tile_start[0] = 0;
+    return num_skipped;
+}
+
+void oskar_grid_tiles_add_d(const int sub_size, const int origin_u,
+        const int origin_v, const double* restrict subgrid,
+        const int grid_size, double* restrict grid)
+{
+    int j, k, j0, j1, k0, k1;
+    j0 = origin_v < 0 ? -origin_v : 0;
+    k0 = origin_u < 0 ? -origin_u : 0;
+    j1 = origin_v + sub_size > grid_size ? grid_size - origin_v : sub_size;
+    k1 = origin_u + sub_size > grid_size ? grid_size - origin_u : sub_size;
+    for (j = j0; j < j1; ++j)
+    {
+        size_t p, s;
+        p = origin_v + j;
+        p *= grid_size; /* Tested to avoid int overflow. */
+        p += origin_u;
+        s = (size_t)j * sub_size;
+        for (k = k0; k < k1; ++k)
+        {
+            grid[(p + k) << 1]       += subgrid[(s + k) << 1];
+            grid[((p + k) << 1) + 1] += subgrid[((s + k) << 1) + 1];
+        }
+    }
+}
+
+void oskar_grid_tiles_add_f(const int sub_size, const int origin_u,
+        const int origin_v, const float* restrict subgrid,
+        const int grid_size, float* restrict grid)
+{
+    int j, k, j0, j1, k0, k1;
+    j0 = origin_v < 0 ? -origin_v : 0;
+    k0 = origin_u < 0 ? -origin_u : 0;
+    j1 = origin_v + sub_size > grid_size ? grid_size - origin_v : sub_size;
+    k1 = origin_u + sub_size > grid_size ? grid_size - origin_u : sub_size;
+    for (j = j0; j < j1; ++j)
+    {
+        size_t p, s;
+        p = origin_v + j;
+        p *= grid_size; /* Tested to avoid int overflow. */
+        p += origin_u;
+        s = (size_t)j * sub_size;
+        for (k = k0; k < k1; ++k)
+        {
+            grid[(p + k) << 1]       += subgrid[(s + k) << 1];
+            grid[((p + k) << 1) + 1] += subgrid[((s + k) << 1) + 1];
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -25,12 +25,15 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
-
 #include "imager/oskar_grid_weights.h"
+#include "imager/oskar_grid_tiles.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Number of grid rows in each band of the weights grid. */
+#define BAND_ROWS 8
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -39,34 +42,68 @@ void oskar_grid_weights_write_d(const size_t num_points,
         const double* restrict uu, const double* restrict vv,
         const double* restrict weight, const double cell_size_rad,
         const int grid_size, size_t* restrict num_skipped,
-        double* restrict grid)
+        double* restrict grid, int* status)
 {
-    size_t i;
+    int b, num_bands;
+    int* band_index;
+    size_t i, *band_start, *sorted;
     const int grid_centre = grid_size / 2;
     const double grid_scale = grid_size * cell_size_rad;
 
-    /* Grid the existing weights. */
-    *num_skipped = 0;
+    /* Find the band of grid rows containing each point,
+     * skipping points that would lie outside the grid. */
+    if (*status) return;
+    num_bands = (grid_size + BAND_ROWS - 1) / BAND_ROWS;
+    band_index = (int*) malloc(num_points * sizeof(int));
+    band_start = (size_t*) malloc((num_bands + 1) * sizeof(size_t));
+    sorted = (size_t*) malloc((num_points + 1) * sizeof(size_t));
+    if (!band_index || !band_start || !sorted)
+    {
+        *status = OSKAR_ERR_MEMORY_ALLOC_FAILURE;
+        free(band_index);
+        free(band_start);
+        free(sorted);
+        return;
+    }
+    #pragma omp parallel for private(i)
     for (i = 0; i < num_points; ++i)
     {
-        /* Convert UV coordinates to grid coordinates. */
         const int grid_u = (int)round(-uu[i] * grid_scale) + grid_centre;
         const int grid_v = (int)round(vv[i] * grid_scale) + grid_centre;
-        size_t t = grid_v;
-        t *= grid_size; /* Tested to avoid int overflow. */
-        t += grid_u;
-
-        /* Catch points that would lie outside the grid. */
         if (grid_u >= grid_size || grid_u < 0 ||
                 grid_v >= grid_size || grid_v < 0)
+            band_index[i] = -1;
+        else
+            band_index[i] = grid_v / BAND_ROWS;
+    }
+
+    /* Sort points by band, keeping their order within each band. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, band_index, num_bands,
+            band_start, sorted);
+
+    /* Grid the existing weights. Bands never overlap, so they can be
+     * updated concurrently, and each cell is summed in input order. */
+    #pragma omp parallel for private(b) schedule(dynamic)
+    for (b = 0; b < num_bands; ++b)
+    {
+        size_t j;
+        for (j = band_start[b]; j < band_start[b + 1]; ++j)
         {
-            *num_skipped += 1;
-            continue;
-        }
+            /* Convert UV coordinates to grid coordinates. */
+            const size_t k = sorted[j];
+            const int grid_u = (int)round(-uu[k] * grid_scale) + grid_centre;
+            const int grid_v = (int)round(vv[k] * grid_scale) + grid_centre;
+            size_t t = grid_v;
+            t *= grid_size; /* Tested to avoid int overflow. */
+            t += grid_u;
 
-        /* Add weight to the grid. */
-        grid[t] += weight[i];
+            /* Add weight to the grid. */
+            grid[t] += weight[k];
+        }
     }
+    free(band_index);
+    free(band_start);
+    free(sorted);
 }
 
 void oskar_grid_weights_read_d(const size_t num_points,
@@ -75,12 +112,12 @@ void oskar_grid_weights_read_d(const size_t num_points,
         const double cell_size_rad, const int grid_size,
         size_t* restrict num_skipped, const double* restrict grid)
 {
-    size_t i;
+    size_t i, skipped = 0;
     const int grid_centre = grid_size / 2;
     const double grid_scale = grid_size * cell_size_rad;
 
     /* Look up gridded weight density at each point location. */
-    *num_skipped = 0;
+    #pragma omp parallel for private(i) reduction(+:skipped)
     for (i = 0; i < num_points; ++i)
     {
         /* Convert UV coordinates to grid coordinates. */
@@ -94,47 +131,127 @@ void oskar_grid_weights_read_d(const size_t num_points,
         if (grid_u >= grid_size || grid_u < 0 ||
                 grid_v >= grid_size || grid_v < 0)
         {
-            *num_skipped += 1;
+            skipped++;
             continue;
         }
 
         /* Calculate new weight based on gridded point density. */
         weight_out[i] = (grid[t] != 0.0) ? weight_in[i] / grid[t] : 0.0;
     }
+    *num_skipped = skipped;
+}
+
+void oskar_grid_weights_briggs_d(const int grid_size,
+        const double robustness, double* restrict grid, int* status)
+{
+    int j;
+    double sum_w = 0.0, sum_w2 = 0.0, f2, *row_sums;
+    if (*status) return;
+    row_sums = (double*) calloc(2 * grid_size, sizeof(double));
+    if (!row_sums)
+    {
+        *status = OSKAR_ERR_MEMORY_ALLOC_FAILURE;
+        return;
+    }
+
+    /* Sum the weights and their squares, in row order. */
+    #pragma omp parallel for private(j)
+    for (j = 0; j < grid_size; ++j)
+    {
+        int k;
+        const double* row = grid + (size_t)j * grid_size;
+        for (k = 0; k < grid_size; ++k)
+        {
+            row_sums[2 * j] += row[k];
+            row_sums[2 * j + 1] += row[k] * row[k];
+        }
+    }
+    for (j = 0; j < grid_size; ++j)
+    {
+        sum_w += row_sums[2 * j];
+        sum_w2 += row_sums[2 * j + 1];
+    }
+    free(row_sums);
+    if (sum_w2 == 0.0) return;
+
+    /* Replace each cell with the Briggs (1995) re-weighting denominator. */
+    f2 = pow(5.0 * pow(10.0, -robustness), 2.0) / (sum_w2 / sum_w);
+    #pragma omp parallel for private(j)
+    for (j = 0; j < grid_size; ++j)
+    {
+        int k;
+        double* row = grid + (size_t)j * grid_size;
+        for (k = 0; k < grid_size; ++k)
+            row[k] = 1.0 + row[k] * f2;
+    }
 }
 
 void oskar_grid_weights_write_f(const size_t num_points,
         const float* restrict uu, const float* restrict vv,
         const float* restrict weight, const float cell_size_rad,
         const int grid_size, size_t* restrict num_skipped,
-        float* restrict grid)
+        float* restrict grid, int* status)
 {
-    size_t i;
+    int b, num_bands;
+    int* band_index;
+    size_t i, *band_start, *sorted;
     const int grid_centre = grid_size / 2;
     const float grid_scale = grid_size * cell_size_rad;
 
-    /* Grid the existing weights. */
-    *num_skipped = 0;
+    /* Find the band of grid rows containing each point,
+     * skipping points that would lie outside the grid. */
+    if (*status) return;
+    num_bands = (grid_size + BAND_ROWS - 1) / BAND_ROWS;
+    band_index = (int*) malloc(num_points * sizeof(int));
+    band_start = (size_t*) malloc((num_bands + 1) * sizeof(size_t));
+    sorted = (size_t*) malloc((num_points + 1) * sizeof(size_t));
+    if (!band_index || !band_start || !sorted)
+    {
+        *status = OSKAR_ERR_MEMORY_ALLOC_FAILURE;
+        free(band_index);
+        free(band_start);
+        free(sorted);
+        return;
+    }
+    #pragma omp parallel for private(i)
     for (i = 0; i < num_points; ++i)
     {
-        /* Convert UV coordinates to grid coordinates. */
         const int grid_u = (int)roundf(-uu[i] * grid_scale) + grid_centre;
         const int grid_v = (int)roundf(vv[i] * grid_scale) + grid_centre;
-        size_t t = grid_v;
-        t *= grid_size; /* Tested to avoid int overflow. */
-        t += grid_u;
-
-        /* Catch points that would lie outside the grid. */
         if (grid_u >= grid_size || grid_u < 0 ||
                 grid_v >= grid_size || grid_v < 0)
+            band_index[i] = -1;
+        else
+            band_index[i] = grid_v / BAND_ROWS;
+    }
+
+    /* Sort points by band, keeping their order within each band. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, band_index, num_bands,
+            band_start, sorted);
+
+    /* Grid the existing weights. Bands never overlap, so they can be
+     * updated concurrently, and each cell is summed in input order. */
+    #pragma omp parallel for private(b) schedule(dynamic)
+    for (b = 0; b < num_bands; ++b)
+    {
+        size_t j;
+        for (j = band_start[b]; j < band_start[b + 1]; ++j)
         {
-            *num_skipped += 1;
-            continue;
-        }
+            /* Convert UV coordinates to grid coordinates. */
+            const size_t k = sorted[j];
+            const int grid_u = (int)roundf(-uu[k] * grid_scale) + grid_centre;
+            const int grid_v = (int)roundf(vv[k] * grid_scale) + grid_centre;
+            size_t t = grid_v;
+            t *= grid_size; /* Tested to avoid int overflow. */
+            t += grid_u;
 
-        /* Add weight to the grid. */
-        grid[t] += weight[i];
+            /* Add weight to the grid. */
+            grid[t] += weight[k];
+        }
     }
+    free(band_index);
+    free(band_start);
+    free(sorted);
 }
 
 void oskar_grid_weights_read_f(const size_t num_points,
@@ -143,12 +260,12 @@ void oskar_grid_weights_read_f(const size_t num_points,
         const float cell_size_rad, const int grid_size,
         size_t* restrict num_skipped, const float* restrict grid)
 {
-    size_t i;
+    size_t i, skipped = 0;
     const int grid_centre = grid_size / 2;
     const float grid_scale = grid_size * cell_size_rad;
 
     /* Look up gridded weight density at each point location. */
-    *num_skipped = 0;
+    #pragma omp parallel for private(i) reduction(+:skipped)
     for (i = 0; i < num_points; ++i)
     {
         /* Convert UV coordinates to grid coordinates. */
@@ -162,13 +279,59 @@ void oskar_grid_weights_read_f(const size_t num_points,
         if (grid_u >= grid_size || grid_u < 0 ||
                 grid_v >= grid_size || grid_v < 0)
         {
-            *num_skipped += 1;
+            skipped++;
             continue;
         }
 
         /* Calculate new weight based on gridded point density. */
         weight_out[i] = (grid[t] != 0.0) ? weight_in[i] / grid[t] : 0.0;
     }
+    *num_skipped = skipped;
+}
+
+void oskar_grid_weights_briggs_f(const int grid_size,
+        const double robustness, float* restrict grid, int* status)
+{
+    int j;
+    double sum_w = 0.0, sum_w2 = 0.0, f2, *row_sums;
+    if (*status) return;
+    row_sums = (double*) calloc(2 * grid_size, sizeof(double));
+    if (!row_sums)
+    {
+        *status = OSKAR_ERR_MEMORY_ALLOC_FAILURE;
+        return;
+    }
+
+    /* Sum the weights and their squares, in row order. */
+    #pragma omp parallel for private(j)
+    for (j = 0; j < grid_size; ++j)
+    {
+        int k;
+        const float* row = grid + (size_t)j * grid_size;
+        for (k = 0; k < grid_size; ++k)
+        {
+            row_sums[2 * j] += row[k];
+            row_sums[2 * j + 1] += row[k] * row[k];
+        }
+    }
+    for (j = 0; j < grid_size; ++j)
+    {
+        sum_w += row_sums[2 * j];
+        sum_w2 += row_sums[2 * j + 1];
+    }
+    free(row_sums);
+    if (sum_w2 == 0.0) return;
+
+    /* Replace each cell with the Briggs (1995) re-weighting denominator. */
+    f2 = pow(5.0 * pow(10.0, -robustness), 2.0) / (sum_w2 / sum_w);
+    #pragma omp parallel for private(j)
+    for (j = 0; j < grid_size; ++j)
+    {
+        int k;
+        float* row = grid + (size_t)j * grid_size;
+        for (k = 0; k < grid_size; ++k)
+            row[k] = (float) (1.0 + row[k] * f2);
+    }
 }
 
 #ifdef __cplusplus
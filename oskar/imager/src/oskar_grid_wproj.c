@@ -27,20 +27,29 @@
  */
 
 #include "imager/oskar_grid_wproj.h"
+#include "imager/oskar_grid_tiles.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void oskar_grid_wproj_d(
+/* Grids the visibilities in one tile into a subgrid, and returns the
+ * normalisation factor for the tile. */
+static double grid_tile_wproj_d(
         const size_t num_w_planes,
         const int* restrict support,
         const int oversample,
         const int conv_size_half,
         const double* restrict conv_func,
         const size_t num_points,
+        const size_t* restrict indices,
         const double* restrict uu,
         const double* restrict vv,
         const double* restrict ww,
@@ -49,30 +58,32 @@ void oskar_grid_wproj_d(
         const double cell_size_rad,
         const double w_scale,
         const int grid_size,
-        size_t* restrict num_skipped,
-        double* restrict norm,
-        double* restrict grid)
+        const int origin_u,
+        const int origin_v,
+        const int sub_size,
+        double* restrict subgrid)
 {
-    size_t i;
+    size_t n;
+    double norm = 0.0;
     const size_t kernel_dim = conv_size_half * conv_size_half;
     const int grid_centre = grid_size / 2;
     const double grid_scale = grid_size * cell_size_rad;
 
-    /* Loop over visibilities. */
-    *num_skipped = 0;
-    for (i = 0; i < num_points; ++i)
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
     {
         double sum = 0.0;
         int j, k;
+        const size_t i = indices[n];
 
-        /* Convert UV coordinates to grid coordinates. */
+        /* Convert UV coordinates to subgrid coordinates. */
         const double pos_u = -uu[i] * grid_scale;
         const double pos_v = vv[i] * grid_scale;
         const double ww_i = ww[i];
         const double conv_conj = (ww_i > 0.0) ? -1.0 : 1.0;
         const size_t grid_w = (size_t)round(sqrt(fabs(ww_i * w_scale)));
-        const int grid_u = (int)round(pos_u) + grid_centre;
-        const int grid_v = (int)round(pos_v) + grid_centre;
+        const int grid_u = (int)round(pos_u) + grid_centre - origin_u;
+        const int grid_v = (int)round(pos_v) + grid_centre - origin_v;
 
         /* Get visibility data. */
         const double weight_i = weight[i];
@@ -89,20 +100,12 @@ void oskar_grid_wproj_d(
         const size_t kernel_start = grid_w < num_w_planes ?
                 grid_w * kernel_dim : (num_w_planes - 1) * kernel_dim;
 
-        /* Catch points that would lie outside the grid. */
-        if (grid_u + w_support >= grid_size || grid_u - w_support < 0 ||
-                grid_v + w_support >= grid_size || grid_v - w_support < 0)
-        {
-            *num_skipped += 1;
-            continue;
-        }
-
-        /* Convolve this point onto the grid. */
+        /* Convolve this point onto the subgrid. */
         for (j = -w_support; j <= w_support; ++j)
         {
             size_t p1, t1;
             p1 = grid_v + j;
-            p1 *= grid_size; /* Tested to avoid int overflow. */
+            p1 *= sub_size;
             p1 += grid_u;
             t1 = abs(off_v + j * oversample);
             t1 *= conv_size_half;
@@ -113,23 +116,148 @@ void oskar_grid_wproj_d(
                 const double c_re = conv_func[p];
                 const double c_im = conv_func[p + 1] * conv_conj;
                 p = (p1 + k) << 1;
-                grid[p]     += (v_re * c_re - v_im * c_im);
-                grid[p + 1] += (v_im * c_re + v_re * c_im);
+                subgrid[p]     += (v_re * c_re - v_im * c_im);
+                subgrid[p + 1] += (v_im * c_re + v_re * c_im);
                 sum += c_re; /* Real part only. */
             }
         }
-        *norm += sum * weight_i;
+        norm += sum * weight_i;
     }
+    return norm;
 }
 
+size_t oskar_grid_wproj_work_size(
+        const size_t num_w_planes,
+        const int* restrict support,
+        const size_t num_points,
+        const int grid_size,
+        const size_t element_size)
+{
+    size_t i;
+    int max_support = 0, tile_size, num_tiles_side;
+    for (i = 0; i < num_w_planes; ++i)
+        if (support[i] > max_support) max_support = support[i];
+    tile_size = oskar_grid_tile_size(max_support);
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    return oskar_grid_tiles_work_size(num_points,
+            num_tiles_side * num_tiles_side, tile_size + 2 * max_support, 1,
+            element_size);
+}
 
-void oskar_grid_wproj_f(
+void oskar_grid_wproj_d(
+        const size_t num_w_planes,
+        const int* restrict support,
+        const int oversample,
+        const int conv_size_half,
+        const double* restrict conv_func,
+        const size_t num_points,
+        const double* restrict uu,
+        const double* restrict vv,
+        const double* restrict ww,
+        const double* restrict vis,
+        const double* restrict weight,
+        const double cell_size_rad,
+        const double w_scale,
+        const int grid_size,
+        void* restrict work,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        double* restrict grid)
+{
+    int c, max_support = 0, tile_size, num_tiles_side, num_tiles, sub_size;
+    int num_threads;
+    int* tile_index;
+    size_t i, *tile_start, *sorted;
+    double *tile_norm, *subgrids;
+    const int grid_centre = grid_size / 2;
+    const double grid_scale = grid_size * cell_size_rad;
+
+    /* Get the tile size from the largest kernel. */
+    for (i = 0; i < num_w_planes; ++i)
+        if (support[i] > max_support) max_support = support[i];
+    tile_size = oskar_grid_tile_size(max_support);
+    sub_size = tile_size + 2 * max_support;
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_tiles = num_tiles_side * num_tiles_side;
+
+    /* Get the arrays from the work buffer. */
+    num_threads = oskar_grid_tiles_num_threads();
+    subgrids = (double*) oskar_grid_tiles_work_split(work, num_points,
+            num_tiles, &tile_index, &tile_start, &sorted, &tile_norm);
+    memset(tile_norm, 0, num_tiles * sizeof(double));
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        const double pos_u = -uu[i] * grid_scale;
+        const double pos_v = vv[i] * grid_scale;
+        const size_t grid_w = (size_t)round(sqrt(fabs(ww[i] * w_scale)));
+        const int grid_u = (int)round(pos_u) + grid_centre;
+        const int grid_v = (int)round(pos_v) + grid_centre;
+        const int w_support = grid_w < num_w_planes ?
+                support[grid_w] : support[num_w_planes - 1];
+        if (grid_u + w_support >= grid_size || grid_u - w_support < 0 ||
+                grid_v + w_support >= grid_size || grid_v - w_support < 0)
+            tile_index[i] = -1;
+        else
+            tile_index[i] = (grid_v / tile_size) * num_tiles_side +
+                    grid_u / tile_size;
+    }
+
+    /* Sort visibilities by tile. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Grid tiles in four passes, so that tiles gridded concurrently
+     * never overlap, and the order of summation is always the same. */
+    for (c = 0; c < 4; ++c)
+    {
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int t;
+            double* subgrid = subgrids;
+#ifdef _OPENMP
+            subgrid += 2 * (size_t)sub_size * sub_size * omp_get_thread_num();
+#endif
+            #pragma omp for schedule(dynamic)
+            for (t = 0; t < num_tiles; ++t)
+            {
+                const int tile_u = t % num_tiles_side;
+                const int tile_v = t / num_tiles_side;
+                const int origin_u = tile_u * tile_size - max_support;
+                const int origin_v = tile_v * tile_size - max_support;
+                if ((tile_u & 1) + 2 * (tile_v & 1) != c ||
+                        tile_start[t] == tile_start[t + 1]) continue;
+                memset(subgrid, 0, 2 * sizeof(double) * sub_size * sub_size);
+                tile_norm[t] = grid_tile_wproj_d(num_w_planes, support,
+                        oversample, conv_size_half, conv_func,
+                        tile_start[t + 1] - tile_start[t],
+                        sorted + tile_start[t], uu, vv, ww, vis, weight,
+                        cell_size_rad, w_scale, grid_size,
+                        origin_u, origin_v, sub_size, subgrid);
+                oskar_grid_tiles_add_d(sub_size, origin_u, origin_v,
+                        subgrid, grid_size, grid);
+            }
+        }
+    }
+
+    /* Sum the normalisation factors in tile order. */
+    for (i = 0; i < (size_t)num_tiles; ++i) *norm += tile_norm[i];
+}
+
+
+/* Grids the visibilities in one tile into a subgrid, and returns the
+ * normalisation factor for the tile. */
+static double grid_tile_wproj_f(
         const size_t num_w_planes,
         const int* restrict support,
         const int oversample,
         const int conv_size_half,
         const float* restrict conv_func,
         const size_t num_points,
+        const size_t* restrict indices,
         const float* restrict uu,
         const float* restrict vv,
         const float* restrict ww,
@@ -138,30 +266,32 @@ void oskar_grid_wproj_f(
         const float cell_size_rad,
         const float w_scale,
         const int grid_size,
-        size_t* restrict num_skipped,
-        double* restrict norm,
-        float* restrict grid)
+        const int origin_u,
+        const int origin_v,
+        const int sub_size,
+        float* restrict subgrid)
 {
-    size_t i;
+    size_t n;
+    double norm = 0.0;
     const size_t kernel_dim = conv_size_half * conv_size_half;
     const int grid_centre = grid_size / 2;
     const float grid_scale = grid_size * cell_size_rad;
 
-    /* Loop over visibilities. */
-    *num_skipped = 0;
-    for (i = 0; i < num_points; ++i)
+    /* Loop over visibilities in the tile. */
+    for (n = 0; n < num_points; ++n)
     {
         double sum = 0.0;
         int j, k;
+        const size_t i = indices[n];
 
-        /* Convert UV coordinates to grid coordinates. */
+        /* Convert UV coordinates to subgrid coordinates. */
         const float pos_u = -uu[i] * grid_scale;
         const float pos_v = vv[i] * grid_scale;
         const float ww_i = ww[i];
         const float conv_conj = (ww_i > 0.0f) ? -1.0f : 1.0f;
         const size_t grid_w = (size_t)roundf(sqrtf(fabsf(ww_i * w_scale)));
-        const int grid_u = (int)roundf(pos_u) + grid_centre;
-        const int grid_v = (int)roundf(pos_v) + grid_centre;
+        const int grid_u = (int)roundf(pos_u) + grid_centre - origin_u;
+        const int grid_v = (int)roundf(pos_v) + grid_centre - origin_v;
 
         /* Get visibility data. */
         const float weight_i = weight[i];
@@ -178,20 +308,12 @@ void oskar_grid_wproj_f(
         const size_t kernel_start = grid_w < num_w_planes ?
                 grid_w * kernel_dim : (num_w_planes - 1) * kernel_dim;
 
-        /* Catch points that would lie outside the grid. */
-        if (grid_u + w_support >= grid_size || grid_u - w_support < 0 ||
-                grid_v + w_support >= grid_size || grid_v - w_support < 0)
-        {
-            *num_skipped += 1;
-            continue;
-        }
-
-        /* Convolve this point onto the grid. */
+        /* Convolve this point onto the subgrid. */
         for (j = -w_support; j <= w_support; ++j)
         {
             size_t p1, t1;
             p1 = grid_v + j;
-            p1 *= grid_size; /* Tested to avoid int overflow. */
+            p1 *= sub_size;
             p1 += grid_u;
             t1 = abs(off_v + j * oversample);
             t1 *= conv_size_half;
@@ -202,13 +324,118 @@ void oskar_grid_wproj_f(
                 const float c_re = conv_func[p];
                 const float c_im = conv_func[p + 1] * conv_conj;
                 p = (p1 + k) << 1;
-                grid[p]     += (v_re * c_re - v_im * c_im);
-                grid[p + 1] += (v_im * c_re + v_re * c_im);
+                subgrid[p]     += (v_re * c_re - v_im * c_im);
+                subgrid[p + 1] += (v_im * c_re + v_re * c_im);
                 sum += c_re; /* Real part only. */
             }
         }
-        *norm += sum * weight_i;
+        norm += sum * weight_i;
     }
+    return norm;
+}
+
+void oskar_grid_wproj_f(
+        const size_t num_w_planes,
+        const int* restrict support,
+        const int oversample,
+        const int conv_size_half,
+        const float* restrict conv_func,
+        const size_t num_points,
+        const float* restrict uu,
+        const float* restrict vv,
+        const float* restrict ww,
+        const float* restrict vis,
+        const float* restrict weight,
+        const float cell_size_rad,
+        const float w_scale,
+        const int grid_size,
+        void* restrict work,
+        size_t* restrict num_skipped,
+        double* restrict norm,
+        float* restrict grid)
+{
+    int c, max_support = 0, tile_size, num_tiles_side, num_tiles, sub_size;
+    int num_threads;
+    int* tile_index;
+    size_t i, *tile_start, *sorted;
+    double* tile_norm;
+    float* subgrids;
+    const int grid_centre = grid_size / 2;
+    const float grid_scale = grid_size * cell_size_rad;
+
+    /* Get the tile size from the largest kernel. */
+    for (i = 0; i < num_w_planes; ++i)
+        if (support[i] > max_support) max_support = support[i];
+    tile_size = oskar_grid_tile_size(max_support);
+    sub_size = tile_size + 2 * max_support;
+    num_tiles_side = (grid_size + tile_size - 1) / tile_size;
+    num_tiles = num_tiles_side * num_tiles_side;
+
+    /* Get the arrays from the work buffer. */
+    num_threads = oskar_grid_tiles_num_threads();
+    subgrids = (float*) oskar_grid_tiles_work_split(work, num_points,
+            num_tiles, &tile_index, &tile_start, &sorted, &tile_norm);
+    memset(tile_norm, 0, num_tiles * sizeof(double));
+
+    /* Find the tile containing each visibility,
+     * skipping points that would lie outside the grid. */
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        const float pos_u = -uu[i] * grid_scale;
+        const float pos_v = vv[i] * grid_scale;
+        const size_t grid_w = (size_t)roundf(sqrtf(fabsf(ww[i] * w_scale)));
+        const int grid_u = (int)roundf(pos_u) + grid_centre;
+        const int grid_v = (int)roundf(pos_v) + grid_centre;
+        const int w_support = grid_w < num_w_planes ?
+                support[grid_w] : support[num_w_planes - 1];
+        if (grid_u + w_support >= grid_size || grid_u - w_support < 0 ||
+                grid_v + w_support >= grid_size || grid_v - w_support < 0)
+            tile_index[i] = -1;
+        else
+            tile_index[i] = (grid_v / tile_size) * num_tiles_side +
+                    grid_u / tile_size;
+    }
+
+    /* Sort visibilities by tile. */
+    *num_skipped = oskar_grid_tiles_sort(num_points, tile_index, num_tiles,
+            tile_start, sorted);
+
+    /* Grid tiles in four passes, so that tiles gridded concurrently
+     * never overlap, and the order of summation is always the same. */
+    for (c = 0; c < 4; ++c)
+    {
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int t;
+            float* subgrid = subgrids;
+#ifdef _OPENMP
+            subgrid += 2 * (size_t)sub_size * sub_size * omp_get_thread_num();
+#endif
+            #pragma omp for schedule(dynamic)
+            for (t = 0; t < num_tiles; ++t)
+            {
+                const int tile_u = t % num_tiles_side;
+                const int tile_v = t / num_tiles_side;
+                const int origin_u = tile_u * tile_size - max_support;
+                const int origin_v = tile_v * tile_size - max_support;
+                if ((tile_u & 1) + 2 * (tile_v & 1) != c ||
+                        tile_start[t] == tile_start[t + 1]) continue;
+                memset(subgrid, 0, 2 * sizeof(float) * sub_size * sub_size);
+                tile_norm[t] = grid_tile_wproj_f(num_w_planes, support,
+                        oversample, conv_size_half, conv_func,
+                        tile_start[t + 1] - tile_start[t],
+                        sorted + tile_start[t], uu, vv, ww, vis, weight,
+                        cell_size_rad, w_scale, grid_size,
+                        origin_u, origin_v, sub_size, subgrid);
+                oskar_grid_tiles_add_f(sub_size, origin_u, origin_v,
+                        subgrid, grid_size, grid);
+            }
+        }
+    }
+
+    /* Sum the normalisation factors in tile order. */
+    for (i = 0; i < (size_t)num_tiles; ++i) *norm += tile_norm[i];
 }
 
 #ifdef __cplusplus
@@ -53,11 +53,15 @@ const char* oskar_imager_algorithm(const oskar_Imager* h)
 {
     switch (h->algorithm)
     {
-    case OSKAR_ALGORITHM_FFT:    return "FFT";
-    case OSKAR_ALGORITHM_WPROJ:  return "W-projection";
-    case OSKAR_ALGORITHM_DFT_2D: return "DFT 2D";
-    case OSKAR_ALGORITHM_DFT_3D: return "DFT 3D";
-    default:                     return "";
+    case OSKAR_ALGORITHM_FFT:      return "FFT";
+    case OSKAR_ALGORITHM_WPROJ:    return "W-projection";
+    case OSKAR_ALGORITHM_DFT_2D:   return "DFT 2D";
+    case OSKAR_ALGORITHM_DFT_3D:   return "DFT 3D";
+    case OSKAR_ALGORITHM_IDG:      return "IDG";
+    case OSKAR_ALGORITHM_WSTACK:   return "W-stacking";
+    case OSKAR_ALGORITHM_NUFFT_2D: return "NUFFT 2D";
+    case OSKAR_ALGORITHM_NUFFT_3D: return "NUFFT 3D";
+    default:                       return "";
     }
 }
 
@@ -74,6 +78,12 @@ int oskar_imager_channel_snapshots(const oskar_Imager* h)
 }
 
 
+int oskar_imager_coords_index(const oskar_Imager* h)
+{
+    return h->use_coords_index;
+}
+
+
 int oskar_imager_coords_only(const oskar_Imager* h)
 {
     return h->coords_only;
@@ -110,6 +120,18 @@ int oskar_imager_generate_w_kernels_on_gpu(const oskar_Imager* h)
 }
 
 
+int oskar_imager_grid_half_plane(const oskar_Imager* h)
+{
+    return h->grid_half_plane;
+}
+
+
+double oskar_imager_grid_kernel_accuracy(const oskar_Imager* h)
+{
+    return h->kernel_accuracy;
+}
+
+
 int oskar_imager_image_size(const oskar_Imager* h)
 {
     return h->image_size;
@@ -142,6 +164,12 @@ char* const* oskar_imager_input_files(const oskar_Imager* h)
 }
 
 
+double oskar_imager_memory_budget_gb(const oskar_Imager* h)
+{
+    return h->memory_budget_gb;
+}
+
+
 const char* oskar_imager_ms_column(const oskar_Imager* h)
 {
     return h->ms_column;
@@ -176,7 +204,10 @@ int oskar_imager_plane_size(oskar_Imager* h)
 {
     if (h->grid_size == 0)
     {
-        if (h->algorithm == OSKAR_ALGORITHM_WPROJ)
+        if (h->algorithm == OSKAR_ALGORITHM_WPROJ ||
+                h->algorithm == OSKAR_ALGORITHM_IDG ||
+                h->algorithm == OSKAR_ALGORITHM_NUFFT_2D ||
+                h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
         {
             (void) oskar_imager_composite_nearest_even(h->image_padding *
                     ((double)(h->image_size)) - 0.5, 0, &h->grid_size);
@@ -209,6 +240,12 @@ int oskar_imager_precision(const oskar_Imager* h)
 }
 
 
+double oskar_imager_robustness(const oskar_Imager* h)
+{
+    return h->robustness;
+}
+
+
 int oskar_imager_scale_norm_with_num_input_files(const oskar_Imager* h)
 {
     return h->scale_norm_with_num_input_files;
@@ -227,6 +264,31 @@ void oskar_imager_set_algorithm(oskar_Imager* h, const char* type,
         h->support = 3;
         h->oversample = 100;
     }
+    else if (!strncmp(type, "IDG", 3) || !strncmp(type, "idg", 3))
+    {
+        h->algorithm = OSKAR_ALGORITHM_IDG;
+        h->image_padding = 1.2;
+    }
+    else if (!strncmp(type, "N", 1) || !strncmp(type, "n", 1))
+    {
+        /* The grid must be padded by a factor of 2 for the kernel
+         * support size to give the required accuracy. */
+        h->algorithm = (!strncmp(type, "NUFFT 3", 7) ||
+                !strncmp(type, "nufft 3", 7)) ?
+                        OSKAR_ALGORITHM_NUFFT_3D : OSKAR_ALGORITHM_NUFFT_2D;
+        h->kernel_type = 'E';
+        h->kernel_accuracy = 1e-6;
+        h->support = 3;
+        h->oversample = 100;
+        h->image_padding = 2.0;
+    }
+    else if (!strncmp(type, "W-s", 3) || !strncmp(type, "w-s", 3))
+    {
+        h->algorithm = OSKAR_ALGORITHM_WSTACK;
+        h->kernel_type = 'S';
+        h->support = 3;
+        h->oversample = 100;
+    }
     else if (!strncmp(type, "W", 1) || !strncmp(type, "w", 1))
     {
         h->algorithm = OSKAR_ALGORITHM_WPROJ;
@@ -262,6 +324,12 @@ void oskar_imager_set_channel_snapshots(oskar_Imager* h, int value)
 }
 
 
+void oskar_imager_set_coords_index(oskar_Imager* h, int value)
+{
+    h->use_coords_index = value;
+}
+
+
 void oskar_imager_set_coords_only(oskar_Imager* h, int flag)
 {
     h->coords_only = flag;
@@ -282,7 +350,8 @@ void oskar_imager_set_coords_only(oskar_Imager* h, int flag)
             h->ww_rms = sqrt(h->ww_rms / h->ww_points);
 
         /* Calculate required number of w-planes if not set. */
-        if ((h->ww_max > 0.0) && (h->num_w_planes < 1))
+        if ((h->ww_max > 0.0) && (h->num_w_planes < 1) &&
+                (h->algorithm == OSKAR_ALGORITHM_WPROJ))
         {
             double max_uvw, ww_mid;
             max_uvw = 1.05 * h->ww_max;
@@ -292,6 +361,7 @@ void oskar_imager_set_coords_only(oskar_Imager* h, int flag)
             h->num_w_planes = (int)(max_uvw *
                     fabs(sin(h->cellsize_rad * h->image_size / 2.0)));
         }
+
     }
 }
 
@@ -348,6 +418,12 @@ void oskar_imager_set_generate_w_kernels_on_gpu(oskar_Imager* h, int value)
 }
 
 
+void oskar_imager_set_grid_half_plane(oskar_Imager* h, int value)
+{
+    h->grid_half_plane = value;
+}
+
+
 void oskar_imager_set_gpus(oskar_Imager* h, int num, const int* ids,
         int* status)
 {
@@ -400,10 +476,18 @@ void oskar_imager_set_grid_kernel(oskar_Imager* h, const char* type,
         h->kernel_type = 'G';
     else if (!strncmp(type, "P", 1) || !strncmp(type, "p", 1))
         h->kernel_type = 'P';
+    else if (!strncmp(type, "E", 1) || !strncmp(type, "e", 1))
+        h->kernel_type = 'E';
     else *status = OSKAR_ERR_INVALID_ARGUMENT;
 }
 
 
+void oskar_imager_set_grid_kernel_accuracy(oskar_Imager* h, double value)
+{
+    h->kernel_accuracy = value;
+}
+
+
 void oskar_imager_set_image_size(oskar_Imager* h, int size, int* status)
 {
     oskar_imager_set_size(h, size, status);
@@ -494,6 +578,12 @@ void oskar_imager_set_log(oskar_Imager* h, oskar_Log* log)
 }
 
 
+void oskar_imager_set_memory_budget_gb(oskar_Imager* h, double value)
+{
+    h->memory_budget_gb = value;
+}
+
+
 void oskar_imager_set_ms_column(oskar_Imager* h, const char* column,
         int* status)
 {
@@ -540,6 +630,12 @@ void oskar_imager_set_oversample(oskar_Imager* h, int value)
 }
 
 
+void oskar_imager_set_robustness(oskar_Imager* h, double value)
+{
+    h->robustness = value;
+}
+
+
 void oskar_imager_set_scale_norm_with_num_input_files(oskar_Imager* h,
         int value)
 {
@@ -570,7 +666,7 @@ void oskar_imager_set_size(oskar_Imager* h, int size, int* status)
 void oskar_imager_set_time_max_utc(oskar_Imager* h, double time_max_mjd_utc)
 {
     if (time_max_mjd_utc != 0.0 && time_max_mjd_utc != DBL_MAX)
-        time_max_mjd_utc += 0.01 / 86400.0;
+        time_max_mjd_utc += OSKAR_IMAGER_TIME_TOL_SEC / 86400.0;
     h->time_max_utc = time_max_mjd_utc * 86400.0;
 }
 
@@ -578,11 +674,18 @@ void oskar_imager_set_time_max_utc(oskar_Imager* h, double time_max_mjd_utc)
 void oskar_imager_set_time_min_utc(oskar_Imager* h, double time_min_mjd_utc)
 {
     if (time_min_mjd_utc != 0.0)
-        time_min_mjd_utc -= 0.01 / 86400.0;
+        time_min_mjd_utc -= OSKAR_IMAGER_TIME_TOL_SEC / 86400.0;
     h->time_min_utc = time_min_mjd_utc * 86400.0;
 }
 
 
+void oskar_imager_set_time_snapshot_interval_sec(oskar_Imager* h,
+        double value)
+{
+    h->time_snap_interval_sec = value;
+}
+
+
 void oskar_imager_set_uv_filter_max(oskar_Imager* h, double max_wavelength)
 {
     h->uv_filter_max = max_wavelength;
@@ -687,6 +790,25 @@ void oskar_imager_set_vis_phase_centre(oskar_Imager* h,
 }
 
 
+void oskar_imager_set_vis_time(oskar_Imager* h,
+        double ref_mjd_utc, double inc_sec, int num)
+{
+    const double start = ref_mjd_utc * 86400.0;
+    const double end = start + num * inc_sec;
+    if (h->planes) return;
+    if (h->vis_time_end_utc <= h->vis_time_start_utc)
+    {
+        h->vis_time_start_utc = start;
+        h->vis_time_end_utc = end;
+    }
+    else
+    {
+        if (start < h->vis_time_start_utc) h->vis_time_start_utc = start;
+        if (end > h->vis_time_end_utc) h->vis_time_end_utc = end;
+    }
+}
+
+
 void oskar_imager_set_num_w_planes(oskar_Imager* h, int value)
 {
     h->num_w_planes = value;
@@ -700,6 +822,20 @@ void oskar_imager_set_num_w_planes(oskar_Imager* h, int value)
 }
 
 
+void oskar_imager_set_w_kernel_cache_dir(oskar_Imager* h, const char* dir)
+{
+    int len = 0;
+    free(h->w_kernel_cache_dir);
+    h->w_kernel_cache_dir = 0;
+    if (dir) len = (int) strlen(dir);
+    if (len > 0)
+    {
+        h->w_kernel_cache_dir = calloc(1 + len, 1);
+        strcpy(h->w_kernel_cache_dir, dir);
+    }
+}
+
+
 void oskar_imager_set_weighting(oskar_Imager* h, const char* type, int* status)
 {
     if (!strncmp(type, "N", 1) || !strncmp(type, "n", 1))
@@ -708,6 +844,8 @@ void oskar_imager_set_weighting(oskar_Imager* h, const char* type, int* status)
         h->weighting = OSKAR_WEIGHTING_RADIAL;
     else if (!strncmp(type, "U", 1) || !strncmp(type, "u", 1))
         h->weighting = OSKAR_WEIGHTING_UNIFORM;
+    else if (!strncmp(type, "B", 1) || !strncmp(type, "b", 1))
+        h->weighting = OSKAR_WEIGHTING_BRIGGS;
     else *status = OSKAR_ERR_INVALID_ARGUMENT;
 }
 
@@ -721,14 +859,20 @@ int oskar_imager_size(const oskar_Imager* h)
 double oskar_imager_time_max_utc(const oskar_Imager* h)
 {
     return h->time_max_utc == 0.0 ? 0.0 :
-            (h->time_max_utc / 86400.0) - 0.01 / 86400.0;
+            (h->time_max_utc / 86400.0) - OSKAR_IMAGER_TIME_TOL_SEC / 86400.0;
 }
 
 
 double oskar_imager_time_min_utc(const oskar_Imager* h)
 {
     return h->time_min_utc == 0.0 ? 0.0 :
-            (h->time_min_utc / 86400.0) + 0.01 / 86400.0;
+            (h->time_min_utc / 86400.0) + OSKAR_IMAGER_TIME_TOL_SEC / 86400.0;
+}
+
+
+double oskar_imager_time_snapshot_interval_sec(const oskar_Imager* h)
+{
+    return h->time_snap_interval_sec;
 }
 
 
@@ -744,6 +888,12 @@ double oskar_imager_uv_filter_min(const oskar_Imager* h)
 }
 
 
+const char* oskar_imager_w_kernel_cache_dir(const oskar_Imager* h)
+{
+    return h->w_kernel_cache_dir;
+}
+
+
 const char* oskar_imager_weighting(const oskar_Imager* h)
 {
     switch (h->weighting)
@@ -751,6 +901,7 @@ const char* oskar_imager_weighting(const oskar_Imager* h)
     case OSKAR_WEIGHTING_NATURAL: return "Natural";
     case OSKAR_WEIGHTING_RADIAL:  return "Radial";
     case OSKAR_WEIGHTING_UNIFORM: return "Uniform";
+    case OSKAR_WEIGHTING_BRIGGS:  return "Briggs";
     default:                      return "";
     }
 }
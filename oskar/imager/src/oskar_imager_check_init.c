@@ -31,7 +31,9 @@
 
 #include "imager/private_imager_init_dft.h"
 #include "imager/private_imager_init_fft.h"
+#include "imager/private_imager_init_nufft.h"
 #include "imager/private_imager_init_wproj.h"
+#include "imager/private_imager_init_wstack.h"
 #include "utility/oskar_timer.h"
 
 #include <stdlib.h>
@@ -67,6 +69,21 @@ void oskar_imager_check_init(oskar_Imager* h, int* status)
             oskar_imager_init_wproj(h, status);
         break;
     }
+    case OSKAR_ALGORITHM_IDG:
+        break;
+    case OSKAR_ALGORITHM_WSTACK:
+    {
+        if (!h->conv_func)
+            oskar_imager_init_wstack(h, status);
+        break;
+    }
+    case OSKAR_ALGORITHM_NUFFT_2D:
+    case OSKAR_ALGORITHM_NUFFT_3D:
+    {
+        if (!h->conv_func)
+            oskar_imager_init_nufft(h, status);
+        break;
+    }
     default:
         *status = OSKAR_ERR_FUNCTION_NOT_AVAILABLE;
     }
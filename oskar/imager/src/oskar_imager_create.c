@@ -30,6 +30,7 @@
 
 #include "imager/oskar_imager_accessors.h"
 #include "imager/oskar_imager_create.h"
+#include "imager/private_imager_scratch.h"
 #include "utility/oskar_timer.h"
 
 #include <stdlib.h>
@@ -54,17 +55,7 @@ oskar_Imager* oskar_imager_create(int imager_precision, int* status)
 
     /* Create scratch arrays. */
     h->imager_prec = imager_precision;
-    h->uu_im       = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->vv_im       = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->ww_im       = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->uu_tmp      = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->vv_tmp      = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->ww_tmp      = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->vis_im      = oskar_mem_create(imager_precision | OSKAR_COMPLEX,
-            OSKAR_CPU, 0, status);
-    h->weight_im   = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->weight_tmp  = oskar_mem_create(imager_precision, OSKAR_CPU, 0, status);
-    h->time_im     = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 0, status);
+    oskar_imager_scratch_resize(h, 1, 0, status);
 
     /* Check data type. */
     if (imager_precision != OSKAR_SINGLE && imager_precision != OSKAR_DOUBLE)
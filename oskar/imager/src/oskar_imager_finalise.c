@@ -26,21 +26,18 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef OSKAR_HAVE_CUDA
-#include <cufft.h>
-#endif
-
 #include "imager/private_imager.h"
 #include "imager/oskar_imager.h"
 
 #include "imager/oskar_grid_correction.h"
-#include "imager/oskar_grid_functions_pillbox.h"
-#include "imager/oskar_grid_functions_spheroidal.h"
-#include "math/oskar_fftpack_cfft.h"
-#include "math/oskar_fftpack_cfft_f.h"
+#include "imager/private_imager_finalise_wstack.h"
+#include "imager/private_imager_fold_uv.h"
+#include "imager/private_imager_init_finalise.h"
+#include "math/oskar_fft.h"
 #include "math/oskar_fftphase.h"
 #include "mem/oskar_mem.h"
 #include "utility/oskar_device_utils.h"
+#include "utility/oskar_thread.h"
 #include "utility/oskar_timer.h"
 
 #include <fitsio.h>
@@ -48,12 +45,24 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+static void finalise_plane(oskar_Imager* h, oskar_Mem* plane,
+        double plane_norm, int region_size, int* status);
+static void trim_plane(oskar_Mem* plane, int plane_size, int image_size,
+        int* status);
+static void fft_plane(oskar_Imager* h, oskar_Mem* plane, int size,
+        int region_size, int* status);
 static void write_plane(oskar_Imager* h, oskar_Mem* plane,
         int c, int p, int* status);
+static void finalise_and_write_planes(oskar_Imager* h, int plane_size,
+        int num_threads, int* status);
 
 
 void oskar_imager_finalise(oskar_Imager* h,
@@ -61,18 +70,19 @@ void oskar_imager_finalise(oskar_Imager* h,
         int num_output_grids, oskar_Mem** output_grids, int* status)
 {
     size_t n;
-    int c, p, i, plane_size;
+    int i, plane_size, num_threads = 1;
     if (*status || !h->planes) return;
 
     /* Adjust normalisation if required. */
     if (h->scale_norm_with_num_input_files)
     {
-        for (i = 0; i < h->num_planes; ++i)
+        for (i = h->batch_start; i < h->batch_end; ++i)
             h->plane_norm[i] /= h->num_files;
     }
 
     /* Copy grids to output grid planes if given. */
-    for (i = 0; (i < h->num_planes) && (i < num_output_grids); ++i)
+    for (i = h->batch_start; (i < h->batch_end) && (i < num_output_grids);
+            ++i)
     {
         if (!(output_grids[i]))
             output_grids[i] = oskar_mem_create(oskar_mem_type(h->planes[i]),
@@ -87,17 +97,20 @@ void oskar_imager_finalise(oskar_Imager* h,
         n = h->image_size * h->image_size;
         plane_size = oskar_imager_plane_size(h);
 
-        /* Finalise all the planes. */
-        for (i = 0; i < h->num_planes; ++i)
-        {
-            oskar_imager_finalise_plane(h, h->planes[i],
-                    h->plane_norm[i], status);
-            oskar_imager_trim_image(h, h->planes[i],
-                    plane_size, h->image_size, status);
-        }
+        /* Finalise all the planes. If there are enough of them to
+         * occupy all threads, transform them concurrently on the CPU,
+         * otherwise let each FFT use all the threads instead. */
+        oskar_imager_init_finalise(h, plane_size, status);
+#ifdef _OPENMP
+        if ((!h->fft || oskar_fft_location(h->fft) == OSKAR_CPU) &&
+                h->batch_end - h->batch_start >= omp_get_max_threads())
+            num_threads = omp_get_max_threads();
+#endif
+        finalise_and_write_planes(h, plane_size, num_threads, status);
 
         /* Copy images to output image planes if given. */
-        for (i = 0; (i < h->num_planes) && (i < num_output_images); ++i)
+        for (i = h->batch_start;
+                (i < h->batch_end) && (i < num_output_images); ++i)
         {
             if (!(output_images[i]))
                 output_images[i] = oskar_mem_create(h->imager_prec,
@@ -108,13 +121,18 @@ void oskar_imager_finalise(oskar_Imager* h,
                     oskar_mem_void_const(h->planes[i]),
                     n * oskar_mem_element_size(h->imager_prec));
         }
+    }
 
-        /* Write to files if required. */
-        oskar_timer_resume(h->tmr_write);
-        for (c = 0, i = 0; c < h->num_im_channels; ++c)
-            for (p = 0; p < h->num_im_pols; ++p, ++i)
-                write_plane(h, h->planes[i], c, p, status);
-        oskar_timer_pause(h->tmr_write);
+    /* Free the planes of this batch if there are more to come. */
+    if (h->batch_end < h->num_planes)
+    {
+        for (i = h->batch_start; i < h->batch_end; ++i)
+        {
+            oskar_mem_free(h->planes[i], status);
+            h->planes[i] = 0;
+            oskar_mem_realloc(h->weights_grids[i], 0, status);
+        }
+        return;
     }
 
     /* Record time taken. */
@@ -176,6 +194,27 @@ void oskar_imager_finalise(oskar_Imager* h,
 
 void oskar_imager_finalise_plane(oskar_Imager* h,
         oskar_Mem* plane, double plane_norm, int* status)
+{
+    if (*status) return;
+    oskar_timer_resume(h->tmr_grid_finalise);
+    oskar_imager_init_finalise(h, oskar_imager_plane_size(h), status);
+    finalise_plane(h, plane, plane_norm, oskar_imager_plane_size(h), status);
+    oskar_timer_pause(h->tmr_grid_finalise);
+}
+
+
+void oskar_imager_trim_image(oskar_Imager* h, oskar_Mem* plane,
+        int plane_size, int image_size, int* status)
+{
+    if (*status) return;
+    oskar_timer_resume(h->tmr_grid_finalise);
+    trim_plane(plane, plane_size, image_size, status);
+    oskar_timer_pause(h->tmr_grid_finalise);
+}
+
+
+void finalise_plane(oskar_Imager* h, oskar_Mem* plane,
+        double plane_norm, int region_size, int* status)
 {
     int size;
     size_t num_cells;
@@ -183,11 +222,7 @@ void oskar_imager_finalise_plane(oskar_Imager* h,
 
     /* Apply normalisation. */
     if (plane_norm > 0.0 || plane_norm < 0.0)
-    {
-        oskar_timer_resume(h->tmr_grid_finalise);
         oskar_mem_scale_real(plane, 1.0 / plane_norm, status);
-        oskar_timer_pause(h->tmr_grid_finalise);
-    }
 
     /* If algorithm if DFT, we've finished here. */
     if (h->algorithm == OSKAR_ALGORITHM_DFT_2D ||
@@ -201,96 +236,29 @@ void oskar_imager_finalise_plane(oskar_Imager* h,
         return;
     }
 
-    /* Check plane size is as expected. */
+    /* Expand the plane to a full grid if it holds only half of it. */
     size = oskar_imager_plane_size(h);
     num_cells = size * size;
-    if (oskar_mem_length(plane) != num_cells)
+    if (oskar_mem_length(plane) == oskar_imager_half_plane_cells(h))
+        oskar_imager_unfold_grid(h, plane, status);
+    if (*status) return;
+
+    /* Check plane size is as expected. */
+    if (oskar_mem_length(plane) != num_cells *
+            (h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+                    h->algorithm == OSKAR_ALGORITHM_NUFFT_3D ?
+                            h->num_w_planes : 1))
     {
         *status = OSKAR_ERR_DIMENSION_MISMATCH;
         return;
     }
 
-    /* Perform FFT shift of the input grid. */
-    oskar_timer_resume(h->tmr_grid_finalise);
-    if (oskar_mem_precision(plane) == OSKAR_DOUBLE)
-        oskar_fftphase_cd(size, size, oskar_mem_double(plane, status));
+    /* Transform the grid to the image plane. */
+    if (h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
+        oskar_imager_finalise_wstack(h, plane, status);
     else
-        oskar_fftphase_cf(size, size, oskar_mem_float(plane, status));
-
-    /* Call FFT. */
-#ifdef OSKAR_HAVE_CUDA
-    if (h->fft_on_gpu && h->num_gpus > 0)
-    {
-        size_t work_size = 0;
-        oskar_Mem *plane_gpu = 0, *plane_ptr = 0;
-        oskar_device_set(h->gpu_ids[0], status);
-        if (cufftGetSize(h->cufft_plan, &work_size) != CUFFT_SUCCESS)
-            cufftPlan2d(&h->cufft_plan, size, size,
-                    (h->imager_prec == OSKAR_DOUBLE) ? CUFFT_Z2Z : CUFFT_C2C);
-        plane_ptr = plane;
-        if (oskar_mem_location(plane) != OSKAR_GPU)
-        {
-            plane_gpu = oskar_mem_create_copy(plane, OSKAR_GPU, status);
-            plane_ptr = plane_gpu;
-        }
-        if (h->imager_prec == OSKAR_DOUBLE)
-            cufftExecZ2Z(h->cufft_plan, oskar_mem_void(plane_ptr),
-                    oskar_mem_void(plane_ptr), CUFFT_FORWARD);
-        else
-            cufftExecC2C(h->cufft_plan, oskar_mem_void(plane_ptr),
-                    oskar_mem_void(plane_ptr), CUFFT_FORWARD);
-        if (oskar_mem_location(plane) != OSKAR_GPU)
-            oskar_mem_copy(plane, plane_ptr, status);
-        oskar_mem_free(plane_gpu, status);
-    }
-    else
-#endif
-    {
-        if (!h->fftpack_work)
-            h->fftpack_work = oskar_mem_create(h->imager_prec, OSKAR_CPU,
-                    2 * num_cells, status);
-        if (!h->fftpack_wsave)
-        {
-            int len = 4 * size + 2 * (int)(log((double)size) / log(2.0)) + 8;
-            h->fftpack_wsave = oskar_mem_create(h->imager_prec, OSKAR_CPU,
-                    len, status);
-            if (h->imager_prec == OSKAR_DOUBLE)
-                oskar_fftpack_cfft2i(size, size,
-                        oskar_mem_double(h->fftpack_wsave, status));
-            else
-                oskar_fftpack_cfft2i_f(size, size,
-                        oskar_mem_float(h->fftpack_wsave, status));
-        }
-        if (h->imager_prec == OSKAR_DOUBLE)
-            oskar_fftpack_cfft2f(size, size, size,
-                    oskar_mem_double(plane, status),
-                    oskar_mem_double(h->fftpack_wsave, status),
-                    oskar_mem_double(h->fftpack_work, status));
-        else
-            oskar_fftpack_cfft2f_f(size, size, size,
-                    oskar_mem_float(plane, status),
-                    oskar_mem_float(h->fftpack_wsave, status),
-                    oskar_mem_float(h->fftpack_work, status));
-        oskar_mem_scale_real(plane, (double)num_cells, status);
-    }
-
-    /* Generate grid correction function if required. */
-    if (!h->corr_func)
-    {
-        h->corr_func = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, size, status);
-        if (h->algorithm != OSKAR_ALGORITHM_FFT)
-            oskar_grid_correction_function_spheroidal(size, h->oversample,
-                    oskar_mem_double(h->corr_func, status));
-        else
-        {
-            if (h->kernel_type == 'S')
-                oskar_grid_correction_function_spheroidal(size, 0,
-                        oskar_mem_double(h->corr_func, status));
-            else if (h->kernel_type == 'P')
-                oskar_grid_correction_function_pillbox(size,
-                        oskar_mem_double(h->corr_func, status));
-        }
-    }
+        fft_plane(h, plane, size, region_size, status);
 
     /* FFT shift again, and apply grid correction. */
     if (oskar_mem_precision(plane) == OSKAR_DOUBLE)
@@ -305,18 +273,16 @@ void oskar_imager_finalise_plane(oskar_Imager* h,
         oskar_grid_correction_f(size, oskar_mem_double(h->corr_func, status),
                 oskar_mem_float(plane, status));
     }
-    oskar_timer_pause(h->tmr_grid_finalise);
 }
 
 
-void oskar_imager_trim_image(oskar_Imager* h, oskar_Mem* plane,
-        int plane_size, int image_size, int* status)
+void trim_plane(oskar_Mem* plane, int plane_size, int image_size,
+        int* status)
 {
     int size_diff;
     if (*status) return;
 
     /* Get the real part only, if the plane is complex. */
-    oskar_timer_resume(h->tmr_grid_finalise);
     if (oskar_mem_is_complex(plane))
     {
         size_t i, num_cells;
@@ -352,7 +318,25 @@ void oskar_imager_trim_image(oskar_Imager* h, oskar_Mem* plane,
             out += copy_len;
         }
     }
-    oskar_timer_pause(h->tmr_grid_finalise);
+}
+
+
+void fft_plane(oskar_Imager* h, oskar_Mem* plane, int size,
+        int region_size, int* status)
+{
+    /* Perform FFT shift of the input grid. */
+    if (oskar_mem_precision(plane) == OSKAR_DOUBLE)
+        oskar_fftphase_cd(size, size, oskar_mem_double(plane, status));
+    else
+        oskar_fftphase_cf(size, size, oskar_mem_float(plane, status));
+
+    /* Call FFT. Only the central region that will be kept after
+     * trimming needs to be computed, and only its real part if the grid
+     * was folded into half the UV plane. */
+    if (oskar_fft_location(h->fft) == OSKAR_GPU)
+        oskar_device_set(h->gpu_ids[0], status);
+    oskar_fft_exec_pruned(h->fft, plane, (size - region_size) / 2,
+            region_size, h->grid_half_plane, status);
 }
 
 
@@ -360,19 +344,174 @@ void write_plane(oskar_Imager* h, oskar_Mem* plane,
         int c, int p, int* status)
 {
     int datatype, num_pixels;
-    long firstpix[3];
+    long firstpix[4];
     if (*status) return;
     if (!h->fits_file[p]) return;
     datatype = (oskar_mem_is_double(plane) ? TDOUBLE : TFLOAT);
     firstpix[0] = 1;
     firstpix[1] = 1;
-    firstpix[2] = 1 + c;
+    firstpix[2] = 1 + c % h->num_im_channels;
+    firstpix[3] = 1 + c / h->num_im_channels;
     num_pixels = h->image_size * h->image_size;
     fits_write_pix(h->fits_file[p], datatype, firstpix, num_pixels,
             oskar_mem_void(plane), status);
 }
 
 
+
+/*
+ * Planes are finalised in rounds. While one round is being finalised,
+ * the planes of the previous round are written by dedicated writer
+ * threads: one per FITS file if CFITSIO is thread-safe, otherwise one
+ * for all of them. Each file is still written in channel order.
+ */
+struct WritePipeline
+{
+    oskar_Imager* h;
+    oskar_Barrier* barrier;
+    int num_writers, num_rounds, round_size, finalise_status, status;
+    int* writer_status;
+};
+typedef struct WritePipeline WritePipeline;
+
+struct WriterArgs
+{
+    WritePipeline* pipe;
+    int writer_id;
+};
+typedef struct WriterArgs WriterArgs;
+
+static void write_pipeline_sync(WritePipeline* pipe, int is_writer)
+{
+    int i;
+
+    /* Barrier 1: Wait for both the finalise and the writes to finish. */
+    if (pipe->num_writers > 0) oskar_barrier_wait(pipe->barrier);
+    if (!is_writer)
+    {
+        pipe->status = pipe->finalise_status;
+        for (i = 0; i < pipe->num_writers && !pipe->status; ++i)
+            pipe->status = pipe->writer_status[i];
+    }
+
+    /* Barrier 2: Make the combined status visible to all threads. */
+    if (pipe->num_writers > 0) oskar_barrier_wait(pipe->barrier);
+}
+
+static void* write_rounds(void* arg)
+{
+    int r, i, i_end;
+    WritePipeline* pipe = ((WriterArgs*)arg)->pipe;
+    const int writer_id = ((WriterArgs*)arg)->writer_id;
+    oskar_Imager* h = pipe->h;
+    int* status = &pipe->writer_status[writer_id];
+
+    /* Write the planes of the previous round. */
+    for (r = 0; r < pipe->num_rounds + 1; ++r)
+    {
+        if (r > 0 && !pipe->status)
+        {
+            if (writer_id == 0) oskar_timer_resume(h->tmr_write);
+            i = h->batch_start + (r - 1) * pipe->round_size;
+            i_end = i + pipe->round_size;
+            if (i_end > h->batch_end) i_end = h->batch_end;
+            for (; i < i_end; ++i)
+            {
+                const int c = i / h->num_im_pols, p = i % h->num_im_pols;
+                if (p % pipe->num_writers == writer_id)
+                    write_plane(h, h->planes[i], c, p, status);
+            }
+            if (writer_id == 0) oskar_timer_pause(h->tmr_write);
+        }
+        write_pipeline_sync(pipe, 1);
+    }
+    return 0;
+}
+
+void finalise_and_write_planes(oskar_Imager* h, int plane_size,
+        int num_threads, int* status)
+{
+    int i, r;
+    WritePipeline pipe;
+    WriterArgs* args = 0;
+    oskar_Thread** threads = 0;
+    if (*status) return;
+
+    /* Set up writer threads, if there are files to write. */
+    memset(&pipe, 0, sizeof(WritePipeline));
+    pipe.h = h;
+    pipe.round_size = h->batch_end - h->batch_start;
+    if (h->fits_file[0])
+    {
+        pipe.num_writers = fits_is_reentrant() ? h->num_im_pols : 1;
+        pipe.round_size = num_threads;
+        pipe.barrier = oskar_barrier_create(pipe.num_writers + 1);
+        pipe.writer_status = (int*) calloc(pipe.num_writers, sizeof(int));
+        args = (WriterArgs*) calloc(pipe.num_writers, sizeof(WriterArgs));
+        threads = (oskar_Thread**) calloc(pipe.num_writers,
+                sizeof(oskar_Thread*));
+        for (i = 0; i < pipe.num_writers; ++i)
+        {
+            args[i].pipe = &pipe;
+            args[i].writer_id = i;
+            threads[i] = oskar_thread_create(write_rounds,
+                    (void*)&args[i], 0);
+        }
+    }
+    if (pipe.round_size < 1) pipe.round_size = 1;
+    pipe.num_rounds = (h->batch_end - h->batch_start +
+            pipe.round_size - 1) / pipe.round_size;
+
+    /* Finalise each round while the previous one is written.
+     * Nothing is written on the first loop counter, and nothing is
+     * finalised on the last. */
+    for (r = 0; r < pipe.num_rounds + 1; ++r)
+    {
+        const int i_start = h->batch_start + r * pipe.round_size;
+        int i_end = i_start + pipe.round_size;
+        if (i_end > h->batch_end) i_end = h->batch_end;
+        if (r < pipe.num_rounds && !pipe.status)
+        {
+            oskar_timer_resume(h->tmr_grid_finalise);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+            for (i = i_start; i < i_end; ++i)
+            {
+                int plane_status = 0;
+                if (pipe.finalise_status) continue;
+                finalise_plane(h, h->planes[i], h->plane_norm[i],
+                        h->image_size, &plane_status);
+                trim_plane(h->planes[i], plane_size, h->image_size,
+                        &plane_status);
+
+                /* Release the memory used to expand a half plane. */
+                if (oskar_imager_half_plane_cells(h) > 0)
+                    oskar_mem_realloc(h->planes[i],
+                            oskar_imager_half_plane_cells(h), &plane_status);
+                if (plane_status)
+                {
+#pragma omp critical (imager_finalise_status)
+                    pipe.finalise_status = plane_status;
+                }
+            }
+            oskar_timer_pause(h->tmr_grid_finalise);
+        }
+        write_pipeline_sync(&pipe, 0);
+    }
+
+    /* Wait for the writer threads to finish. */
+    for (i = 0; i < pipe.num_writers; ++i)
+    {
+        oskar_thread_join(threads[i]);
+        oskar_thread_free(threads[i]);
+    }
+    oskar_barrier_free(pipe.barrier);
+    free(pipe.writer_status);
+    free(threads);
+    free(args);
+    *status = pipe.status;
+}
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,7 @@
 #include "imager/oskar_imager_free.h"
 #include "imager/oskar_imager_reset_cache.h"
 #include "imager/private_imager_free_device_data.h"
+#include "imager/private_imager_scratch.h"
 #include "utility/oskar_timer.h"
 #include "utility/oskar_device_utils.h"
 #include <stdlib.h>
@@ -44,16 +45,8 @@ void oskar_imager_free(oskar_Imager* h, int* status)
     int i;
     if (!h) return;
     oskar_imager_reset_cache(h, status);
-    oskar_mem_free(h->uu_im, status);
-    oskar_mem_free(h->vv_im, status);
-    oskar_mem_free(h->ww_im, status);
-    oskar_mem_free(h->uu_tmp, status);
-    oskar_mem_free(h->vv_tmp, status);
-    oskar_mem_free(h->ww_tmp, status);
-    oskar_mem_free(h->vis_im, status);
-    oskar_mem_free(h->weight_im, status);
-    oskar_mem_free(h->weight_tmp, status);
-    oskar_mem_free(h->time_im, status);
+    oskar_imager_scratch_free(h, status);
+    oskar_mem_free(h->model_image, status);
     oskar_timer_free(h->tmr_grid_finalise);
     oskar_timer_free(h->tmr_grid_update);
     oskar_timer_free(h->tmr_init);
@@ -73,6 +66,7 @@ void oskar_imager_free(oskar_Imager* h, int* status)
     free(h->input_root);
     free(h->output_root);
     free(h->ms_column);
+    free(h->w_kernel_cache_dir);
     free(h->gpu_ids);
     free(h->d);
     free(h);
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/oskar_degrid_simple.h"
+#include "imager/oskar_degrid_wproj.h"
+#include "imager/oskar_grid_correction.h"
+#include "imager/private_imager_init_finalise.h"
+#include "imager/private_imager_scratch.h"
+#include "math/oskar_fft.h"
+#include "math/oskar_fftphase.h"
+#include "utility/oskar_device_utils.h"
+#include "utility/oskar_timer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void transform_model(oskar_Imager* h, int* status);
+
+
+void oskar_imager_set_model_image(oskar_Imager* h, const oskar_Mem* image,
+        int* status)
+{
+    oskar_Mem* tmp;
+    if (*status) return;
+
+    /* Check the image is real and of the expected size. */
+    if (oskar_mem_is_complex(image) || oskar_mem_is_matrix(image))
+    {
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+        return;
+    }
+    if (oskar_mem_length(image) != (size_t)h->image_size * h->image_size)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+
+    /* Keep a copy of the image in CPU memory, at the imager precision. */
+    tmp = oskar_mem_create_copy(image, OSKAR_CPU, status);
+    oskar_mem_free(h->model_image, status);
+    h->model_image = oskar_mem_convert_precision(tmp, h->imager_prec, status);
+    oskar_mem_free(tmp, status);
+
+    /* The transformed model must be regenerated. */
+    oskar_mem_free(h->model_grid, status);
+    h->model_grid = 0;
+}
+
+
+void oskar_imager_predict(oskar_Imager* h, size_t num_vis,
+        const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* ww,
+        oskar_Mem* amps, int* status)
+{
+    int grid_size;
+    size_t num_skipped = 0;
+    if (*status || num_vis == 0) return;
+
+    /* Check the algorithm and the data. */
+    if (h->algorithm != OSKAR_ALGORITHM_FFT &&
+            h->algorithm != OSKAR_ALGORITHM_WPROJ)
+    {
+        *status = OSKAR_ERR_FUNCTION_NOT_AVAILABLE;
+        return;
+    }
+    if (!h->model_image)
+    {
+        *status = OSKAR_ERR_MEMORY_NOT_ALLOCATED;
+        return;
+    }
+    if (oskar_mem_type(amps) != (h->imager_prec | OSKAR_COMPLEX) ||
+            oskar_mem_location(amps) != OSKAR_CPU)
+    {
+        *status = OSKAR_ERR_TYPE_MISMATCH;
+        return;
+    }
+    if (oskar_mem_length(amps) < num_vis)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+
+    /* Initialise the kernels and transform the model if required. */
+    oskar_imager_check_init(h, status);
+    oskar_timer_resume(h->tmr_grid_update);
+    transform_model(h, status);
+
+    /* Convert precision of input coordinates into workspaces if required. */
+    uu = oskar_imager_scratch_convert(h, uu, &h->conv_uu, num_vis, status);
+    vv = oskar_imager_scratch_convert(h, vv, &h->conv_vv, num_vis, status);
+    ww = oskar_imager_scratch_convert(h, ww, &h->conv_ww, num_vis, status);
+    if (*status)
+    {
+        oskar_timer_pause(h->tmr_grid_update);
+        return;
+    }
+
+    /* Degrid the transformed model. */
+    grid_size = oskar_imager_plane_size(h);
+    if (h->algorithm == OSKAR_ALGORITHM_FFT)
+    {
+        if (h->imager_prec == OSKAR_DOUBLE)
+            oskar_degrid_simple_d(h->support, h->oversample,
+                    oskar_mem_double_const(h->conv_func, status), num_vis,
+                    oskar_mem_double_const(uu, status),
+                    oskar_mem_double_const(vv, status),
+                    h->cellsize_rad, grid_size,
+                    oskar_mem_double_const(h->model_grid, status),
+                    &num_skipped, oskar_mem_double(amps, status));
+        else
+            oskar_degrid_simple_f(h->support, h->oversample,
+                    oskar_mem_float_const(h->conv_func, status), num_vis,
+                    oskar_mem_float_const(uu, status),
+                    oskar_mem_float_const(vv, status),
+                    (float) (h->cellsize_rad), grid_size,
+                    oskar_mem_float_const(h->model_grid, status),
+                    &num_skipped, oskar_mem_float(amps, status));
+    }
+    else
+    {
+        if (h->imager_prec == OSKAR_DOUBLE)
+            oskar_degrid_wproj_d(h->num_w_planes,
+                    oskar_mem_int_const(h->w_support, status),
+                    h->oversample, h->conv_size_half,
+                    oskar_mem_double_const(h->w_kernels, status), num_vis,
+                    oskar_mem_double_const(uu, status),
+                    oskar_mem_double_const(vv, status),
+                    oskar_mem_double_const(ww, status),
+                    h->cellsize_rad, h->w_scale, grid_size,
+                    oskar_mem_double_const(h->model_grid, status),
+                    &num_skipped, oskar_mem_double(amps, status));
+        else
+            oskar_degrid_wproj_f(h->num_w_planes,
+                    oskar_mem_int_const(h->w_support, status),
+                    h->oversample, h->conv_size_half,
+                    oskar_mem_float_const(h->w_kernels, status), num_vis,
+                    oskar_mem_float_const(uu, status),
+                    oskar_mem_float_const(vv, status),
+                    oskar_mem_float_const(ww, status),
+                    (float) (h->cellsize_rad), (float) (h->w_scale),
+                    grid_size, oskar_mem_float_const(h->model_grid, status),
+                    &num_skipped, oskar_mem_float(amps, status));
+    }
+    oskar_timer_pause(h->tmr_grid_update);
+    if (num_skipped > 0)
+        printf("WARNING: Skipped %lu visibility points.\n",
+                (unsigned long) num_skipped);
+}
+
+
+/* Generates the grid to degrid from the model image. This is the adjoint
+ * of finalising a plane: the grid correction is applied to the padded
+ * image, which is then transformed by an inverse FFT. As the model is real,
+ * the inverse transform is the conjugate of the forward transform. */
+void transform_model(oskar_Imager* h, int* status)
+{
+    int size, offset, y;
+    size_t i, num_cells, element_size, row_bytes;
+    char *grid;
+    const char *image;
+    if (*status || h->model_grid) return;
+
+    /* Copy the model image into the real part of the centre of the grid. */
+    size = oskar_imager_plane_size(h);
+    num_cells = (size_t)size * size;
+    offset = (size - h->image_size) / 2;
+    oskar_imager_init_finalise(h, size, status);
+    h->model_grid = oskar_mem_create(h->imager_prec | OSKAR_COMPLEX,
+            OSKAR_CPU, num_cells, status);
+    oskar_mem_clear_contents(h->model_grid, status);
+    if (*status) return;
+    grid = oskar_mem_char(h->model_grid);
+    image = oskar_mem_char_const(h->model_image);
+    element_size = oskar_mem_element_size(h->imager_prec);
+    row_bytes = element_size * h->image_size;
+    for (y = 0; y < h->image_size; ++y)
+    {
+        int x;
+        const char* in = image + y * row_bytes;
+        char* out = grid + 2 * element_size *
+                ((size_t)(y + offset) * size + offset);
+        for (x = 0; x < h->image_size; ++x)
+            memcpy(out + 2 * x * element_size, in + x * element_size,
+                    element_size);
+    }
+
+    /* Apply grid correction, and transform with FFT shifts either side. */
+    if (h->imager_prec == OSKAR_DOUBLE)
+    {
+        double* t = oskar_mem_double(h->model_grid, status);
+        oskar_grid_correction_d(size, oskar_mem_double(h->corr_func, status),
+                t);
+        oskar_fftphase_cd(size, size, t);
+        if (oskar_fft_location(h->fft) == OSKAR_GPU)
+            oskar_device_set(h->gpu_ids[0], status);
+        oskar_fft_exec(h->fft, h->model_grid, status);
+        oskar_fftphase_cd(size, size, t);
+        for (i = 0; i < num_cells; ++i) t[2 * i + 1] = -t[2 * i + 1];
+    }
+    else
+    {
+        float* t = oskar_mem_float(h->model_grid, status);
+        oskar_grid_correction_f(size, oskar_mem_double(h->corr_func, status),
+                t);
+        oskar_fftphase_cf(size, size, t);
+        if (oskar_fft_location(h->fft) == OSKAR_GPU)
+            oskar_device_set(h->gpu_ids[0], status);
+        oskar_fft_exec(h->fft, h->model_grid, status);
+        oskar_fftphase_cf(size, size, t);
+        for (i = 0; i < num_cells; ++i) t[2 * i + 1] = -t[2 * i + 1];
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -26,12 +26,10 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef OSKAR_HAVE_CUDA
-#include <cufft.h>
-#endif
-
 #include "imager/private_imager.h"
 #include "imager/oskar_imager_reset_cache.h"
+#include "imager/private_imager_scratch.h"
+#include "imager/private_imager_w_kernel_cache.h"
 #include <fitsio.h>
 
 #include <stdlib.h>
@@ -51,18 +49,19 @@ void oskar_imager_reset_cache(oskar_Imager* h, int* status)
     h->im_freqs = 0;
     h->num_sel_freqs = 0;
     h->num_im_channels = 0;
+    h->num_im_times = 0;
+    h->vis_time_start_utc = 0.0;
+    h->vis_time_end_utc = 0.0;
+    h->im_time_start_utc = 0.0;
+    h->vis_block_rows = 0;
+    h->vis_block_chans = 0;
+    h->vis_block_bytes = 0;
 
     /* Clear FFT caches. */
     oskar_mem_free(h->corr_func, status);
-    oskar_mem_free(h->fftpack_wsave, status);
-    oskar_mem_free(h->fftpack_work, status);
-#ifdef OSKAR_HAVE_CUDA
-    cufftDestroy(h->cufft_plan);
-    h->cufft_plan = 0;
-#endif
+    oskar_fft_free(h->fft);
     h->corr_func = 0;
-    h->fftpack_wsave = 0;
-    h->fftpack_work = 0;
+    h->fft = 0;
 
     /* Clear algorithm-specific caches. */
     oskar_mem_free(h->l, status); h->l = 0;
@@ -70,9 +69,12 @@ void oskar_imager_reset_cache(oskar_Imager* h, int* status)
     oskar_mem_free(h->n, status); h->n = 0;
     oskar_mem_free(h->conv_func, status); h->conv_func = 0;
     oskar_mem_free(h->w_kernels, status); h->w_kernels = 0;
+    oskar_imager_w_kernel_cache_release(h);
     oskar_mem_free(h->w_support, status); h->w_support = 0;
     oskar_mem_free(h->w_kernels_compact, status); h->w_kernels_compact = 0;
     oskar_mem_free(h->w_kernel_start, status); h->w_kernel_start = 0;
+    oskar_mem_free(h->n_minus_1, status); h->n_minus_1 = 0;
+    oskar_mem_free(h->model_grid, status); h->model_grid = 0;
 
     /* Free the image planes. */
     if (h->planes)
@@ -89,18 +91,10 @@ void oskar_imager_reset_cache(oskar_Imager* h, int* status)
             oskar_mem_free(h->weights_grids[i], status);
     free(h->weights_grids);
     h->weights_grids = 0;
+    h->weights_grids_pending = 0;
 
     /* Collapse temp arrays. */
-    oskar_mem_realloc(h->uu_im, 0, status);
-    oskar_mem_realloc(h->vv_im, 0, status);
-    oskar_mem_realloc(h->ww_im, 0, status);
-    oskar_mem_realloc(h->uu_tmp, 0, status);
-    oskar_mem_realloc(h->vv_tmp, 0, status);
-    oskar_mem_realloc(h->ww_tmp, 0, status);
-    oskar_mem_realloc(h->vis_im, 0, status);
-    oskar_mem_realloc(h->weight_im, 0, status);
-    oskar_mem_realloc(h->weight_tmp, 0, status);
-    oskar_mem_realloc(h->time_im, 0, status);
+    oskar_imager_scratch_collapse(h, status);
     oskar_mem_free(h->stokes, status);
     h->stokes = 0;
 
@@ -116,6 +110,8 @@ void oskar_imager_reset_cache(oskar_Imager* h, int* status)
 
     /* Clear the number of image planes. */
     h->num_planes = 0;
+    h->batch_start = 0;
+    h->batch_end = 0;
 }
 
 #ifdef __cplusplus
@@ -27,25 +27,40 @@
  */
 
 #include "imager/private_imager.h"
+#include "imager/private_imager_fold_uv.h"
 #include "imager/private_imager_read_coords.h"
 #include "imager/private_imager_read_data.h"
 #include "imager/private_imager_read_dims.h"
+#include "imager/private_imager_set_num_planes.h"
 #include "imager/oskar_imager.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 static int oskar_imager_is_ms(const char* filename);
+static int images_per_batch(oskar_Imager* h, double* image_bytes,
+        double* fixed_bytes);
+static double fixed_memory(oskar_Imager* h);
+static void set_batch(oskar_Imager* h, int first_image, int num_images);
+static void log_init(oskar_Imager* h, int num_images, double image_bytes,
+        double fixed_bytes);
 
 void oskar_imager_run(oskar_Imager* h,
         int num_output_images, oskar_Mem** output_images,
         int num_output_grids, oskar_Mem** output_grids, int* status)
 {
-    int i, num_files, percent_done = 0, percent_next = 10;
+    int c, i, num_files, num_images, read_coords, uniform;
+    int percent_done = 0, percent_next = 10;
+    double image_bytes = 0.0, fixed_bytes = 0.0;
     const char* filename;
     if (*status) return;
 
@@ -100,89 +115,262 @@ void oskar_imager_run(oskar_Imager* h,
         return;
     }
 
-    /* Read baseline coordinates and weights if required. */
-    if (h->weighting == OSKAR_WEIGHTING_UNIFORM ||
-            h->algorithm == OSKAR_ALGORITHM_WPROJ)
+    /* Work out how many images can be made at once.
+     * Each image is one channel of one time snapshot. */
+    oskar_imager_set_num_planes(h, status);
+    if (*status)
+    {
+        oskar_imager_reset_cache(h, status);
+        return;
+    }
+    num_images = images_per_batch(h, &image_bytes, &fixed_bytes);
+    if (h->log && h->time_snap_interval_sec > 0.0)
+        oskar_log_message(h->log, 'M', 0, "Using %d time snapshot(s) "
+                "of %.3f sec", h->num_im_times, h->time_snap_interval_sec);
+    uniform = (h->weighting == OSKAR_WEIGHTING_UNIFORM ||
+            h->weighting == OSKAR_WEIGHTING_BRIGGS);
+    read_coords = uniform ||
+            h->algorithm == OSKAR_ALGORITHM_WPROJ ||
+            h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D;
+
+    /* Loop over batches of images. */
+    for (c = 0; c < h->num_planes / h->num_im_pols && !*status;
+            c += num_images)
     {
-        oskar_imager_set_coords_only(h, 1);
+        set_batch(h, c, num_images);
+
+        /* Read baseline coordinates and weights if required.
+         * After the first batch, these are needed only for the weights. */
+        if (read_coords && (c == 0 || uniform))
+        {
+            oskar_imager_set_coords_only(h, 1);
+            if (h->log)
+                oskar_log_section(h->log, 'M', "Reading coordinates...");
+
+            /* Loop over input files. */
+            percent_done = 0; percent_next = 10;
+            for (i = 0; i < num_files; ++i)
+            {
+                /* Read coordinates and weights. */
+                if (*status) break;
+                filename = h->input_files[i];
+                if (h->log)
+                    oskar_log_message(h->log, 'M', 0, "Opening '%s'",
+                            filename);
+                if (oskar_imager_is_ms(filename))
+                    oskar_imager_read_coords_ms(h, filename, i, num_files,
+                            &percent_done, &percent_next, status);
+                else
+                    oskar_imager_read_coords_vis(h, filename, i, num_files,
+                            &percent_done, &percent_next, status);
+            }
+            oskar_imager_set_coords_only(h, 0);
+        }
+
+        /* Check for errors. */
+        if (*status) break;
+
+        /* Initialise the algorithm. */
+        if (c == 0)
+        {
+            if (h->log)
+                oskar_log_section(h->log, 'M', "Initialising algorithm...");
+            oskar_imager_check_init(h, status);
+            if (*status) break;
+
+            /* The number of W-layers is known only now, so check that
+             * the first batch is still small enough. Any weights grids
+             * made for images no longer in it are discarded. */
+            i = h->batch_end;
+            num_images = images_per_batch(h, &image_bytes, &fixed_bytes);
+            set_batch(h, c, num_images);
+            for (; i > h->batch_end; --i)
+                oskar_mem_realloc(h->weights_grids[i - 1], 0, status);
+            if (h->log)
+                log_init(h, num_images, image_bytes, fixed_bytes);
+        }
         if (h->log)
-            oskar_log_section(h->log, 'M', "Reading coordinates...");
+        {
+            if (h->batch_end - h->batch_start < h->num_planes)
+                oskar_log_section(h->log, 'M', "Reading visibility data "
+                        "for images %d to %d...",
+                        h->batch_start / h->num_im_pols,
+                        h->batch_end / h->num_im_pols - 1);
+            else
+                oskar_log_section(h->log, 'M', "Reading visibility data...");
+        }
 
         /* Loop over input files. */
+        percent_done = 0; percent_next = 10;
         for (i = 0; i < num_files; ++i)
         {
-            /* Read coordinates and weights. */
+            /* Read visibility data. */
             if (*status) break;
             filename = h->input_files[i];
             if (h->log)
                 oskar_log_message(h->log, 'M', 0, "Opening '%s'", filename);
             if (oskar_imager_is_ms(filename))
-                oskar_imager_read_coords_ms(h, filename, i, num_files,
+                oskar_imager_read_data_ms(h, filename, i, num_files,
                         &percent_done, &percent_next, status);
             else
-                oskar_imager_read_coords_vis(h, filename, i, num_files,
+                oskar_imager_read_data_vis(h, filename, i, num_files,
                         &percent_done, &percent_next, status);
         }
-        oskar_imager_set_coords_only(h, 0);
+
+        /* Check for errors. */
+        if (*status) break;
+
+        if (h->log)
+            oskar_log_section(h->log, 'M', "Finalising %d image plane(s)...",
+                    h->batch_end - h->batch_start);
+        oskar_imager_finalise(h, num_output_images, output_images,
+                num_output_grids, output_grids, status);
     }
 
     /* Check for errors. */
     if (*status)
-    {
         oskar_imager_reset_cache(h, status);
-        return;
-    }
+}
 
-    /* Initialise the algorithm. */
-    if (h->log)
-        oskar_log_section(h->log, 'M', "Initialising algorithm...");
-    oskar_imager_check_init(h, status);
-    if (h->log && !*status)
-    {
-        oskar_log_message(h->log, 'M', 0, "Plane size is %d x %d.",
-                oskar_imager_plane_size(h), oskar_imager_plane_size(h));
-        if (h->algorithm == OSKAR_ALGORITHM_WPROJ)
-        {
-            oskar_log_message(h->log, 'M', 0,
-                    "Baseline W values (wavelengths)");
-            oskar_log_message(h->log, 'M', 1, "Min: %.12e", h->ww_min);
-            oskar_log_message(h->log, 'M', 1, "Max: %.12e", h->ww_max);
-            oskar_log_message(h->log, 'M', 1, "RMS: %.12e", h->ww_rms);
-            oskar_log_message(h->log, 'M', 0, "Using %d W-planes.",
-                    oskar_imager_num_w_planes(h));
-        }
-        oskar_log_section(h->log, 'M', "Reading visibility data...");
-    }
 
-    /* Loop over input files. */
-    percent_done = 0; percent_next = 10;
-    for (i = 0; i < num_files; ++i)
+static int images_per_batch(oskar_Imager* h, double* image_bytes,
+        double* fixed_bytes)
+{
+    int num_images;
+    double plane_bytes, plane_cells;
+
+    /* Get the memory needed for the planes of each image.
+     * W-stacking and 3D NUFFT planes have a layer for each W-plane, and
+     * planes may hold only half of the UV plane. */
+    plane_cells = (double) oskar_imager_plane_size(h) *
+            (double) oskar_imager_plane_size(h);
+    plane_bytes = (oskar_imager_half_plane_cells(h) > 0 ?
+            (double) oskar_imager_half_plane_cells(h) : plane_cells) *
+            oskar_mem_element_size(oskar_imager_plane_type(h));
+    if ((h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D) && h->num_w_planes > 1)
+        plane_bytes *= h->num_w_planes;
+    if (h->weighting == OSKAR_WEIGHTING_UNIFORM ||
+            h->weighting == OSKAR_WEIGHTING_BRIGGS)
+        plane_bytes += plane_cells * oskar_mem_element_size(h->imager_prec);
+    *image_bytes = plane_bytes * h->num_im_pols;
+    *fixed_bytes = fixed_memory(h);
+
+    /* Make as many images as fit within the budget, but at least one. */
+    num_images = h->num_planes / h->num_im_pols;
+    if (h->memory_budget_gb > 0.0)
     {
-        /* Read visibility data. */
-        if (*status) break;
-        filename = h->input_files[i];
-        if (h->log)
-            oskar_log_message(h->log, 'M', 0, "Opening '%s'", filename);
-        if (oskar_imager_is_ms(filename))
-            oskar_imager_read_data_ms(h, filename, i, num_files,
-                    &percent_done, &percent_next, status);
-        else
-            oskar_imager_read_data_vis(h, filename, i, num_files,
-                    &percent_done, &percent_next, status);
+        const double budget = h->memory_budget_gb *
+                1024.0 * 1024.0 * 1024.0 - *fixed_bytes;
+        if (budget < num_images * *image_bytes)
+            num_images = (int) floor(budget / *image_bytes);
+        if (num_images < 1) num_images = 1;
     }
+    return num_images;
+}
 
-    /* Check for errors. */
-    if (*status)
+
+static double mem_bytes(const oskar_Mem* mem)
+{
+    return mem ? (double) oskar_mem_length(mem) *
+            (double) oskar_mem_element_size(oskar_mem_type(mem)) : 0.0;
+}
+
+
+/* Get the memory needed regardless of the number of images in a batch. */
+static double fixed_memory(oskar_Imager* h)
+{
+    int num_threads = 1;
+    double cells, num_vis, scratch_bytes, fixed_bytes = 0.0;
+    const double prec = (double) oskar_mem_element_size(h->imager_prec);
+
+    /* Scratch arrays for each thread that may update a plane
+     * (see oskar_imager_update()), sized for the largest block.
+     * Each holds the selected coordinates, weights and amplitudes,
+     * and a copy of the coordinates if rephasing. */
+    cells = (double) oskar_imager_plane_size(h) *
+            (double) oskar_imager_plane_size(h);
+    num_vis = (double) h->vis_block_rows *
+            (double) (h->chan_snaps ? 1 : h->vis_block_chans);
+    scratch_bytes = num_vis * prec * (h->direction_type == 'R' ? 10 : 7);
+
+    /* A full grid for each thread, if planes hold only half of it. */
+    if (oskar_imager_half_plane_cells(h) > 0)
+        scratch_bytes += cells * 2.0 * prec;
+
+    /* The work buffer used by the gridders sorts the visibilities into
+     * tiles, and W-stacking also sorts them into W-layers. */
+    if (h->algorithm == OSKAR_ALGORITHM_FFT ||
+            h->algorithm == OSKAR_ALGORITHM_WPROJ ||
+            h->algorithm == OSKAR_ALGORITHM_IDG ||
+            h->algorithm == OSKAR_ALGORITHM_WSTACK)
+        scratch_bytes += num_vis * (sizeof(int) + sizeof(size_t));
+    if (h->algorithm == OSKAR_ALGORITHM_WSTACK)
+        scratch_bytes += num_vis * (5.0 * prec + sizeof(int) +
+                sizeof(size_t));
+
+    /* The value of n - 1 at each pixel, shared by all planes. */
+    if (h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
+        fixed_bytes += cells * sizeof(double);
+#ifdef _OPENMP
+    if (h->algorithm != OSKAR_ALGORITHM_DFT_2D &&
+            h->algorithm != OSKAR_ALGORITHM_DFT_3D)
+        num_threads = omp_get_max_threads();
+#endif
+
+    /* Add the W-kernels, and the blocks held by the reader. */
+    return num_threads * scratch_bytes + fixed_bytes +
+            mem_bytes(h->w_kernels) + mem_bytes(h->w_kernels_compact) +
+            mem_bytes(h->w_support) + mem_bytes(h->w_kernel_start) +
+            OSKAR_IMAGER_READ_SLOTS * (double) h->vis_block_bytes;
+}
+
+
+static void set_batch(oskar_Imager* h, int first_image, int num_images)
+{
+    int last_image = first_image + num_images;
+    if (last_image > h->num_planes / h->num_im_pols)
+        last_image = h->num_planes / h->num_im_pols;
+    h->batch_start = first_image * h->num_im_pols;
+    h->batch_end = last_image * h->num_im_pols;
+}
+
+
+static void log_init(oskar_Imager* h, int num_images, double image_bytes,
+        double fixed_bytes)
+{
+    const int total = h->num_planes / h->num_im_pols;
+    const int num_batches = (total + num_images - 1) / num_images;
+    const double gb = 1.0 / (1024.0 * 1024.0 * 1024.0);
+    oskar_log_message(h->log, 'M', 0, "Plane size is %d x %d.",
+            oskar_imager_plane_size(h), oskar_imager_plane_size(h));
+    if (h->algorithm == OSKAR_ALGORITHM_WPROJ ||
+            h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
     {
-        oskar_imager_reset_cache(h, status);
-        return;
+        oskar_log_message(h->log, 'M', 0,
+                "Baseline W values (wavelengths)");
+        oskar_log_message(h->log, 'M', 1, "Min: %.12e", h->ww_min);
+        oskar_log_message(h->log, 'M', 1, "Max: %.12e", h->ww_max);
+        oskar_log_message(h->log, 'M', 1, "RMS: %.12e", h->ww_rms);
+        oskar_log_message(h->log, 'M', 0, "Using %d W-%s.",
+                oskar_imager_num_w_planes(h),
+                h->algorithm == OSKAR_ALGORITHM_WSTACK ?
+                        "layers" : "planes");
     }
-
-    if (h->log)
-        oskar_log_section(h->log, 'M', "Finalising %d image plane(s)...",
-                h->num_planes);
-    oskar_imager_finalise(h, num_output_images, output_images,
-            num_output_grids, output_grids, status);
+    oskar_log_message(h->log, 'M', 0, "Expected peak memory: %.3f GB "
+            "(image planes: %.3f GB).",
+            (num_images * image_bytes + fixed_bytes) * gb,
+            num_images * image_bytes * gb);
+    if (num_batches > 1)
+        oskar_log_message(h->log, 'M', 1, "Making %d image(s) in "
+                "%d batches of up to %d.", total, num_batches, num_images);
+    if (h->memory_budget_gb > 0.0 &&
+            (image_bytes + fixed_bytes) * gb > h->memory_budget_gb)
+        oskar_log_warning(h->log, "Memory budget of %.3f GB is too small "
+                "for one image.", h->memory_budget_gb);
 }
 
 
@@ -34,11 +34,16 @@
 #include "imager/private_imager_create_fits_files.h"
 #include "imager/private_imager_filter_time.h"
 #include "imager/private_imager_filter_uv.h"
+#include "imager/private_imager_fold_uv.h"
+#include "imager/private_imager_scratch.h"
 #include "imager/private_imager_set_num_planes.h"
 #include "imager/private_imager_select_data.h"
 #include "imager/private_imager_update_plane_dft.h"
 #include "imager/private_imager_update_plane_fft.h"
+#include "imager/private_imager_update_plane_idg.h"
+#include "imager/private_imager_update_plane_nufft.h"
 #include "imager/private_imager_update_plane_wproj.h"
+#include "imager/private_imager_update_plane_wstack.h"
 #include "imager/private_imager_weight_radial.h"
 #include "imager/private_imager_weight_uniform.h"
 
@@ -46,15 +51,28 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 static void oskar_imager_allocate_planes(oskar_Imager* h, int *status);
+static void update_plane(oskar_Imager* h, size_t num_vis,
+        const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* ww,
+        const oskar_Mem* amps, const oskar_Mem* weight, oskar_Mem* plane,
+        double* plane_norm, oskar_Mem* weights_grid, oskar_Mem* weight_tmp,
+        oskar_Mem** grid_work, int* status);
 static void oskar_imager_update_weights_grid(oskar_Imager* h,
         size_t num_points, const oskar_Mem* uu, const oskar_Mem* vv,
         const oskar_Mem* ww, const oskar_Mem* weight, oskar_Mem* weights_grid,
         int* status);
+static void convert_weights_grids(oskar_Imager* h, int* status);
+static void time_range(const oskar_Imager* h, size_t num_rows,
+        const oskar_Mem* time_centroid, int* time_first, int* time_last,
+        int* status);
 
 void oskar_imager_update_from_block(oskar_Imager* h,
         const oskar_VisHeader* header, const oskar_VisBlock* block,
@@ -62,10 +80,8 @@ void oskar_imager_update_from_block(oskar_Imager* h,
 {
     int t, start_time, start_chan, end_chan;
     int num_baselines, num_channels, num_pols, num_times;
-    size_t num_rows;
-    double time_start_mjd, time_inc_sec;
-    oskar_Mem *weight = 0, *weight_ptr = 0, *time_centroid, *time_slice;
-    oskar_Mem *scratch = 0;
+    size_t i, num_rows, weight_len, old_len;
+    double time_start_mjd, time_inc_sec, *time_centroid;
     const oskar_Mem* ptr;
     if (*status) return;
 
@@ -93,84 +109,51 @@ void oskar_imager_update_from_block(oskar_Imager* h,
     oskar_imager_set_vis_phase_centre(h,
             oskar_vis_header_phase_centre_ra_deg(header),
             oskar_vis_header_phase_centre_dec_deg(header));
-
-    /* Create scratch arrays. Weights are all 1. */
-    if (num_channels > 1)
-        scratch = oskar_mem_create(oskar_mem_type(
-                oskar_vis_block_cross_correlations_const(block)),
-                OSKAR_CPU, num_rows * num_channels, status);
-    if (!weight)
-    {
-        size_t weight_len = num_rows * num_pols;
-        weight = oskar_mem_create(oskar_mem_precision(
-                oskar_vis_block_cross_correlations_const(block)),
-                OSKAR_CPU, weight_len, status);
-        oskar_mem_set_value_real(weight, 1.0, 0, weight_len, status);
-        weight_ptr = weight;
-    }
+    oskar_imager_set_vis_time(h,
+            oskar_vis_header_time_start_mjd_utc(header), time_inc_sec,
+            oskar_vis_header_num_times_total(header));
+
+    /* Weights are all 1, so only newly-grown elements need to be set. */
+    weight_len = num_rows * num_pols;
+    old_len = oskar_imager_scratch_ensure(&h->block_weight,
+            h->imager_prec, weight_len, status);
+    if (old_len < weight_len)
+        oskar_mem_set_value_real(h->block_weight, 1.0,
+                old_len, weight_len - old_len, status);
 
     /* Fill in the time centroid values. */
-    time_centroid = oskar_mem_create(OSKAR_DOUBLE,
-            OSKAR_CPU, num_rows, status);
-    time_slice = oskar_mem_create_alias(0, 0, 0, status);
-    for (t = 0; t < num_times; ++t)
+    oskar_imager_scratch_ensure(&h->block_time, OSKAR_DOUBLE,
+            num_rows, status);
+    if (*status) return;
+    time_centroid = oskar_mem_double(h->block_time, status);
+    for (t = 0, i = 0; t < num_times; ++t)
     {
-        oskar_mem_set_alias(time_slice, time_centroid,
-                t * num_baselines, num_baselines, status);
-        oskar_mem_set_value_real(time_slice,
-                time_start_mjd + (start_time + t + 0.5) * time_inc_sec,
-                0, num_baselines, status);
+        const double val =
+                time_start_mjd + (start_time + t + 0.5) * time_inc_sec;
+        const size_t end = i + num_baselines;
+        for (; i < end; ++i) time_centroid[i] = val;
     }
 
-    /* Swap baseline and channel dimensions. */
+    /* Swap baseline and channel dimensions, converting to the imager
+     * precision at the same time. */
     ptr = oskar_vis_block_cross_correlations_const(block);
-#define SWAP_LOOP \
-        for (t = 0; t < num_times; ++t)                                  \
-            for (c = 0; c < num_channels; ++c)                           \
-                for (b = 0; b < num_baselines; ++b)                      \
-                    for (p = 0; p < num_pols; ++p)                       \
-                    {                                                    \
-                        k = (num_pols * (num_baselines *                 \
-                                (num_channels * t + c) + b) + p) << 1;   \
-                        l = (num_pols * (num_channels *                  \
-                                (num_baselines * t + b) + c) + p) << 1;  \
-                        out[l] = in[k];                                  \
-                        out[l + 1] = in[k + 1];                          \
-                    }
-        if (num_channels != 1)
-        {
-            int b, c, p;
-            size_t k, l;
-            if (oskar_mem_precision(ptr) == OSKAR_SINGLE)
-            {
-                const float *in;
-                float *out;
-                in  = oskar_mem_float_const(ptr, status);
-                out = oskar_mem_float(scratch, status);
-                SWAP_LOOP
-            }
-            else
-            {
-                const double *in;
-                double *out;
-                in  = oskar_mem_double_const(ptr, status);
-                out = oskar_mem_double(scratch, status);
-                SWAP_LOOP
-            }
-            ptr = scratch;
-        }
-#undef SWAP_LOOP
+    if (num_channels != 1)
+    {
+        const int type = (oskar_mem_type(ptr) &
+                ~(OSKAR_SINGLE | OSKAR_DOUBLE)) | h->imager_prec;
+        oskar_imager_scratch_ensure(&h->block_vis, type,
+                num_rows * num_channels, status);
+        oskar_mem_transpose(ptr, h->block_vis, num_times, num_channels,
+                num_baselines, status);
+        ptr = h->block_vis;
+    }
 
     /* Update the imager with the data. */
     oskar_imager_update(h, num_rows, start_chan, end_chan, num_pols,
             oskar_vis_block_baseline_uu_metres_const(block),
             oskar_vis_block_baseline_vv_metres_const(block),
             oskar_vis_block_baseline_ww_metres_const(block),
-            ptr, weight_ptr, time_centroid, status);
-    oskar_mem_free(weight, status);
-    oskar_mem_free(scratch, status);
-    oskar_mem_free(time_centroid, status);
-    oskar_mem_free(time_slice, status);
+            ptr, h->block_weight, h->block_time, status);
 }
 
 
@@ -179,9 +162,8 @@ void oskar_imager_update(oskar_Imager* h, size_t num_rows, int start_chan,
         const oskar_Mem* ww, const oskar_Mem* amps, const oskar_Mem* weight,
         const oskar_Mem* time_centroid, int* status)
 {
-    int c, p, plane;
-    size_t max_num_vis;
-    oskar_Mem *tu = 0, *tv = 0, *tw = 0, *ta = 0, *th = 0;
+    int num_threads, plane, plane_start, plane_end, time_first, time_last;
+    size_t max_num_vis, num_cells, num_half_cells;
     const oskar_Mem *u_in, *v_in, *w_in, *amp_in = 0, *weight_in;
     if (*status) return;
 
@@ -197,14 +179,28 @@ void oskar_imager_update(oskar_Imager* h, size_t num_rows, int start_chan,
         return;
     }
 
+    /* Check time centroids are present if making time snapshots. */
+    if (h->time_snap_interval_sec > 0.0 && !time_centroid)
+    {
+        *status = OSKAR_ERR_INVALID_ARGUMENT;
+        return;
+    }
+
     /* Ensure image/grid planes exist and algorithm has been initialised. */
     oskar_imager_set_num_planes(h, status);
     oskar_imager_check_init(h, status);
     oskar_imager_allocate_planes(h, status);
     if (*status) return;
 
-    /* Convert precision of input data if required. */
-    u_in = uu; v_in = vv; w_in = ww; weight_in = weight;
+    /* Weights grids written in coordinate-only mode are complete once
+     * the visibility data arrive, so convert them now if required. */
+    if (h->coords_only)
+        h->weights_grids_pending = (h->weighting == OSKAR_WEIGHTING_BRIGGS);
+    else if (h->weights_grids_pending)
+        convert_weights_grids(h, status);
+    if (*status) return;
+
+    /* Convert precision of input data into workspaces if required. */
     if (!h->coords_only)
     {
         if (!amps)
@@ -212,118 +208,157 @@ void oskar_imager_update(oskar_Imager* h, size_t num_rows, int start_chan,
             *status = OSKAR_ERR_MEMORY_NOT_ALLOCATED;
             return;
         }
-        amp_in = amps;
-        if (oskar_mem_precision(amps) != h->imager_prec)
-        {
-            ta = oskar_mem_convert_precision(amps, h->imager_prec, status);
-            amp_in = ta;
-        }
+        amp_in = oskar_imager_scratch_convert(h, amps, &h->conv_amp,
+                oskar_mem_length(amps), status);
 
         /* Convert linear polarisations to Stokes parameters if required. */
-        if (h->use_stokes)
+        if (h->use_stokes && oskar_mem_is_matrix(amp_in))
         {
             oskar_imager_linear_to_stokes(amp_in, &h->stokes, status);
             amp_in = h->stokes;
         }
     }
-    if (oskar_mem_precision(uu) != h->imager_prec)
-    {
-        tu = oskar_mem_convert_precision(uu, h->imager_prec, status);
-        u_in = tu;
-    }
-    if (oskar_mem_precision(vv) != h->imager_prec)
-    {
-        tv = oskar_mem_convert_precision(vv, h->imager_prec, status);
-        v_in = tv;
-    }
-    if (oskar_mem_precision(ww) != h->imager_prec)
-    {
-        tw = oskar_mem_convert_precision(ww, h->imager_prec, status);
-        w_in = tw;
-    }
-    if (oskar_mem_precision(weight) != h->imager_prec)
+    u_in = oskar_imager_scratch_convert(h, uu, &h->conv_uu,
+            num_rows, status);
+    v_in = oskar_imager_scratch_convert(h, vv, &h->conv_vv,
+            num_rows, status);
+    w_in = oskar_imager_scratch_convert(h, ww, &h->conv_ww,
+            num_rows, status);
+    weight_in = oskar_imager_scratch_convert(h, weight, &h->conv_weight,
+            oskar_mem_length(weight), status);
+    if (*status) return;
+
+    /* Only the planes in the current batch are updated, but the W-range
+     * must include all of them. */
+    plane_start = h->batch_start;
+    plane_end = h->batch_end;
+    if (h->coords_only && (h->algorithm == OSKAR_ALGORITHM_WPROJ ||
+            h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D))
     {
-        th = oskar_mem_convert_precision(weight, h->imager_prec, status);
-        weight_in = th;
+        plane_start = 0;
+        plane_end = h->num_planes;
     }
 
+    /* Skip the planes of time snapshots not covered by the data. */
+    time_range(h, num_rows, time_centroid, &time_first, &time_last, status);
+    if (*status) return;
+
+    /* Image planes can be updated concurrently using separate scratch
+     * arrays, but only if the algorithm does not use shared state.
+     * The weights grids and W-range must be updated in order.
+     * Nested parallel regions run serially, so only update planes
+     * concurrently if there are enough of them to occupy all threads.
+     * Otherwise, let the gridder for each plane use all the threads. */
+    num_threads = 1;
+#ifdef _OPENMP
+    if (!h->coords_only &&
+            plane_end - plane_start >= omp_get_max_threads() &&
+            h->algorithm != OSKAR_ALGORITHM_DFT_2D &&
+            h->algorithm != OSKAR_ALGORITHM_DFT_3D)
+        num_threads = omp_get_max_threads();
+#endif
+
     /* Ensure work arrays are large enough. */
     max_num_vis = num_rows;
     if (!h->chan_snaps) max_num_vis *= (1 + end_chan - start_chan);
-    oskar_mem_realloc(h->uu_im, max_num_vis, status);
-    oskar_mem_realloc(h->vv_im, max_num_vis, status);
-    oskar_mem_realloc(h->ww_im, max_num_vis, status);
-    oskar_mem_realloc(h->vis_im, max_num_vis, status);
-    oskar_mem_realloc(h->weight_im, max_num_vis, status);
-    if (h->direction_type == 'R')
-    {
-        oskar_mem_realloc(h->uu_tmp, max_num_vis, status);
-        oskar_mem_realloc(h->vv_tmp, max_num_vis, status);
-        oskar_mem_realloc(h->ww_tmp, max_num_vis, status);
-    }
+    oskar_imager_scratch_resize(h, num_threads, max_num_vis, status);
+    if (*status) return;
+
+    /* If planes hold only half of the UV plane, each thread grids into
+     * its own full grid, which is then folded into the plane. */
+    num_cells = (size_t) oskar_imager_plane_size(h);
+    num_cells *= num_cells;
+    num_half_cells = oskar_imager_half_plane_cells(h);
 
     /* Loop over each image plane being made. */
-    for (c = 0; c < h->num_im_channels; ++c)
+    oskar_timer_resume(h->tmr_grid_update);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+    for (plane = plane_start; plane < plane_end; ++plane)
     {
-        for (p = 0; p < h->num_im_pols; ++p)
-        {
-            oskar_Mem *pu, *pv, *pw;
-            size_t num_vis = 0;
-            if (*status) break;
+        oskar_Mem *pu, *pv, *pw;
+        ScratchData* s;
+        size_t num_vis = 0;
+        int plane_status = 0;
+        const int c = (plane / h->num_im_pols) % h->num_im_channels;
+        const int t = plane / (h->num_im_pols * h->num_im_channels);
+        const int p = plane % h->num_im_pols;
+        if (*status || t < time_first || t > time_last) continue;
+#ifdef _OPENMP
+        s = &(h->scratch[omp_get_thread_num()]);
+#else
+        s = &(h->scratch[0]);
+#endif
 
-            /* Get all visibility data needed to update this plane. */
-            pu = h->uu_im; pv = h->vv_im; pw = h->ww_im;
-            if (h->direction_type == 'R')
-            {
-                pu = h->uu_tmp; pv = h->vv_tmp; pw = h->ww_tmp;
-            }
-            oskar_imager_select_data(h, num_rows, start_chan, end_chan,
-                    num_pols, u_in, v_in, w_in, amp_in, weight_in,
-                    time_centroid, h->im_freqs[c], p,
-                    &num_vis, pu, pv, pw, h->vis_im, h->weight_im,
-                    h->time_im, status);
-
-            /* Skip if nothing was selected. */
-            if (num_vis == 0) continue;
-
-            /* Rotate baseline coordinates if required. */
-            if (h->direction_type == 'R')
-                oskar_imager_rotate_coords(h, num_vis,
-                        h->uu_tmp, h->vv_tmp, h->ww_tmp,
-                        h->uu_im, h->vv_im, h->ww_im);
-
-            /* Overwrite visibilities if making PSF, or phase rotate. */
-            if (h->im_type == OSKAR_IMAGE_TYPE_PSF)
-                oskar_mem_set_value_real(h->vis_im, 1.0, 0, 0, status);
-            else if (h->direction_type == 'R' && !h->coords_only)
-                oskar_imager_rotate_vis(h, num_vis,
-                        h->uu_tmp, h->vv_tmp, h->ww_tmp, h->vis_im);
-
-            /* Apply time and baseline length filters if required. */
-            oskar_imager_filter_time(h, &num_vis, h->uu_im, h->vv_im,
-                    h->ww_im, h->vis_im, h->weight_im, h->time_im, status);
-            oskar_imager_filter_uv(h, &num_vis, h->uu_im, h->vv_im,
-                    h->ww_im, h->vis_im, h->weight_im, status);
-
-            /* Update this image plane with the visibilities. */
-            plane = h->num_im_pols * c + p;
-            if (h->coords_only)
-                oskar_imager_update_plane(h, num_vis, h->uu_im, h->vv_im,
-                        h->ww_im, 0, h->weight_im, 0, 0,
-                        h->weights_grids[plane], status);
-            else
-                oskar_imager_update_plane(h, num_vis, h->uu_im, h->vv_im,
-                        h->ww_im, h->vis_im, h->weight_im,
-                        h->planes[plane], &h->plane_norm[plane],
-                        h->weights_grids[plane], status);
+        /* Get all visibility data needed to update this plane. */
+        pu = s->uu_im; pv = s->vv_im; pw = s->ww_im;
+        if (h->direction_type == 'R')
+        {
+            pu = s->uu_tmp; pv = s->vv_tmp; pw = s->ww_tmp;
+        }
+        oskar_imager_select_data(h, num_rows, start_chan, end_chan,
+                num_pols, u_in, v_in, w_in, amp_in, weight_in,
+                time_centroid, h->im_freqs[c], p,
+                &num_vis, pu, pv, pw, s->vis_im, s->weight_im,
+                s->time_im, &plane_status);
+
+        /* Skip if nothing was selected. */
+        if (num_vis == 0 && !plane_status) continue;
+
+        /* Rotate baseline coordinates if required. */
+        if (h->direction_type == 'R')
+            oskar_imager_rotate_coords(h, num_vis,
+                    s->uu_tmp, s->vv_tmp, s->ww_tmp,
+                    s->uu_im, s->vv_im, s->ww_im);
+
+        /* Overwrite visibilities if making PSF, or phase rotate. */
+        if (h->im_type == OSKAR_IMAGE_TYPE_PSF)
+            oskar_mem_set_value_real(s->vis_im, 1.0, 0, 0, &plane_status);
+        else if (h->direction_type == 'R' && !h->coords_only)
+            oskar_imager_rotate_vis(h, num_vis,
+                    s->uu_tmp, s->vv_tmp, s->ww_tmp, s->vis_im);
+
+        /* Apply time and baseline length filters if required. */
+        oskar_imager_filter_time(h, t, &num_vis, s->uu_im, s->vv_im,
+                s->ww_im, s->vis_im, s->weight_im, s->time_im,
+                &plane_status);
+        oskar_imager_filter_uv(h, &num_vis, s->uu_im, s->vv_im,
+                s->ww_im, s->vis_im, s->weight_im, &plane_status);
+
+        /* Fold visibilities into half the UV plane if required. */
+        oskar_imager_fold_uv(h, num_vis, s->uu_im, s->vv_im, s->ww_im,
+                h->coords_only ? 0 : s->vis_im, &plane_status);
+
+        /* Update this image plane with the visibilities. */
+        if (h->coords_only)
+            update_plane(h, num_vis, s->uu_im, s->vv_im, s->ww_im,
+                    0, s->weight_im, 0, 0, (plane >= h->batch_start &&
+                            plane < h->batch_end) ?
+                                    h->weights_grids[plane] : 0,
+                    s->weight_tmp, &s->grid_work, &plane_status);
+        else if (num_half_cells > 0)
+        {
+            if (oskar_mem_length(s->grid) < num_cells)
+                oskar_mem_realloc(s->grid, num_cells, &plane_status);
+            update_plane(h, num_vis, s->uu_im, s->vv_im, s->ww_im,
+                    s->vis_im, s->weight_im, s->grid,
+                    &h->plane_norm[plane], h->weights_grids[plane],
+                    s->weight_tmp, &s->grid_work, &plane_status);
+            oskar_imager_fold_grid(h, s->grid, h->planes[plane],
+                    &plane_status);
+        }
+        else
+            update_plane(h, num_vis, s->uu_im, s->vv_im, s->ww_im,
+                    s->vis_im, s->weight_im, h->planes[plane],
+                    &h->plane_norm[plane], h->weights_grids[plane],
+                    s->weight_tmp, &s->grid_work, &plane_status);
+        if (plane_status)
+        {
+#pragma omp critical (imager_update_status)
+            *status = plane_status;
         }
     }
-
-    oskar_mem_free(tu, status);
-    oskar_mem_free(tv, status);
-    oskar_mem_free(tw, status);
-    oskar_mem_free(ta, status);
-    oskar_mem_free(th, status);
+    oskar_timer_pause(h->tmr_grid_update);
 }
 
 
@@ -332,52 +367,44 @@ void oskar_imager_update_plane(oskar_Imager* h, size_t num_vis,
         const oskar_Mem* amps, const oskar_Mem* weight, oskar_Mem* plane,
         double* plane_norm, oskar_Mem* weights_grid, int* status)
 {
-    oskar_Mem *tu = 0, *tv = 0, *tw = 0, *ta = 0, *th = 0;
-    const oskar_Mem *pu, *pv, *pw, *pa, *ph;
     if (*status || num_vis == 0) return;
     oskar_timer_resume(h->tmr_grid_update);
 
-    /* Convert precision of input data if required. */
-    pu = uu; pv = vv; pw = ww; ph = weight;
-    if (oskar_mem_precision(uu) != h->imager_prec)
-    {
-        tu = oskar_mem_convert_precision(uu, h->imager_prec, status);
-        pu = tu;
-    }
-    if (oskar_mem_precision(vv) != h->imager_prec)
-    {
-        tv = oskar_mem_convert_precision(vv, h->imager_prec, status);
-        pv = tv;
-    }
-    if (oskar_mem_precision(ww) != h->imager_prec)
-    {
-        tw = oskar_mem_convert_precision(ww, h->imager_prec, status);
-        pw = tw;
-    }
-    if (oskar_mem_precision(weight) != h->imager_prec)
-    {
-        th = oskar_mem_convert_precision(weight, h->imager_prec, status);
-        ph = th;
-    }
+    /* Convert precision of input data into workspaces if required. */
+    uu = oskar_imager_scratch_convert(h, uu, &h->conv_uu, num_vis, status);
+    vv = oskar_imager_scratch_convert(h, vv, &h->conv_vv, num_vis, status);
+    ww = oskar_imager_scratch_convert(h, ww, &h->conv_ww, num_vis, status);
+    weight = oskar_imager_scratch_convert(h, weight, &h->conv_weight,
+            num_vis, status);
+    if (!h->coords_only)
+        amps = oskar_imager_scratch_convert(h, amps, &h->conv_amp,
+                num_vis, status);
+    update_plane(h, num_vis, uu, vv, ww, amps, weight, plane, plane_norm,
+            weights_grid, h->scratch[0].weight_tmp,
+            &h->scratch[0].grid_work, status);
+    oskar_timer_pause(h->tmr_grid_update);
+}
+
+
+static void update_plane(oskar_Imager* h, size_t num_vis,
+        const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* ww,
+        const oskar_Mem* amps, const oskar_Mem* weight, oskar_Mem* plane,
+        double* plane_norm, oskar_Mem* weights_grid, oskar_Mem* weight_tmp,
+        oskar_Mem** grid_work, int* status)
+{
+    const oskar_Mem *ph = weight;
+    if (*status || num_vis == 0) return;
 
     /* Just update the grid of weights if we're in coordinate-only mode. */
     if (h->coords_only)
     {
-        oskar_imager_update_weights_grid(h, num_vis, pu, pv, pw, ph,
+        oskar_imager_update_weights_grid(h, num_vis, uu, vv, ww, weight,
                 weights_grid, status);
     }
     else
     {
         size_t num_skipped = 0;
 
-        /* Convert precision of visibility amplitudes if required. */
-        pa = amps;
-        if (oskar_mem_precision(amps) != h->imager_prec)
-        {
-            ta = oskar_mem_convert_precision(amps, h->imager_prec, status);
-            pa = ta;
-        }
-
         /* Check imager is ready. */
         oskar_imager_check_init(h, status);
 
@@ -388,15 +415,16 @@ void oskar_imager_update_plane(oskar_Imager* h, size_t num_vis,
             /* Nothing to do. */
             break;
         case OSKAR_WEIGHTING_RADIAL:
-            oskar_imager_weight_radial(num_vis, pu, pv, ph, h->weight_tmp,
+            oskar_imager_weight_radial(num_vis, uu, vv, ph, weight_tmp,
                     status);
-            ph = h->weight_tmp;
+            ph = weight_tmp;
             break;
         case OSKAR_WEIGHTING_UNIFORM:
-            oskar_imager_weight_uniform(num_vis, pu, pv, ph, h->weight_tmp,
+        case OSKAR_WEIGHTING_BRIGGS:
+            oskar_imager_weight_uniform(num_vis, uu, vv, ph, weight_tmp,
                     h->cellsize_rad, oskar_imager_plane_size(h), weights_grid,
                     status);
-            ph = h->weight_tmp;
+            ph = weight_tmp;
             break;
         default:
             *status = OSKAR_ERR_FUNCTION_NOT_AVAILABLE;
@@ -408,15 +436,28 @@ void oskar_imager_update_plane(oskar_Imager* h, size_t num_vis,
         {
         case OSKAR_ALGORITHM_DFT_2D:
         case OSKAR_ALGORITHM_DFT_3D:
-            oskar_imager_update_plane_dft(h, num_vis, pu, pv, pw, pa, ph,
+            oskar_imager_update_plane_dft(h, num_vis, uu, vv, ww, amps, ph,
                     plane, plane_norm, status);
             break;
         case OSKAR_ALGORITHM_FFT:
-            oskar_imager_update_plane_fft(h, num_vis, pu, pv, pa, ph,
-                    plane, plane_norm, &num_skipped, status);
+            oskar_imager_update_plane_fft(h, num_vis, uu, vv, amps, ph,
+                    plane, plane_norm, grid_work, &num_skipped, status);
             break;
         case OSKAR_ALGORITHM_WPROJ:
-            oskar_imager_update_plane_wproj(h, num_vis, pu, pv, pw, pa, ph,
+            oskar_imager_update_plane_wproj(h, num_vis, uu, vv, ww, amps, ph,
+                    plane, plane_norm, grid_work, &num_skipped, status);
+            break;
+        case OSKAR_ALGORITHM_IDG:
+            oskar_imager_update_plane_idg(h, num_vis, uu, vv, ww, amps, ph,
+                    plane, plane_norm, grid_work, &num_skipped, status);
+            break;
+        case OSKAR_ALGORITHM_WSTACK:
+            oskar_imager_update_plane_wstack(h, num_vis, uu, vv, ww, amps, ph,
+                    plane, plane_norm, grid_work, &num_skipped, status);
+            break;
+        case OSKAR_ALGORITHM_NUFFT_2D:
+        case OSKAR_ALGORITHM_NUFFT_3D:
+            oskar_imager_update_plane_nufft(h, num_vis, uu, vv, ww, amps, ph,
                     plane, plane_norm, &num_skipped, status);
             break;
         default:
@@ -428,14 +469,6 @@ void oskar_imager_update_plane(oskar_Imager* h, size_t num_vis,
             printf("WARNING: Skipped %lu visibility points.\n",
                     (unsigned long) num_skipped);
     }
-
-    /* Clean up. */
-    oskar_mem_free(tu, status);
-    oskar_mem_free(tv, status);
-    oskar_mem_free(tw, status);
-    oskar_mem_free(ta, status);
-    oskar_mem_free(th, status);
-    oskar_timer_pause(h->tmr_grid_update);
 }
 
 
@@ -445,8 +478,9 @@ void oskar_imager_update_weights_grid(oskar_Imager* h, size_t num_points,
 {
     if (*status) return;
 
-    /* Update the weights grid. */
-    if (h->weighting == OSKAR_WEIGHTING_UNIFORM)
+    /* Update the weights grid, if it is in the current batch. */
+    if ((h->weighting == OSKAR_WEIGHTING_UNIFORM ||
+            h->weighting == OSKAR_WEIGHTING_BRIGGS) && weights_grid)
     {
         int grid_size;
         size_t num_cells, num_skipped = 0;
@@ -464,21 +498,23 @@ void oskar_imager_update_weights_grid(oskar_Imager* h, size_t num_points,
                     oskar_mem_double_const(vv, status),
                     oskar_mem_double_const(weight, status),
                     h->cellsize_rad, grid_size, &num_skipped,
-                    oskar_mem_double(weights_grid, status));
+                    oskar_mem_double(weights_grid, status), status);
         else
             oskar_grid_weights_write_f(num_points,
                     oskar_mem_float_const(uu, status),
                     oskar_mem_float_const(vv, status),
                     oskar_mem_float_const(weight, status),
                     (float) (h->cellsize_rad), grid_size, &num_skipped,
-                    oskar_mem_float(weights_grid, status));
+                    oskar_mem_float(weights_grid, status), status);
         if (num_skipped > 0)
             printf("WARNING: Skipped %lu visibility weights.\n",
                     (unsigned long) num_skipped);
     }
 
     /* Update baseline W minimum, maximum and RMS. */
-    if (h->algorithm == OSKAR_ALGORITHM_WPROJ)
+    if (h->algorithm == OSKAR_ALGORITHM_WPROJ ||
+            h->algorithm == OSKAR_ALGORITHM_WSTACK ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
     {
         size_t j;
         double val;
@@ -512,6 +548,7 @@ void oskar_imager_update_weights_grid(oskar_Imager* h, size_t num_points,
 void oskar_imager_allocate_planes(oskar_Imager* h, int *status)
 {
     int i, plane_size;
+    size_t num_cells;
     if (*status) return;
 
     /* Allocate empty weights grids if required. */
@@ -524,20 +561,77 @@ void oskar_imager_allocate_planes(oskar_Imager* h, int *status)
                     OSKAR_CPU, 0, status);
     }
 
-    /* If we're in coordinate-only mode, or the planes already exist,
-     * there's nothing more to do here. */
-    if (h->coords_only || h->planes) return;
+    /* If we're in coordinate-only mode, there's nothing more to do here. */
+    if (h->coords_only) return;
 
-    /* Allocate the image or visibility planes. */
-    h->planes = (oskar_Mem**) calloc(h->num_planes, sizeof(oskar_Mem*));
-    h->plane_norm = (double*) calloc(h->num_planes, sizeof(double));
+    /* Create FITS files for all the planes if required. */
+    if (!h->planes)
+    {
+        h->planes = (oskar_Mem**) calloc(h->num_planes, sizeof(oskar_Mem*));
+        h->plane_norm = (double*) calloc(h->num_planes, sizeof(double));
+        oskar_imager_create_fits_files(h, status);
+    }
+
+    /* Allocate the image or visibility planes in the current batch. */
     plane_size = oskar_imager_plane_size(h);
-    for (i = 0; i < h->num_planes; ++i)
-        h->planes[i] = oskar_mem_create(oskar_imager_plane_type(h), OSKAR_CPU,
-                plane_size * plane_size, status);
+    num_cells = oskar_imager_half_plane_cells(h);
+    if (num_cells == 0)
+        num_cells = (size_t)plane_size * plane_size;
+    for (i = h->batch_start; i < h->batch_end; ++i)
+        if (!h->planes[i])
+            h->planes[i] = oskar_mem_create(oskar_imager_plane_type(h),
+                    OSKAR_CPU, num_cells, status);
+}
+
 
-    /* Create FITS files for the planes if required. */
-    oskar_imager_create_fits_files(h, status);
+void convert_weights_grids(oskar_Imager* h, int* status)
+{
+    int i;
+    const int grid_size = oskar_imager_plane_size(h);
+    for (i = h->batch_start; i < h->batch_end && !*status; ++i)
+    {
+        oskar_Mem* grid = h->weights_grids[i];
+        if (oskar_mem_length(grid) == 0) continue;
+        if (oskar_mem_precision(grid) == OSKAR_DOUBLE)
+            oskar_grid_weights_briggs_d(grid_size, h->robustness,
+                    oskar_mem_double(grid, status), status);
+        else
+            oskar_grid_weights_briggs_f(grid_size, h->robustness,
+                    oskar_mem_float(grid, status), status);
+    }
+    h->weights_grids_pending = 0;
+}
+
+
+void time_range(const oskar_Imager* h, size_t num_rows,
+        const oskar_Mem* time_centroid, int* time_first, int* time_last,
+        int* status)
+{
+    size_t i;
+    double t_min, t_max;
+    const double* t;
+    *time_first = 0;
+    *time_last = h->num_im_times - 1;
+    if (*status || h->time_snap_interval_sec <= 0.0 || num_rows == 0) return;
+
+    /* Find the time snapshots spanned by the supplied time centroids. */
+    if (oskar_mem_length(time_centroid) < num_rows)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+    t = oskar_mem_double_const(time_centroid, status);
+    if (*status) return;
+    t_min = t_max = t[0];
+    for (i = 1; i < num_rows; ++i)
+    {
+        if (t[i] < t_min) t_min = t[i];
+        if (t[i] > t_max) t_max = t[i];
+    }
+    *time_first = (int) floor((t_min - h->im_time_start_utc) /
+            h->time_snap_interval_sec);
+    *time_last = (int) floor((t_max - h->im_time_start_utc) /
+            h->time_snap_interval_sec);
 }
 
 
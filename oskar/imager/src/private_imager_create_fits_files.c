@@ -49,8 +49,9 @@ extern "C" {
 #endif
 
 static fitsfile* create_fits_file(const char* filename, int precision,
-        int width, int height, int num_channels, double centre_deg[2],
-        double fov_deg[2], double start_freq_hz, double delta_freq_hz,
+        int width, int height, int num_channels, int num_times,
+        double centre_deg[2], double fov_deg[2], double start_freq_hz,
+        double delta_freq_hz, double start_time_utc, double delta_time_sec,
         int* status);
 static void write_axis_header(fitsfile* fptr, int axis_id,
         const char* ctype, const char* ctype_comment, double crval,
@@ -100,8 +101,9 @@ void oskar_imager_create_fits_files(oskar_Imager* h, int* status)
 
         fov_deg[0] = fov_deg[1] = h->fov_deg;
         h->fits_file[i] = create_fits_file(f, h->imager_prec, h->image_size,
-                h->image_size, h->num_im_channels, h->im_centre_deg, fov_deg,
-                h->im_freqs[0], h->freq_inc_hz, status);
+                h->image_size, h->num_im_channels, h->num_im_times,
+                h->im_centre_deg, fov_deg, h->im_freqs[0], h->freq_inc_hz,
+                h->im_time_start_utc, h->time_snap_interval_sec, status);
         h->output_name[i] = (char*) realloc(h->output_name[i], 1 + strlen(f));
         strcpy(h->output_name[i], f);
     }
@@ -110,11 +112,13 @@ void oskar_imager_create_fits_files(oskar_Imager* h, int* status)
 
 
 fitsfile* create_fits_file(const char* filename, int precision,
-        int width, int height, int num_channels, double centre_deg[2],
-        double fov_deg[2], double start_freq_hz, double delta_freq_hz,
+        int width, int height, int num_channels, int num_times,
+        double centre_deg[2], double fov_deg[2], double start_freq_hz,
+        double delta_freq_hz, double start_time_utc, double delta_time_sec,
         int* status)
 {
-    long naxes[3];
+    long naxes[4];
+    int num_axes;
     double delta;
     fitsfile* f = 0;
     FILE* t = 0;
@@ -130,9 +134,11 @@ fitsfile* create_fits_file(const char* filename, int precision,
     naxes[0]  = width;
     naxes[1]  = height;
     naxes[2]  = num_channels;
+    naxes[3]  = num_times;
+    num_axes = delta_time_sec > 0.0 ? 4 : 3;
     fits_create_file(&f, filename, status);
     fits_create_img(f, (precision == OSKAR_DOUBLE ? DOUBLE_IMG : FLOAT_IMG),
-            3, naxes, status);
+            num_axes, naxes, status);
     fits_set_hdrsize(f, 120, status); /* Reserve some header space for log. */
     fits_write_date(f, status);
 
@@ -145,6 +151,14 @@ fitsfile* create_fits_file(const char* filename, int precision,
             centre_deg[1], delta, height / 2 + 1, 0.0, status);
     write_axis_header(f, 3, "FREQ", "Frequency",
             start_freq_hz, delta_freq_hz, 1.0, 0.0, status);
+    if (num_axes == 4)
+    {
+        /* Time snapshots are labelled by the centre of each interval. */
+        write_axis_header(f, 4, "UTC", "Time (MJD seconds)",
+                start_time_utc + 0.5 * delta_time_sec, delta_time_sec,
+                1.0, 0.0, status);
+        fits_write_key_str(f, "CUNIT4", "s", "Time units", status);
+    }
 
     /* Write other headers. */
     fits_write_key_str(f, "BUNIT", "JY/BEAM", "Brightness units", status);
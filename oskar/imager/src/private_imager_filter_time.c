@@ -30,20 +30,33 @@
 
 #include "imager/private_imager_filter_time.h"
 #include <float.h>
+#include <math.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void oskar_imager_filter_time(const oskar_Imager* h, size_t* num_vis,
-        oskar_Mem* uu, oskar_Mem* vv, oskar_Mem* ww, oskar_Mem* amp,
-        oskar_Mem* weight, oskar_Mem* time_centroid, int* status)
+static int keep(const oskar_Imager* h, int im_time, const double range[2],
+        double t)
+{
+    if (t < range[0] || t > range[1]) return 0;
+    if (h->time_snap_interval_sec > 0.0)
+        return (int) floor((t - h->im_time_start_utc) /
+                h->time_snap_interval_sec) == im_time;
+    return 1;
+}
+
+void oskar_imager_filter_time(const oskar_Imager* h, int im_time,
+        size_t* num_vis, oskar_Mem* uu, oskar_Mem* vv, oskar_Mem* ww,
+        oskar_Mem* amp, oskar_Mem* weight, oskar_Mem* time_centroid,
+        int* status)
 {
     size_t i, n;
     double t, range[2], *time_centroid_;
 
     /* Return immediately if filtering is not enabled. */
-    if ((h->time_min_utc <= 0.0 && h->time_max_utc <= 0.0) ||
+    if ((h->time_min_utc <= 0.0 && h->time_max_utc <= 0.0 &&
+            h->time_snap_interval_sec <= 0.0) ||
             !time_centroid ||
             oskar_mem_length(time_centroid) == 0)
         return;
@@ -72,7 +85,7 @@ void oskar_imager_filter_time(const oskar_Imager* h, size_t* num_vis,
         for (i = 0; i < n; ++i)
         {
             t = time_centroid_[i];
-            if (t >= range[0] && t <= range[1])
+            if (keep(h, im_time, range, t))
             {
                 uu_[*num_vis] = uu_[i];
                 vv_[*num_vis] = vv_[i];
@@ -97,7 +110,7 @@ void oskar_imager_filter_time(const oskar_Imager* h, size_t* num_vis,
         for (i = 0; i < n; ++i)
         {
             t = time_centroid_[i];
-            if (t >= range[0] && t <= range[1])
+            if (keep(h, im_time, range, t))
             {
                 uu_[*num_vis] = uu_[i];
                 vv_[*num_vis] = vv_[i];
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/private_imager_finalise_wstack.h"
+#include "imager/oskar_grid_functions_es.h"
+#include "math/oskar_cmath.h"
+#include "math/oskar_fft.h"
+#include "math/oskar_fftphase.h"
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void layers_to_image(oskar_FFT* fft, const int size,
+        const int num_layers, const int first_layer, const double w_scale,
+        const double* restrict n_minus_1, oskar_Mem* plane, int* status)
+{
+    int k;
+    size_t i;
+    const size_t num_cells = (size_t)size * size;
+
+    /* Transform each layer to the image plane, and apply its W-term.
+     * Layers are transformed concurrently, each by a single thread.
+     * The second FFT shift is applied by the caller, after the layers
+     * have been summed. */
+    #pragma omp parallel for schedule(dynamic)
+    for (k = 0; k < num_layers; ++k)
+    {
+        size_t j;
+        int layer_status = 0;
+        const double w = (w_scale > 0.0) ? (k + first_layer) / w_scale : 0.0;
+        oskar_Mem* layer = oskar_mem_create_alias(plane, k * num_cells,
+                num_cells, &layer_status);
+        if (oskar_mem_precision(plane) == OSKAR_DOUBLE)
+        {
+            double* t = oskar_mem_double(layer, &layer_status);
+            oskar_fftphase_cd(size, size, t);
+            oskar_fft_exec(fft, layer, &layer_status);
+            for (j = 0; j < num_cells; ++j)
+            {
+                const double phase = -2.0 * M_PI * w * n_minus_1[j];
+                const double re = t[2 * j], im = t[2 * j + 1];
+                const double c = cos(phase), s = sin(phase);
+                t[2 * j]     = re * c - im * s;
+                t[2 * j + 1] = re * s + im * c;
+            }
+        }
+        else
+        {
+            float* t = oskar_mem_float(layer, &layer_status);
+            oskar_fftphase_cf(size, size, t);
+            oskar_fft_exec(fft, layer, &layer_status);
+            for (j = 0; j < num_cells; ++j)
+            {
+                const double phase = -2.0 * M_PI * w * n_minus_1[j];
+                const double re = t[2 * j], im = t[2 * j + 1];
+                const double c = cos(phase), s = sin(phase);
+                t[2 * j]     = (float) (re * c - im * s);
+                t[2 * j + 1] = (float) (re * s + im * c);
+            }
+        }
+        oskar_mem_free(layer, &layer_status);
+        if (layer_status)
+        {
+            #pragma omp critical (finalise_wstack_status)
+            *status = layer_status;
+        }
+    }
+    if (*status) return;
+
+    /* Sum the layers in order, so the result does not depend on the
+     * number of threads. */
+    if (oskar_mem_precision(plane) == OSKAR_DOUBLE)
+    {
+        double* layers = oskar_mem_double(plane, status);
+        #pragma omp parallel for private(i, k)
+        for (i = 0; i < num_cells; ++i)
+        {
+            for (k = 1; k < num_layers; ++k)
+            {
+                const size_t j = k * num_cells + i;
+                layers[2 * i]     += layers[2 * j];
+                layers[2 * i + 1] += layers[2 * j + 1];
+            }
+        }
+    }
+    else
+    {
+        float* layers = oskar_mem_float(plane, status);
+        #pragma omp parallel for private(i, k)
+        for (i = 0; i < num_cells; ++i)
+        {
+            for (k = 1; k < num_layers; ++k)
+            {
+                const size_t j = k * num_cells + i;
+                layers[2 * i]     += layers[2 * j];
+                layers[2 * i + 1] += layers[2 * j + 1];
+            }
+        }
+    }
+}
+
+static void w_correction(const oskar_Imager* h, const int size,
+        const double* restrict n_minus_1, oskar_Mem* plane, int* status)
+{
+    int ix, iy;
+    size_t j = 0;
+    double* corr;
+    const int image_size = h->image_size;
+    const int offset = (size - image_size) / 2;
+    if (*status) return;
+
+    /* Evaluate the Fourier transform of the kernel at the (n - 1) value
+     * of each pixel that will be kept after trimming, in cycles per
+     * W-plane. */
+    corr = (double*) malloc((size_t)image_size * image_size * sizeof(double));
+    for (iy = offset; iy < offset + image_size; ++iy)
+        for (ix = offset; ix < offset + image_size; ++ix)
+            corr[j++] = (h->w_scale > 0.0) ?
+                    n_minus_1[(size_t)iy * size + ix] / h->w_scale : 0.0;
+    oskar_grid_fourier_transform_es(h->support,
+            oskar_grid_beta_es(h->support), image_size * image_size,
+            corr, corr);
+
+    /* Divide by it. */
+    for (iy = 0, j = 0; iy < image_size; ++iy)
+    {
+        const size_t p = (size_t)(iy + offset) * size + offset;
+        if (oskar_mem_precision(plane) == OSKAR_DOUBLE)
+        {
+            double* t = oskar_mem_double(plane, status) + 2 * p;
+            for (ix = 0; ix < image_size; ++ix, ++j)
+            {
+                const double c = (corr[j] != 0.0) ? 1.0 / corr[j] : 1.0;
+                t[2 * ix] *= c;
+                t[2 * ix + 1] *= c;
+            }
+        }
+        else
+        {
+            float* t = oskar_mem_float(plane, status) + 2 * p;
+            for (ix = 0; ix < image_size; ++ix, ++j)
+            {
+                const double c = (corr[j] != 0.0) ? 1.0 / corr[j] : 1.0;
+                t[2 * ix] *= c;
+                t[2 * ix + 1] *= c;
+            }
+        }
+    }
+    free(corr);
+}
+
+void oskar_imager_finalise_wstack(oskar_Imager* h, oskar_Mem* plane,
+        int* status)
+{
+    int size;
+    size_t num_cells;
+    const double* n_minus_1;
+    if (*status) return;
+    size = oskar_imager_plane_size(h);
+    num_cells = (size_t)size * size;
+
+    /* Check the FFT plan and the table of n - 1 exist. */
+    if (!h->fft || !h->n_minus_1 ||
+            oskar_mem_length(h->n_minus_1) != num_cells)
+    {
+        *status = OSKAR_ERR_MEMORY_NOT_ALLOCATED;
+        return;
+    }
+    n_minus_1 = oskar_mem_double_const(h->n_minus_1, status);
+
+    /* Transform the W-layers and sum them into the first one.
+     * For the 3D NUFFT, the first W-plane is at W = -support / w_scale. */
+    layers_to_image(h->fft, size, h->num_w_planes,
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_3D ? -h->support : 0,
+            h->w_scale, n_minus_1, plane, status);
+
+    /* Correct for the kernel used to spread visibilities in W. */
+    if (h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
+        w_correction(h, size, n_minus_1, plane, status);
+
+    /* Release memory used by the other layers. */
+    oskar_mem_realloc(plane, num_cells, status);
+}
+
+#ifdef __cplusplus
+}
+#endif
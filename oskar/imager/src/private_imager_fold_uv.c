@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/private_imager_fold_uv.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static int is_folded(const oskar_Imager* h)
+{
+    return h->grid_half_plane && (h->algorithm == OSKAR_ALGORITHM_FFT ||
+            h->algorithm == OSKAR_ALGORITHM_WPROJ ||
+            h->algorithm == OSKAR_ALGORITHM_IDG ||
+            h->algorithm == OSKAR_ALGORITHM_NUFFT_2D);
+}
+
+void oskar_imager_fold_uv(const oskar_Imager* h, size_t num_vis,
+        oskar_Mem* uu, oskar_Mem* vv, oskar_Mem* ww, oskar_Mem* amp,
+        int* status)
+{
+    size_t i;
+
+    /* Return immediately if folding is not enabled. */
+    if (!is_folded(h) || *status) return;
+
+    /* V(-u, -v, -w) is the complex conjugate of V(u, v, w). */
+    if (h->imager_prec == OSKAR_DOUBLE)
+    {
+        double *uu_, *vv_, *ww_, *amp_ = 0;
+        uu_ = oskar_mem_double(uu, status);
+        vv_ = oskar_mem_double(vv, status);
+        ww_ = oskar_mem_double(ww, status);
+        if (amp) amp_ = oskar_mem_double(amp, status);
+        for (i = 0; i < num_vis; ++i)
+        {
+            if (vv_[i] >= 0.0) continue;
+            uu_[i] = -uu_[i];
+            vv_[i] = -vv_[i];
+            ww_[i] = -ww_[i];
+            if (amp_) amp_[2 * i + 1] = -amp_[2 * i + 1];
+        }
+    }
+    else
+    {
+        float *uu_, *vv_, *ww_, *amp_ = 0;
+        uu_ = oskar_mem_float(uu, status);
+        vv_ = oskar_mem_float(vv, status);
+        ww_ = oskar_mem_float(ww, status);
+        if (amp) amp_ = oskar_mem_float(amp, status);
+        for (i = 0; i < num_vis; ++i)
+        {
+            if (vv_[i] >= 0.0f) continue;
+            uu_[i] = -uu_[i];
+            vv_[i] = -vv_[i];
+            ww_[i] = -ww_[i];
+            if (amp_) amp_[2 * i + 1] = -amp_[2 * i + 1];
+        }
+    }
+}
+
+
+size_t oskar_imager_half_plane_cells(oskar_Imager* h)
+{
+    const size_t size = (size_t) oskar_imager_plane_size(h);
+    return is_folded(h) ? size * (size / 2 + 1) : 0;
+}
+
+
+/* Full grid row r is half plane row r - c if r >= c. Otherwise it is
+ * added to half plane row c - r, conjugated and with column x moved to
+ * (2c - x) mod size. For an even size, row 0 goes to the last half plane
+ * row, which holds V = size / 2. */
+static void fold_grid_d(const int size, double* grid, double* plane)
+{
+    int r, x;
+    const int c = size / 2;
+    for (r = 0; r < size; ++r)
+    {
+        double* in = grid + 2 * (size_t)r * size;
+        if (r >= c)
+        {
+            double* out = plane + 2 * (size_t)(r - c) * size;
+            for (x = 0; x < 2 * size; ++x)
+            {
+                out[x] += in[x];
+                in[x] = 0.0;
+            }
+        }
+        else
+        {
+            double* out = plane + 2 * (size_t)(c - r) * size;
+            for (x = 0; x < size; ++x)
+            {
+                const int x2 = (2 * c - x) % size;
+                out[2 * x2]     += in[2 * x];
+                out[2 * x2 + 1] -= in[2 * x + 1];
+                in[2 * x] = in[2 * x + 1] = 0.0;
+            }
+        }
+    }
+}
+
+static void fold_grid_f(const int size, float* grid, float* plane)
+{
+    int r, x;
+    const int c = size / 2;
+    for (r = 0; r < size; ++r)
+    {
+        float* in = grid + 2 * (size_t)r * size;
+        if (r >= c)
+        {
+            float* out = plane + 2 * (size_t)(r - c) * size;
+            for (x = 0; x < 2 * size; ++x)
+            {
+                out[x] += in[x];
+                in[x] = 0.0f;
+            }
+        }
+        else
+        {
+            float* out = plane + 2 * (size_t)(c - r) * size;
+            for (x = 0; x < size; ++x)
+            {
+                const int x2 = (2 * c - x) % size;
+                out[2 * x2]     += in[2 * x];
+                out[2 * x2 + 1] -= in[2 * x + 1];
+                in[2 * x] = in[2 * x + 1] = 0.0f;
+            }
+        }
+    }
+}
+
+void oskar_imager_fold_grid(oskar_Imager* h, oskar_Mem* grid,
+        oskar_Mem* plane, int* status)
+{
+    int size;
+    size_t num_half;
+    if (*status) return;
+    size = oskar_imager_plane_size(h);
+    num_half = (size_t)size * (size / 2 + 1);
+    if (oskar_mem_length(grid) < (size_t)size * size)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+    if (oskar_mem_length(plane) < num_half)
+        oskar_mem_realloc(plane, num_half, status);
+    if (*status) return;
+    if (oskar_mem_precision(grid) == OSKAR_DOUBLE)
+        fold_grid_d(size, oskar_mem_double(grid, status),
+                oskar_mem_double(plane, status));
+    else
+        fold_grid_f(size, oskar_mem_float(grid, status),
+                oskar_mem_float(plane, status));
+}
+
+
+void oskar_imager_unfold_grid(oskar_Imager* h, oskar_Mem* plane,
+        int* status)
+{
+    int r, size, c, num_rows;
+    size_t row_bytes;
+    char *p, *nyquist = 0;
+    if (*status) return;
+    size = oskar_imager_plane_size(h);
+    c = size / 2;
+    num_rows = size - c;
+    row_bytes = (size_t)size * oskar_mem_element_size(oskar_mem_type(plane));
+    if (oskar_mem_length(plane) != (size_t)size * (size / 2 + 1))
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+
+    /* For an even size, save the last row, which goes to full row 0. */
+    if (size % 2 == 0)
+    {
+        nyquist = (char*) malloc(row_bytes);
+        if (!nyquist)
+        {
+            *status = OSKAR_ERR_MEMORY_ALLOC_FAILURE;
+            return;
+        }
+        memcpy(nyquist, oskar_mem_char(plane) + num_rows * row_bytes,
+                row_bytes);
+    }
+
+    /* Move the rows with V >= 0 into place, starting with the last one,
+     * and clear the rows below them. */
+    oskar_mem_realloc(plane, (size_t)size * size, status);
+    if (!*status)
+    {
+        p = oskar_mem_char(plane);
+        for (r = num_rows - 1; r >= 0; --r)
+            memmove(p + (r + c) * row_bytes, p + r * row_bytes, row_bytes);
+        memset(p, 0, c * row_bytes);
+        if (nyquist) memcpy(p, nyquist, row_bytes);
+    }
+    free(nyquist);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -29,6 +29,7 @@
 #include "imager/private_imager.h"
 
 #include "imager/private_imager_init_fft.h"
+#include "imager/oskar_grid_functions_es.h"
 #include "imager/oskar_grid_functions_spheroidal.h"
 #include "imager/oskar_grid_functions_pillbox.h"
 
@@ -41,6 +42,10 @@ void oskar_imager_init_fft(oskar_Imager* h, int* status)
     oskar_Mem* tmp = 0;
     if (*status) return;
 
+    /* Choose the support size from the required accuracy, if set. */
+    if (h->kernel_type == 'E' && h->kernel_accuracy > 0.0)
+        h->support = oskar_grid_support_es(h->kernel_accuracy);
+
     /* Generate the convolution function. */
     tmp = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
             h->oversample * (h->support + 1), status);
@@ -54,6 +59,11 @@ void oskar_imager_init_fft(oskar_Imager* h, int* status)
         oskar_grid_convolution_function_pillbox(h->support, h->oversample,
                 oskar_mem_double(tmp, status));
         break;
+    case 'E':
+        oskar_grid_convolution_function_es(h->support, h->oversample,
+                oskar_grid_beta_es(h->support),
+                oskar_mem_double(tmp, status));
+        break;
     default:
         *status = OSKAR_ERR_FUNCTION_NOT_AVAILABLE;
         break;
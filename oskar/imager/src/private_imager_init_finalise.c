@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/private_imager_init_finalise.h"
+#include "imager/oskar_grid_functions_es.h"
+#include "imager/oskar_grid_functions_pillbox.h"
+#include "imager/oskar_grid_functions_spheroidal.h"
+#include "math/oskar_fft.h"
+#include "utility/oskar_device_utils.h"
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void correction_function_nufft(const int size, const int support,
+        double* fn);
+
+void oskar_imager_init_finalise(oskar_Imager* h, int size, int* status)
+{
+    if (*status) return;
+
+    /* Nothing to do for the DFT algorithms. */
+    if (h->algorithm == OSKAR_ALGORITHM_DFT_2D ||
+            h->algorithm == OSKAR_ALGORITHM_DFT_3D)
+        return;
+
+    /* Create the FFT plan if required.
+     * W-stacking and the 3D NUFFT transform their layers concurrently,
+     * so use the CPU. */
+    if (!h->fft)
+    {
+        int location = OSKAR_CPU;
+        if (h->fft_on_gpu && h->num_gpus > 0 &&
+                h->algorithm != OSKAR_ALGORITHM_WSTACK &&
+                h->algorithm != OSKAR_ALGORITHM_NUFFT_3D)
+        {
+            location = OSKAR_GPU;
+            oskar_device_set(h->gpu_ids[0], status);
+        }
+        h->fft = oskar_fft_create(h->imager_prec, location, 2, size,
+                status);
+    }
+
+    /* Generate grid correction function if required. */
+    if (!h->corr_func)
+    {
+        h->corr_func = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, size, status);
+        if (h->algorithm == OSKAR_ALGORITHM_IDG)
+            oskar_grid_correction_function_spheroidal(size, 0,
+                    oskar_mem_double(h->corr_func, status));
+        else if (h->algorithm == OSKAR_ALGORITHM_NUFFT_2D ||
+                h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
+            correction_function_nufft(size, h->support,
+                    oskar_mem_double(h->corr_func, status));
+        else if (h->algorithm != OSKAR_ALGORITHM_FFT &&
+                h->algorithm != OSKAR_ALGORITHM_WSTACK)
+        {
+            if (h->kernel_type == 'E')
+                oskar_grid_correction_function_es(size, h->oversample,
+                        h->support, oskar_grid_beta_es(h->support),
+                        oskar_mem_double(h->corr_func, status));
+            else
+                oskar_grid_correction_function_spheroidal(size,
+                        h->oversample,
+                        oskar_mem_double(h->corr_func, status));
+        }
+        else
+        {
+            if (h->kernel_type == 'S')
+                oskar_grid_correction_function_spheroidal(size, 0,
+                        oskar_mem_double(h->corr_func, status));
+            else if (h->kernel_type == 'P')
+                oskar_grid_correction_function_pillbox(size,
+                        oskar_mem_double(h->corr_func, status));
+            else if (h->kernel_type == 'E')
+                oskar_grid_correction_function_es(size, 0, h->support,
+                        oskar_grid_beta_es(h->support),
+                        oskar_mem_double(h->corr_func, status));
+        }
+    }
+}
+
+
+/* The NUFFT kernel is evaluated exactly, so the correction is the
+ * reciprocal of the Fourier transform of the continuous kernel. This is
+ * not normalised by its value at the centre, as the grid normalisation
+ * is the sum of the visibility weights, rather than of the kernel. */
+void correction_function_nufft(const int size, const int support,
+        double* fn)
+{
+    int i;
+    double* freq = (double*) malloc(size * sizeof(double));
+    for (i = 0; i < size; ++i)
+        freq[i] = (double)(i - size / 2) / size;
+    oskar_grid_fourier_transform_es(support, oskar_grid_beta_es(support),
+            size, freq, fn);
+    for (i = 0; i < size; ++i)
+        fn[i] = (fn[i] != 0.0) ? 1.0 / fn[i] : 1.0;
+    free(freq);
+}
+
+#ifdef __cplusplus
+}
+#endif
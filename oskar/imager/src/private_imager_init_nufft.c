@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/private_imager_init_fft.h"
+#include "imager/private_imager_init_nufft.h"
+#include "imager/private_imager_init_wstack.h"
+#include "math/oskar_cmath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void oskar_imager_init_nufft(oskar_Imager* h, int* status)
+{
+    double max_w, l_max, r2;
+    if (*status) return;
+
+    /* Generate the kernel, choosing its support size from the required
+     * accuracy. The kernel itself is evaluated exactly when gridding. */
+    h->kernel_type = 'E';
+    oskar_imager_init_fft(h, status);
+    if (h->algorithm != OSKAR_ALGORITHM_NUFFT_3D) return;
+
+    /* Space the W-planes so that the W-term is sampled with the same
+     * oversampling factor of 2 as the UV-plane, at the corner of the
+     * image, where |n - 1| is largest. */
+    max_w = (h->ww_max > 0.0) ? h->ww_max : 0.25 / fabs(h->cellsize_rad);
+    l_max = sin(h->cellsize_rad) * (h->image_size / 2);
+    r2 = 2.0 * l_max * l_max;
+    if (r2 > 1.0) r2 = 1.0;
+    h->w_scale = 4.0 * (1.0 - sqrt(1.0 - r2));
+    h->num_w_planes = (int)ceil(max_w * h->w_scale) + 2 * h->support + 1;
+
+    /* Evaluate the W-terms used when the planes are combined. */
+    oskar_imager_init_n_minus_1(h, status);
+}
+
+#ifdef __cplusplus
+}
+#endif
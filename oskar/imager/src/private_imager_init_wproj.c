@@ -36,6 +36,8 @@
 #include "imager/private_imager_composite_nearest_even.h"
 #include "imager/private_imager_generate_w_phase_screen.h"
 #include "imager/private_imager_init_wproj.h"
+#include "imager/private_imager_w_kernel_cache.h"
+#include "imager/oskar_grid_functions_es.h"
 #include "imager/oskar_grid_functions_spheroidal.h"
 #include "math/oskar_cmath.h"
 #include "math/oskar_fftpack_cfft.h"
@@ -101,6 +103,34 @@ static void compact_kernels(const int num_w_planes, const int* support,
         const oskar_Mem* kernels_in, oskar_Mem* kernels_out,
         int* compacted_kernel_start, int* status);
 
+/* Saves only the first quarter of the kernel; the rest is redundant.
+ * Returns the maximum (from the first element). */
+static double save_kernel(int iw, int conv_size, int conv_size_half,
+        const oskar_Mem* screen, oskar_Mem* kernels)
+{
+    int iy;
+    const char* ptr_in;
+    char* ptr_out;
+    const size_t element_size = oskar_mem_element_size(oskar_mem_type(screen));
+    const size_t copy_len = element_size * conv_size_half;
+    ptr_in = (const char*) oskar_mem_void_const(screen);
+    ptr_out = (char*) oskar_mem_void(kernels) + ((size_t) iw) * copy_len *
+            ((size_t) conv_size_half);
+    for (iy = 0; iy < conv_size_half; ++iy)
+        memcpy(ptr_out + iy * copy_len,
+                ptr_in + ((size_t) iy) * conv_size * element_size, copy_len);
+    if (oskar_mem_precision(screen) == OSKAR_DOUBLE)
+    {
+        const double* t = (const double*) ptr_in;
+        return sqrt(t[0]*t[0] + t[1]*t[1]);
+    }
+    else
+    {
+        const float* t = (const float*) ptr_in;
+        return sqrt(t[0]*t[0] + t[1]*t[1]);
+    }
+}
+
 /*
  * W-kernel generation is based on CASA implementation
  * in code/synthesis/TransformMachines/WPConvFunc.cc
@@ -109,22 +139,21 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
 {
     size_t max_mem_bytes, max_bytes_per_plane, element_size, copy_len;
     int i, iw, ix, iy, *supp, new_conv_size, oversample, prec;
-    int conv_size, conv_size_half, inner, nearest;
+    int conv_size, conv_size_half, inner, nearest, initial_conv_size;
     double l_max, max_conv_size, max_uvw, max_val, sampling, sum;
     double *maxes;
-#ifdef OSKAR_HAVE_CUDA
-    cufftHandle cufft_plan = 0;
-#endif
-    oskar_Mem *screen = 0, *screen_gpu = 0, *screen_ptr = 0;
-    oskar_Mem *taper = 0, *taper_gpu = 0, *taper_ptr = 0;
-    oskar_Mem *wsave = 0, *work = 0;
-    char *ptr_out, *ptr_in, *fname = 0;
+    oskar_Mem *taper = 0;
+    char *fname = 0;
     if (*status) return;
 
     /* Get GCF padding oversample factor and imager precision. */
     oversample = h->oversample;
     prec = h->imager_prec;
 
+    /* Choose the ES kernel support size from the required accuracy. */
+    if (h->kernel_type == 'E' && h->kernel_accuracy > 0.0)
+        h->support = oskar_grid_support_es(h->kernel_accuracy);
+
     /* Calculate required number of w-planes if not set. */
     if (h->ww_max > 0.0)
     {
@@ -155,9 +184,12 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
     conv_size = MIN((int)(h->image_size * h->image_padding), nearest);
     conv_size_half = conv_size / 2 - 1;
     h->conv_size_half = conv_size_half;
+    initial_conv_size = conv_size;
 
     /* Allocate kernels and support array. */
     oskar_mem_free(h->w_kernels, status);
+    h->w_kernels = 0;
+    oskar_imager_w_kernel_cache_release(h);
     oskar_mem_free(h->w_support, status);
     oskar_mem_free(h->w_kernels_compact, status);
     oskar_mem_free(h->w_kernel_start, status);
@@ -165,12 +197,21 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
             h->num_w_planes, status);
     h->w_kernel_start = oskar_mem_create(OSKAR_INT, OSKAR_CPU,
             h->num_w_planes, status);
-    h->w_kernels = oskar_mem_create(prec | OSKAR_COMPLEX, OSKAR_CPU,
-            ((size_t) h->num_w_planes) * ((size_t) conv_size_half) *
-            ((size_t) conv_size_half), status);
     h->w_kernels_compact = oskar_mem_create(prec | OSKAR_COMPLEX, OSKAR_CPU,
             0, status);
     supp = oskar_mem_int(h->w_support, status);
+
+    /* Use kernels from a previous run, if they are in the cache. */
+    if (oskar_imager_w_kernel_cache_load(h, initial_conv_size, status))
+    {
+        compact_kernels(h->num_w_planes, supp, oversample, h->conv_size_half,
+                h->w_kernels, h->w_kernels_compact,
+                oskar_mem_int(h->w_kernel_start, status), status);
+        return;
+    }
+    h->w_kernels = oskar_mem_create(prec | OSKAR_COMPLEX, OSKAR_CPU,
+            ((size_t) h->num_w_planes) * ((size_t) conv_size_half) *
+            ((size_t) conv_size_half), status);
     element_size = oskar_mem_element_size(oskar_mem_type(h->w_kernels));
     if (*status) return;
 
@@ -180,162 +221,163 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
     sampling = (2.0 * l_max * oversample) / h->image_size;
     sampling *= ((double) oskar_imager_plane_size(h)) / ((double) conv_size);
 
-    /* Create scratch arrays and FFT plan for the phase screens. */
-    screen = oskar_mem_create(prec | OSKAR_COMPLEX,
-            OSKAR_CPU, conv_size * conv_size, status);
-    screen_ptr = screen;
+    /* Generate 1D tapering function to cover the inner region.
+     * For the ES kernel, this is the Fourier transform of the kernel. */
+    taper = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, inner, status);
+    if (!*status)
+    {
+        double* t = oskar_mem_double(taper, status);
+        if (h->kernel_type == 'E')
+        {
+            oskar_grid_correction_function_es(inner, 0, h->support,
+                    oskar_grid_beta_es(h->support), t);
+            for (i = 0; i < inner; ++i) t[i] = 1.0 / t[i];
+        }
+        else
+        {
+            for (i = 0; i < inner; ++i)
+            {
+                double nu;
+                nu = (i - (inner / 2)) / ((double)(inner / 2));
+                t[i] = oskar_grid_function_spheroidal(fabs(nu));
+            }
+        }
+    }
+    if (prec != OSKAR_DOUBLE)
+    {
+        oskar_Mem* t = oskar_mem_convert_precision(taper, prec, status);
+        oskar_mem_free(taper, status);
+        taper = t;
+    }
+
+    /* Evaluate kernels. */
+    maxes = (double*) calloc(h->num_w_planes, sizeof(double));
 #ifdef OSKAR_HAVE_CUDA
     if (h->generate_w_kernels_on_gpu && h->num_gpus > 0)
     {
+        cufftHandle cufft_plan = 0;
+        oskar_Mem *screen, *screen_gpu, *taper_gpu;
+
+        /* Create scratch arrays and FFT plan for the phase screens. */
         oskar_device_set(h->gpu_ids[0], status);
+        screen = oskar_mem_create(prec | OSKAR_COMPLEX,
+                OSKAR_CPU, conv_size * conv_size, status);
         screen_gpu = oskar_mem_create(prec | OSKAR_COMPLEX,
                 OSKAR_GPU, conv_size * conv_size, status);
-        screen_ptr = screen_gpu;
+        taper_gpu = oskar_mem_create_copy(taper, OSKAR_GPU, status);
         if (prec == OSKAR_DOUBLE)
             cufftPlan2d(&cufft_plan, conv_size, conv_size, CUFFT_Z2Z);
         else
             cufftPlan2d(&cufft_plan, conv_size, conv_size, CUFFT_C2C);
+        for (iw = 0; iw < h->num_w_planes; ++iw)
+        {
+            /* Generate the tapered phase screen. */
+            oskar_imager_generate_w_phase_screen(iw, conv_size, inner,
+                    sampling, h->w_scale, taper_gpu, screen_gpu, status);
+            if (*status) break;
+
+            /* Perform the FFT to get the kernel. No shifts are required. */
+            if (prec == OSKAR_DOUBLE)
+                cufftExecZ2Z(cufft_plan, oskar_mem_void(screen_gpu),
+                        oskar_mem_void(screen_gpu), CUFFT_FORWARD);
+            else
+                cufftExecC2C(cufft_plan, oskar_mem_void(screen_gpu),
+                        oskar_mem_void(screen_gpu), CUFFT_FORWARD);
+            oskar_mem_copy(screen, screen_gpu, status);
+            if (*status) break;
+            maxes[iw] = save_kernel(iw, conv_size, conv_size_half,
+                    screen, h->w_kernels);
+        }
+        cufftDestroy(cufft_plan);
+        oskar_mem_free(screen, status);
+        oskar_mem_free(screen_gpu, status);
+        oskar_mem_free(taper_gpu, status);
     }
     else
 #endif
     {
+        oskar_Mem* wsave;
         int len_save = 4 * conv_size +
                 2 * (int)(log((double)conv_size) / log(2.0)) + 8;
+
+        /* The FFT coefficients are read-only, so can be shared. */
         wsave = oskar_mem_create(prec, OSKAR_CPU, len_save, status);
-        work = oskar_mem_create(prec, OSKAR_CPU,
-                2 * conv_size * conv_size, status);
         if (prec == OSKAR_DOUBLE)
             oskar_fftpack_cfft2i(conv_size, conv_size,
                     oskar_mem_double(wsave, status));
         else
             oskar_fftpack_cfft2i_f(conv_size, conv_size,
                     oskar_mem_float(wsave, status));
-    }
 
-    /* Generate 1D spheroidal tapering function to cover the inner region. */
-    taper = oskar_mem_create(prec, OSKAR_CPU, inner, status);
-    taper_ptr = taper;
-    if (prec == OSKAR_DOUBLE)
-    {
-        double* t = oskar_mem_double(taper, status);
-        for (i = 0; i < inner; ++i)
+        /* Generate kernels for different W-planes in parallel.
+         * Each thread needs its own phase screen and FFT work buffer. */
+#pragma omp parallel private(iw)
         {
-            double nu;
-            nu = (i - (inner / 2)) / ((double)(inner / 2));
-            t[i] = oskar_grid_function_spheroidal(fabs(nu));
-        }
-    }
-    else
-    {
-        float* t = oskar_mem_float(taper, status);
-        for (i = 0; i < inner; ++i)
-        {
-            double nu;
-            nu = (i - (inner / 2)) / ((double)(inner / 2));
-            t[i] = oskar_grid_function_spheroidal(fabs(nu));
-        }
-    }
-#ifdef OSKAR_HAVE_CUDA
-    if (h->generate_w_kernels_on_gpu && h->num_gpus > 0)
-    {
-        taper_gpu = oskar_mem_create_copy(taper, OSKAR_GPU, status);
-        taper_ptr = taper_gpu;
-    }
-#endif
-
-    /* Evaluate kernels. */
-    ptr_in   = oskar_mem_char(screen);
-    copy_len = element_size * conv_size_half;
-    maxes = (double*) calloc(h->num_w_planes, sizeof(double));
-    for (iw = 0; iw < h->num_w_planes; ++iw)
-    {
-        size_t in = 0, out = 0, offset;
-
-        /* Generate the tapered phase screen. */
-        oskar_imager_generate_w_phase_screen(iw, conv_size, inner, sampling,
-                h->w_scale, taper_ptr, screen_ptr, status);
-        if (*status) break;
-
-        /* Perform the FFT to get the kernel. No shifts are required. */
-#ifdef OSKAR_HAVE_CUDA
-        if (h->generate_w_kernels_on_gpu && h->num_gpus > 0)
-        {
-            if (oskar_mem_precision(screen) == OSKAR_DOUBLE)
-                cufftExecZ2Z(cufft_plan, oskar_mem_void(screen_ptr),
-                        oskar_mem_void(screen_ptr), CUFFT_FORWARD);
-            else
-                cufftExecC2C(cufft_plan, oskar_mem_void(screen_ptr),
-                        oskar_mem_void(screen_ptr), CUFFT_FORWARD);
-            oskar_mem_copy(screen, screen_ptr, status);
-        }
-        else
-#endif
-        {
-            if (oskar_mem_precision(screen_ptr) == OSKAR_DOUBLE)
-                oskar_fftpack_cfft2f(conv_size, conv_size, conv_size,
-                        oskar_mem_double(screen_ptr, status),
-                        oskar_mem_double(wsave, status),
-                        oskar_mem_double(work, status));
-            else
-                oskar_fftpack_cfft2f_f(conv_size, conv_size, conv_size,
-                        oskar_mem_float(screen_ptr, status),
-                        oskar_mem_float(wsave, status),
-                        oskar_mem_float(work, status));
-        }
-        if (*status) break;
-
-        /* Get the maximum (from the first element). */
-        if (oskar_mem_precision(screen) == OSKAR_DOUBLE)
-        {
-            const double* t = (const double*) oskar_mem_void_const(screen);
-            maxes[iw] = sqrt(t[0]*t[0] + t[1]*t[1]);
-        }
-        else
-        {
-            const float* t = (const float*) oskar_mem_void_const(screen);
-            maxes[iw] = sqrt(t[0]*t[0] + t[1]*t[1]);
-        }
-
-        /* Save only the first quarter of the kernel; the rest is redundant. */
-        offset = iw * conv_size_half * conv_size_half * element_size;
-        ptr_out = oskar_mem_char(h->w_kernels) + offset;
-        for (iy = 0; iy < conv_size_half; ++iy)
-        {
-            memcpy(ptr_out + out, ptr_in + in, copy_len);
-            in += conv_size * element_size;
-            out += copy_len;
+            int thread_status = *status;
+            oskar_Mem *screen, *work;
+            screen = oskar_mem_create(prec | OSKAR_COMPLEX,
+                    OSKAR_CPU, conv_size * conv_size, &thread_status);
+            work = oskar_mem_create(prec, OSKAR_CPU,
+                    2 * conv_size * conv_size, &thread_status);
+#pragma omp for schedule(dynamic)
+            for (iw = 0; iw < h->num_w_planes; ++iw)
+            {
+                if (thread_status) continue;
+
+                /* Generate the tapered phase screen. */
+                oskar_imager_generate_w_phase_screen(iw, conv_size, inner,
+                        sampling, h->w_scale, taper, screen, &thread_status);
+
+                /* Perform the FFT to get the kernel. No shifts are required. */
+                if (prec == OSKAR_DOUBLE)
+                    oskar_fftpack_cfft2f(conv_size, conv_size, conv_size,
+                            oskar_mem_double(screen, &thread_status),
+                            oskar_mem_double(wsave, &thread_status),
+                            oskar_mem_double(work, &thread_status));
+                else
+                    oskar_fftpack_cfft2f_f(conv_size, conv_size, conv_size,
+                            oskar_mem_float(screen, &thread_status),
+                            oskar_mem_float(wsave, &thread_status),
+                            oskar_mem_float(work, &thread_status));
+                if (thread_status) continue;
+                maxes[iw] = save_kernel(iw, conv_size, conv_size_half,
+                        screen, h->w_kernels);
+            }
+            oskar_mem_free(screen, &thread_status);
+            oskar_mem_free(work, &thread_status);
+            if (thread_status)
+            {
+#pragma omp critical (init_wproj_status)
+                *status = thread_status;
+            }
         }
+        oskar_mem_free(wsave, status);
     }
-
-    /* Clean up. */
-#ifdef OSKAR_HAVE_CUDA
-    cufftDestroy(cufft_plan);
-#endif
-    oskar_mem_free(screen, status);
-    oskar_mem_free(screen_gpu, status);
     oskar_mem_free(taper, status);
-    oskar_mem_free(taper_gpu, status);
-    oskar_mem_free(wsave, status);
-    oskar_mem_free(work, status);
 
     /* Normalise each plane by the maximum. */
-    if (*status) return;
+    if (*status)
+    {
+        free(maxes);
+        return;
+    }
     max_val = -INT_MAX;
     for (iw = 0; iw < h->num_w_planes; ++iw) max_val = MAX(max_val, maxes[iw]);
     oskar_mem_scale_real(h->w_kernels, 1.0 / max_val, status);
     free(maxes);
+    if (*status) return;
 
     /* Find the support size of each kernel by stepping in from the edge. */
+#pragma omp parallel for
     for (iw = 0; iw < h->num_w_planes; ++iw)
     {
         int trial = 0, found = 0, plane_offset, ind1, ind2;
         double v1, v2;
-        if (*status) break;
         plane_offset = conv_size_half * conv_size_half * iw;
-        if (oskar_mem_precision(h->w_kernels) == OSKAR_DOUBLE)
+        if (prec == OSKAR_DOUBLE)
         {
-            const double *restrict p = oskar_mem_double_const(
-                    h->w_kernels, status);
+            const double *restrict p = (const double*)
+                    oskar_mem_void_const(h->w_kernels);
             for (trial = conv_size_half - 1; trial > 0; trial--)
             {
                 ind1 = 2 * (trial * conv_size_half + plane_offset);
@@ -351,8 +393,8 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
         }
         else
         {
-            const float *restrict p = oskar_mem_float_const(
-                    h->w_kernels, status);
+            const float *restrict p = (const float*)
+                    oskar_mem_void_const(h->w_kernels);
             for (trial = conv_size_half - 1; trial > 0; trial--)
             {
                 ind1 = 2 * (trial * conv_size_half + plane_offset);
@@ -373,7 +415,6 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
                 supp[iw] = conv_size / 2 / oversample - 1;
         }
     }
-    if (*status) return;
 
     /* Compact the kernels if we can. */
     max_val = -INT_MAX;
@@ -381,31 +422,43 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
     new_conv_size = 2 * (max_val + 2) * oversample;
     if (new_conv_size < conv_size)
     {
-        char *ptr;
+        oskar_Mem* compacted;
+        const char *ptr_in;
+        char *ptr_out;
         int new_conv_size_half;
-        size_t in = 0, out = 0;
-        ptr = oskar_mem_char(h->w_kernels);
         new_conv_size_half = new_conv_size / 2 - 2;
         copy_len = element_size * new_conv_size_half;
 
+        /* Copy into a new array, so that planes can be copied in parallel. */
+        compacted = oskar_mem_create(prec | OSKAR_COMPLEX, OSKAR_CPU,
+                ((size_t) h->num_w_planes) * ((size_t) new_conv_size_half) *
+                ((size_t) new_conv_size_half), status);
+        if (*status)
+        {
+            oskar_mem_free(compacted, status);
+            return;
+        }
+        ptr_in = (const char*) oskar_mem_void_const(h->w_kernels);
+        ptr_out = (char*) oskar_mem_void(compacted);
+#pragma omp parallel for private(iy)
         for (iw = 0; iw < h->num_w_planes; ++iw)
         {
-            in = iw * conv_size_half * conv_size_half * element_size;
+            const char* in = ptr_in + ((size_t) iw) * element_size *
+                    ((size_t) conv_size_half) * ((size_t) conv_size_half);
+            char* out = ptr_out + ((size_t) iw) * copy_len *
+                    ((size_t) new_conv_size_half);
             for (iy = 0; iy < new_conv_size_half; ++iy)
             {
-                /* Use memmove() rather than memcpy() to allow for overlap. */
-                memmove(ptr + out, ptr + in, copy_len);
+                memcpy(out, in, copy_len);
                 in += conv_size_half * element_size;
                 out += copy_len;
             }
         }
+        oskar_mem_free(h->w_kernels, status);
+        h->w_kernels = compacted;
         conv_size = new_conv_size;
         h->conv_size_half = conv_size_half = new_conv_size_half;
-        oskar_mem_realloc(h->w_kernels,
-                ((size_t) h->num_w_planes) * ((size_t) new_conv_size_half) *
-                ((size_t) new_conv_size_half), status);
     }
-    if (*status) return;
 
 #if 0
     /* Print kernel support sizes. */
@@ -456,6 +509,10 @@ void oskar_imager_init_wproj(oskar_Imager* h, int* status)
     compact_kernels(h->num_w_planes, supp, oversample, conv_size_half,
             h->w_kernels, h->w_kernels_compact,
             oskar_mem_int(h->w_kernel_start, status), status);
+
+    /* Save the kernels to the cache, if required. */
+    if (!*status)
+        oskar_imager_w_kernel_cache_save(h, initial_conv_size);
 }
 
 static void compact_kernels(const int num_w_planes, const int* support,
@@ -496,6 +553,7 @@ static void compact_kernels(const int num_w_planes, const int* support,
     out_f = (float2*)  oskar_mem_void(kernels_out);
     out_d = (double2*) oskar_mem_void(kernels_out);
 
+#pragma omp parallel for private(j, k, off_u, off_v)
     for (w = 0; w < num_w_planes; w++)
     {
         const int w_support = support[w];
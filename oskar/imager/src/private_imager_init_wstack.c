@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/private_imager_init_fft.h"
+#include "imager/private_imager_init_wstack.h"
+#include "math/oskar_cmath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void oskar_imager_init_wstack(oskar_Imager* h, int* status)
+{
+    double max_w, r2;
+    if (*status) return;
+
+    /* Generate the convolution function used to grid each W-layer. */
+    oskar_imager_init_fft(h, status);
+
+    /* Calculate required number of W-layers if not set.
+     * Layers are spaced so that the W-term phase error at the corner of
+     * the image is at most 0.5 radians. */
+    max_w = (h->ww_max > 0.0) ? h->ww_max : 0.25 / fabs(h->cellsize_rad);
+    if (h->num_w_planes < 1)
+    {
+        r2 = 2.0 * pow(sin(h->cellsize_rad * h->image_size / 2.0), 2.0);
+        if (r2 > 1.0) r2 = 1.0;
+        h->num_w_planes = 1 + (int)ceil(2.0 * M_PI * max_w *
+                (1.0 - sqrt(1.0 - r2)));
+    }
+
+    /* Set the scale factor used to find the W-layer index. */
+    h->w_scale = (h->num_w_planes > 1) ? (h->num_w_planes - 1) / max_w : 0.0;
+
+    /* Evaluate the W-terms used when the layers are combined. */
+    oskar_imager_init_n_minus_1(h, status);
+}
+
+void oskar_imager_init_n_minus_1(oskar_Imager* h, int* status)
+{
+    int size, ix, iy;
+    double delta_l, *t;
+    if (*status) return;
+
+    /* Evaluate n - 1 at each pixel of the image, or set it to zero
+     * beyond the horizon. The NUFFT pixels are spaced uniformly in
+     * direction cosine. */
+    size = oskar_imager_plane_size(h);
+    delta_l = h->cellsize_rad;
+    if (h->algorithm == OSKAR_ALGORITHM_NUFFT_3D)
+        delta_l = sin(h->cellsize_rad);
+    oskar_mem_free(h->n_minus_1, status);
+    h->n_minus_1 = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            (size_t)size * size, status);
+    t = oskar_mem_double(h->n_minus_1, status);
+    if (*status) return;
+    for (iy = 0; iy < size; ++iy)
+    {
+        const double m = delta_l * (iy - size / 2);
+        for (ix = 0; ix < size; ++ix)
+        {
+            const double l = delta_l * (ix - size / 2);
+            const double r2 = l*l + m*m;
+            t[(size_t)iy * size + ix] = (r2 < 1.0) ? sqrt(1.0 - r2) - 1.0 : 0.0;
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
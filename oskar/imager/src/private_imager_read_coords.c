@@ -28,32 +28,156 @@
 
 #include "imager/private_imager.h"
 #include "imager/private_imager_read_coords.h"
+#include "imager/private_imager_update_progress.h"
 #include "imager/oskar_imager.h"
 #include "binary/oskar_binary.h"
 #include "math/oskar_cmath.h"
 #include "mem/oskar_binary_read_mem.h"
+#include "mem/oskar_binary_write_mem.h"
 #include "ms/oskar_measurement_set.h"
 #include "vis/oskar_vis_block.h"
 #include "vis/oskar_vis_header.h"
+#include "utility/oskar_dir.h"
 #include "utility/oskar_timer.h"
 
 #include <float.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef OSKAR_OS_WIN
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Coordinate index files contain a copy of the baseline coordinates,
+ * weights and time centroids in a Measurement Set, so that they can be
+ * read without opening its tables on subsequent runs.
+ * The total size and latest modification time of the files in the
+ * Measurement Set are stored too, so that the index is not used once the
+ * Measurement Set has changed. Modification times have a resolution of
+ * one second, so an index is also not used if it was written in the same
+ * second as the Measurement Set was last modified. */
+#define INDEX_GROUP "IMAGER_COORDS"
+#define INDEX_TAGS_PER_HEADER 8
+#define INDEX_TAGS_PER_BLOCK 5
+
+#ifndef OSKAR_NO_MS
+static double file_mtime(const char* filename)
+{
+    struct stat s;
+    return stat(filename, &s) ? 0.0 : (double) s.st_mtime;
+}
+
+/* Gets the total size and latest modification time of the files in the
+ * Measurement Set directory. */
+static void ms_stats(const char* filename, double* size, double* mtime)
+{
+    int i, num_items = 0;
+    char** items = 0;
+    *size = *mtime = 0.0;
+    oskar_dir_items(filename, 0, 1, 0, &num_items, &items);
+    for (i = 0; i < num_items; ++i)
+    {
+        struct stat s;
+        char* path = oskar_dir_get_path(filename, items[i]);
+        if (!stat(path, &s))
+        {
+            *size += (double) s.st_size;
+            if ((double) s.st_mtime > *mtime) *mtime = (double) s.st_mtime;
+        }
+        free(path);
+        free(items[i]);
+    }
+    free(items);
+}
+
+static char* index_filename(const char* filename)
+{
+    char* name;
+    size_t len = strlen(filename);
+    while (len > 1 && (filename[len - 1] == '/' || filename[len - 1] == '\\'))
+        len--;
+    name = (char*) calloc(len + 12, 1);
+    memcpy(name, filename, len);
+    strcpy(name + len, ".coords");
+    return name;
+}
+
+static void write_index_header(oskar_Binary* f, int num_rows,
+        int num_stations, int num_channels, int num_pols,
+        double freq_start_hz, double freq_inc_hz, double ms_size,
+        double ms_mtime, int* status)
+{
+    oskar_binary_write_ext_int(f, INDEX_GROUP, "NUM_ROWS", 0,
+            num_rows, status);
+    oskar_binary_write_ext_int(f, INDEX_GROUP, "NUM_STATIONS", 0,
+            num_stations, status);
+    oskar_binary_write_ext_int(f, INDEX_GROUP, "NUM_CHANNELS", 0,
+            num_channels, status);
+    oskar_binary_write_ext_int(f, INDEX_GROUP, "NUM_POLS", 0,
+            num_pols, status);
+    oskar_binary_write_ext_double(f, INDEX_GROUP, "FREQ_START_HZ", 0,
+            freq_start_hz, status);
+    oskar_binary_write_ext_double(f, INDEX_GROUP, "FREQ_INC_HZ", 0,
+            freq_inc_hz, status);
+    oskar_binary_write_ext_double(f, INDEX_GROUP, "MS_SIZE", 0,
+            ms_size, status);
+    oskar_binary_write_ext_double(f, INDEX_GROUP, "MS_MTIME", 0,
+            ms_mtime, status);
+}
+
+/* Returns true if the index file exists and matches the Measurement Set. */
+static int check_index_header(oskar_Binary* f, int num_rows,
+        int num_stations, int num_channels, int num_pols,
+        double freq_start_hz, double freq_inc_hz, double ms_size,
+        double ms_mtime, double index_mtime)
+{
+    int status = 0, val[4];
+    double freq[2], ms[2];
+    oskar_binary_read_ext_int(f, INDEX_GROUP, "NUM_ROWS", 0,
+            &val[0], &status);
+    oskar_binary_read_ext_int(f, INDEX_GROUP, "NUM_STATIONS", 0,
+            &val[1], &status);
+    oskar_binary_read_ext_int(f, INDEX_GROUP, "NUM_CHANNELS", 0,
+            &val[2], &status);
+    oskar_binary_read_ext_int(f, INDEX_GROUP, "NUM_POLS", 0,
+            &val[3], &status);
+    oskar_binary_read_ext_double(f, INDEX_GROUP, "FREQ_START_HZ", 0,
+            &freq[0], &status);
+    oskar_binary_read_ext_double(f, INDEX_GROUP, "FREQ_INC_HZ", 0,
+            &freq[1], &status);
+    oskar_binary_read_ext_double(f, INDEX_GROUP, "MS_SIZE", 0,
+            &ms[0], &status);
+    oskar_binary_read_ext_double(f, INDEX_GROUP, "MS_MTIME", 0,
+            &ms[1], &status);
+    return !status && val[0] == num_rows && val[1] == num_stations &&
+            val[2] == num_channels && val[3] == num_pols &&
+            freq[0] == freq_start_hz && freq[1] == freq_inc_hz &&
+            ms[0] == ms_size && ms[1] == ms_mtime && ms_mtime < index_mtime;
+}
+#endif
+
 void oskar_imager_read_coords_ms(oskar_Imager* h, const char* filename,
         int i_file, int num_files, int* percent_done, int* percent_next,
         int* status)
 {
 #ifndef OSKAR_NO_MS
     oskar_MeasurementSet* ms;
+    oskar_Binary *index = 0;
     oskar_Mem *uvw, *u, *v, *w, *weight, *time_centroid;
     int num_channels, num_stations, num_baselines, num_pols;
-    int start_row, num_rows;
-    double *uvw_, *u_, *v_, *w_;
+    int start_row, num_rows, i_block, index_status = 0, use_index = 0;
+    double *uvw_, *u_, *v_, *w_, freq_start_hz, freq_inc_hz;
+    double ms_size = 0.0, ms_mtime = 0.0;
+    char *index_name = 0, *index_name_tmp = 0;
     if (*status) return;
 
     /* Read the header. */
@@ -68,15 +192,49 @@ void oskar_imager_read_coords_ms(oskar_Imager* h, const char* filename,
     num_baselines = num_stations * (num_stations - 1) / 2;
     num_pols = (int) oskar_ms_num_pols(ms);
     num_channels = (int) oskar_ms_num_channels(ms);
+    freq_start_hz = oskar_ms_freq_start_hz(ms);
+    freq_inc_hz = oskar_ms_freq_inc_hz(ms);
 
     /* Set visibility meta-data. */
     oskar_imager_set_vis_frequency(h,
-            oskar_ms_freq_start_hz(ms),
-            oskar_ms_freq_inc_hz(ms), num_channels);
+            freq_start_hz, freq_inc_hz, num_channels);
     oskar_imager_set_vis_phase_centre(h,
             oskar_ms_phase_centre_ra_rad(ms) * 180/M_PI,
             oskar_ms_phase_centre_dec_rad(ms) * 180/M_PI);
 
+    /* Use the coordinate index file if it exists and matches,
+     * or create a new one. */
+    if (h->use_coords_index)
+    {
+        index_name = index_filename(filename);
+        ms_stats(filename, &ms_size, &ms_mtime);
+        index = oskar_binary_create(index_name, 'r', &index_status);
+        if (!index_status && check_index_header(index, num_rows,
+                num_stations, num_channels, num_pols,
+                freq_start_hz, freq_inc_hz, ms_size, ms_mtime,
+                file_mtime(index_name)))
+        {
+            use_index = 1;
+            if (h->log)
+                oskar_log_message(h->log, 'M', 1,
+                        "Using coordinate index '%s'", index_name);
+        }
+        else
+        {
+            /* Write to a temporary file, then rename it when complete.
+             * The process ID makes the name unique if other processes
+             * are writing an index for the same Measurement Set. */
+            oskar_binary_free(index);
+            index_status = 0;
+            index_name_tmp = (char*) calloc(strlen(index_name) + 20, 1);
+            sprintf(index_name_tmp, "%s.%d.tmp", index_name, (int) getpid());
+            index = oskar_binary_create(index_name_tmp, 'w', &index_status);
+            write_index_header(index, num_rows, num_stations, num_channels,
+                    num_pols, freq_start_hz, freq_inc_hz, ms_size, ms_mtime,
+                    &index_status);
+        }
+    }
+
     /* Create arrays. */
     uvw = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 3 * num_baselines, status);
     u = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_baselines, status);
@@ -92,16 +250,42 @@ void oskar_imager_read_coords_ms(oskar_Imager* h, const char* filename,
     w_ = oskar_mem_double(w, status);
 
     /* Loop over visibility blocks. */
-    for (start_row = 0; start_row < num_rows; start_row += num_baselines)
+    for (start_row = 0, i_block = 0; start_row < num_rows;
+            start_row += num_baselines, ++i_block)
     {
         int i, block_size;
         size_t allocated, required;
         if (*status) break;
-
-        /* Read coordinates and weights from Measurement Set. */
         oskar_timer_resume(h->tmr_read);
         block_size = num_rows - start_row;
         if (block_size > num_baselines) block_size = num_baselines;
+
+        /* Read coordinates and weights from the index if possible. */
+        if (use_index)
+        {
+            oskar_binary_set_query_search_start(index,
+                    INDEX_TAGS_PER_HEADER + i_block * INDEX_TAGS_PER_BLOCK,
+                    status);
+            oskar_binary_read_mem_ext(index, u, INDEX_GROUP, "UU",
+                    i_block, status);
+            oskar_binary_read_mem_ext(index, v, INDEX_GROUP, "VV",
+                    i_block, status);
+            oskar_binary_read_mem_ext(index, w, INDEX_GROUP, "WW",
+                    i_block, status);
+            oskar_binary_read_mem_ext(index, weight, INDEX_GROUP, "WEIGHT",
+                    i_block, status);
+            oskar_binary_read_mem_ext(index, time_centroid, INDEX_GROUP,
+                    "TIME_CENTROID", i_block, status);
+            oskar_timer_pause(h->tmr_read);
+            oskar_imager_update(h, block_size, 0, num_channels - 1, num_pols,
+                    u, v, w, 0, weight, time_centroid, status);
+            oskar_imager_update_progress(h,
+                    (start_row + block_size) / (double)num_rows,
+                    i_file, num_files, percent_done, percent_next);
+            continue;
+        }
+
+        /* Read coordinates and weights from Measurement Set. */
         allocated = oskar_mem_length(uvw) *
                 oskar_mem_element_size(oskar_mem_type(uvw));
         oskar_ms_read_column(ms, "UVW", start_row, block_size,
@@ -123,19 +307,49 @@ void oskar_imager_read_coords_ms(oskar_Imager* h, const char* filename,
             w_[i] = uvw_[3*i + 2];
         }
 
+        /* Save a copy of the block to the index file if required. */
+        if (index && !index_status && !*status)
+        {
+            oskar_binary_write_mem_ext(index, u, INDEX_GROUP, "UU",
+                    i_block, block_size, &index_status);
+            oskar_binary_write_mem_ext(index, v, INDEX_GROUP, "VV",
+                    i_block, block_size, &index_status);
+            oskar_binary_write_mem_ext(index, w, INDEX_GROUP, "WW",
+                    i_block, block_size, &index_status);
+            oskar_binary_write_mem_ext(index, weight, INDEX_GROUP, "WEIGHT",
+                    i_block, block_size * num_pols, &index_status);
+            oskar_binary_write_mem_ext(index, time_centroid, INDEX_GROUP,
+                    "TIME_CENTROID", i_block, block_size, &index_status);
+        }
+
         /* Update the imager with the data. */
         oskar_timer_pause(h->tmr_read);
         oskar_imager_update(h, block_size, 0, num_channels - 1, num_pols,
                 u, v, w, 0, weight, time_centroid, status);
-        *percent_done = (int) round(100.0 * (
-                (start_row + block_size) / (double)(num_rows * num_files) +
-                i_file / (double)num_files));
-        if (h->log && percent_next && *percent_done >= *percent_next)
+        oskar_imager_update_progress(h,
+                (start_row + block_size) / (double)num_rows,
+                i_file, num_files, percent_done, percent_next);
+    }
+
+    /* Close the index file, and keep it only if it is complete. */
+    oskar_binary_free(index);
+    if (index_name_tmp)
+    {
+        if (!index_status && !*status)
+        {
+            remove(index_name);
+            index_status = rename(index_name_tmp, index_name);
+        }
+        if (index_status || *status)
         {
-            oskar_log_message(h->log, 'S', -2, "%3d%% ...", *percent_done);
-            *percent_next = 10 + 10 * (*percent_done / 10);
+            remove(index_name_tmp);
+            if (h->log && !*status)
+                oskar_log_warning(h->log, "Unable to write coordinate "
+                        "index file '%s'.", index_name);
         }
     }
+    free(index_name);
+    free(index_name_tmp);
     oskar_mem_free(uvw, status);
     oskar_mem_free(u, status);
     oskar_mem_free(v, status);
@@ -253,14 +467,8 @@ void oskar_imager_read_coords_vis(oskar_Imager* h, const char* filename,
         oskar_timer_pause(h->tmr_read);
         oskar_imager_update(h, num_rows, start_chan, end_chan, num_pols,
                 uu, vv, ww, 0, weight, time_centroid, status);
-        *percent_done = (int) round(100.0 * (
-                (i_block + 1) / (double)(num_blocks * num_files) +
-                i_file / (double)num_files));
-        if (h->log && percent_next && *percent_done >= *percent_next)
-        {
-            oskar_log_message(h->log, 'S', -2, "%3d%% ...", *percent_done);
-            *percent_next = 10 + 10 * (*percent_done / 10);
-        }
+        oskar_imager_update_progress(h, (i_block + 1) / (double)num_blocks,
+                i_file, num_files, percent_done, percent_next);
     }
     oskar_mem_free(uu, status);
     oskar_mem_free(vv, status);
@@ -28,6 +28,8 @@
 
 #include "imager/private_imager.h"
 #include "imager/private_imager_read_data.h"
+#include "imager/private_imager_scratch.h"
+#include "imager/private_imager_update_progress.h"
 #include "imager/oskar_imager.h"
 #include "binary/oskar_binary.h"
 #include "math/oskar_cmath.h"
@@ -35,6 +37,7 @@
 #include "ms/oskar_measurement_set.h"
 #include "vis/oskar_vis_block.h"
 #include "vis/oskar_vis_header.h"
+#include "utility/oskar_thread.h"
 #include "utility/oskar_timer.h"
 
 #include <float.h>
@@ -46,114 +49,259 @@
 extern "C" {
 #endif
 
+/*
+ * Blocks are read by a dedicated thread into one of two buffers, while the
+ * calling thread updates the imager with the block in the other buffer.
+ * The reader also converts the data to the imager precision, so that
+ * oskar_imager_update() does not need to.
+ */
+#define NUM_SLOTS OSKAR_IMAGER_READ_SLOTS
+
+typedef void (*BlockFunc)(void* arg, int i_block, int slot, int* status);
+
+struct ReadPipeline
+{
+    BlockFunc read_block, update_block;
+    void* arg;
+    oskar_Barrier* barrier;
+    int num_blocks, read_status, update_status, status;
+};
+typedef struct ReadPipeline ReadPipeline;
+
+static void pipeline_sync(ReadPipeline* p, int is_reader)
+{
+    /* Barrier 1: Wait for both the read and the update to finish. */
+    oskar_barrier_wait(p->barrier);
+    if (!is_reader)
+        p->status = p->read_status ? p->read_status : p->update_status;
+
+    /* Barrier 2: Make the combined status visible to both threads. */
+    oskar_barrier_wait(p->barrier);
+}
+
+static void* pipeline_read_thread(void* arg)
+{
+    int b;
+    ReadPipeline* p = (ReadPipeline*) arg;
+
+    /* Read block b while the previous block is being used. */
+    for (b = 0; b < p->num_blocks + 1; ++b)
+    {
+        if (b < p->num_blocks && !p->status)
+            p->read_block(p->arg, b, b % NUM_SLOTS, &p->read_status);
+        pipeline_sync(p, 1);
+    }
+    return 0;
+}
+
+static void pipeline_run(BlockFunc read_block, BlockFunc update_block,
+        void* arg, int num_blocks, int* status)
+{
+    int b;
+    ReadPipeline p;
+    oskar_Thread* thread;
+    if (*status) return;
+    p.read_block = read_block;
+    p.update_block = update_block;
+    p.arg = arg;
+    p.num_blocks = num_blocks;
+    p.read_status = p.update_status = p.status = 0;
+    p.barrier = oskar_barrier_create(2);
+    thread = oskar_thread_create(pipeline_read_thread, (void*)&p, 0);
+
+    /* Note that nothing is used on the first loop counter (as no data are
+     * ready yet), and nothing is read on the last loop counter. */
+    for (b = 0; b < num_blocks + 1; ++b)
+    {
+        if (b > 0 && !p.status)
+            update_block(arg, b - 1, (b - 1) % NUM_SLOTS, &p.update_status);
+        pipeline_sync(&p, 0);
+    }
+    oskar_thread_join(thread);
+    oskar_thread_free(thread);
+    oskar_barrier_free(p.barrier);
+    *status = p.status;
+}
+
+#ifndef OSKAR_NO_MS
+struct MsReader
+{
+    oskar_Imager* h;
+    oskar_MeasurementSet* ms;
+    oskar_Mem *uvw[NUM_SLOTS], *u[NUM_SLOTS], *v[NUM_SLOTS], *w[NUM_SLOTS];
+    oskar_Mem *data[NUM_SLOTS], *weight[NUM_SLOTS];
+    oskar_Mem *conv_data[NUM_SLOTS], *conv_weight[NUM_SLOTS];
+    const oskar_Mem *amp_in[NUM_SLOTS], *weight_in[NUM_SLOTS];
+    oskar_Mem *time_centroid[NUM_SLOTS];
+    size_t num_baselines, num_rows, block_size[NUM_SLOTS];
+    int num_channels, num_pols, i_file, num_files;
+    int *percent_done, *percent_next;
+};
+typedef struct MsReader MsReader;
+
+static void read_block_ms(void* arg, int i_block, int slot, int* status)
+{
+    MsReader* r = (MsReader*) arg;
+    size_t allocated, required, block_size, start_row, i;
+    const double* uvw_;
+    if (*status) return;
+
+    /* Read rows from Measurement Set. */
+    oskar_timer_resume(r->h->tmr_read);
+    start_row = i_block * r->num_baselines;
+    block_size = r->num_rows - start_row;
+    if (block_size > r->num_baselines) block_size = r->num_baselines;
+    r->block_size[slot] = block_size;
+    allocated = oskar_mem_length(r->uvw[slot]) *
+            oskar_mem_element_size(oskar_mem_type(r->uvw[slot]));
+    oskar_ms_read_column(r->ms, "UVW", start_row, block_size,
+            allocated, oskar_mem_void(r->uvw[slot]), &required, status);
+    allocated = oskar_mem_length(r->weight[slot]) *
+            oskar_mem_element_size(oskar_mem_type(r->weight[slot]));
+    oskar_ms_read_column(r->ms, "WEIGHT", start_row, block_size,
+            allocated, oskar_mem_void(r->weight[slot]), &required, status);
+    allocated = oskar_mem_length(r->time_centroid[slot]) *
+            oskar_mem_element_size(oskar_mem_type(r->time_centroid[slot]));
+    oskar_ms_read_column(r->ms, "TIME_CENTROID", start_row, block_size,
+            allocated, oskar_mem_void(r->time_centroid[slot]),
+            &required, status);
+    allocated = oskar_mem_length(r->data[slot]) *
+            oskar_mem_element_size(oskar_mem_type(r->data[slot]));
+    oskar_ms_read_column(r->ms, r->h->ms_column, start_row, block_size,
+            allocated, oskar_mem_void(r->data[slot]), &required, status);
+    if (*status)
+    {
+        oskar_timer_pause(r->h->tmr_read);
+        return;
+    }
+
+    /* Split up baseline coordinates in the imager precision. */
+    uvw_ = oskar_mem_double_const(r->uvw[slot], status);
+    if (oskar_mem_precision(r->u[slot]) == OSKAR_DOUBLE)
+    {
+        double *u_, *v_, *w_;
+        u_ = oskar_mem_double(r->u[slot], status);
+        v_ = oskar_mem_double(r->v[slot], status);
+        w_ = oskar_mem_double(r->w[slot], status);
+        for (i = 0; i < block_size; ++i)
+        {
+            u_[i] = uvw_[3*i + 0];
+            v_[i] = uvw_[3*i + 1];
+            w_[i] = uvw_[3*i + 2];
+        }
+    }
+    else
+    {
+        float *u_, *v_, *w_;
+        u_ = oskar_mem_float(r->u[slot], status);
+        v_ = oskar_mem_float(r->v[slot], status);
+        w_ = oskar_mem_float(r->w[slot], status);
+        for (i = 0; i < block_size; ++i)
+        {
+            u_[i] = (float) uvw_[3*i + 0];
+            v_[i] = (float) uvw_[3*i + 1];
+            w_[i] = (float) uvw_[3*i + 2];
+        }
+    }
+
+    /* Convert visibilities and weights to the imager precision. */
+    r->amp_in[slot] = oskar_imager_scratch_convert(r->h, r->data[slot],
+            &r->conv_data[slot], block_size * r->num_channels, status);
+    r->weight_in[slot] = oskar_imager_scratch_convert(r->h, r->weight[slot],
+            &r->conv_weight[slot], block_size * r->num_pols, status);
+    oskar_timer_pause(r->h->tmr_read);
+}
+
+static void update_block_ms(void* arg, int i_block, int slot, int* status)
+{
+    MsReader* r = (MsReader*) arg;
+    const size_t block_size = r->block_size[slot];
+    if (*status) return;
+
+    /* Update the imager with the data. */
+    oskar_imager_update(r->h, block_size, 0, r->num_channels - 1,
+            r->num_pols, r->u[slot], r->v[slot], r->w[slot], r->amp_in[slot],
+            r->weight_in[slot], r->time_centroid[slot], status);
+    oskar_imager_update_progress(r->h,
+            (i_block * r->num_baselines + block_size) / (double)(r->num_rows),
+            r->i_file, r->num_files, r->percent_done, r->percent_next);
+}
+#endif
+
 void oskar_imager_read_data_ms(oskar_Imager* h, const char* filename,
         int i_file, int num_files, int* percent_done, int* percent_next,
         int* status)
 {
 #ifndef OSKAR_NO_MS
-    oskar_MeasurementSet* ms;
-    oskar_Mem *uvw, *u, *v, *w, *data, *weight, *time_centroid;
-    int num_channels, num_pols, num_stations, type;
-    size_t num_baselines, start_row, num_rows;
-    double *uvw_, *u_, *v_, *w_;
+    MsReader r;
+    int i, num_stations, num_blocks, type;
     if (*status) return;
 
     /* Read the header. */
-    ms = oskar_ms_open(filename);
-    if (!ms)
+    memset(&r, 0, sizeof(MsReader));
+    r.ms = oskar_ms_open(filename);
+    if (!r.ms)
     {
         *status = OSKAR_ERR_FILE_IO;
         return;
     }
-    num_rows = (size_t) oskar_ms_num_rows(ms);
-    num_stations = (int) oskar_ms_num_stations(ms);
-    num_baselines = num_stations * (num_stations - 1) / 2;
-    num_pols = (int) oskar_ms_num_pols(ms);
-    num_channels = (int) oskar_ms_num_channels(ms);
+    r.h = h;
+    r.i_file = i_file;
+    r.num_files = num_files;
+    r.percent_done = percent_done;
+    r.percent_next = percent_next;
+    r.num_rows = (size_t) oskar_ms_num_rows(r.ms);
+    num_stations = (int) oskar_ms_num_stations(r.ms);
+    r.num_baselines = num_stations * (num_stations - 1) / 2;
+    r.num_pols = (int) oskar_ms_num_pols(r.ms);
+    r.num_channels = (int) oskar_ms_num_channels(r.ms);
+    num_blocks = r.num_baselines == 0 ? 0 : (int) (
+            (r.num_rows + r.num_baselines - 1) / r.num_baselines);
 
     /* Set visibility meta-data. */
     oskar_imager_set_vis_frequency(h,
-            oskar_ms_freq_start_hz(ms),
-            oskar_ms_freq_inc_hz(ms), num_channels);
+            oskar_ms_freq_start_hz(r.ms),
+            oskar_ms_freq_inc_hz(r.ms), r.num_channels);
     oskar_imager_set_vis_phase_centre(h,
-            oskar_ms_phase_centre_ra_rad(ms) * 180/M_PI,
-            oskar_ms_phase_centre_dec_rad(ms) * 180/M_PI);
-
-    /* Create arrays. */
-    uvw = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 3 * num_baselines, status);
-    u = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_baselines, status);
-    v = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_baselines, status);
-    w = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_baselines, status);
-    weight = oskar_mem_create(OSKAR_SINGLE, OSKAR_CPU,
-            num_baselines * num_pols, status);
-    time_centroid = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_baselines,
-            status);
-    uvw_ = oskar_mem_double(uvw, status);
-    u_ = oskar_mem_double(u, status);
-    v_ = oskar_mem_double(v, status);
-    w_ = oskar_mem_double(w, status);
-    type = OSKAR_SINGLE | OSKAR_COMPLEX;
-    if (num_pols == 4) type |= OSKAR_MATRIX;
-    data = oskar_mem_create(type, OSKAR_CPU,
-            num_baselines * num_channels, status);
+            oskar_ms_phase_centre_ra_rad(r.ms) * 180/M_PI,
+            oskar_ms_phase_centre_dec_rad(r.ms) * 180/M_PI);
 
-    /* Loop over visibility blocks. */
-    for (start_row = 0; start_row < num_rows; start_row += num_baselines)
+    /* Create arrays for each buffer. */
+    type = OSKAR_SINGLE | OSKAR_COMPLEX;
+    if (r.num_pols == 4) type |= OSKAR_MATRIX;
+    for (i = 0; i < NUM_SLOTS; ++i)
     {
-        size_t allocated, required, block_size, i;
-        if (*status) break;
-
-        /* Read rows from Measurement Set. */
-        oskar_timer_resume(h->tmr_read);
-        block_size = num_rows - start_row;
-        if (block_size > num_baselines) block_size = num_baselines;
-        allocated = oskar_mem_length(uvw) *
-                oskar_mem_element_size(oskar_mem_type(uvw));
-        oskar_ms_read_column(ms, "UVW", start_row, block_size,
-                allocated, oskar_mem_void(uvw), &required, status);
-        allocated = oskar_mem_length(weight) *
-                oskar_mem_element_size(oskar_mem_type(weight));
-        oskar_ms_read_column(ms, "WEIGHT", start_row, block_size,
-                allocated, oskar_mem_void(weight), &required, status);
-        allocated = oskar_mem_length(time_centroid) *
-                oskar_mem_element_size(oskar_mem_type(time_centroid));
-        oskar_ms_read_column(ms, "TIME_CENTROID", start_row, block_size,
-                allocated, oskar_mem_void(time_centroid), &required, status);
-        allocated = oskar_mem_length(data) *
-                oskar_mem_element_size(oskar_mem_type(data));
-        oskar_ms_read_column(ms, h->ms_column, start_row, block_size,
-                allocated, oskar_mem_void(data), &required, status);
-        if (*status) break;
-
-        /* Split up baseline coordinates. */
-        for (i = 0; i < block_size; ++i)
-        {
-            u_[i] = uvw_[3*i + 0];
-            v_[i] = uvw_[3*i + 1];
-            w_[i] = uvw_[3*i + 2];
-        }
+        r.uvw[i] = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+                3 * r.num_baselines, status);
+        r.u[i] = oskar_mem_create(h->imager_prec, OSKAR_CPU,
+                r.num_baselines, status);
+        r.v[i] = oskar_mem_create(h->imager_prec, OSKAR_CPU,
+                r.num_baselines, status);
+        r.w[i] = oskar_mem_create(h->imager_prec, OSKAR_CPU,
+                r.num_baselines, status);
+        r.weight[i] = oskar_mem_create(OSKAR_SINGLE, OSKAR_CPU,
+                r.num_baselines * r.num_pols, status);
+        r.time_centroid[i] = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+                r.num_baselines, status);
+        r.data[i] = oskar_mem_create(type, OSKAR_CPU,
+                r.num_baselines * r.num_channels, status);
+    }
 
-        /* Update the imager with the data. */
-        oskar_timer_pause(h->tmr_read);
-        oskar_imager_update(h, block_size, 0, num_channels - 1, num_pols,
-                u, v, w, data, weight, time_centroid, status);
-        *percent_done = (int) round(100.0 * (
-                (start_row + block_size) / (double)(num_rows * num_files) +
-                i_file / (double)num_files));
-        if (h->log && percent_next && *percent_done >= *percent_next)
-        {
-            oskar_log_message(h->log, 'S', -2, "%3d%% ...", *percent_done);
-            *percent_next = 10 + 10 * (*percent_done / 10);
-        }
+    /* Loop over visibility blocks, reading ahead of the imager. */
+    pipeline_run(read_block_ms, update_block_ms, &r, num_blocks, status);
+    for (i = 0; i < NUM_SLOTS; ++i)
+    {
+        oskar_mem_free(r.uvw[i], status);
+        oskar_mem_free(r.u[i], status);
+        oskar_mem_free(r.v[i], status);
+        oskar_mem_free(r.w[i], status);
+        oskar_mem_free(r.data[i], status);
+        oskar_mem_free(r.weight[i], status);
+        oskar_mem_free(r.conv_data[i], status);
+        oskar_mem_free(r.conv_weight[i], status);
+        oskar_mem_free(r.time_centroid[i], status);
     }
-    oskar_mem_free(uvw, status);
-    oskar_mem_free(u, status);
-    oskar_mem_free(v, status);
-    oskar_mem_free(w, status);
-    oskar_mem_free(data, status);
-    oskar_mem_free(weight, status);
-    oskar_mem_free(time_centroid, status);
-    oskar_ms_close(ms);
+    oskar_ms_close(r.ms);
 #else
     (void) filename;
     (void) i_file;
@@ -166,149 +314,170 @@ void oskar_imager_read_data_ms(oskar_Imager* h, const char* filename,
 }
 
 
-void oskar_imager_read_data_vis(oskar_Imager* h, const char* filename,
-        int i_file, int num_files, int* percent_done, int* percent_next,
-        int* status)
+struct VisReader
 {
+    oskar_Imager* h;
     oskar_Binary* vis_file;
-    oskar_VisBlock* block;
     oskar_VisHeader* header;
-    oskar_Mem *weight, *time_centroid, *time_slice, *scratch = 0, *ptr;
-    int max_times_per_block, tags_per_block, i_block, num_blocks;
-    int num_times_tot, num_channels_tot, num_stations, num_baselines, num_pols;
+    oskar_VisBlock* block[NUM_SLOTS];
+    oskar_Mem *time_centroid[NUM_SLOTS], *scratch[NUM_SLOTS], *ptr[NUM_SLOTS];
+    oskar_Mem *conv_uu[NUM_SLOTS], *conv_vv[NUM_SLOTS], *conv_ww[NUM_SLOTS];
+    const oskar_Mem *uu[NUM_SLOTS], *vv[NUM_SLOTS], *ww[NUM_SLOTS];
+    oskar_Mem *weight, *time_slice;
     double time_start_mjd, time_inc_sec;
+    int tags_per_block, num_baselines, num_pols, num_blocks;
+    int i_file, num_files, *percent_done, *percent_next;
+};
+typedef struct VisReader VisReader;
+
+static void read_block_vis(void* arg, int i_block, int slot, int* status)
+{
+    VisReader* r = (VisReader*) arg;
+    oskar_VisBlock* block = r->block[slot];
+    oskar_Mem* ptr;
+    int t, num_times, num_channels, num_baselines, start_time;
+    if (*status) return;
+
+    /* Read the visibility data. */
+    oskar_timer_resume(r->h->tmr_read);
+    oskar_binary_set_query_search_start(r->vis_file,
+            i_block * r->tags_per_block, status);
+    oskar_vis_block_read(block, r->header, r->vis_file, i_block, status);
+    start_time    = oskar_vis_block_start_time_index(block);
+    num_times     = oskar_vis_block_num_times(block);
+    num_channels  = oskar_vis_block_num_channels(block);
+    num_baselines = r->num_baselines;
+
+    /* Fill in the time centroid values. */
+    for (t = 0; t < num_times; ++t)
+    {
+        oskar_mem_set_alias(r->time_slice, r->time_centroid[slot],
+                t * num_baselines, num_baselines, status);
+        oskar_mem_set_value_real(r->time_slice,
+                r->time_start_mjd + (start_time + t + 0.5) * r->time_inc_sec,
+                0, num_baselines, status);
+    }
+
+    /* Swap baseline and channel dimensions, converting to the imager
+     * precision at the same time. */
+    ptr = oskar_vis_block_cross_correlations(block);
+    if (num_channels != 1 || oskar_mem_precision(ptr) != r->h->imager_prec)
+    {
+        oskar_mem_transpose(ptr, r->scratch[slot], num_times, num_channels,
+                num_baselines, status);
+        ptr = r->scratch[slot];
+    }
+    r->ptr[slot] = ptr;
+
+    /* Convert baseline coordinates to the imager precision. */
+    r->uu[slot] = oskar_imager_scratch_convert(r->h,
+            oskar_vis_block_baseline_uu_metres(block), &r->conv_uu[slot],
+            num_times * num_baselines, status);
+    r->vv[slot] = oskar_imager_scratch_convert(r->h,
+            oskar_vis_block_baseline_vv_metres(block), &r->conv_vv[slot],
+            num_times * num_baselines, status);
+    r->ww[slot] = oskar_imager_scratch_convert(r->h,
+            oskar_vis_block_baseline_ww_metres(block), &r->conv_ww[slot],
+            num_times * num_baselines, status);
+    oskar_timer_pause(r->h->tmr_read);
+}
+
+static void update_block_vis(void* arg, int i_block, int slot, int* status)
+{
+    VisReader* r = (VisReader*) arg;
+    oskar_VisBlock* block = r->block[slot];
+    int start_chan, end_chan;
+    size_t num_rows;
+    if (*status) return;
+
+    /* Update the imager with the data. */
+    start_chan = oskar_vis_block_start_channel_index(block);
+    end_chan   = start_chan + oskar_vis_block_num_channels(block) - 1;
+    num_rows   = oskar_vis_block_num_times(block) * r->num_baselines;
+    oskar_imager_update(r->h, num_rows, start_chan, end_chan, r->num_pols,
+            r->uu[slot], r->vv[slot], r->ww[slot],
+            r->ptr[slot], r->weight, r->time_centroid[slot], status);
+    oskar_imager_update_progress(r->h,
+            (i_block + 1) / (double)(r->num_blocks),
+            r->i_file, r->num_files, r->percent_done, r->percent_next);
+}
+
+void oskar_imager_read_data_vis(oskar_Imager* h, const char* filename,
+        int i_file, int num_files, int* percent_done, int* percent_next,
+        int* status)
+{
+    VisReader r;
+    int i, max_times_per_block, num_times_tot, num_channels_tot, num_stations;
     if (*status) return;
 
     /* Read the header. */
-    vis_file = oskar_binary_create(filename, 'r', status);
-    header = oskar_vis_header_read(vis_file, status);
+    memset(&r, 0, sizeof(VisReader));
+    r.vis_file = oskar_binary_create(filename, 'r', status);
+    r.header = oskar_vis_header_read(r.vis_file, status);
     if (*status)
     {
-        oskar_vis_header_free(header, status);
-        oskar_binary_free(vis_file);
+        oskar_vis_header_free(r.header, status);
+        oskar_binary_free(r.vis_file);
         return;
     }
-    max_times_per_block = oskar_vis_header_max_times_per_block(header);
-    tags_per_block = oskar_vis_header_num_tags_per_block(header);
-    num_times_tot = oskar_vis_header_num_times_total(header);
-    num_channels_tot = oskar_vis_header_num_channels_total(header);
-    num_stations = oskar_vis_header_num_stations(header);
-    num_baselines = num_stations * (num_stations - 1) / 2;
-    num_pols = oskar_type_is_matrix(oskar_vis_header_amp_type(header)) ? 4 : 1;
-    num_blocks = (num_times_tot + max_times_per_block - 1) /
+    r.h = h;
+    r.i_file = i_file;
+    r.num_files = num_files;
+    r.percent_done = percent_done;
+    r.percent_next = percent_next;
+    max_times_per_block = oskar_vis_header_max_times_per_block(r.header);
+    r.tags_per_block = oskar_vis_header_num_tags_per_block(r.header);
+    num_times_tot = oskar_vis_header_num_times_total(r.header);
+    num_channels_tot = oskar_vis_header_num_channels_total(r.header);
+    num_stations = oskar_vis_header_num_stations(r.header);
+    r.num_baselines = num_stations * (num_stations - 1) / 2;
+    r.num_pols = oskar_type_is_matrix(
+            oskar_vis_header_amp_type(r.header)) ? 4 : 1;
+    r.num_blocks = (num_times_tot + max_times_per_block - 1) /
             max_times_per_block;
-    time_start_mjd = oskar_vis_header_time_start_mjd_utc(header) * 86400.0;
-    time_inc_sec = oskar_vis_header_time_inc_sec(header);
+    r.time_start_mjd = oskar_vis_header_time_start_mjd_utc(r.header) * 86400.0;
+    r.time_inc_sec = oskar_vis_header_time_inc_sec(r.header);
 
     /* Set visibility meta-data. */
     oskar_imager_set_vis_frequency(h,
-            oskar_vis_header_freq_start_hz(header),
-            oskar_vis_header_freq_inc_hz(header), num_channels_tot);
+            oskar_vis_header_freq_start_hz(r.header),
+            oskar_vis_header_freq_inc_hz(r.header), num_channels_tot);
     oskar_imager_set_vis_phase_centre(h,
-            oskar_vis_header_phase_centre_ra_deg(header),
-            oskar_vis_header_phase_centre_dec_deg(header));
+            oskar_vis_header_phase_centre_ra_deg(r.header),
+            oskar_vis_header_phase_centre_dec_deg(r.header));
 
     /* Create scratch arrays. Weights are all 1. */
-    time_centroid = oskar_mem_create(OSKAR_DOUBLE,
-            OSKAR_CPU, num_baselines * max_times_per_block, status);
-    time_slice = oskar_mem_create_alias(0, 0, 0, status);
-    weight = oskar_mem_create(h->imager_prec,
-            OSKAR_CPU, num_baselines * num_pols * max_times_per_block, status);
-    oskar_mem_set_value_real(weight, 1.0, 0, 0, status);
-    if (num_channels_tot > 1)
-        scratch = oskar_mem_create(oskar_vis_header_amp_type(header), OSKAR_CPU,
-                num_baselines * num_channels_tot * max_times_per_block, status);
-
-    /* Loop over visibility blocks. */
-    block = oskar_vis_block_create_from_header(OSKAR_CPU, header, status);
-    for (i_block = 0; i_block < num_blocks; ++i_block)
+    r.time_slice = oskar_mem_create_alias(0, 0, 0, status);
+    r.weight = oskar_mem_create(h->imager_prec, OSKAR_CPU,
+            r.num_baselines * r.num_pols * max_times_per_block, status);
+    oskar_mem_set_value_real(r.weight, 1.0, 0, 0, status);
+    for (i = 0; i < NUM_SLOTS; ++i)
     {
-        int t, num_times, num_channels, start_time, start_chan, end_chan;
-        size_t num_rows;
-        if (*status) break;
-
-        /* Read the visibility data. */
-        oskar_timer_resume(h->tmr_read);
-        oskar_binary_set_query_search_start(vis_file,
-                i_block * tags_per_block, status);
-        oskar_vis_block_read(block, header, vis_file, i_block, status);
-        start_time   = oskar_vis_block_start_time_index(block);
-        start_chan   = oskar_vis_block_start_channel_index(block);
-        num_times    = oskar_vis_block_num_times(block);
-        num_channels = oskar_vis_block_num_channels(block);
-        num_rows     = num_times * num_baselines;
-        end_chan     = start_chan + num_channels - 1;
-
-        /* Fill in the time centroid values. */
-        for (t = 0; t < num_times; ++t)
-        {
-            oskar_mem_set_alias(time_slice, time_centroid,
-                    t * num_baselines, num_baselines, status);
-            oskar_mem_set_value_real(time_slice,
-                    time_start_mjd + (start_time + t + 0.5) * time_inc_sec,
-                    0, num_baselines, status);
-        }
+        r.block[i] = oskar_vis_block_create_from_header(OSKAR_CPU,
+                r.header, status);
+        r.time_centroid[i] = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+                r.num_baselines * max_times_per_block, status);
+        r.scratch[i] = oskar_mem_create((oskar_vis_header_amp_type(r.header) &
+                ~(OSKAR_SINGLE | OSKAR_DOUBLE)) | h->imager_prec, OSKAR_CPU,
+                r.num_baselines * num_channels_tot * max_times_per_block,
+                status);
+    }
 
-        /* Swap baseline and channel dimensions. */
-        ptr = oskar_vis_block_cross_correlations(block);
-#define SWAP_LOOP \
-        for (t = 0; t < num_times; ++t)                                  \
-            for (c = 0; c < num_channels; ++c)                           \
-                for (b = 0; b < num_baselines; ++b)                      \
-                    for (p = 0; p < num_pols; ++p)                       \
-                    {                                                    \
-                        k = (num_pols * (num_baselines *                 \
-                                (num_channels * t + c) + b) + p) << 1;   \
-                        l = (num_pols * (num_channels *                  \
-                                (num_baselines * t + b) + c) + p) << 1;  \
-                        out[l] = in[k];                                  \
-                        out[l + 1] = in[k + 1];                          \
-                    }
-        if (num_channels != 1)
-        {
-            int b, c, p;
-            size_t k, l;
-            if (oskar_mem_precision(ptr) == OSKAR_SINGLE)
-            {
-                float *in, *out;
-                in  = oskar_mem_float(ptr, status);
-                out = oskar_mem_float(scratch, status);
-                SWAP_LOOP
-            }
-            else
-            {
-                double *in, *out;
-                in  = oskar_mem_double(ptr, status);
-                out = oskar_mem_double(scratch, status);
-                SWAP_LOOP
-            }
-            ptr = scratch;
-        }
-#undef SWAP_LOOP
-
-        /* Update the imager with the data. */
-        oskar_timer_pause(h->tmr_read);
-        oskar_imager_update(h, num_rows, start_chan, end_chan, num_pols,
-                oskar_vis_block_baseline_uu_metres(block),
-                oskar_vis_block_baseline_vv_metres(block),
-                oskar_vis_block_baseline_ww_metres(block),
-                ptr, weight, time_centroid, status);
-        *percent_done = (int) round(100.0 * (
-                (i_block + 1) / (double)(num_blocks * num_files) +
-                i_file / (double)num_files));
-        if (h->log && percent_next && *percent_done >= *percent_next)
-        {
-            oskar_log_message(h->log, 'S', -2, "%3d%% ...", *percent_done);
-            *percent_next = 10 + 10 * (*percent_done / 10);
-        }
+    /* Loop over visibility blocks, reading ahead of the imager. */
+    pipeline_run(read_block_vis, update_block_vis, &r, r.num_blocks, status);
+    for (i = 0; i < NUM_SLOTS; ++i)
+    {
+        oskar_mem_free(r.scratch[i], status);
+        oskar_mem_free(r.conv_uu[i], status);
+        oskar_mem_free(r.conv_vv[i], status);
+        oskar_mem_free(r.conv_ww[i], status);
+        oskar_mem_free(r.time_centroid[i], status);
+        oskar_vis_block_free(r.block[i], status);
     }
-    oskar_mem_free(scratch, status);
-    oskar_mem_free(weight, status);
-    oskar_mem_free(time_centroid, status);
-    oskar_mem_free(time_slice, status);
-    oskar_vis_block_free(block, status);
-    oskar_vis_header_free(header, status);
-    oskar_binary_free(vis_file);
+    oskar_mem_free(r.weight, status);
+    oskar_mem_free(r.time_slice, status);
+    oskar_vis_header_free(r.header, status);
+    oskar_binary_free(r.vis_file);
 }
 
 #ifdef __cplusplus
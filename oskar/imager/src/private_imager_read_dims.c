@@ -37,11 +37,22 @@
 extern "C" {
 #endif
 
+/* Record the largest visibility block, and the memory needed to read it. */
+static void set_block_size(oskar_Imager* h, size_t num_rows,
+        size_t num_channels, size_t bytes)
+{
+    if (num_rows > h->vis_block_rows) h->vis_block_rows = num_rows;
+    if (num_channels > h->vis_block_chans) h->vis_block_chans = num_channels;
+    if (bytes > h->vis_block_bytes) h->vis_block_bytes = bytes;
+}
+
 void oskar_imager_read_dims_ms(oskar_Imager* h, const char* filename,
         int* status)
 {
 #ifndef OSKAR_NO_MS
     oskar_MeasurementSet* ms;
+    int num_stations, num_baselines, type;
+    size_t amp_bytes, num_channels, num_pols, prec_bytes;
     if (*status) return;
 
     /* Read the header. */
@@ -57,6 +68,28 @@ void oskar_imager_read_dims_ms(oskar_Imager* h, const char* filename,
             oskar_ms_freq_start_hz(ms),
             oskar_ms_freq_inc_hz(ms),
             (int) oskar_ms_num_channels(ms));
+    num_stations = (int) oskar_ms_num_stations(ms);
+    num_baselines = num_stations * (num_stations - 1) / 2;
+    if (num_baselines > 0)
+        oskar_imager_set_vis_time(h,
+                oskar_ms_time_start_mjd_utc(ms),
+                oskar_ms_time_inc_sec(ms),
+                (int) oskar_ms_num_rows(ms) / num_baselines);
+
+    /* Each block holds one time sample: the data read in single precision,
+     * a copy converted to the imager precision, coordinates and weights. */
+    num_channels = (size_t) oskar_ms_num_channels(ms);
+    num_pols = (size_t) oskar_ms_num_pols(ms);
+    type = OSKAR_SINGLE | OSKAR_COMPLEX;
+    if (num_pols == 4) type |= OSKAR_MATRIX;
+    amp_bytes = oskar_mem_element_size(type) +
+            oskar_mem_element_size((type & ~OSKAR_SINGLE) | h->imager_prec);
+    prec_bytes = oskar_mem_element_size(h->imager_prec);
+    if (num_baselines > 0)
+        set_block_size(h, (size_t) num_baselines, num_channels,
+                (size_t) num_baselines * (num_channels * amp_bytes +
+                        4 * sizeof(double) + 3 * prec_bytes +
+                        num_pols * (sizeof(float) + prec_bytes)));
     oskar_ms_close(ms);
 #else
     (void) filename;
@@ -71,6 +104,8 @@ void oskar_imager_read_dims_vis(oskar_Imager* h, const char* filename,
 {
     oskar_Binary* vis_file;
     oskar_VisHeader* header;
+    int amp_type, num_stations;
+    size_t amp_bytes, num_rows, num_channels, coord_bytes, prec_bytes;
     if (*status) return;
 
     /* Read the header. */
@@ -88,6 +123,26 @@ void oskar_imager_read_dims_vis(oskar_Imager* h, const char* filename,
             oskar_vis_header_freq_start_hz(header),
             oskar_vis_header_freq_inc_hz(header),
             oskar_vis_header_num_channels_total(header));
+    oskar_imager_set_vis_time(h,
+            oskar_vis_header_time_start_mjd_utc(header),
+            oskar_vis_header_time_inc_sec(header),
+            oskar_vis_header_num_times_total(header));
+
+    /* Each block holds the amplitudes and a copy converted to the
+     * imager precision, and the baseline coordinates. */
+    amp_type = oskar_vis_header_amp_type(header);
+    num_stations = oskar_vis_header_num_stations(header);
+    num_rows = (size_t) oskar_vis_header_max_times_per_block(header) *
+            (size_t) (num_stations * (num_stations - 1) / 2);
+    num_channels = (size_t) oskar_vis_header_num_channels_total(header);
+    amp_bytes = oskar_mem_element_size(amp_type) +
+            oskar_mem_element_size((amp_type &
+                    ~(OSKAR_SINGLE | OSKAR_DOUBLE)) | h->imager_prec);
+    coord_bytes = oskar_mem_element_size(
+            oskar_vis_header_coord_precision(header));
+    prec_bytes = oskar_mem_element_size(h->imager_prec);
+    set_block_size(h, num_rows, num_channels, num_rows * (num_channels *
+            amp_bytes + 3 * coord_bytes + 3 * prec_bytes + sizeof(double)));
     oskar_vis_header_free(header, status);
     oskar_binary_free(vis_file);
 }
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/private_imager_scratch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void grow(oskar_Mem* mem, size_t num, int* status);
+static void free_workspaces(oskar_Imager* h, int* status);
+
+void oskar_imager_scratch_resize(oskar_Imager* h, int num_sets,
+        size_t num_vis, int* status)
+{
+    int i;
+    const int prec = h->imager_prec;
+    if (*status) return;
+
+    /* Create any new sets of scratch arrays. */
+    if (num_sets > h->num_scratch)
+    {
+        h->scratch = (ScratchData*) realloc(h->scratch,
+                num_sets * sizeof(ScratchData));
+        for (i = h->num_scratch; i < num_sets; ++i)
+        {
+            ScratchData* s = &(h->scratch[i]);
+            s->uu_im      = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->vv_im      = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->ww_im      = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->uu_tmp     = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->vv_tmp     = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->ww_tmp     = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->vis_im     = oskar_mem_create(prec | OSKAR_COMPLEX,
+                    OSKAR_CPU, 0, status);
+            s->weight_im  = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->weight_tmp = oskar_mem_create(prec, OSKAR_CPU, 0, status);
+            s->time_im    = oskar_mem_create(OSKAR_DOUBLE,
+                    OSKAR_CPU, 0, status);
+            s->grid       = oskar_mem_create(prec | OSKAR_COMPLEX,
+                    OSKAR_CPU, 0, status);
+            s->grid_work  = oskar_mem_create(OSKAR_CHAR,
+                    OSKAR_CPU, 0, status);
+        }
+        h->num_scratch = num_sets;
+    }
+
+    /* Grow the arrays if required. They are never shrunk here. */
+    for (i = 0; i < num_sets; ++i)
+    {
+        ScratchData* s = &(h->scratch[i]);
+        grow(s->uu_im, num_vis, status);
+        grow(s->vv_im, num_vis, status);
+        grow(s->ww_im, num_vis, status);
+        grow(s->vis_im, num_vis, status);
+        grow(s->weight_im, num_vis, status);
+        if (h->direction_type == 'R')
+        {
+            grow(s->uu_tmp, num_vis, status);
+            grow(s->vv_tmp, num_vis, status);
+            grow(s->ww_tmp, num_vis, status);
+        }
+    }
+}
+
+
+size_t oskar_imager_scratch_ensure(oskar_Mem** mem, int type,
+        size_t num, int* status)
+{
+    size_t old_len;
+    if (*status) return 0;
+    if (*mem && oskar_mem_type(*mem) != type)
+    {
+        oskar_mem_free(*mem, status);
+        *mem = 0;
+    }
+    if (!*mem)
+    {
+        *mem = oskar_mem_create(type, OSKAR_CPU, num, status);
+        return 0;
+    }
+    old_len = oskar_mem_length(*mem);
+    grow(*mem, num, status);
+    return old_len;
+}
+
+
+const oskar_Mem* oskar_imager_scratch_convert(const oskar_Imager* h,
+        const oskar_Mem* in, oskar_Mem** work, size_t num, int* status)
+{
+    size_t i;
+    int type;
+    if (*status || !in) return in;
+    if (oskar_mem_precision(in) == h->imager_prec) return in;
+    if (oskar_mem_location(in) != OSKAR_CPU)
+    {
+        *status = OSKAR_ERR_BAD_LOCATION;
+        return in;
+    }
+
+    /* Keep the complex and matrix flags of the input type. */
+    type = (oskar_mem_type(in) & ~(OSKAR_SINGLE | OSKAR_DOUBLE)) |
+            h->imager_prec;
+    oskar_imager_scratch_ensure(work, type, num, status);
+    if (*status) return in;
+    if (oskar_mem_is_complex(in)) num *= 2;
+    if (oskar_mem_is_matrix(in)) num *= 4;
+    if (h->imager_prec == OSKAR_DOUBLE)
+    {
+        const float* src = oskar_mem_float_const(in, status);
+        double* dst = oskar_mem_double(*work, status);
+        for (i = 0; i < num; ++i) dst[i] = src[i];
+    }
+    else
+    {
+        const double* src = oskar_mem_double_const(in, status);
+        float* dst = oskar_mem_float(*work, status);
+        for (i = 0; i < num; ++i) dst[i] = (float) src[i];
+    }
+    return *work;
+}
+
+
+void oskar_imager_scratch_collapse(oskar_Imager* h, int* status)
+{
+    int i;
+    for (i = 0; i < h->num_scratch; ++i)
+    {
+        ScratchData* s = &(h->scratch[i]);
+        oskar_mem_realloc(s->uu_im, 0, status);
+        oskar_mem_realloc(s->vv_im, 0, status);
+        oskar_mem_realloc(s->ww_im, 0, status);
+        oskar_mem_realloc(s->uu_tmp, 0, status);
+        oskar_mem_realloc(s->vv_tmp, 0, status);
+        oskar_mem_realloc(s->ww_tmp, 0, status);
+        oskar_mem_realloc(s->vis_im, 0, status);
+        oskar_mem_realloc(s->weight_im, 0, status);
+        oskar_mem_realloc(s->weight_tmp, 0, status);
+        oskar_mem_realloc(s->time_im, 0, status);
+        oskar_mem_realloc(s->grid, 0, status);
+        oskar_mem_realloc(s->grid_work, 0, status);
+    }
+    free_workspaces(h, status);
+}
+
+
+void oskar_imager_scratch_free(oskar_Imager* h, int* status)
+{
+    int i;
+    for (i = 0; i < h->num_scratch; ++i)
+    {
+        ScratchData* s = &(h->scratch[i]);
+        oskar_mem_free(s->uu_im, status);
+        oskar_mem_free(s->vv_im, status);
+        oskar_mem_free(s->ww_im, status);
+        oskar_mem_free(s->uu_tmp, status);
+        oskar_mem_free(s->vv_tmp, status);
+        oskar_mem_free(s->ww_tmp, status);
+        oskar_mem_free(s->vis_im, status);
+        oskar_mem_free(s->weight_im, status);
+        oskar_mem_free(s->weight_tmp, status);
+        oskar_mem_free(s->time_im, status);
+        oskar_mem_free(s->grid, status);
+        oskar_mem_free(s->grid_work, status);
+    }
+    free(h->scratch);
+    h->scratch = 0;
+    h->num_scratch = 0;
+    free_workspaces(h, status);
+}
+
+
+static void grow(oskar_Mem* mem, size_t num, int* status)
+{
+    if (oskar_mem_length(mem) < num)
+        oskar_mem_realloc(mem, num, status);
+}
+
+
+static void free_workspaces(oskar_Imager* h, int* status)
+{
+    oskar_mem_free(h->block_vis, status);
+    oskar_mem_free(h->block_weight, status);
+    oskar_mem_free(h->block_time, status);
+    oskar_mem_free(h->conv_uu, status);
+    oskar_mem_free(h->conv_vv, status);
+    oskar_mem_free(h->conv_ww, status);
+    oskar_mem_free(h->conv_amp, status);
+    oskar_mem_free(h->conv_weight, status);
+    h->block_vis = h->block_weight = h->block_time = 0;
+    h->conv_uu = h->conv_vv = h->conv_ww = h->conv_amp = h->conv_weight = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
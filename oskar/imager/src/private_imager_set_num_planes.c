@@ -29,6 +29,8 @@
 #include "imager/private_imager.h"
 #include "imager/private_imager_set_num_planes.h"
 
+#include <math.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -61,7 +63,40 @@ void oskar_imager_set_num_planes(oskar_Imager* h, int* status)
             h->im_freqs[0] += h->sel_freqs[i];
         h->im_freqs[0] /= h->num_sel_freqs;
     }
-    h->num_planes = h->num_im_channels * h->num_im_pols;
+
+    /* Set the time intervals if making time snapshots. */
+    h->num_im_times = 1;
+    h->im_time_start_utc = 0.0;
+    if (h->time_snap_interval_sec > 0.0)
+    {
+        double start = h->vis_time_start_utc, end = h->vis_time_end_utc;
+        double tol = 0.0;
+        if (h->time_min_utc > start)
+        {
+            start = h->time_min_utc;
+            tol += OSKAR_IMAGER_TIME_TOL_SEC;
+        }
+        if (h->time_max_utc > 0.0 && h->time_max_utc < end)
+        {
+            end = h->time_max_utc;
+            tol += OSKAR_IMAGER_TIME_TOL_SEC;
+        }
+        if (end <= start)
+        {
+            oskar_log_error(h->log, "Input visibility time range not set.");
+            *status = OSKAR_ERR_OUT_OF_RANGE;
+            return;
+        }
+
+        /* Ignore any tolerance added to the ends of the time filter range. */
+        h->im_time_start_utc = start;
+        h->num_im_times = (int) ceil(
+                (end - start - tol) / h->time_snap_interval_sec);
+        if (h->num_im_times < 1) h->num_im_times = 1;
+    }
+    h->num_planes = h->num_im_times * h->num_im_channels * h->num_im_pols;
+    h->batch_start = 0;
+    h->batch_end = h->num_planes;
 }
 
 
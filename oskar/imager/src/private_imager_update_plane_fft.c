@@ -30,6 +30,7 @@
 #include "imager/oskar_imager.h"
 
 #include "imager/private_imager_update_plane_fft.h"
+#include "imager/private_imager_scratch.h"
 #include "imager/oskar_grid_simple.h"
 
 #ifdef __cplusplus
@@ -39,7 +40,7 @@ extern "C" {
 void oskar_imager_update_plane_fft(oskar_Imager* h, size_t num_vis,
         const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* amps,
         const oskar_Mem* weight, oskar_Mem* plane, double* plane_norm,
-        size_t* num_skipped, int* status)
+        oskar_Mem** work, size_t* num_skipped, int* status)
 {
     int grid_size;
     size_t num_cells;
@@ -50,6 +51,9 @@ void oskar_imager_update_plane_fft(oskar_Imager* h, size_t num_vis,
         *status = OSKAR_ERR_TYPE_MISMATCH;
     if (oskar_mem_length(plane) < num_cells)
         oskar_mem_realloc(plane, num_cells, status);
+    oskar_imager_scratch_ensure(work, OSKAR_CHAR,
+            oskar_grid_simple_work_size(h->support, num_vis, grid_size,
+                    oskar_mem_element_size(h->imager_prec)), status);
     if (*status) return;
     if (h->imager_prec == OSKAR_DOUBLE)
         oskar_grid_simple_d(h->support, h->oversample,
@@ -58,8 +62,8 @@ void oskar_imager_update_plane_fft(oskar_Imager* h, size_t num_vis,
                 oskar_mem_double_const(vv, status),
                 oskar_mem_double_const(amps, status),
                 oskar_mem_double_const(weight, status),
-                h->cellsize_rad, grid_size, num_skipped, plane_norm,
-                oskar_mem_double(plane, status));
+                h->cellsize_rad, grid_size, oskar_mem_void(*work),
+                num_skipped, plane_norm, oskar_mem_double(plane, status));
     else
         oskar_grid_simple_f(h->support, h->oversample,
                 oskar_mem_float_const(h->conv_func, status), num_vis,
@@ -67,8 +71,8 @@ void oskar_imager_update_plane_fft(oskar_Imager* h, size_t num_vis,
                 oskar_mem_float_const(vv, status),
                 oskar_mem_float_const(amps, status),
                 oskar_mem_float_const(weight, status),
-                (float) (h->cellsize_rad), grid_size, num_skipped, plane_norm,
-                oskar_mem_float(plane, status));
+                (float) (h->cellsize_rad), grid_size, oskar_mem_void(*work),
+                num_skipped, plane_norm, oskar_mem_float(plane, status));
 }
 
 #ifdef __cplusplus
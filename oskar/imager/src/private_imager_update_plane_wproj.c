@@ -30,6 +30,7 @@
 #include "imager/oskar_imager.h"
 
 #include "imager/private_imager_update_plane_wproj.h"
+#include "imager/private_imager_scratch.h"
 #include "imager/oskar_grid_wproj.h"
 
 #include <stdlib.h>
@@ -47,7 +48,8 @@ extern "C" {
 void oskar_imager_update_plane_wproj(oskar_Imager* h, size_t num_vis,
         const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* ww,
         const oskar_Mem* amps, const oskar_Mem* weight, oskar_Mem* plane,
-        double* plane_norm, size_t* num_skipped, int* status)
+        double* plane_norm, oskar_Mem** work, size_t* num_skipped,
+        int* status)
 {
     int grid_size;
     size_t num_cells;
@@ -58,6 +60,11 @@ void oskar_imager_update_plane_wproj(oskar_Imager* h, size_t num_vis,
         *status = OSKAR_ERR_TYPE_MISMATCH;
     if (oskar_mem_length(plane) < num_cells)
         oskar_mem_realloc(plane, num_cells, status);
+    oskar_imager_scratch_ensure(work, OSKAR_CHAR,
+            oskar_grid_wproj_work_size(h->num_w_planes,
+                    oskar_mem_int_const(h->w_support, status), num_vis,
+                    grid_size, oskar_mem_element_size(h->imager_prec)),
+            status);
     if (*status) return;
     if (h->imager_prec == OSKAR_DOUBLE)
         oskar_grid_wproj_d(h->num_w_planes,
@@ -70,7 +77,7 @@ void oskar_imager_update_plane_wproj(oskar_Imager* h, size_t num_vis,
                 oskar_mem_double_const(amps, status),
                 oskar_mem_double_const(weight, status),
                 h->cellsize_rad, h->w_scale,
-                grid_size, num_skipped, plane_norm,
+                grid_size, oskar_mem_void(*work), num_skipped, plane_norm,
                 oskar_mem_double(plane, status));
     else
     {
@@ -116,7 +123,7 @@ void oskar_imager_update_plane_wproj(oskar_Imager* h, size_t num_vis,
                 oskar_mem_float_const(amps, status),
                 oskar_mem_float_const(weight, status),
                 (float) (h->cellsize_rad), (float) (h->w_scale),
-                grid_size, num_skipped, plane_norm,
+                grid_size, oskar_mem_void(*work), num_skipped, plane_norm,
                 oskar_mem_float(plane, status));
 #if SAVE_OUTPUT_DAT
         {
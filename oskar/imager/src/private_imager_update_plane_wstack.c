@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/private_imager_update_plane_wstack.h"
+#include "imager/private_imager_scratch.h"
+#include "imager/oskar_grid_simple.h"
+#include "imager/oskar_grid_tiles.h"
+#include "math/oskar_cmath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Copy visibilities into W-layer order. Visibilities with negative W are
+ * replaced by their complex conjugate at (-u, -v, -w), so that all
+ * W-layers have W >= 0. */
+static void sort_layers_d(const size_t num_vis, const size_t* sorted,
+        const double* uu, const double* vv, const double* amps,
+        const double* weight, const double* ww, double* uu_out, double* vv_out,
+        double* amps_out, double* weight_out)
+{
+    size_t k;
+    for (k = 0; k < num_vis; ++k)
+    {
+        const size_t i = sorted[k];
+        const double f = ww[i] < 0 ? -1 : 1;
+        uu_out[k] = f * uu[i];
+        vv_out[k] = f * vv[i];
+        amps_out[2 * k] = amps[2 * i];
+        amps_out[2 * k + 1] = f * amps[2 * i + 1];
+        weight_out[k] = weight[i];
+    }
+}
+
+static void sort_layers_f(const size_t num_vis, const size_t* sorted,
+        const float* uu, const float* vv, const float* amps,
+        const float* weight, const float* ww, float* uu_out, float* vv_out,
+        float* amps_out, float* weight_out)
+{
+    size_t k;
+    for (k = 0; k < num_vis; ++k)
+    {
+        const size_t i = sorted[k];
+        const float f = ww[i] < 0 ? -1 : 1;
+        uu_out[k] = f * uu[i];
+        vv_out[k] = f * vv[i];
+        amps_out[2 * k] = amps[2 * i];
+        amps_out[2 * k + 1] = f * amps[2 * i + 1];
+        weight_out[k] = weight[i];
+    }
+}
+
+/* Round up to a whole number of doubles, so the next array is aligned. */
+static size_t aligned(size_t bytes)
+{
+    return sizeof(double) * ((bytes + sizeof(double) - 1) / sizeof(double));
+}
+
+void oskar_imager_update_plane_wstack(oskar_Imager* h, size_t num_vis,
+        const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* ww,
+        const oskar_Mem* amps, const oskar_Mem* weight, oskar_Mem* plane,
+        double* plane_norm, oskar_Mem** work, size_t* num_skipped,
+        int* status)
+{
+    int grid_size, i, num_layers;
+    int* layer_index;
+    char *p, *grid_work;
+    size_t j, num_cells, element_size, sort_bytes, *layer_start, *sorted;
+    void *uu_s, *vv_s, *amps_s, *weight_s;
+    if (*status) return;
+    grid_size = oskar_imager_plane_size(h);
+    num_cells = (size_t)grid_size * grid_size;
+    num_layers = h->num_w_planes;
+    if (num_layers < 1) num_layers = 1;
+    if (oskar_mem_precision(plane) != h->imager_prec)
+        *status = OSKAR_ERR_TYPE_MISMATCH;
+    if (oskar_mem_length(plane) < num_cells * num_layers)
+        oskar_mem_realloc(plane, num_cells * num_layers, status);
+
+    /* Get the arrays used to sort visibilities by W-layer from the work
+     * buffer, followed by the work buffer for the gridder. */
+    element_size = oskar_mem_element_size(h->imager_prec);
+    sort_bytes = aligned((num_layers + 1) * sizeof(size_t)) +
+            aligned((num_vis + 1) * sizeof(size_t)) +
+            aligned(num_vis * sizeof(int)) +
+            5 * aligned(num_vis * element_size);
+    oskar_imager_scratch_ensure(work, OSKAR_CHAR, sort_bytes +
+            oskar_grid_simple_work_size(h->support, num_vis, grid_size,
+                    element_size), status);
+    if (*status) return;
+    p = oskar_mem_char(*work);
+    layer_start = (size_t*) p;
+    p += aligned((num_layers + 1) * sizeof(size_t));
+    sorted = (size_t*) p;
+    p += aligned((num_vis + 1) * sizeof(size_t));
+    layer_index = (int*) p;
+    p += aligned(num_vis * sizeof(int));
+    uu_s = p;
+    p += aligned(num_vis * element_size);
+    vv_s = p;
+    p += aligned(num_vis * element_size);
+    weight_s = p;
+    p += aligned(num_vis * element_size);
+    amps_s = p;
+    grid_work = oskar_mem_char(*work) + sort_bytes;
+
+    /* Find the nearest W-layer for each visibility. */
+    if (h->imager_prec == OSKAR_DOUBLE)
+    {
+        const double* w = oskar_mem_double_const(ww, status);
+        for (j = 0; j < num_vis; ++j)
+            layer_index[j] = (int)round(fabs(w[j]) * h->w_scale);
+    }
+    else
+    {
+        const float* w = oskar_mem_float_const(ww, status);
+        for (j = 0; j < num_vis; ++j)
+            layer_index[j] = (int)round(fabs(w[j]) * h->w_scale);
+    }
+    for (j = 0; j < num_vis; ++j)
+        if (layer_index[j] >= num_layers) layer_index[j] = num_layers - 1;
+
+    /* Sort visibilities by W-layer. */
+    (void) oskar_grid_tiles_sort(num_vis, layer_index, num_layers,
+            layer_start, sorted);
+    if (h->imager_prec == OSKAR_DOUBLE)
+        sort_layers_d(num_vis, sorted,
+                oskar_mem_double_const(uu, status),
+                oskar_mem_double_const(vv, status),
+                oskar_mem_double_const(amps, status),
+                oskar_mem_double_const(weight, status),
+                oskar_mem_double_const(ww, status), (double*) uu_s,
+                (double*) vv_s, (double*) amps_s, (double*) weight_s);
+    else
+        sort_layers_f(num_vis, sorted,
+                oskar_mem_float_const(uu, status),
+                oskar_mem_float_const(vv, status),
+                oskar_mem_float_const(amps, status),
+                oskar_mem_float_const(weight, status),
+                oskar_mem_float_const(ww, status), (float*) uu_s,
+                (float*) vv_s, (float*) amps_s, (float*) weight_s);
+
+    /* Grid each W-layer in turn using the standard gridder.
+     * The plane holds a UV grid for each layer, which are transformed
+     * to the image plane and summed with their W-terms in finalise. */
+    *num_skipped = 0;
+    for (i = 0; i < num_layers && !*status; ++i)
+    {
+        size_t skipped = 0;
+        const size_t start = layer_start[i];
+        const size_t num = layer_start[i + 1] - start;
+        if (num == 0) continue;
+        if (h->imager_prec == OSKAR_DOUBLE)
+            oskar_grid_simple_d(h->support, h->oversample,
+                    oskar_mem_double_const(h->conv_func, status), num,
+                    (const double*) uu_s + start,
+                    (const double*) vv_s + start,
+                    (const double*) amps_s + 2 * start,
+                    (const double*) weight_s + start,
+                    h->cellsize_rad, grid_size, grid_work, &skipped,
+                    plane_norm,
+                    oskar_mem_double(plane, status) + 2 * i * num_cells);
+        else
+            oskar_grid_simple_f(h->support, h->oversample,
+                    oskar_mem_float_const(h->conv_func, status), num,
+                    (const float*) uu_s + start,
+                    (const float*) vv_s + start,
+                    (const float*) amps_s + 2 * start,
+                    (const float*) weight_s + start,
+                    (float) (h->cellsize_rad), grid_size, grid_work,
+                    &skipped, plane_norm,
+                    oskar_mem_float(plane, status) + 2 * i * num_cells);
+        *num_skipped += skipped;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
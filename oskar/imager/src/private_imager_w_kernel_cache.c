@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imager/private_imager.h"
+#include "imager/oskar_imager.h"
+
+#include "imager/private_imager_w_kernel_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(OSKAR_OS_WIN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CACHE_MAGIC "OSKARWK3"
+
+/* The file header contains the parameters that determine the W-kernels
+ * (the key), followed by the kernel dimensions. All fields are stored
+ * little-endian. The support sizes come next, as 32-bit little-endian
+ * integers, padded so that the kernel data that follows them is aligned
+ * to 16 bytes. The kernel data are stored in host byte order, so the
+ * host byte order is part of the key. */
+#define KEY_SIZE 60
+#define HEADER_SIZE 64
+
+typedef struct
+{
+    double fov_deg, w_scale;
+    int kernel_type, precision, num_w_planes, oversample, image_size;
+    int plane_size, conv_size, taper_support, big_endian;
+} CacheKey;
+
+static int host_is_big_endian(void)
+{
+    const int one = 1;
+    return *((const char*) &one) == 0;
+}
+
+static void put_int(unsigned char* p, int value)
+{
+    const unsigned int v = (unsigned int) value;
+    p[0] = (unsigned char) (v & 0xFF);
+    p[1] = (unsigned char) ((v >> 8) & 0xFF);
+    p[2] = (unsigned char) ((v >> 16) & 0xFF);
+    p[3] = (unsigned char) ((v >> 24) & 0xFF);
+}
+
+static int get_int(const unsigned char* p)
+{
+    const unsigned int v = ((unsigned int) p[0]) |
+            ((unsigned int) p[1] << 8) | ((unsigned int) p[2] << 16) |
+            ((unsigned int) p[3] << 24);
+    return (int) v;
+}
+
+static void put_double(unsigned char* p, double value)
+{
+    int i;
+    unsigned char b[8];
+    memcpy(b, &value, sizeof(b));
+    for (i = 0; i < 8; ++i)
+        p[i] = host_is_big_endian() ? b[7 - i] : b[i];
+}
+
+static void pack_key(const CacheKey* key, unsigned char* p)
+{
+    memcpy(p, CACHE_MAGIC, 8);
+    put_double(p + 8, key->fov_deg);
+    put_double(p + 16, key->w_scale);
+    put_int(p + 24, key->kernel_type);
+    put_int(p + 28, key->precision);
+    put_int(p + 32, key->num_w_planes);
+    put_int(p + 36, key->oversample);
+    put_int(p + 40, key->image_size);
+    put_int(p + 44, key->plane_size);
+    put_int(p + 48, key->conv_size);
+    put_int(p + 52, key->taper_support);
+    put_int(p + 56, key->big_endian);
+}
+
+static size_t data_offset(int num_w_planes)
+{
+    size_t bytes = HEADER_SIZE + num_w_planes * 4;
+    return 16 * ((bytes + 15) / 16);
+}
+
+static void fill_key(oskar_Imager* h, int conv_size, CacheKey* key)
+{
+    key->fov_deg = h->fov_deg;
+    key->w_scale = h->w_scale;
+    key->kernel_type = h->kernel_type;
+    key->precision = h->imager_prec;
+    key->num_w_planes = h->num_w_planes;
+    key->oversample = h->oversample;
+    key->image_size = h->image_size;
+    key->plane_size = oskar_imager_plane_size(h);
+    key->conv_size = conv_size;
+    key->taper_support = (h->kernel_type == 'E') ? h->support : 0;
+    key->big_endian = host_is_big_endian();
+}
+
+/* Returns the cache file name for the packed key, which must be freed by
+ * the caller. The name contains a 32-bit FNV-1a hash of the key. */
+static char* cache_filename(const char* dir, const unsigned char* key)
+{
+    size_t i;
+    char* fname;
+    unsigned int hash = 2166136261u;
+    for (i = 0; i < KEY_SIZE; ++i)
+    {
+        hash ^= key[i];
+        hash *= 16777619u;
+        hash &= 0xFFFFFFFFu;
+    }
+    fname = (char*) calloc(strlen(dir) + 40, 1);
+    sprintf(fname, "%s/oskar_w_kernels_%08x.bin", dir, hash);
+    return fname;
+}
+
+
+int oskar_imager_w_kernel_cache_load(oskar_Imager* h, int conv_size,
+        int* status)
+{
+    CacheKey key;
+    unsigned char key_data[KEY_SIZE], header[HEADER_SIZE];
+    unsigned char* support_data;
+    FILE* f;
+    char* fname;
+    size_t num_kernel_elements, offset, kernel_bytes, file_size;
+    size_t support_bytes;
+    int i, type, conv_size_half, loaded = 0;
+    if (*status || !h->w_kernel_cache_dir) return 0;
+
+    /* Open the file and check the header matches. */
+    fill_key(h, conv_size, &key);
+    pack_key(&key, key_data);
+    fname = cache_filename(h->w_kernel_cache_dir, key_data);
+    f = fopen(fname, "rb");
+    if (!f)
+    {
+        free(fname);
+        return 0;
+    }
+    conv_size_half = 0;
+    if (fread(header, 1, HEADER_SIZE, f) == HEADER_SIZE &&
+            memcmp(header, key_data, KEY_SIZE) == 0)
+        conv_size_half = get_int(header + KEY_SIZE);
+    if (conv_size_half < 1)
+    {
+        fclose(f);
+        free(fname);
+        return 0;
+    }
+    type = h->imager_prec | OSKAR_COMPLEX;
+    num_kernel_elements = ((size_t) h->num_w_planes) *
+            ((size_t) conv_size_half) * ((size_t) conv_size_half);
+    offset = data_offset(h->num_w_planes);
+    kernel_bytes = num_kernel_elements * oskar_mem_element_size(type);
+    support_bytes = 4 * (size_t) h->num_w_planes;
+    support_data = (unsigned char*) malloc(support_bytes);
+    fseek(f, 0, SEEK_END);
+    file_size = (size_t) ftell(f);
+    if (!support_data || file_size != offset + kernel_bytes ||
+            fseek(f, HEADER_SIZE, SEEK_SET) != 0 ||
+            fread(support_data, 1, support_bytes, f) != support_bytes)
+    {
+        free(support_data);
+        fclose(f);
+        free(fname);
+        return 0;
+    }
+    {
+        int* support = oskar_mem_int(h->w_support, status);
+        for (i = 0; i < h->num_w_planes; ++i)
+            support[i] = get_int(support_data + 4 * i);
+    }
+    free(support_data);
+
+    /* Map the kernels into memory if possible, or read them otherwise. */
+    oskar_mem_free(h->w_kernels, status);
+    h->w_kernels = 0;
+#if !defined(OSKAR_OS_WIN)
+    {
+        int fd = open(fname, O_RDONLY);
+        if (fd >= 0)
+        {
+            void* map = mmap(0, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (map != MAP_FAILED)
+            {
+                h->w_kernel_map = map;
+                h->w_kernel_map_size = file_size;
+                h->w_kernels = oskar_mem_create_alias_from_raw(
+                        (char*) map + offset,
+                        type, OSKAR_CPU, num_kernel_elements, status);
+                loaded = 1;
+            }
+        }
+    }
+#endif
+    if (!loaded)
+    {
+        h->w_kernels = oskar_mem_create(type, OSKAR_CPU,
+                num_kernel_elements, status);
+        fseek(f, (long) offset, SEEK_SET);
+        loaded = !*status && (fread(oskar_mem_void(h->w_kernels),
+                1, kernel_bytes, f) == kernel_bytes);
+        if (!loaded)
+        {
+            oskar_mem_free(h->w_kernels, status);
+            h->w_kernels = 0;
+        }
+    }
+    fclose(f);
+    free(fname);
+    if (loaded) h->conv_size_half = conv_size_half;
+    return loaded;
+}
+
+
+void oskar_imager_w_kernel_cache_save(oskar_Imager* h, int conv_size)
+{
+    CacheKey key;
+    unsigned char header[HEADER_SIZE], *support_data;
+    FILE* f;
+    char *fname, *fname_tmp;
+    size_t support_bytes, kernel_bytes;
+    const int* support;
+    int i, ok, status = 0;
+    if (!h->w_kernel_cache_dir || !h->w_kernels || !h->w_support) return;
+
+    /* Write to a temporary file first, and then rename it, so that
+     * other processes never see a partial file. The temporary name
+     * contains the process ID, so that concurrent writers do not
+     * clobber each other. */
+    fill_key(h, conv_size, &key);
+    pack_key(&key, header);
+    put_int(header + KEY_SIZE, h->conv_size_half);
+    fname = cache_filename(h->w_kernel_cache_dir, header);
+    fname_tmp = (char*) calloc(strlen(fname) + 20, 1);
+    sprintf(fname_tmp, "%s.%d.tmp", fname, (int) getpid());
+
+    /* Pack the support sizes, and zero the padding after them. */
+    support_bytes = data_offset(h->num_w_planes) - HEADER_SIZE;
+    support_data = (unsigned char*) calloc(support_bytes, 1);
+    support = oskar_mem_int_const(h->w_support, &status);
+    f = support_data ? fopen(fname_tmp, "wb") : 0;
+    if (!f)
+    {
+        if (h->log)
+            oskar_log_warning(h->log, "Unable to write W-kernel cache "
+                    "file '%s'.", fname);
+        free(support_data);
+        free(fname);
+        free(fname_tmp);
+        return;
+    }
+    for (i = 0; i < h->num_w_planes; ++i)
+        put_int(support_data + 4 * i, support[i]);
+    kernel_bytes = oskar_mem_length(h->w_kernels) *
+            oskar_mem_element_size(oskar_mem_type(h->w_kernels));
+    ok = fwrite(header, 1, HEADER_SIZE, f) == HEADER_SIZE;
+    ok = ok && fwrite(support_data, 1, support_bytes, f) == support_bytes;
+    ok = ok && fwrite(oskar_mem_void_const(h->w_kernels), 1,
+            kernel_bytes, f) == kernel_bytes;
+    ok = (fclose(f) == 0) && ok;
+    if (ok)
+    {
+        remove(fname);
+        ok = (rename(fname_tmp, fname) == 0);
+    }
+    if (!ok)
+    {
+        remove(fname_tmp);
+        if (h->log)
+            oskar_log_warning(h->log, "Unable to write W-kernel cache "
+                    "file '%s'.", fname);
+    }
+    free(support_data);
+    free(fname);
+    free(fname_tmp);
+}
+
+
+void oskar_imager_w_kernel_cache_release(oskar_Imager* h)
+{
+#if !defined(OSKAR_OS_WIN)
+    if (h->w_kernel_map)
+        munmap(h->w_kernel_map, h->w_kernel_map_size);
+#endif
+    h->w_kernel_map = 0;
+    h->w_kernel_map_size = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
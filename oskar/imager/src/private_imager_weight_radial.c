@@ -39,7 +39,8 @@ void oskar_imager_weight_radial(size_t num_points, const oskar_Mem* uu,
 {
     size_t i;
     if (*status) return;
-    oskar_mem_realloc(weight_out, num_points, status);
+    if (oskar_mem_length(weight_out) < num_points)
+        oskar_mem_realloc(weight_out, num_points, status);
     if (oskar_mem_precision(weight_out) == OSKAR_DOUBLE)
     {
         double *wt_out;
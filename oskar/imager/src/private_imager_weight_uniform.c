@@ -49,7 +49,8 @@ void oskar_imager_weight_uniform(size_t num_points, const oskar_Mem* uu,
     }
 
     /* Size the output array. */
-    oskar_mem_realloc(weight_out, num_points, status);
+    if (oskar_mem_length(weight_out) < num_points)
+        oskar_mem_realloc(weight_out, num_points, status);
     if (*status) return;
 
     /* Calculate new weights from the grid. */
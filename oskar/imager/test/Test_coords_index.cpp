@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "ms/oskar_measurement_set.h"
+#include "utility/oskar_dir.h"
+#include "vis/oskar_vis_block.h"
+#include "vis/oskar_vis_header.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef OSKAR_OS_WIN
+#include <utime.h>
+#else
+#include <sys/utime.h>
+#endif
+
+static void write_ms(const char* filename, double uv_scale, int* status)
+{
+    const int num_stations = 10, num_channels = 2, num_times = 4;
+    oskar_VisHeader* hdr = oskar_vis_header_create(
+            OSKAR_DOUBLE_COMPLEX_MATRIX, OSKAR_DOUBLE, num_times, num_times,
+            num_channels, num_channels, num_stations, 0, 1, status);
+    oskar_vis_header_set_freq_start_hz(hdr, 100e6);
+    oskar_vis_header_set_freq_inc_hz(hdr, 1e6);
+    oskar_vis_header_set_time_start_mjd_utc(hdr, 51544.5);
+    oskar_vis_header_set_time_inc_sec(hdr, 10.0);
+    oskar_vis_header_set_phase_centre(hdr, 0, 20.0, -30.0);
+    oskar_VisBlock* blk = oskar_vis_block_create_from_header(OSKAR_CPU,
+            hdr, status);
+    oskar_vis_block_set_num_times(blk, num_times, status);
+    oskar_mem_random_gaussian(oskar_vis_block_baseline_uu_metres(blk),
+            0, 1, 2, 3, uv_scale, status);
+    oskar_mem_random_gaussian(oskar_vis_block_baseline_vv_metres(blk),
+            0, 4, 5, 6, uv_scale, status);
+    oskar_mem_random_gaussian(oskar_vis_block_baseline_ww_metres(blk),
+            0, 7, 8, 9, 0.1 * uv_scale, status);
+    oskar_mem_random_gaussian(oskar_vis_block_cross_correlations(blk),
+            0, 10, 11, 12, 1.0, status);
+    oskar_MeasurementSet* ms = oskar_vis_header_write_ms(hdr, filename,
+            OSKAR_TRUE, OSKAR_FALSE, status);
+    oskar_vis_block_write_ms(blk, hdr, ms, status);
+    oskar_ms_close(ms);
+    oskar_vis_block_free(blk, status);
+    oskar_vis_header_free(hdr, status);
+}
+
+static void set_mtime(const char* path, time_t t)
+{
+    struct utimbuf times;
+    times.actime = times.modtime = t;
+    utime(path, &times);
+}
+
+static void set_ms_mtime(const char* filename, time_t t)
+{
+    int num_items = 0;
+    char** items = 0;
+    oskar_dir_items(filename, 0, 1, 0, &num_items, &items);
+    for (int i = 0; i < num_items; ++i)
+    {
+        char* path = oskar_dir_get_path(filename, items[i]);
+        set_mtime(path, t);
+        free(path);
+        free(items[i]);
+    }
+    free(items);
+}
+
+static time_t get_mtime(const char* path)
+{
+    struct stat s;
+    return stat(path, &s) ? 0 : s.st_mtime;
+}
+
+static oskar_Mem* make_image(const char* filename, int use_index,
+        int* status)
+{
+    oskar_Mem* image = 0;
+    oskar_Imager* im = oskar_imager_create(OSKAR_DOUBLE, status);
+    oskar_imager_set_fov(im, 2.0);
+    oskar_imager_set_size(im, 128, status);
+    oskar_imager_set_weighting(im, "Uniform", status);
+    oskar_imager_set_fft_on_gpu(im, 0);
+    oskar_imager_set_coords_index(im, use_index);
+    oskar_imager_set_input_files(im, 1, &filename, status);
+    oskar_imager_run(im, 1, &image, 0, 0, status);
+    oskar_imager_free(im, status);
+    return image;
+}
+
+TEST(imager, coords_index)
+{
+    int status = 0, num_tmp = 0;
+    char** tmp = 0;
+    const char* ms = "temp_test_imager_coords_index.ms";
+    const char* index = "temp_test_imager_coords_index.ms.coords";
+    const time_t now = time(0);
+    oskar_Mem *ref, *image;
+    remove(index);
+
+    // Write the index. Use an old modification time for the Measurement
+    // Set, as an index written in the same second is not trusted.
+    write_ms(ms, 100.0, &status);
+    set_ms_mtime(ms, now - 100);
+    ref = make_image(ms, 0, &status);
+    image = make_image(ms, 1, &status);
+    ASSERT_EQ(0, status);
+    ASSERT_NE(0, (int) get_mtime(index));
+    EXPECT_FALSE(oskar_mem_different(ref, image, 0, &status));
+    oskar_mem_free(image, &status);
+
+    // Check no temporary files are left behind.
+    oskar_dir_items(".", "temp_test_imager_coords_index.ms.coords.*",
+            1, 0, &num_tmp, &tmp);
+    EXPECT_EQ(0, num_tmp);
+    for (int i = 0; i < num_tmp; ++i) free(tmp[i]);
+    free(tmp);
+
+    // Check the index is used again, and not rewritten.
+    set_mtime(index, now - 50);
+    image = make_image(ms, 1, &status);
+    ASSERT_EQ(0, status);
+    EXPECT_EQ(now - 50, get_mtime(index));
+    EXPECT_FALSE(oskar_mem_different(ref, image, 0, &status));
+    oskar_mem_free(image, &status);
+    oskar_mem_free(ref, &status);
+
+    // Change the Measurement Set, and check the index is rewritten.
+    write_ms(ms, 150.0, &status);
+    set_ms_mtime(ms, now - 40);
+    ref = make_image(ms, 0, &status);
+    image = make_image(ms, 1, &status);
+    ASSERT_EQ(0, status);
+    EXPECT_NE(now - 50, get_mtime(index));
+    EXPECT_FALSE(oskar_mem_different(ref, image, 0, &status));
+
+    // Clean up.
+    oskar_mem_free(ref, &status);
+    oskar_mem_free(image, &status);
+    oskar_dir_remove(ms);
+    remove(index);
+}
@@ -162,5 +162,9 @@ TEST(fits_write, test_planes)
     // Close the FITS file.
     fits_close_file(f, &status);
     oskar_mem_free(data, &status);
+    ASSERT_EQ(0, status);
+
+    // Remove the temporary file.
+    remove(filename);
 }
 
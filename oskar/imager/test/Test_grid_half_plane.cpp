@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "math/oskar_cmath.h"
+
+TEST(imager, grid_half_plane)
+{
+    int status = 0, size = 256, num_vis = 4000;
+    const int type = OSKAR_DOUBLE;
+    const char* algorithms[] = {"FFT", "W-projection", "IDG"};
+
+    // IDG moves folded visibilities to different subgrids, so only agrees
+    // to within the accuracy of its subgrid approximations.
+    const double tolerance[] = {1e-9, 1e-9, 1e-2};
+
+    // Create visibility data for all four linear polarisations.
+    oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU,
+            4 * num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, 4 * num_vis,
+            &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 500.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 500.0, &status);
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 50.0, &status);
+    oskar_mem_random_gaussian(vis, 12, 13, 14, 15, 1.0, &status);
+    oskar_mem_random_uniform(weight, 16, 17, 18, 19, &status);
+    ASSERT_EQ(0, status);
+
+    // Check images made using half the UV plane match the full plane.
+    for (int a = 0; a < 3; ++a)
+    {
+        oskar_Mem* images[2][4];
+        for (int i = 0; i < 2; ++i)
+        {
+            oskar_Imager* im = oskar_imager_create(type, &status);
+            oskar_imager_set_algorithm(im, algorithms[a], &status);
+            oskar_imager_set_image_type(im, "Linear", &status);
+            oskar_imager_set_weighting(im, "Radial", &status);
+            oskar_imager_set_fov(im, 2.0);
+            oskar_imager_set_size(im, size, &status);
+            oskar_imager_set_fft_on_gpu(im, 0);
+            oskar_imager_set_generate_w_kernels_on_gpu(im, 0);
+            oskar_imager_set_grid_half_plane(im, i);
+            oskar_imager_set_vis_frequency(im, 100e6, 0.0, 1);
+            oskar_Mem* grids[4];
+            for (int p = 0; p < 4; ++p) images[i][p] = grids[p] = 0;
+            oskar_imager_update(im, num_vis, 0, 0, 4, uu, vv, ww, vis,
+                    weight, 0, &status);
+            oskar_imager_finalise(im, 4, images[i], 4, grids, &status);
+            ASSERT_EQ(0, status) << algorithms[a];
+
+            // Check the half plane holds only the rows with V >= 0.
+            const size_t plane_size = oskar_imager_plane_size(im);
+            for (int p = 0; p < 4; ++p)
+            {
+                EXPECT_EQ(plane_size * (i ? plane_size / 2 + 1 : plane_size),
+                        oskar_mem_length(grids[p])) << algorithms[a];
+                oskar_mem_free(grids[p], &status);
+            }
+            oskar_imager_free(im, &status);
+        }
+        for (int p = 0; p < 4; ++p)
+        {
+            const size_t num_pixels = size * size;
+            const double* x = oskar_mem_double_const(images[0][p], &status);
+            const double* y = oskar_mem_double_const(images[1][p], &status);
+            double max_abs = 0.0, max_diff = 0.0;
+            for (size_t j = 0; j < num_pixels; ++j)
+            {
+                if (fabs(x[j]) > max_abs) max_abs = fabs(x[j]);
+                if (fabs(x[j] - y[j]) > max_diff) max_diff = fabs(x[j] - y[j]);
+            }
+            EXPECT_LT(max_diff, tolerance[a] * max_abs) << algorithms[a] <<
+                    ", polarisation " << p;
+            oskar_mem_free(images[0][p], &status);
+            oskar_mem_free(images[1][p], &status);
+        }
+    }
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+}
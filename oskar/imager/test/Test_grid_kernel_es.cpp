@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "math/oskar_cmath.h"
+
+TEST(imager, grid_kernel_es)
+{
+    int status = 0, size = 128, num_vis = 2000;
+    const int type = OSKAR_DOUBLE;
+
+    // Create visibility data for point sources near the phase centre.
+    oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU,
+            num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 400.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 400.0, &status);
+    oskar_mem_clear_contents(ww, &status);
+    oskar_mem_set_value_real(weight, 1.0, 0, num_vis, &status);
+    ASSERT_EQ(0, status);
+    const double* u_ = oskar_mem_double_const(uu, &status);
+    const double* v_ = oskar_mem_double_const(vv, &status);
+    double2* vis_ = oskar_mem_double2(vis, &status);
+    const double src[][2] = {{0.003, -0.01}, {-0.012, 0.007}, {0.0, 0.0}};
+    for (int i = 0; i < num_vis; ++i)
+    {
+        vis_[i].x = vis_[i].y = 0.0;
+        for (int s = 0; s < 3; ++s)
+        {
+            double phase = -2.0 * M_PI * (u_[i] * src[s][0] +
+                    v_[i] * src[s][1]);
+            vis_[i].x += cos(phase);
+            vis_[i].y += sin(phase);
+        }
+    }
+
+    // Make images using a 2D DFT, the spheroidal kernel, and the
+    // exponential of semicircle kernel with a smaller support size,
+    // and with the support size chosen from the required accuracy.
+    const int num_images = 4;
+    const char* kernel[] = {0, "Spheroidal", "ES", "ES"};
+    const int support[] = {0, 3, 2, 0};
+    const double accuracy[] = {0.0, 0.0, 0.0, 1e-5};
+    oskar_Mem* images[num_images];
+    for (int i = 0; i < num_images; ++i)
+    {
+        oskar_Imager* im = oskar_imager_create(type, &status);
+        oskar_imager_set_algorithm(im, kernel[i] ? "FFT" : "DFT 2D",
+                &status);
+        if (kernel[i])
+            oskar_imager_set_grid_kernel(im, kernel[i], support[i], 10000,
+                    &status);
+        oskar_imager_set_grid_kernel_accuracy(im, accuracy[i]);
+        oskar_imager_set_fov(im, 2.0);
+        oskar_imager_set_size(im, size, &status);
+        oskar_imager_set_fft_on_gpu(im, 0);
+        oskar_imager_set_vis_frequency(im, 100e6, 0.0, 1);
+        images[i] = 0;
+        oskar_imager_update(im, num_vis, 0, 0, 1, uu, vv, ww, vis,
+                weight, 0, &status);
+        oskar_imager_finalise(im, 1, &images[i], 0, 0, &status);
+        oskar_imager_free(im, &status);
+        ASSERT_EQ(0, status);
+    }
+
+    // Find the errors in the inner part of the field.
+    double max_diff[num_images], peak = 0.0;
+    const double* dft = oskar_mem_double_const(images[0], &status);
+    for (int j = 0; j < size * size; ++j)
+        if (fabs(dft[j]) > peak) peak = fabs(dft[j]);
+    for (int i = 1; i < num_images; ++i)
+    {
+        const double* img = oskar_mem_double_const(images[i], &status);
+        max_diff[i] = 0.0;
+        for (int y = size / 4; y < 3 * size / 4; ++y)
+        {
+            for (int x = size / 4; x < 3 * size / 4; ++x)
+            {
+                double diff = fabs(dft[y * size + x] - img[y * size + x]);
+                if (diff > max_diff[i]) max_diff[i] = diff;
+            }
+        }
+        max_diff[i] /= peak;
+    }
+
+    // Check the exponential of semicircle kernel with a support size of 2
+    // is about as accurate as the spheroidal kernel with a support size
+    // of 3, and that the requested accuracy is met.
+    EXPECT_LT(max_diff[1], 1e-3);
+    EXPECT_LT(max_diff[2], 1.5 * max_diff[1]);
+    EXPECT_LT(max_diff[3], 1e-5);
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+    for (int i = 0; i < num_images; ++i)
+        oskar_mem_free(images[i], &status);
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_grid_simple.h"
+#include "imager/oskar_grid_wproj.h"
+#include "imager/oskar_grid_functions_spheroidal.h"
+#include "math/oskar_cmath.h"
+#include "mem/oskar_mem.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <cstdlib>
+#include <vector>
+
+// Reference W-projection gridder, without tiles.
+static void grid_wproj_reference(int num_w_planes, const int* support,
+        int oversample, int conv_size_half, const double* conv_func,
+        int num_points, const double* uu, const double* vv,
+        const double* ww, const double* vis, const double* weight,
+        double cell_size_rad, double w_scale, int grid_size,
+        size_t* num_skipped, double* norm, double* grid)
+{
+    const int grid_centre = grid_size / 2;
+    const double grid_scale = grid_size * cell_size_rad;
+    for (int i = 0; i < num_points; ++i)
+    {
+        const double pos_u = -uu[i] * grid_scale;
+        const double pos_v = vv[i] * grid_scale;
+        int grid_w = (int)round(sqrt(fabs(ww[i] * w_scale)));
+        if (grid_w >= num_w_planes) grid_w = num_w_planes - 1;
+        const int w_support = support[grid_w];
+        const int grid_u = (int)round(pos_u) + grid_centre;
+        const int grid_v = (int)round(pos_v) + grid_centre;
+        if (grid_u + w_support >= grid_size || grid_u - w_support < 0 ||
+                grid_v + w_support >= grid_size || grid_v - w_support < 0)
+        {
+            (*num_skipped)++;
+            continue;
+        }
+        const int off_u = (int)round((round(pos_u) - pos_u) * oversample);
+        const int off_v = (int)round((round(pos_v) - pos_v) * oversample);
+        const double conv_conj = (ww[i] > 0.0) ? -1.0 : 1.0;
+        const double v_re = weight[i] * vis[2 * i];
+        const double v_im = weight[i] * vis[2 * i + 1];
+        double sum = 0.0;
+        for (int j = -w_support; j <= w_support; ++j)
+        {
+            for (int k = -w_support; k <= w_support; ++k)
+            {
+                const size_t t = 2 * ((size_t)grid_w *
+                        conv_size_half * conv_size_half +
+                        abs(off_v + j * oversample) * conv_size_half +
+                        abs(off_u + k * oversample));
+                const double c_re = conv_func[t];
+                const double c_im = conv_func[t + 1] * conv_conj;
+                const size_t p = 2 * ((size_t)(grid_v + j) * grid_size +
+                        grid_u + k);
+                grid[p]     += (v_re * c_re - v_im * c_im);
+                grid[p + 1] += (v_im * c_re + v_re * c_im);
+                sum += c_re;
+            }
+        }
+        *norm += sum * weight[i];
+    }
+}
+
+TEST(imager, grid_thread_independent)
+{
+    int status = 0, support = 3, oversample = 100;
+    int size = 512, num_vis = 20000;
+    double cell_size_rad = 4.0 * M_PI / (180.0 * size);
+    std::vector<double> conv_func(oversample * (support + 1));
+    std::vector<float> conv_func_f(conv_func.size());
+    oskar_grid_convolution_function_spheroidal(support, oversample,
+            &conv_func[0]);
+    for (size_t i = 0; i < conv_func.size(); ++i)
+        conv_func_f[i] = (float) conv_func[i];
+
+    // Test in both precisions.
+    for (int prec = 0; prec < 2; ++prec)
+    {
+        const int type = prec == 0 ? OSKAR_DOUBLE : OSKAR_SINGLE;
+
+        // Create visibility data.
+        oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+        oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+        oskar_Mem* vis = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU,
+                num_vis, &status);
+        oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, num_vis,
+                &status);
+        oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 1000.0, &status);
+        oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 1000.0, &status);
+        oskar_mem_random_gaussian(vis, 8, 9, 10, 11, 1.0, &status);
+        oskar_mem_random_uniform(weight, 12, 13, 14, 15, &status);
+        ASSERT_EQ(0, status);
+
+        // Grid with one thread for a serial reference, and then with four,
+        // restoring the number of threads afterwards.
+        oskar_Mem* grid[2];
+        double norm[2] = {0.0, 0.0};
+        size_t num_skipped[2] = {0, 0};
+#ifdef _OPENMP
+        const int max_threads = omp_get_max_threads();
+#endif
+        for (int i = 0; i < 2; ++i)
+        {
+            grid[i] = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU,
+                    size * size, &status);
+            oskar_mem_clear_contents(grid[i], &status);
+#ifdef _OPENMP
+            omp_set_num_threads(i == 0 ? 1 : 4);
+#endif
+            std::vector<char> work(oskar_grid_simple_work_size(support,
+                    num_vis, size, oskar_mem_element_size(type)));
+            if (type == OSKAR_DOUBLE)
+                oskar_grid_simple_d(support, oversample, &conv_func[0],
+                        num_vis, oskar_mem_double_const(uu, &status),
+                        oskar_mem_double_const(vv, &status),
+                        oskar_mem_double_const(vis, &status),
+                        oskar_mem_double_const(weight, &status),
+                        cell_size_rad, size, &work[0], &num_skipped[i],
+                        &norm[i], oskar_mem_double(grid[i], &status));
+            else
+                oskar_grid_simple_f(support, oversample, &conv_func_f[0],
+                        num_vis, oskar_mem_float_const(uu, &status),
+                        oskar_mem_float_const(vv, &status),
+                        oskar_mem_float_const(vis, &status),
+                        oskar_mem_float_const(weight, &status),
+                        (float) cell_size_rad, size, &work[0],
+                        &num_skipped[i], &norm[i],
+                        oskar_mem_float(grid[i], &status));
+        }
+#ifdef _OPENMP
+        omp_set_num_threads(max_threads);
+#endif
+        ASSERT_EQ(0, status);
+
+        // Check results are identical.
+        EXPECT_EQ(num_skipped[0], num_skipped[1]);
+        EXPECT_EQ(norm[0], norm[1]);
+        EXPECT_FALSE(oskar_mem_different(grid[0], grid[1], 0, &status));
+
+        // Clean up.
+        oskar_mem_free(uu, &status);
+        oskar_mem_free(vv, &status);
+        oskar_mem_free(vis, &status);
+        oskar_mem_free(weight, &status);
+        oskar_mem_free(grid[0], &status);
+        oskar_mem_free(grid[1], &status);
+    }
+}
+
+TEST(imager, grid_wproj_thread_independent)
+{
+    int status = 0, oversample = 4, conv_size_half = 48;
+    int size = 512, num_vis = 20000, num_w_planes = 4;
+    int support[] = {2, 4, 7, 11};
+    double cell_size_rad = 4.0 * M_PI / (180.0 * size);
+    double w_scale = 16.0 / 3000.0;
+
+    // Test in both precisions.
+    for (int prec = 0; prec < 2; ++prec)
+    {
+        const int type = prec == 0 ? OSKAR_DOUBLE : OSKAR_SINGLE;
+
+        // Create visibility data and arbitrary W-kernels. Some of the
+        // W values are beyond the last W-plane.
+        oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+        oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+        oskar_Mem* ww = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+        oskar_Mem* vis = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU,
+                num_vis, &status);
+        oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, num_vis,
+                &status);
+        oskar_Mem* kernels = oskar_mem_create(type | OSKAR_COMPLEX,
+                OSKAR_CPU, num_w_planes * conv_size_half * conv_size_half,
+                &status);
+        oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 1000.0, &status);
+        oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 1000.0, &status);
+        oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 1000.0, &status);
+        oskar_mem_random_gaussian(vis, 12, 13, 14, 15, 1.0, &status);
+        oskar_mem_random_uniform(weight, 16, 17, 18, 19, &status);
+        oskar_mem_random_uniform(kernels, 20, 21, 22, 23, &status);
+        ASSERT_EQ(0, status);
+
+        // Grid with one thread for a serial reference, and then with four,
+        // restoring the number of threads afterwards.
+        oskar_Mem* grid[2];
+        double norm[2] = {0.0, 0.0};
+        size_t num_skipped[2] = {0, 0};
+#ifdef _OPENMP
+        const int max_threads = omp_get_max_threads();
+#endif
+        for (int i = 0; i < 2; ++i)
+        {
+            grid[i] = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU,
+                    size * size, &status);
+            oskar_mem_clear_contents(grid[i], &status);
+#ifdef _OPENMP
+            omp_set_num_threads(i == 0 ? 1 : 4);
+#endif
+            std::vector<char> work(oskar_grid_wproj_work_size(num_w_planes,
+                    support, num_vis, size, oskar_mem_element_size(type)));
+            if (type == OSKAR_DOUBLE)
+                oskar_grid_wproj_d(num_w_planes, support, oversample,
+                        conv_size_half, oskar_mem_double_const(kernels,
+                        &status), num_vis,
+                        oskar_mem_double_const(uu, &status),
+                        oskar_mem_double_const(vv, &status),
+                        oskar_mem_double_const(ww, &status),
+                        oskar_mem_double_const(vis, &status),
+                        oskar_mem_double_const(weight, &status),
+                        cell_size_rad, w_scale, size, &work[0],
+                        &num_skipped[i], &norm[i],
+                        oskar_mem_double(grid[i], &status));
+            else
+                oskar_grid_wproj_f(num_w_planes, support, oversample,
+                        conv_size_half, oskar_mem_float_const(kernels,
+                        &status), num_vis,
+                        oskar_mem_float_const(uu, &status),
+                        oskar_mem_float_const(vv, &status),
+                        oskar_mem_float_const(ww, &status),
+                        oskar_mem_float_const(vis, &status),
+                        oskar_mem_float_const(weight, &status),
+                        (float) cell_size_rad, (float) w_scale, size,
+                        &work[0], &num_skipped[i], &norm[i],
+                        oskar_mem_float(grid[i], &status));
+        }
+#ifdef _OPENMP
+        omp_set_num_threads(max_threads);
+#endif
+        ASSERT_EQ(0, status);
+
+        // Check results are identical, and that some points were skipped.
+        EXPECT_GT(num_skipped[0], 0u);
+        EXPECT_EQ(num_skipped[0], num_skipped[1]);
+        EXPECT_EQ(norm[0], norm[1]);
+        EXPECT_FALSE(oskar_mem_different(grid[0], grid[1], 0, &status));
+
+        // Check the double-precision result against the reference.
+        if (type == OSKAR_DOUBLE)
+        {
+            size_t ref_skipped = 0;
+            double ref_norm = 0.0, max_err = 0.0, max_val = 0.0;
+            std::vector<double> ref(2 * size * size, 0.0);
+            grid_wproj_reference(num_w_planes, support, oversample,
+                    conv_size_half, oskar_mem_double_const(kernels, &status),
+                    num_vis, oskar_mem_double_const(uu, &status),
+                    oskar_mem_double_const(vv, &status),
+                    oskar_mem_double_const(ww, &status),
+                    oskar_mem_double_const(vis, &status),
+                    oskar_mem_double_const(weight, &status),
+                    cell_size_rad, w_scale, size, &ref_skipped, &ref_norm,
+                    &ref[0]);
+            const double* g = oskar_mem_double_const(grid[0], &status);
+            for (size_t i = 0; i < ref.size(); ++i)
+            {
+                if (fabs(ref[i]) > max_val) max_val = fabs(ref[i]);
+                if (fabs(ref[i] - g[i]) > max_err)
+                    max_err = fabs(ref[i] - g[i]);
+            }
+            EXPECT_EQ(ref_skipped, num_skipped[0]);
+            EXPECT_NEAR(ref_norm, norm[0], 1e-12 * fabs(ref_norm));
+            EXPECT_LT(max_err, 1e-12 * max_val);
+        }
+
+        // Clean up.
+        oskar_mem_free(uu, &status);
+        oskar_mem_free(vv, &status);
+        oskar_mem_free(ww, &status);
+        oskar_mem_free(vis, &status);
+        oskar_mem_free(weight, &status);
+        oskar_mem_free(kernels, &status);
+        oskar_mem_free(grid[0], &status);
+        oskar_mem_free(grid[1], &status);
+    }
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "imager/oskar_grid_weights.h"
+#include "math/oskar_cmath.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <vector>
+
+TEST(imager, grid_weights_thread_independent)
+{
+    int status = 0, type = OSKAR_DOUBLE, size = 512, num_vis = 20000;
+    double cell_size_rad = 4.0 * M_PI / (180.0 * size);
+
+    // Create baseline coordinates and weights.
+    oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 1000.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 1000.0, &status);
+    oskar_mem_random_uniform(weight, 12, 13, 14, 15, &status);
+    ASSERT_EQ(0, status);
+
+    // Write and read the grid of weights with one thread for a serial
+    // reference, and then with four, restoring the number of threads.
+    std::vector<double> grid[2], weight_out[2];
+    size_t num_skipped[2][2] = {{0, 0}, {0, 0}};
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+#endif
+    for (int i = 0; i < 2; ++i)
+    {
+        grid[i].resize(size * size, 0.0);
+        weight_out[i].resize(num_vis, 0.0);
+#ifdef _OPENMP
+        omp_set_num_threads(i == 0 ? 1 : 4);
+#endif
+        oskar_grid_weights_write_d(num_vis,
+                oskar_mem_double_const(uu, &status),
+                oskar_mem_double_const(vv, &status),
+                oskar_mem_double_const(weight, &status),
+                cell_size_rad, size, &num_skipped[i][0], &grid[i][0],
+                &status);
+        oskar_grid_weights_read_d(num_vis,
+                oskar_mem_double_const(uu, &status),
+                oskar_mem_double_const(vv, &status),
+                oskar_mem_double_const(weight, &status),
+                &weight_out[i][0], cell_size_rad, size,
+                &num_skipped[i][1], &grid[i][0]);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(max_threads);
+#endif
+    ASSERT_EQ(0, status);
+
+    // Check results are identical.
+    EXPECT_EQ(num_skipped[0][0], num_skipped[1][0]);
+    EXPECT_EQ(num_skipped[0][1], num_skipped[1][1]);
+    EXPECT_TRUE(grid[0] == grid[1]);
+    EXPECT_TRUE(weight_out[0] == weight_out[1]);
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(weight, &status);
+}
+
+
+static oskar_Mem* briggs_test_image(const char* weighting, double robustness,
+        int size, double fov, const oskar_Mem* uu, const oskar_Mem* vv,
+        const oskar_Mem* ww, const oskar_Mem* vis, const oskar_Mem* weight,
+        int num_blocks = 1)
+{
+    int status = 0;
+    oskar_Mem* image = 0;
+    const int num_vis = (int) oskar_mem_length(uu);
+    const int block_size = (num_vis + num_blocks - 1) / num_blocks;
+    oskar_Imager* h = oskar_imager_create(OSKAR_DOUBLE, &status);
+    oskar_imager_set_algorithm(h, "FFT", &status);
+    oskar_imager_set_weighting(h, weighting, &status);
+    oskar_imager_set_robustness(h, robustness);
+    oskar_imager_set_fov(h, fov);
+    oskar_imager_set_size(h, size, &status);
+    oskar_imager_set_fft_on_gpu(h, 0);
+    oskar_imager_set_vis_frequency(h, 100e6, 0.0, 1);
+    oskar_imager_set_coords_only(h, 1);
+    oskar_imager_update(h, num_vis, 0, 0, 1, uu, vv, ww, 0, weight,
+            0, &status);
+    oskar_imager_set_coords_only(h, 0);
+    for (int i = 0; i < num_vis; i += block_size)
+    {
+        const int n = (num_vis - i < block_size) ? num_vis - i : block_size;
+        oskar_Mem* u = oskar_mem_create_alias(uu, i, n, &status);
+        oskar_Mem* v = oskar_mem_create_alias(vv, i, n, &status);
+        oskar_Mem* w = oskar_mem_create_alias(ww, i, n, &status);
+        oskar_Mem* a = oskar_mem_create_alias(vis, i, n, &status);
+        oskar_Mem* wt = oskar_mem_create_alias(weight, i, n, &status);
+        oskar_imager_update(h, n, 0, 0, 1, u, v, w, a, wt, 0, &status);
+        oskar_mem_free(u, &status);
+        oskar_mem_free(v, &status);
+        oskar_mem_free(w, &status);
+        oskar_mem_free(a, &status);
+        oskar_mem_free(wt, &status);
+    }
+    oskar_imager_finalise(h, 1, &image, 0, 0, &status);
+    oskar_imager_free(h, &status);
+    EXPECT_EQ(0, status);
+    return image;
+}
+
+
+static double briggs_test_error(const oskar_Mem* ref,
+        const oskar_Mem* image)
+{
+    int status = 0;
+    double max_diff = 0.0, peak = 0.0;
+    const size_t num_pixels = oskar_mem_length(ref);
+    const double* x = oskar_mem_double_const(ref, &status);
+    const double* y = oskar_mem_double_const(image, &status);
+    for (size_t i = 0; i < num_pixels; ++i)
+    {
+        if (fabs(x[i]) > peak) peak = fabs(x[i]);
+        if (fabs(x[i] - y[i]) > max_diff) max_diff = fabs(x[i] - y[i]);
+    }
+    return max_diff / peak;
+}
+
+
+TEST(imager, briggs_weighting)
+{
+    int status = 0, size = 128, num_vis = 5000;
+    const double fov = 2.0, fov_rad = fov * M_PI / 180.0;
+
+    // Create visibility data.
+    oskar_Mem* uu = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 0.2 * size / fov_rad, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 0.2 * size / fov_rad, &status);
+    oskar_mem_random_gaussian(vis, 8, 9, 10, 11, 1.0, &status);
+    oskar_mem_random_uniform(weight, 12, 13, 14, 15, &status);
+    oskar_mem_clear_contents(ww, &status);
+    ASSERT_EQ(0, status);
+
+    // Check the limits of the robustness parameter give the natural
+    // and uniform weighted images, and that the default differs from both.
+    oskar_Mem* natural = briggs_test_image("Natural", 0.0, size, fov,
+            uu, vv, ww, vis, weight);
+    oskar_Mem* uniform = briggs_test_image("Uniform", 0.0, size, fov,
+            uu, vv, ww, vis, weight);
+    oskar_Mem* image = briggs_test_image("Briggs", 10.0, size, fov,
+            uu, vv, ww, vis, weight);
+    EXPECT_LT(briggs_test_error(natural, image), 1e-6);
+    oskar_mem_free(image, &status);
+    image = briggs_test_image("Briggs", -10.0, size, fov,
+            uu, vv, ww, vis, weight);
+    EXPECT_LT(briggs_test_error(uniform, image), 1e-6);
+    oskar_mem_free(image, &status);
+    image = briggs_test_image("Briggs", 0.0, size, fov,
+            uu, vv, ww, vis, weight);
+    EXPECT_GT(briggs_test_error(natural, image), 1e-3);
+    EXPECT_GT(briggs_test_error(uniform, image), 1e-3);
+
+    // Check the weights grid is converted only once when the data are
+    // supplied in several calls.
+    oskar_Mem* blocks = briggs_test_image("Briggs", 0.0, size, fov,
+            uu, vv, ww, vis, weight, 3);
+    EXPECT_LT(briggs_test_error(image, blocks), 1e-10);
+    oskar_mem_free(blocks, &status);
+    oskar_mem_free(image, &status);
+    oskar_mem_free(natural, &status);
+    oskar_mem_free(uniform, &status);
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+}
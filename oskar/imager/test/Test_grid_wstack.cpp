@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "math/oskar_cmath.h"
+
+TEST(imager, grid_wstack)
+{
+    int status = 0, type = OSKAR_DOUBLE, size = 128, num_vis = 2000;
+    double fov_deg = 10.0, l = 0.04, m = -0.05;
+    double cell_size_rad = sin(fov_deg * M_PI / 180.0) / size;
+
+    // Create visibility data for an off-centre point source,
+    // with significant W-terms.
+    oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU, num_vis,
+            &status);
+    oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 50.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 50.0, &status);
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 150.0, &status);
+    oskar_mem_set_value_real(weight, 1.0, 0, num_vis, &status);
+    ASSERT_EQ(0, status);
+    const double* u_ = oskar_mem_double_const(uu, &status);
+    const double* v_ = oskar_mem_double_const(vv, &status);
+    const double* w_ = oskar_mem_double_const(ww, &status);
+    double2* vis_ = oskar_mem_double2(vis, &status);
+    for (int i = 0; i < num_vis; ++i)
+    {
+        double n = sqrt(1.0 - l*l - m*m);
+        double phase = -2.0 * M_PI * (u_[i] * l + v_[i] * m -
+                w_[i] * (n - 1.0));
+        vis_[i].x = cos(phase);
+        vis_[i].y = sin(phase);
+    }
+
+    // Make images using a 3D DFT and using W-stacking.
+    // The first pass finds the range of W values.
+    const char* algorithm[] = {"DFT 3D", "W-stacking"};
+    oskar_Mem* image[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        double plane_norm = 0.0;
+        oskar_Imager* im = oskar_imager_create(type, &status);
+        oskar_imager_set_algorithm(im, algorithm[i], &status);
+        oskar_imager_set_fov(im, fov_deg);
+        oskar_imager_set_size(im, size, &status);
+        oskar_imager_set_fft_on_gpu(im, 0);
+        image[i] = oskar_mem_create(oskar_imager_plane_type(im), OSKAR_CPU,
+                0, &status);
+        oskar_imager_set_coords_only(im, 1);
+        oskar_imager_update_plane(im, num_vis, uu, vv, ww, vis, weight,
+                0, 0, 0, &status);
+        oskar_imager_set_coords_only(im, 0);
+
+        // Update the plane in two blocks, so that W-layers accumulate
+        // across updates.
+        for (int k = 0; k < 2; ++k)
+        {
+            const int start = k * num_vis / 2;
+            const int num = (k + 1) * num_vis / 2 - start;
+            oskar_Mem* uu_k = oskar_mem_create_alias(uu, start, num, &status);
+            oskar_Mem* vv_k = oskar_mem_create_alias(vv, start, num, &status);
+            oskar_Mem* ww_k = oskar_mem_create_alias(ww, start, num, &status);
+            oskar_Mem* vis_k = oskar_mem_create_alias(vis, start, num,
+                    &status);
+            oskar_Mem* weight_k = oskar_mem_create_alias(weight, start, num,
+                    &status);
+            oskar_imager_update_plane(im, num, uu_k, vv_k, ww_k, vis_k,
+                    weight_k, image[i], &plane_norm, 0, &status);
+            oskar_mem_free(uu_k, &status);
+            oskar_mem_free(vv_k, &status);
+            oskar_mem_free(ww_k, &status);
+            oskar_mem_free(vis_k, &status);
+            oskar_mem_free(weight_k, &status);
+        }
+
+        // Check the plane holds a UV grid for each W-layer until finalise.
+        const int plane_size = oskar_imager_plane_size(im);
+        if (i > 0)
+        {
+            EXPECT_GT(oskar_imager_num_w_planes(im), 1);
+            EXPECT_EQ((size_t)plane_size * plane_size *
+                    oskar_imager_num_w_planes(im),
+                    oskar_mem_length(image[i]));
+        }
+        oskar_imager_finalise_plane(im, image[i], plane_norm, &status);
+        oskar_imager_trim_image(im, image[i], plane_size, size, &status);
+        oskar_imager_free(im, &status);
+        ASSERT_EQ(0, status);
+    }
+
+    // Check the images agree in the inner part of the field.
+    const double* dft = oskar_mem_double_const(image[0], &status);
+    const double* wstack = oskar_mem_double_const(image[1], &status);
+    int src = (int)round(-m / cell_size_rad + size / 2) * size +
+            (int)round(l / cell_size_rad + size / 2);
+    EXPECT_GT(dft[src], 0.9);
+    EXPECT_NEAR(dft[src], wstack[src], 5e-3);
+    double max_diff = 0.0;
+    for (int y = size / 4; y < 3 * size / 4; ++y)
+    {
+        for (int x = size / 4; x < 3 * size / 4; ++x)
+        {
+            double diff = fabs(dft[y * size + x] - wstack[y * size + x]);
+            if (diff > max_diff) max_diff = diff;
+        }
+    }
+    EXPECT_LT(max_diff, 5e-3);
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+    oskar_mem_free(image[0], &status);
+    oskar_mem_free(image[1], &status);
+}
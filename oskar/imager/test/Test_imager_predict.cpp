@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "math/oskar_cmath.h"
+#include "math/oskar_evaluate_image_lmn_grid.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static double predict_error(const char* algorithm, const char* kernel,
+        int support, int oversample, oskar_Mem* image, int size, double fov,
+        const oskar_Mem* uu, const oskar_Mem* vv, const oskar_Mem* ww,
+        const oskar_Mem* l, const oskar_Mem* m, const oskar_Mem* n)
+{
+    int status = 0;
+    const int num_vis = (int) oskar_mem_length(uu);
+    oskar_Mem* vis = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_vis, &status);
+    oskar_mem_clear_contents(vis, &status);
+
+    // Predict visibilities from the image.
+    oskar_Imager* h = oskar_imager_create(OSKAR_DOUBLE, &status);
+    oskar_imager_set_algorithm(h, algorithm, &status);
+    if (kernel)
+        oskar_imager_set_grid_kernel(h, kernel, support, oversample, &status);
+    oskar_imager_set_fov(h, fov);
+    oskar_imager_set_size(h, size, &status);
+    oskar_imager_set_fft_on_gpu(h, 0);
+    oskar_imager_set_generate_w_kernels_on_gpu(h, 0);
+    if (!strcmp(algorithm, "W-projection"))
+    {
+        oskar_Mem* weight = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+                num_vis, &status);
+        oskar_mem_set_value_real(weight, 1.0, 0, num_vis, &status);
+        oskar_imager_set_coords_only(h, 1);
+        oskar_imager_update_plane(h, num_vis, uu, vv, ww, 0, weight,
+                0, 0, 0, &status);
+        oskar_imager_set_coords_only(h, 0);
+        oskar_mem_free(weight, &status);
+    }
+    oskar_imager_set_model_image(h, image, &status);
+    oskar_imager_predict(h, num_vis, uu, vv, ww, vis, &status);
+    oskar_imager_free(h, &status);
+    EXPECT_EQ(0, status);
+
+    // Compare against a direct evaluation of the sum over pixels.
+    double max_diff = 0.0, peak = 0.0;
+    const double* u_ = oskar_mem_double_const(uu, &status);
+    const double* v_ = oskar_mem_double_const(vv, &status);
+    const double* w_ = oskar_mem_double_const(ww, &status);
+    const double* l_ = oskar_mem_double_const(l, &status);
+    const double* m_ = oskar_mem_double_const(m, &status);
+    const double* n_ = oskar_mem_double_const(n, &status);
+    const double* img = oskar_mem_double_const(image, &status);
+    const double2* vis_ = oskar_mem_double2_const(vis, &status);
+    for (int i = 0; i < num_vis; ++i)
+    {
+        double re = 0.0, im = 0.0;
+        for (int j = 0; j < size * size; ++j)
+        {
+            if (img[j] == 0.0) continue;
+            const double phase = 2.0 * M_PI * (u_[i] * l_[j] +
+                    v_[i] * m_[j] + w_[i] * (n_[j] - 1.0));
+            re += img[j] * cos(phase);
+            im += img[j] * sin(phase);
+        }
+        const double diff = sqrt(pow(re - vis_[i].x, 2.0) +
+                pow(im - vis_[i].y, 2.0));
+        if (diff > max_diff) max_diff = diff;
+        if (sqrt(re * re + im * im) > peak) peak = sqrt(re * re + im * im);
+    }
+    oskar_mem_free(vis, &status);
+    return max_diff / peak;
+}
+
+
+TEST(imager, predict)
+{
+    int status = 0, size = 128, num_vis = 1000;
+    const double fov = 2.0;
+
+    // Create a model image containing point sources.
+    oskar_Mem* image = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            size * size, &status);
+    oskar_mem_clear_contents(image, &status);
+    double* img = oskar_mem_double(image, &status);
+    srand(1);
+    for (int i = 0; i < 40; ++i)
+    {
+        const int x = rand() % (size / 2) + size / 4;
+        const int y = rand() % (size / 2) + size / 4;
+        img[y * size + x] += 1.0 + i * 0.1;
+    }
+    oskar_Mem* l = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            size * size, &status);
+    oskar_Mem* m = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            size * size, &status);
+    oskar_Mem* n = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            size * size, &status);
+    oskar_evaluate_image_lmn_grid(size, size, fov * M_PI / 180.0,
+            fov * M_PI / 180.0, 0, l, m, n, &status);
+
+    // Create baseline coordinates, in wavelengths.
+    oskar_Mem* uu = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 300.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 300.0, &status);
+    oskar_mem_clear_contents(ww, &status);
+    ASSERT_EQ(0, status);
+
+    // Check a well-sampled kernel gives accurate visibilities.
+    double err_fft = predict_error("FFT", "ES", 3, 1000, image, size, fov,
+            uu, vv, ww, l, m, n);
+    EXPECT_LT(err_fft, 1e-3);
+
+    // Check W-projection copes with non-zero baseline W coordinates
+    // much better than the FFT.
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 1000.0, &status);
+    double err_fft_w = predict_error("FFT", 0, 0, 0, image, size, fov,
+            uu, vv, ww, l, m, n);
+    double err_wproj = predict_error("W-projection", 0, 0, 0, image, size, fov,
+            uu, vv, ww, l, m, n);
+    EXPECT_LT(err_wproj, 0.1);
+    EXPECT_LT(2.0 * err_wproj, err_fft_w);
+
+    // Clean up.
+    oskar_mem_free(image, &status);
+    oskar_mem_free(l, &status);
+    oskar_mem_free(m, &status);
+    oskar_mem_free(n, &status);
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+}
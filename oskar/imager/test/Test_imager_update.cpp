@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "imager/private_imager.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <vector>
+
+struct Workspace
+{
+    const oskar_Mem* mem;
+    const void* data;
+    size_t length;
+};
+
+// Returns the handle, address and length of each imager workspace.
+static std::vector<Workspace> workspaces(const oskar_Imager* h)
+{
+    std::vector<const oskar_Mem*> mems;
+    mems.push_back(h->block_vis);
+    mems.push_back(h->block_weight);
+    mems.push_back(h->block_time);
+    mems.push_back(h->conv_uu);
+    mems.push_back(h->conv_vv);
+    mems.push_back(h->conv_ww);
+    mems.push_back(h->conv_amp);
+    mems.push_back(h->conv_weight);
+    for (int i = 0; i < h->num_scratch; ++i)
+    {
+        const ScratchData* s = &h->scratch[i];
+        mems.push_back(s->uu_im);
+        mems.push_back(s->vv_im);
+        mems.push_back(s->ww_im);
+        mems.push_back(s->vis_im);
+        mems.push_back(s->weight_im);
+        mems.push_back(s->time_im);
+        mems.push_back(s->uu_tmp);
+        mems.push_back(s->vv_tmp);
+        mems.push_back(s->ww_tmp);
+        mems.push_back(s->weight_tmp);
+        mems.push_back(s->grid_work);
+    }
+    std::vector<Workspace> out(mems.size());
+    for (size_t i = 0; i < mems.size(); ++i)
+    {
+        out[i].mem = mems[i];
+        out[i].data = mems[i] ? oskar_mem_void_const(mems[i]) : 0;
+        out[i].length = mems[i] ? oskar_mem_length(mems[i]) : 0;
+    }
+    return out;
+}
+
+TEST(imager, update_planes_thread_independent)
+{
+    int status = 0, type = OSKAR_DOUBLE, size = 256, num_vis = 5000;
+
+    // Create visibility data for all four linear polarisations.
+    oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU,
+            4 * num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, 4 * num_vis,
+            &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 500.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 500.0, &status);
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 50.0, &status);
+    oskar_mem_random_gaussian(vis, 12, 13, 14, 15, 1.0, &status);
+    oskar_mem_random_uniform(weight, 16, 17, 18, 19, &status);
+    ASSERT_EQ(0, status);
+
+    // Make the images with one thread for a serial reference, and then
+    // with four, restoring the number of threads afterwards.
+    oskar_Mem* images[2][4];
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+#endif
+    for (int i = 0; i < 2; ++i)
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(i == 0 ? 1 : 4);
+#endif
+        oskar_Imager* im = oskar_imager_create(type, &status);
+        oskar_imager_set_image_type(im, "Linear", &status);
+        oskar_imager_set_weighting(im, "Radial", &status);
+        oskar_imager_set_fov(im, 2.0);
+        oskar_imager_set_size(im, size, &status);
+        oskar_imager_set_fft_on_gpu(im, 0);
+        oskar_imager_set_vis_frequency(im, 100e6, 0.0, 1);
+        for (int p = 0; p < 4; ++p) images[i][p] = 0;
+        oskar_imager_update(im, num_vis, 0, 0, 4, uu, vv, ww, vis, weight,
+                0, &status);
+        oskar_imager_finalise(im, 4, images[i], 0, 0, &status);
+        oskar_imager_free(im, &status);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(max_threads);
+#endif
+    ASSERT_EQ(0, status);
+
+    // Check results are identical.
+    for (int p = 0; p < 4; ++p)
+    {
+        const size_t num_pixels = size * size;
+        ASSERT_EQ(num_pixels, oskar_mem_length(images[0][p]));
+        ASSERT_EQ(num_pixels, oskar_mem_length(images[1][p]));
+        const double* a = oskar_mem_double_const(images[0][p], &status);
+        const double* b = oskar_mem_double_const(images[1][p], &status);
+        size_t num_different = 0;
+        for (size_t j = 0; j < num_pixels; ++j)
+            if (a[j] != b[j]) num_different++;
+        EXPECT_EQ(0u, num_different) << "Polarisation " << p;
+    }
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+    for (int i = 0; i < 2; ++i)
+        for (int p = 0; p < 4; ++p)
+            oskar_mem_free(images[i][p], &status);
+}
+
+
+TEST(imager, update_reuses_workspaces)
+{
+    int status = 0, size = 256, num_vis = 4000;
+
+    // Create double-precision visibility data for a single-precision imager.
+    oskar_Mem* uu = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis,
+            &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 500.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 500.0, &status);
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 50.0, &status);
+    oskar_mem_random_gaussian(vis, 12, 13, 14, 15, 1.0, &status);
+    oskar_mem_random_uniform(weight, 16, 17, 18, 19, &status);
+    oskar_Mem* uu_f = oskar_mem_convert_precision(uu, OSKAR_SINGLE, &status);
+    oskar_Mem* vv_f = oskar_mem_convert_precision(vv, OSKAR_SINGLE, &status);
+    oskar_Mem* ww_f = oskar_mem_convert_precision(ww, OSKAR_SINGLE, &status);
+    oskar_Mem* vis_f = oskar_mem_convert_precision(vis, OSKAR_SINGLE, &status);
+    oskar_Mem* weight_f = oskar_mem_convert_precision(weight, OSKAR_SINGLE,
+            &status);
+    ASSERT_EQ(0, status);
+
+    // Update with a full block and then a shorter one, so that the
+    // second update runs with workspaces longer than the data.
+    oskar_Mem* images[2] = {0, 0};
+    for (int i = 0; i < 2; ++i)
+    {
+        oskar_Imager* im = oskar_imager_create(OSKAR_SINGLE, &status);
+        oskar_imager_set_weighting(im, "Radial", &status);
+        oskar_imager_set_fov(im, 2.0);
+        oskar_imager_set_size(im, size, &status);
+        oskar_imager_set_fft_on_gpu(im, 0);
+        oskar_imager_set_vis_frequency(im, 100e6, 0.0, 1);
+        if (i == 0)
+        {
+            oskar_imager_update(im, num_vis, 0, 0, 1, uu, vv, ww, vis,
+                    weight, 0, &status);
+            oskar_imager_update(im, num_vis / 2, 0, 0, 1, uu, vv, ww, vis,
+                    weight, 0, &status);
+        }
+        else
+        {
+            oskar_imager_update(im, num_vis, 0, 0, 1, uu_f, vv_f, ww_f,
+                    vis_f, weight_f, 0, &status);
+            oskar_imager_update(im, num_vis / 2, 0, 0, 1, uu_f, vv_f, ww_f,
+                    vis_f, weight_f, 0, &status);
+        }
+        oskar_imager_finalise(im, 1, &images[i], 0, 0, &status);
+        oskar_imager_free(im, &status);
+        ASSERT_EQ(0, status);
+    }
+
+    // Check results are identical.
+    const size_t num_pixels = size * size;
+    ASSERT_EQ(num_pixels, oskar_mem_length(images[0]));
+    ASSERT_EQ(num_pixels, oskar_mem_length(images[1]));
+    const float* a = oskar_mem_float_const(images[0], &status);
+    const float* b = oskar_mem_float_const(images[1], &status);
+    size_t num_different = 0;
+    for (size_t j = 0; j < num_pixels; ++j)
+        if (a[j] != b[j]) num_different++;
+    EXPECT_EQ(0u, num_different);
+
+    // Update from a double-precision block with several channels, so the
+    // data are converted and transposed. After the first block, blocks
+    // of the same size or smaller must not reallocate any workspace,
+    // including the work buffer of each gridder.
+    const int num_stations = 20, num_channels = 3, num_times = 4;
+    oskar_VisHeader* hdr = oskar_vis_header_create(OSKAR_DOUBLE_COMPLEX,
+            OSKAR_DOUBLE, num_times, num_times, num_channels, num_channels,
+            num_stations, 0, 1, &status);
+    oskar_vis_header_set_freq_start_hz(hdr, 100e6);
+    oskar_vis_header_set_freq_inc_hz(hdr, 1e6);
+    oskar_vis_header_set_time_start_mjd_utc(hdr, 51544.5);
+    oskar_vis_header_set_time_inc_sec(hdr, 10.0);
+    oskar_VisBlock* blk = oskar_vis_block_create_from_header(OSKAR_CPU,
+            hdr, &status);
+    oskar_mem_random_gaussian(oskar_vis_block_baseline_uu_metres(blk),
+            0, 1, 2, 3, 500.0, &status);
+    oskar_mem_random_gaussian(oskar_vis_block_baseline_vv_metres(blk),
+            4, 5, 6, 7, 500.0, &status);
+    oskar_mem_random_gaussian(oskar_vis_block_baseline_ww_metres(blk),
+            8, 9, 10, 11, 50.0, &status);
+    oskar_mem_random_gaussian(oskar_vis_block_cross_correlations(blk),
+            12, 13, 14, 15, 1.0, &status);
+    const char* algorithm[] = {"FFT", "W-projection", "IDG", "W-stacking"};
+    for (int a = 0; a < 4; ++a)
+    {
+        SCOPED_TRACE(algorithm[a]);
+        oskar_Imager* im = oskar_imager_create(OSKAR_SINGLE, &status);
+        oskar_imager_set_algorithm(im, algorithm[a], &status);
+        oskar_imager_set_num_w_planes(im, 4);
+        oskar_imager_set_weighting(im, "Radial", &status);
+        oskar_imager_set_fov(im, 2.0);
+        oskar_imager_set_size(im, size, &status);
+        oskar_imager_set_fft_on_gpu(im, 0);
+        oskar_imager_set_generate_w_kernels_on_gpu(im, 0);
+        oskar_vis_block_set_num_times(blk, num_times, &status);
+        oskar_imager_update_from_block(im, hdr, blk, &status);
+        ASSERT_EQ(0, status);
+        const std::vector<Workspace> ref = workspaces(im);
+        ASSERT_NE((const oskar_Mem*) 0, ref[0].mem);
+        EXPECT_GT(oskar_mem_length(im->scratch[0].grid_work), 0u);
+        for (int t = num_times; t > 0; t -= 2)
+        {
+            oskar_vis_block_set_num_times(blk, t, &status);
+            oskar_imager_update_from_block(im, hdr, blk, &status);
+            ASSERT_EQ(0, status);
+            const std::vector<Workspace> w = workspaces(im);
+            ASSERT_EQ(ref.size(), w.size());
+            for (size_t j = 0; j < w.size(); ++j)
+            {
+                EXPECT_EQ(ref[j].mem, w[j].mem) << "Workspace " << j;
+                EXPECT_EQ(ref[j].data, w[j].data) << "Workspace " << j;
+                EXPECT_EQ(ref[j].length, w[j].length) << "Workspace " << j;
+            }
+        }
+        oskar_imager_free(im, &status);
+    }
+    oskar_vis_block_free(blk, &status);
+    oskar_vis_header_free(hdr, &status);
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+    oskar_mem_free(uu_f, &status);
+    oskar_mem_free(vv_f, &status);
+    oskar_mem_free(ww_f, &status);
+    oskar_mem_free(vis_f, &status);
+    oskar_mem_free(weight_f, &status);
+    oskar_mem_free(images[0], &status);
+    oskar_mem_free(images[1], &status);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "math/oskar_cmath.h"
+
+#include <cstring>
+
+static oskar_Mem* nufft_test_image(const char* algorithm, int size,
+        double fov, const oskar_Mem* uu, const oskar_Mem* vv,
+        const oskar_Mem* ww, const oskar_Mem* vis, const oskar_Mem* weight)
+{
+    int status = 0;
+    oskar_Mem* image = 0;
+    const int num_vis = (int) oskar_mem_length(uu);
+    oskar_Imager* h = oskar_imager_create(OSKAR_DOUBLE, &status);
+    oskar_imager_set_algorithm(h, algorithm, &status);
+    oskar_imager_set_fov(h, fov);
+    oskar_imager_set_size(h, size, &status);
+    oskar_imager_set_fft_on_gpu(h, 0);
+    oskar_imager_set_vis_frequency(h, 100e6, 0.0, 1);
+    if (!strcmp(algorithm, "NUFFT 3D"))
+    {
+        oskar_imager_set_coords_only(h, 1);
+        oskar_imager_update(h, num_vis, 0, 0, 1, uu, vv, ww, 0, weight,
+                0, &status);
+        oskar_imager_set_coords_only(h, 0);
+    }
+    oskar_imager_update(h, num_vis, 0, 0, 1, uu, vv, ww, vis, weight,
+            0, &status);
+    oskar_imager_finalise(h, 1, &image, 0, 0, &status);
+    oskar_imager_free(h, &status);
+    EXPECT_EQ(0, status);
+    return image;
+}
+
+
+static double nufft_test_error(const oskar_Mem* ref, const oskar_Mem* image)
+{
+    int status = 0;
+    double max_diff = 0.0, peak = 0.0;
+    const size_t num_pixels = oskar_mem_length(ref);
+    const double* x = oskar_mem_double_const(ref, &status);
+    const double* y = oskar_mem_double_const(image, &status);
+    for (size_t i = 0; i < num_pixels; ++i)
+    {
+        if (fabs(x[i]) > peak) peak = fabs(x[i]);
+        if (fabs(x[i] - y[i]) > max_diff) max_diff = fabs(x[i] - y[i]);
+    }
+    return max_diff / peak;
+}
+
+
+static void nufft_test_case(int size, double fov, double w_sigma)
+{
+    int status = 0, num_vis = 1000;
+    const double fov_rad = fov * M_PI / 180.0;
+
+    // Create baseline coordinates and weights.
+    oskar_Mem* uu = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 0.3 * size / fov_rad, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 0.3 * size / fov_rad, &status);
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, w_sigma, &status);
+    oskar_mem_random_uniform(weight, 12, 13, 14, 15, &status);
+    ASSERT_EQ(0, status);
+
+    // Generate visibilities from point sources anywhere in the field.
+    const double src[][2] = {
+            {0.1, -0.3}, {-0.45, 0.4}, {0.0, 0.0}, {0.49, 0.49}};
+    const double* u_ = oskar_mem_double_const(uu, &status);
+    const double* v_ = oskar_mem_double_const(vv, &status);
+    const double* w_ = oskar_mem_double_const(ww, &status);
+    double2* vis_ = oskar_mem_double2(vis, &status);
+    for (int i = 0; i < num_vis; ++i)
+    {
+        vis_[i].x = vis_[i].y = 0.0;
+        for (int s = 0; s < 4; ++s)
+        {
+            const double l = sin(src[s][0] * fov_rad);
+            const double m = sin(src[s][1] * fov_rad);
+            const double n = sqrt(1.0 - l * l - m * m);
+            const double phase = -2.0 * M_PI * (u_[i] * l + v_[i] * m +
+                    w_[i] * (n - 1.0));
+            vis_[i].x += cos(phase);
+            vis_[i].y += sin(phase);
+        }
+    }
+
+    // Check the 3D NUFFT matches the 3D DFT, where the FFT does not.
+    // Use the default kernel accuracy.
+    oskar_Mem* ref = nufft_test_image("DFT 3D", size, fov,
+            uu, vv, ww, vis, weight);
+    oskar_Mem* image = nufft_test_image("NUFFT 3D", size, fov,
+            uu, vv, ww, vis, weight);
+    EXPECT_LT(nufft_test_error(ref, image), 1e-6) << "FOV " << fov;
+    oskar_mem_free(image, &status);
+    image = nufft_test_image("FFT", size, fov, uu, vv, ww, vis, weight);
+    EXPECT_GT(nufft_test_error(ref, image), 1e-3) << "FOV " << fov;
+    oskar_mem_free(image, &status);
+    oskar_mem_free(ref, &status);
+
+    // Check the 2D NUFFT matches the 2D DFT.
+    ref = nufft_test_image("DFT 2D", size, fov, uu, vv, ww, vis, weight);
+    image = nufft_test_image("NUFFT 2D", size, fov, uu, vv, ww, vis, weight);
+    EXPECT_LT(nufft_test_error(ref, image), 1e-6) << "FOV " << fov;
+    oskar_mem_free(image, &status);
+    oskar_mem_free(ref, &status);
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+}
+
+
+TEST(imager, nufft)
+{
+    // Check a narrow field with large W-values, and then a wide field.
+    nufft_test_case(64, 2.0, 1000.0);
+    nufft_test_case(64, 60.0, 20.0);
+}
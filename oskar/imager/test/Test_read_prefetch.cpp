@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+#include "binary/oskar_binary.h"
+#include "vis/oskar_vis_block.h"
+#include "vis/oskar_vis_header.h"
+
+#include <cmath>
+#include <cstdio>
+
+TEST(imager, read_prefetch)
+{
+    int status = 0, size = 128;
+    const int num_stations = 12, num_channels = 3, num_times = 8;
+    const int max_times_per_block = 3;
+    const int num_blocks = (num_times + max_times_per_block - 1) /
+            max_times_per_block;
+    const char* filename = "temp_test_imager_read_prefetch.vis";
+
+    // Write a visibility file of several blocks in single precision,
+    // with the last block only partly filled.
+    oskar_VisHeader* hdr = oskar_vis_header_create(
+            OSKAR_SINGLE_COMPLEX_MATRIX, OSKAR_SINGLE, max_times_per_block,
+            num_times, num_channels, num_channels, num_stations, 0, 1,
+            &status);
+    oskar_vis_header_set_freq_start_hz(hdr, 100e6);
+    oskar_vis_header_set_freq_inc_hz(hdr, 1e6);
+    oskar_vis_header_set_time_start_mjd_utc(hdr, 51544.5);
+    oskar_vis_header_set_time_inc_sec(hdr, 10.0);
+    oskar_vis_header_set_phase_centre(hdr, 0, 20.0, -30.0);
+    oskar_Binary* file = oskar_vis_header_write(hdr, filename, &status);
+    oskar_VisBlock* blk = oskar_vis_block_create_from_header(OSKAR_CPU,
+            hdr, &status);
+    for (int b = 0; b < num_blocks; ++b)
+    {
+        int n = num_times - b * max_times_per_block;
+        if (n > max_times_per_block) n = max_times_per_block;
+        oskar_vis_block_set_start_time_index(blk, b * max_times_per_block);
+        oskar_vis_block_set_num_times(blk, n, &status);
+        oskar_mem_random_gaussian(oskar_vis_block_baseline_uu_metres(blk),
+                b, 1, 2, 3, 200.0, &status);
+        oskar_mem_random_gaussian(oskar_vis_block_baseline_vv_metres(blk),
+                b, 4, 5, 6, 200.0, &status);
+        oskar_mem_random_gaussian(oskar_vis_block_baseline_ww_metres(blk),
+                b, 7, 8, 9, 20.0, &status);
+        oskar_mem_random_gaussian(oskar_vis_block_cross_correlations(blk),
+                b, 10, 11, 12, 1.0, &status);
+        oskar_vis_block_write(blk, file, b, &status);
+    }
+    oskar_vis_block_free(blk, &status);
+    oskar_vis_header_free(hdr, &status);
+    oskar_binary_free(file);
+    ASSERT_EQ(0, status);
+
+    // Make images in double precision by running the imager, which reads
+    // blocks ahead of gridding, and by updating it with each block in turn.
+    oskar_Mem* images[2] = {0, 0};
+    for (int i = 0; i < 2; ++i)
+    {
+        oskar_Imager* im = oskar_imager_create(OSKAR_DOUBLE, &status);
+        oskar_imager_set_fov(im, 2.0);
+        oskar_imager_set_size(im, size, &status);
+        oskar_imager_set_fft_on_gpu(im, 0);
+        if (i == 0)
+        {
+            oskar_imager_set_input_files(im, 1, &filename, &status);
+            oskar_imager_run(im, 1, &images[i], 0, 0, &status);
+        }
+        else
+        {
+            file = oskar_binary_create(filename, 'r', &status);
+            hdr = oskar_vis_header_read(file, &status);
+            blk = oskar_vis_block_create_from_header(OSKAR_CPU, hdr, &status);
+            for (int b = 0; b < num_blocks; ++b)
+            {
+                oskar_vis_block_read(blk, hdr, file, b, &status);
+                oskar_imager_update_from_block(im, hdr, blk, &status);
+            }
+            oskar_imager_finalise(im, 1, &images[i], 0, 0, &status);
+            oskar_vis_block_free(blk, &status);
+            oskar_vis_header_free(hdr, &status);
+            oskar_binary_free(file);
+        }
+        oskar_imager_free(im, &status);
+        ASSERT_EQ(0, status);
+    }
+
+    // Check the images are identical, and not empty.
+    ASSERT_EQ((size_t)(size * size), oskar_mem_length(images[0]));
+    const double* pix = oskar_mem_double_const(images[0], &status);
+    double peak = 0.0;
+    for (int j = 0; j < size * size; ++j)
+        if (fabs(pix[j]) > peak) peak = fabs(pix[j]);
+    EXPECT_GT(peak, 0.0);
+    EXPECT_FALSE(oskar_mem_different(images[0], images[1], 0, &status));
+
+    // Clean up.
+    oskar_mem_free(images[0], &status);
+    oskar_mem_free(images[1], &status);
+    remove(filename);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "math/oskar_cmath.h"
+#include "imager/oskar_imager.h"
+
+#include <vector>
+
+TEST(imager, time_snapshots)
+{
+    int status = 0, size = 64, num_vis = 3000, num_times = 3;
+    const double fov = 2.0, fov_rad = fov * M_PI / 180.0;
+    const double t0 = 51544.0, interval = 10.0;
+
+    // Create visibility data, with each sample in one of three intervals.
+    oskar_Mem* uu = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* weight = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_vis, &status);
+    oskar_Mem* time = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU,
+            num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 0.3 * size / fov_rad, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 0.3 * size / fov_rad, &status);
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 10.0, &status);
+    oskar_mem_random_gaussian(vis, 12, 13, 14, 15, 1.0, &status);
+    oskar_mem_random_uniform(weight, 16, 17, 18, 19, &status);
+    double* time_ = oskar_mem_double(time, &status);
+    for (int i = 0; i < num_vis; ++i)
+        time_[i] = t0 * 86400.0 + (i % num_times + 0.5) * interval;
+    ASSERT_EQ(0, status);
+
+    // Make all the snapshots in a single pass.
+    std::vector<oskar_Mem*> snapshots(num_times, (oskar_Mem*) 0);
+    oskar_Imager* h = oskar_imager_create(OSKAR_DOUBLE, &status);
+    oskar_imager_set_fov(h, fov);
+    oskar_imager_set_size(h, size, &status);
+    oskar_imager_set_fft_on_gpu(h, 0);
+    oskar_imager_set_vis_frequency(h, 100e6, 0.0, 1);
+    oskar_imager_set_vis_time(h, t0, interval, num_times);
+    oskar_imager_set_time_snapshot_interval_sec(h, interval);
+    oskar_imager_update(h, num_vis, 0, 0, 1, uu, vv, ww, vis, weight,
+            time, &status);
+    oskar_imager_finalise(h, num_times, &snapshots[0], 0, 0, &status);
+    oskar_imager_free(h, &status);
+    ASSERT_EQ(0, status);
+
+    // Check each snapshot matches an image of its own interval.
+    for (int t = 0; t < num_times; ++t)
+    {
+        int n = 0;
+        const int m = num_vis / num_times;
+        oskar_Mem* image = 0;
+        oskar_Mem* su = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, m, &status);
+        oskar_Mem* sv = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, m, &status);
+        oskar_Mem* sw = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, m, &status);
+        oskar_Mem* sx = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+                m, &status);
+        oskar_Mem* sy = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, m, &status);
+        for (int i = t; i < num_vis; i += num_times, ++n)
+        {
+            oskar_mem_copy_contents(su, uu, n, i, 1, &status);
+            oskar_mem_copy_contents(sv, vv, n, i, 1, &status);
+            oskar_mem_copy_contents(sw, ww, n, i, 1, &status);
+            oskar_mem_copy_contents(sx, vis, n, i, 1, &status);
+            oskar_mem_copy_contents(sy, weight, n, i, 1, &status);
+        }
+        h = oskar_imager_create(OSKAR_DOUBLE, &status);
+        oskar_imager_set_fov(h, fov);
+        oskar_imager_set_size(h, size, &status);
+        oskar_imager_set_fft_on_gpu(h, 0);
+        oskar_imager_set_vis_frequency(h, 100e6, 0.0, 1);
+        oskar_imager_update(h, n, 0, 0, 1, su, sv, sw, sx, sy, 0, &status);
+        oskar_imager_finalise(h, 1, &image, 0, 0, &status);
+        oskar_imager_free(h, &status);
+        ASSERT_EQ(0, status);
+        EXPECT_FALSE(oskar_mem_different(image, snapshots[t], 0,
+                &status));
+        oskar_mem_free(image, &status);
+        oskar_mem_free(snapshots[t], &status);
+        oskar_mem_free(su, &status);
+        oskar_mem_free(sv, &status);
+        oskar_mem_free(sw, &status);
+        oskar_mem_free(sx, &status);
+        oskar_mem_free(sy, &status);
+    }
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+    oskar_mem_free(time, &status);
+}
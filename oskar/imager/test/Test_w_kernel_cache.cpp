@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include "imager/oskar_imager.h"
+
+TEST(imager, w_kernel_cache)
+{
+    int status = 0, type = OSKAR_DOUBLE, size = 128, num_vis = 2000;
+
+    // Create visibility data.
+    oskar_Mem* uu = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vv = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* ww = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_Mem* vis = oskar_mem_create(type | OSKAR_COMPLEX, OSKAR_CPU, num_vis,
+            &status);
+    oskar_Mem* weight = oskar_mem_create(type, OSKAR_CPU, num_vis, &status);
+    oskar_mem_random_gaussian(uu, 0, 1, 2, 3, 50.0, &status);
+    oskar_mem_random_gaussian(vv, 4, 5, 6, 7, 50.0, &status);
+    oskar_mem_random_gaussian(ww, 8, 9, 10, 11, 150.0, &status);
+    oskar_mem_set_value_real(vis, 1.0, 0, num_vis, &status);
+    oskar_mem_set_value_real(weight, 1.0, 0, num_vis, &status);
+    ASSERT_EQ(0, status);
+
+    // Grid the data twice using W-projection: the first run generates
+    // the kernels and saves them, and the second run loads them.
+    oskar_Mem* grid[2];
+    double plane_norm[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        oskar_Imager* im = oskar_imager_create(type, &status);
+        oskar_imager_set_algorithm(im, "W-projection", &status);
+        oskar_imager_set_fov(im, 10.0);
+        oskar_imager_set_size(im, size, &status);
+        oskar_imager_set_num_w_planes(im, 16);
+        oskar_imager_set_generate_w_kernels_on_gpu(im, 0);
+        oskar_imager_set_w_kernel_cache_dir(im, ".");
+        grid[i] = oskar_mem_create(oskar_imager_plane_type(im), OSKAR_CPU,
+                0, &status);
+        plane_norm[i] = 0.0;
+        oskar_imager_update_plane(im, num_vis, uu, vv, ww, vis, weight,
+                grid[i], &plane_norm[i], 0, &status);
+        oskar_imager_free(im, &status);
+        ASSERT_EQ(0, status);
+    }
+
+    // Check the grids are identical.
+    EXPECT_DOUBLE_EQ(plane_norm[0], plane_norm[1]);
+    ASSERT_EQ(oskar_mem_length(grid[0]), oskar_mem_length(grid[1]));
+    const double2* g0 = oskar_mem_double2_const(grid[0], &status);
+    const double2* g1 = oskar_mem_double2_const(grid[1], &status);
+    size_t num_different = 0;
+    for (size_t i = 0; i < oskar_mem_length(grid[0]); ++i)
+        if (g0[i].x != g1[i].x || g0[i].y != g1[i].y) num_different++;
+    EXPECT_EQ(0u, num_different);
+
+    // Clean up.
+    oskar_mem_free(uu, &status);
+    oskar_mem_free(vv, &status);
+    oskar_mem_free(ww, &status);
+    oskar_mem_free(vis, &status);
+    oskar_mem_free(weight, &status);
+    oskar_mem_free(grid[0], &status);
+    oskar_mem_free(grid[1], &status);
+}
@@ -91,6 +91,30 @@ void oskar_interferometer_run_block(oskar_Interferometer* h, int block_index,
 OSKAR_EXPORT
 void oskar_interferometer_run(oskar_Interferometer* h, int* status);
 
+/**
+ * @brief
+ * Sets the number of time samples between station beam evaluations.
+ *
+ * @details
+ * If greater than 1, station beams are evaluated only at every
+ * \p value time samples (the interpolation nodes), and the complex
+ * Jones matrices at intermediate times are obtained by linear interpolation
+ * between the two nodes either side. Where a source is below the horizon
+ * at one of the nodes, the beam at the other node is used. The beam is
+ * evaluated in full once per visibility block and channel at the centre of
+ * an interval, and the largest error found relative to the beam peak is
+ * reported in the log.
+ *
+ * This is only a good approximation if the beam varies slowly over
+ * the interval between nodes.
+ *
+ * @param[in] h     Handle to simulator.
+ * @param[in] value Number of time samples between beam nodes (default 1).
+ */
+OSKAR_EXPORT
+void oskar_interferometer_set_beam_interp_factor(oskar_Interferometer* h,
+        int value);
+
 OSKAR_EXPORT
 void oskar_interferometer_set_coords_only(oskar_Interferometer* h, int value,
         int* status);
@@ -144,6 +168,38 @@ OSKAR_EXPORT
 void oskar_interferometer_set_settings_path(oskar_Interferometer* h,
         const char* filename);
 
+/**
+ * @brief
+ * Sets a model image of the sky, to be predicted using FFT degridding.
+ *
+ * @details
+ * Sets a model image of the sky, which is simulated by taking its Fourier
+ * transform and degridding it at each baseline coordinate, instead of
+ * treating each pixel as a point source. This is much faster than the
+ * direct method for large images of diffuse emission.
+ *
+ * The image must be square, in Jy/pixel, and contain Stokes I only.
+ * It must be centred on the phase centre, using the same pixel ordering as
+ * images made by the imager. As the image is not multiplied by the station
+ * beams, it should contain the apparent sky brightness.
+ * Predicted visibilities are added to the cross-correlations of each block,
+ * and are not affected by bandwidth or time-average smearing.
+ *
+ * The algorithm must be either "FFT" or "W-projection".
+ * Set \p image to NULL to clear a previously set image.
+ *
+ * @param[in] h               Handle to simulator.
+ * @param[in] image           Model image, length image_size * image_size.
+ * @param[in] image_size      Side length of the image.
+ * @param[in] cellsize_arcsec Pixel size, in arcseconds.
+ * @param[in] algorithm       Algorithm used to predict visibilities.
+ * @param[in,out] status      Status return code.
+ */
+OSKAR_EXPORT
+void oskar_interferometer_set_sky_image(oskar_Interferometer* h,
+        const oskar_Mem* image, int image_size, double cellsize_arcsec,
+        const char* algorithm, int* status);
+
 OSKAR_EXPORT
 void oskar_interferometer_set_sky_model(oskar_Interferometer* h,
         const oskar_Sky* sky, int* status);
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_JONES_INTERPOLATE_H_
+#define OSKAR_JONES_INTERPOLATE_H_
+
+/**
+ * @file oskar_jones_interpolate.h
+ */
+
+#include <oskar_global.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Linearly interpolates between two sets of Jones matrices.
+ *
+ * @details
+ * This function evaluates J = (1 - frac) * J0 + frac * J1 for every
+ * element of the two input sets, operating separately on the real and
+ * imaginary parts of each matrix component.
+ *
+ * It is used to obtain station beams at times between two coarser
+ * evaluation nodes, where the beam varies slowly with time.
+ *
+ * If every component of a Jones matrix is zero at one node (as it is when
+ * the source is below the horizon there), the matrix at the other node
+ * is used instead, so that beams are not interpolated towards zero as a
+ * source rises or sets.
+ *
+ * The dimensions (number of sources, number of stations), data types and
+ * memory locations of all three Jones structures must be the same.
+ *
+ * @param[out] out    Output set of Jones matrices.
+ * @param[in]  j0     Jones matrices at the first node (frac = 0).
+ * @param[in]  j1     Jones matrices at the second node (frac = 1).
+ * @param[in]  frac   Fractional distance between the nodes.
+ * @param[in,out] status   Status return code.
+ */
+OSKAR_EXPORT
+void oskar_jones_interpolate(oskar_Jones* out, const oskar_Jones* j0,
+        const oskar_Jones* j1, double frac, int* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_JONES_INTERPOLATE_H_ */
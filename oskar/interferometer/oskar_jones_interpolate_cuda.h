@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_JONES_INTERPOLATE_CUDA_H_
+#define OSKAR_JONES_INTERPOLATE_CUDA_H_
+
+/**
+ * @file oskar_jones_interpolate_cuda.h
+ */
+
+#include <oskar_global.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Linearly interpolates between two real arrays using CUDA
+ * (single precision).
+ *
+ * Where every value of a Jones element is zero in one array, the values
+ * from the other array are used.
+ *
+ * @param[in]  num    Number of real values in each array.
+ * @param[in]  stride Number of real values in each Jones element.
+ * @param[in]  frac   Fractional distance between the arrays.
+ * @param[in]  d_a    First input array (frac = 0).
+ * @param[in]  d_b    Second input array (frac = 1).
+ * @param[out] d_out  Output array.
+ */
+OSKAR_EXPORT
+void oskar_jones_interpolate_cuda_f(int num, int stride, float frac,
+        const float* d_a, const float* d_b, float* d_out);
+
+/**
+ * @brief
+ * Linearly interpolates between two real arrays using CUDA
+ * (double precision).
+ *
+ * Where every value of a Jones element is zero in one array, the values
+ * from the other array are used.
+ *
+ * @param[in]  num    Number of real values in each array.
+ * @param[in]  stride Number of real values in each Jones element.
+ * @param[in]  frac   Fractional distance between the arrays.
+ * @param[in]  d_a    First input array (frac = 0).
+ * @param[in]  d_b    Second input array (frac = 1).
+ * @param[out] d_out  Output array.
+ */
+OSKAR_EXPORT
+void oskar_jones_interpolate_cuda_d(int num, int stride, double frac,
+        const double* d_a, const double* d_b, double* d_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_JONES_INTERPOLATE_CUDA_H_ */
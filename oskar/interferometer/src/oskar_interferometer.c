@@ -30,8 +30,10 @@
 #include "convert/oskar_convert_ecef_to_station_uvw.h"
 #include "convert/oskar_convert_ecef_to_baseline_uvw.h"
 #include "convert/oskar_convert_mjd_to_gast_fast.h"
+#include "convert/oskar_convert_relative_directions_to_enu_directions.h"
 #include "correlate/oskar_auto_correlate.h"
 #include "correlate/oskar_cross_correlate.h"
+#include "imager/oskar_imager.h"
 #include "interferometer/oskar_evaluate_jones_R.h"
 #include "interferometer/oskar_evaluate_jones_Z.h"
 #include "interferometer/oskar_evaluate_jones_E.h"
@@ -41,6 +43,8 @@
 #include "log/oskar_log.h"
 #include "sky/oskar_sky.h"
 #include "telescope/oskar_telescope.h"
+#include "telescope/station/oskar_blank_below_horizon.h"
+#include "telescope/station/oskar_evaluate_element_weights_block.h"
 #include "utility/oskar_cuda_mem_log.h"
 #include "utility/oskar_device_utils.h"
 #include "utility/oskar_get_memory_usage.h"
@@ -79,6 +83,8 @@ struct DeviceData
     oskar_Sky* chunk_clip;      /* Copy of the chunk after horizon clipping. */
     oskar_Telescope* tel;       /* Telescope model, created as a copy. */
     oskar_Jones *J, *R, *E, *K, *Z;
+    oskar_Jones *E_node[2];     /* Station beams at interpolation nodes. */
+    oskar_Jones *E_check;       /* Exact station beam for accuracy check. */
     oskar_StationWork* station_work;
 
     /* Timers. */
@@ -99,13 +105,14 @@ struct oskar_Interferometer
     int prec, num_devices, num_gpus, *gpu_ids, num_channels, num_time_steps;
     int max_sources_per_chunk, max_times_per_block;
     int apply_horizon_clip, force_polarised_ms, zero_failed_gaussians;
-    int coords_only;
+    int coords_only, beam_interp_factor;
     double freq_start_hz, freq_inc_hz, time_start_mjd_utc, time_inc_sec;
     double source_min_jy, source_max_jy;
     char correlation_type, *vis_name, *ms_name, *settings_path;
 
     /* State. */
     int init_sky, work_unit_index, status;
+    double beam_interp_max_error;
     oskar_Mutex* mutex;
     oskar_Barrier* barrier;
 
@@ -114,6 +121,10 @@ struct oskar_Interferometer
     oskar_Sky** sky_chunks;
     oskar_Telescope* tel;
 
+    /* Model image of the sky, predicted by degridding its FFT. */
+    oskar_Imager* sky_image;
+    oskar_Mem *pred_uu, *pred_vv, *pred_ww, *pred_vis;
+
     /* Output data and file handles. */
     oskar_Log* log;
     oskar_VisHeader* header;
@@ -136,7 +147,23 @@ typedef struct oskar_Interferometer oskar_Interferometer;
 
 static void sim_baselines(oskar_Interferometer* h, DeviceData* d,
         oskar_Sky* sky, int channel_index_block, int time_index_block,
+        int time_index_simulation, int beam_ready, int* status);
+static void sim_interp_work_unit(oskar_Interferometer* h, DeviceData* d,
+        int i_chunk, int i_channel, int time_index_start, int time_index_end,
+        int device_id, int* status);
+static void sim_station_beams(oskar_Interferometer* h, DeviceData* d,
+        oskar_Sky* sky, oskar_Jones* E, int channel_index_block,
         int time_index_simulation, int* status);
+static void sim_station_weights(oskar_Interferometer* h, DeviceData* d,
+        int time_index_start, int time_index_end, int* status);
+static void blank_below_horizon(oskar_Interferometer* h, DeviceData* d,
+        const oskar_Sky* sky, oskar_Jones* E, int time_index_simulation,
+        int* status);
+static double beam_interp_error(const oskar_Jones* approx,
+        const oskar_Jones* exact, int* status);
+static void init_sky_image(oskar_Interferometer* h, int* status);
+static void predict_sky_image(oskar_Interferometer* h, oskar_VisBlock* block,
+        int* status);
 static void free_device_data(oskar_Interferometer* h, int* status);
 static void set_up_device_data(oskar_Interferometer* h, int* status);
 static void set_up_vis_header(oskar_Interferometer* h, int* status);
@@ -192,6 +219,7 @@ void oskar_interferometer_check_init(oskar_Interferometer* h, int* status)
                         "for %i sources. These will be simulated "
                         "as point sources.", num_failed);
         }
+        init_sky_image(h, status);
         h->init_sky = 1;
     }
 
@@ -225,6 +253,7 @@ oskar_Interferometer* oskar_interferometer_create(int precision, int* status)
     oskar_interferometer_set_horizon_clip(h, 1);
     oskar_interferometer_set_source_flux_range(h, -DBL_MAX, DBL_MAX);
     oskar_interferometer_set_max_times_per_block(h, 10);
+    oskar_interferometer_set_beam_interp_factor(h, 1);
     return h;
 }
 
@@ -279,6 +308,10 @@ oskar_VisBlock* oskar_interferometer_finalise_block(oskar_Interferometer* h,
                 oskar_vis_block_baseline_ww_metres(b0), h->temp, status);
     }
 
+    /* Add visibilities predicted from the sky model image, if set. */
+    if (!h->coords_only && h->sky_image)
+        predict_sky_image(h, b0, status);
+
     /* Add uncorrelated system noise to the combined visibilities. */
     if (!h->coords_only)
     {
@@ -310,6 +343,11 @@ void oskar_interferometer_free(oskar_Interferometer* h, int* status)
     for (i = 0; i < h->num_sky_chunks; ++i)
         oskar_sky_free(h->sky_chunks[i], status);
     oskar_telescope_free(h->tel, status);
+    oskar_imager_free(h->sky_image, status);
+    oskar_mem_free(h->pred_uu, status);
+    oskar_mem_free(h->pred_vv, status);
+    oskar_mem_free(h->pred_ww, status);
+    oskar_mem_free(h->pred_vis, status);
     oskar_mem_free(h->temp, status);
     oskar_timer_free(h->tmr_sim);
     oskar_timer_free(h->tmr_write);
@@ -368,7 +406,7 @@ void oskar_interferometer_run_block(oskar_Interferometer* h, int block_index,
         int device_id, int* status)
 {
     double obs_start_mjd, dt_dump_days;
-    int i_active, time_index_start, time_index_end;
+    int i_active, time_index_start, time_index_end, interp, num_work_units;
     int num_channels, num_times_block, total_chunks, total_times;
     DeviceData* d;
     if (*status) return;
@@ -410,7 +448,26 @@ void oskar_interferometer_run_block(oskar_Interferometer* h, int block_index,
     oskar_vis_block_set_start_time_index(d->vis_block, time_index_start);
 
     /* Go though all possible work units in the block. A work unit is defined
-     * as the simulation for one time and one sky chunk. */
+     * as the simulation for one time and one sky chunk.
+     * With station beam interpolation, a work unit is instead one sky chunk
+     * and one channel for all times in the block, so that the beam at the
+     * end of each interval between nodes is reused at the start of the
+     * next one. */
+    interp = h->beam_interp_factor > 1 ? h->beam_interp_factor : 1;
+    num_work_units = total_chunks *
+            (interp > 1 ? num_channels : num_times_block);
+
+    /* Evaluate beamforming weights for all times (and beam nodes) and
+     * channels in the block, so they can be reused by all work units. */
+    if (!h->coords_only)
+    {
+        if (interp > 1)
+            sim_station_weights(h, d, (time_index_start / interp) * interp,
+                    (time_index_end / interp + 1) * interp, status);
+        else
+            sim_station_weights(h, d, time_index_start, time_index_end,
+                    status);
+    }
     while (!h->coords_only)
     {
         oskar_Sky* sky;
@@ -419,7 +476,17 @@ void oskar_interferometer_run_block(oskar_Interferometer* h, int block_index,
         oskar_mutex_lock(h->mutex);
         i_work_unit = (h->work_unit_index)++;
         oskar_mutex_unlock(h->mutex);
-        if ((i_work_unit >= num_times_block * total_chunks) || *status) break;
+        if ((i_work_unit >= num_work_units) || *status) break;
+
+        /* Simulate all times in the block for one chunk and channel. */
+        if (interp > 1)
+        {
+            i_chunk   = i_work_unit / num_channels;
+            i_channel = i_work_unit - i_chunk * num_channels;
+            sim_interp_work_unit(h, d, i_chunk, i_channel, time_index_start,
+                    time_index_end, device_id, status);
+            continue;
+        }
 
         /* Convert slice index to chunk/time index. */
         i_chunk      = i_work_unit / num_times_block;
@@ -462,7 +529,8 @@ void oskar_interferometer_run_block(oskar_Interferometer* h, int block_index,
                         device_id, oskar_sky_num_sources(sky));
                 oskar_mutex_unlock(h->mutex);
             }
-            sim_baselines(h, d, sky, i_channel, i_time, sim_time_idx, status);
+            sim_baselines(h, d, sky, i_channel, i_time, sim_time_idx, 0,
+                    status);
         }
         d->previous_chunk_index = i_chunk;
     }
@@ -597,6 +665,7 @@ void oskar_interferometer_run(oskar_Interferometer* h, int* status)
 
     /* Start simulation timer. */
     oskar_timer_start(h->tmr_sim);
+    h->beam_interp_max_error = 0.0;
 
     /* Set status code. */
     h->status = *status;
@@ -688,6 +757,17 @@ void oskar_interferometer_run(oskar_Interferometer* h, int* status)
 }
 
 
+void oskar_interferometer_set_beam_interp_factor(oskar_Interferometer* h,
+        int value)
+{
+    int status = 0;
+    if (value < 1) value = 1;
+    if (value == h->beam_interp_factor) return;
+    free_device_data(h, &status);
+    h->beam_interp_factor = value;
+}
+
+
 void oskar_interferometer_set_coords_only(oskar_Interferometer* h, int value,
         int* status)
 {
@@ -828,6 +908,40 @@ void oskar_interferometer_set_settings_path(oskar_Interferometer* h,
 }
 
 
+void oskar_interferometer_set_sky_image(oskar_Interferometer* h,
+        const oskar_Mem* image, int image_size, double cellsize_arcsec,
+        const char* algorithm, int* status)
+{
+    if (*status || !h) return;
+
+    /* Clear any old image. */
+    oskar_imager_free(h->sky_image, status);
+    h->sky_image = 0;
+    if (!image) return;
+
+    /* Set up an imager to predict visibilities from the image. */
+    h->sky_image = oskar_imager_create(h->prec, status);
+    oskar_imager_set_algorithm(h->sky_image, algorithm, status);
+    oskar_imager_set_fft_on_gpu(h->sky_image, 0);
+    oskar_imager_set_generate_w_kernels_on_gpu(h->sky_image, 0);
+    oskar_imager_set_image_size(h->sky_image, image_size, status);
+    oskar_imager_set_cellsize(h->sky_image, cellsize_arcsec);
+    oskar_imager_set_model_image(h->sky_image, image, status);
+    h->init_sky = 0;
+
+    /* Print summary data. */
+    if (h->log)
+    {
+        oskar_log_section(h->log, 'M', "Sky model image summary");
+        oskar_log_value(h->log, 'M', 0, "Image size", "%d", image_size);
+        oskar_log_value(h->log, 'M', 0, "Cellsize [arcsec]", "%.3f",
+                cellsize_arcsec);
+        oskar_log_value(h->log, 'M', 0, "Algorithm", "%s",
+                oskar_imager_algorithm(h->sky_image));
+    }
+}
+
+
 void oskar_interferometer_set_sky_model(oskar_Interferometer* h,
         const oskar_Sky* sky, int* status)
 {
@@ -960,7 +1074,7 @@ void oskar_interferometer_write_block(oskar_Interferometer* h,
 
 static void sim_baselines(oskar_Interferometer* h, DeviceData* d,
         oskar_Sky* sky, int channel_index_block, int time_index_block,
-        int time_index_simulation, int* status)
+        int time_index_simulation, int beam_ready, int* status)
 {
     int num_baselines, num_stations, num_src, num_times_block, num_channels;
     double dt_dump_days, t_start, t_dump, gast, frequency, ra0, dec0;
@@ -1003,15 +1117,13 @@ static void sim_baselines(oskar_Interferometer* h, DeviceData* d,
     if (d->Z)
         oskar_jones_set_size(d->Z, num_stations, num_src, status);
     oskar_jones_set_size(d->J, num_stations, num_src, status);
-    oskar_jones_set_size(d->E, num_stations, num_src, status);
     oskar_jones_set_size(d->K, num_stations, num_src, status);
 
-    /* Evaluate station beam (Jones E: may be matrix). */
-    oskar_timer_resume(d->tmr_E);
-    oskar_evaluate_jones_E(d->E, num_src, OSKAR_RELATIVE_DIRECTIONS,
-            oskar_sky_l(sky), oskar_sky_m(sky), oskar_sky_n(sky), d->tel,
-            gast, frequency, d->station_work, time_index_simulation, status);
-    oskar_timer_pause(d->tmr_E);
+    /* Evaluate station beam (Jones E: may be matrix), unless it has
+     * already been obtained by interpolation. */
+    if (!beam_ready)
+        sim_station_beams(h, d, sky, d->E, channel_index_block,
+                time_index_simulation, status);
 
 #if 0
     /* Evaluate ionospheric phase (Jones Z: scalar) and join with Jones E.
@@ -1086,6 +1198,449 @@ static void sim_baselines(oskar_Interferometer* h, DeviceData* d,
 }
 
 
+static void sim_interp_work_unit(oskar_Interferometer* h, DeviceData* d,
+        int i_chunk, int i_channel, int time_index_start, int time_index_end,
+        int device_id, int* status)
+{
+    oskar_Sky* sky;
+    oskar_Jones* E_swap;
+    int t, node, interp, check_time, num_src, total_chunks, total_times;
+
+    /* Copy sky chunk to device only if different from the previous one. */
+    if (i_chunk != d->previous_chunk_index)
+    {
+        oskar_timer_resume(d->tmr_copy);
+        oskar_sky_copy(d->chunk, h->sky_chunks[i_chunk], status);
+        oskar_timer_pause(d->tmr_copy);
+    }
+    d->previous_chunk_index = i_chunk;
+    sky = h->apply_horizon_clip ? d->chunk_clip : d->chunk;
+
+    /* Apply horizon clip if required.
+     * The same sources must be used for the beams at every node, so keep
+     * those above the horizon at any time in the block. */
+    if (h->apply_horizon_clip)
+    {
+        int i, num_times;
+        double* gast;
+        num_times = 1 + time_index_end - time_index_start;
+        gast = (double*) malloc(num_times * sizeof(double));
+        for (i = 0; i < num_times; ++i)
+            gast[i] = oskar_convert_mjd_to_gast_fast(h->time_start_mjd_utc +
+                    (h->time_inc_sec / 86400.0) *
+                    (time_index_start + i + 0.5));
+        oskar_timer_resume(d->tmr_clip);
+        oskar_sky_horizon_clip_times(d->chunk_clip, d->chunk, d->tel,
+                num_times, gast, d->station_work, status);
+        oskar_timer_pause(d->tmr_clip);
+        free(gast);
+    }
+
+    /* Check accuracy against a full evaluation at the centre of the first
+     * interval in the block, once for every channel. */
+    interp = h->beam_interp_factor;
+    check_time = (time_index_start / interp) * interp + interp / 2;
+    if (check_time < time_index_start) check_time += interp;
+    if (i_chunk != 0) check_time = -1;
+
+    /* Simulate all baselines for all times for this channel and chunk. */
+    num_src = oskar_sky_num_sources(sky);
+    total_chunks = h->num_sky_chunks;
+    total_times = h->num_time_steps;
+    for (t = time_index_start, node = -1; t <= time_index_end; ++t)
+    {
+        if (*status) break;
+        if (h->log)
+        {
+            oskar_mutex_lock(h->mutex);
+            oskar_log_message(h->log, 'S', 1, "Time %*i/%i, "
+                    "Chunk %*i/%i, Channel %*i/%i [Device %i, %i sources]",
+                    disp_width(total_times), t + 1, total_times,
+                    disp_width(total_chunks), i_chunk + 1, total_chunks,
+                    disp_width(h->num_channels), i_channel + 1,
+                    h->num_channels, device_id, num_src);
+            oskar_mutex_unlock(h->mutex);
+        }
+        if (num_src > 0)
+        {
+            /* Evaluate station beams at the nodes either side of this time.
+             * The end node of the previous interval is the start node of
+             * this one, so only one new beam is needed. */
+            if (node != (t / interp) * interp)
+            {
+                if (node >= 0)
+                {
+                    E_swap = d->E_node[0];
+                    d->E_node[0] = d->E_node[1];
+                    d->E_node[1] = E_swap;
+                }
+                else
+                    sim_station_beams(h, d, sky, d->E_node[0], i_channel,
+                            (t / interp) * interp, status);
+                node = (t / interp) * interp;
+                sim_station_beams(h, d, sky, d->E_node[1], i_channel,
+                        node + interp, status);
+            }
+
+            /* Interpolate station beams between the nodes. */
+            oskar_timer_resume(d->tmr_E);
+            oskar_jones_set_size(d->E,
+                    oskar_jones_num_stations(d->E_node[0]),
+                    oskar_jones_num_sources(d->E_node[0]), status);
+            oskar_jones_interpolate(d->E, d->E_node[0], d->E_node[1],
+                    (double)(t - node) / interp, status);
+            blank_below_horizon(h, d, sky, d->E, t, status);
+            oskar_timer_pause(d->tmr_E);
+            if (t == check_time)
+            {
+                double error;
+                sim_station_beams(h, d, sky, d->E_check, i_channel,
+                        t, status);
+                error = beam_interp_error(d->E, d->E_check, status);
+                oskar_mutex_lock(h->mutex);
+                if (error > h->beam_interp_max_error)
+                    h->beam_interp_max_error = error;
+                oskar_mutex_unlock(h->mutex);
+            }
+        }
+        sim_baselines(h, d, sky, i_channel, t - time_index_start, t, 1,
+                status);
+    }
+}
+
+
+static void sim_station_beams(oskar_Interferometer* h, DeviceData* d,
+        oskar_Sky* sky, oskar_Jones* E, int channel_index_block,
+        int time_index_simulation, int* status)
+{
+    int num_src;
+    double t_dump, gast, frequency;
+
+    /* Get the time and frequency of the beam being evaluated. */
+    num_src = oskar_sky_num_sources(sky);
+    t_dump = h->time_start_mjd_utc +
+            (h->time_inc_sec / 86400.0) * (time_index_simulation + 0.5);
+    gast = oskar_convert_mjd_to_gast_fast(t_dump);
+    frequency = h->freq_start_hz + channel_index_block * h->freq_inc_hz;
+
+    /* Evaluate station beam (Jones E: may be matrix). */
+    oskar_jones_set_size(E, oskar_telescope_num_stations(d->tel), num_src,
+            status);
+    oskar_timer_resume(d->tmr_E);
+    oskar_evaluate_jones_E(E, num_src, OSKAR_RELATIVE_DIRECTIONS,
+            oskar_sky_l(sky), oskar_sky_m(sky), oskar_sky_n(sky), d->tel,
+            gast, frequency, d->station_work, time_index_simulation, status);
+    oskar_timer_pause(d->tmr_E);
+}
+
+
+static void sim_station_weights(oskar_Interferometer* h, DeviceData* d,
+        int time_index_start, int time_index_end, int* status)
+{
+    int i, num_stations, num_times;
+    double *gast, *frequency;
+
+    /* Get the times and frequencies of the block. */
+    num_times = 1 + time_index_end - time_index_start;
+    gast = (double*) malloc(num_times * sizeof(double));
+    frequency = (double*) malloc(h->num_channels * sizeof(double));
+    for (i = 0; i < num_times; ++i)
+        gast[i] = oskar_convert_mjd_to_gast_fast(h->time_start_mjd_utc +
+                (h->time_inc_sec / 86400.0) * (time_index_start + i + 0.5));
+    for (i = 0; i < h->num_channels; ++i)
+        frequency[i] = h->freq_start_hz + i * h->freq_inc_hz;
+
+    /* Only station 0 is evaluated if the station beams are duplicated. */
+    num_stations = oskar_telescope_num_stations(d->tel);
+    if (oskar_telescope_allow_station_beam_duplication(d->tel) &&
+            oskar_telescope_identical_stations(d->tel))
+        num_stations = 1;
+
+    /* Evaluate the beamforming weights. */
+    oskar_timer_resume(d->tmr_E);
+    oskar_evaluate_element_weights_block(d->station_work, d->tel,
+            num_stations, 0, h->num_channels, frequency, time_index_start,
+            num_times, gast, status);
+    oskar_timer_pause(d->tmr_E);
+    free(gast);
+    free(frequency);
+}
+
+
+static void blank_below_horizon(oskar_Interferometer* h, DeviceData* d,
+        const oskar_Sky* sky, oskar_Jones* E, int time_index_simulation,
+        int* status)
+{
+    int i, num_src, num_stations;
+    double t_dump, gast, ra0, dec0;
+    oskar_Mem *x, *y, *z, *E_st;
+    if (*status) return;
+
+    /* Get the time of the beams. */
+    num_src = oskar_sky_num_sources(sky);
+    num_stations = oskar_telescope_num_stations(d->tel);
+    t_dump = h->time_start_mjd_utc +
+            (h->time_inc_sec / 86400.0) * (time_index_simulation + 0.5);
+    gast = oskar_convert_mjd_to_gast_fast(t_dump);
+    ra0 = oskar_sky_reference_ra_rad(sky);
+    dec0 = oskar_sky_reference_dec_rad(sky);
+
+    /* Resize work arrays if needed. */
+    x = oskar_station_work_enu_direction_x(d->station_work);
+    y = oskar_station_work_enu_direction_y(d->station_work);
+    z = oskar_station_work_enu_direction_z(d->station_work);
+    if ((int)oskar_mem_length(x) < num_src)
+        oskar_mem_realloc(x, num_src, status);
+    if ((int)oskar_mem_length(y) < num_src)
+        oskar_mem_realloc(y, num_src, status);
+    if ((int)oskar_mem_length(z) < num_src)
+        oskar_mem_realloc(z, num_src, status);
+
+    /* Zero interpolated beams for sources below each station's horizon. */
+    E_st = oskar_mem_create_alias(0, 0, 0, status);
+    for (i = 0; i < num_stations; ++i)
+    {
+        const oskar_Station* s = oskar_telescope_station_const(d->tel, i);
+        oskar_convert_relative_directions_to_enu_directions(x, y, z, num_src,
+                oskar_sky_l_const(sky), oskar_sky_m_const(sky),
+                oskar_sky_n_const(sky),
+                (gast + oskar_station_lon_rad(s)) - ra0, dec0,
+                oskar_station_lat_rad(s), status);
+        oskar_jones_get_station_pointer(E_st, E, i, status);
+        oskar_blank_below_horizon(num_src, z, E_st, status);
+    }
+    oskar_mem_free(E_st, status);
+}
+
+
+static double beam_interp_error(const oskar_Jones* approx,
+        const oskar_Jones* exact, int* status)
+{
+    int i, num;
+    double diff, val, max_diff = 0.0, max_val = 0.0;
+    oskar_Mem *a, *b;
+    if (*status) return 0.0;
+
+    /* Copy both sets of beams to the host as double precision. */
+    num = oskar_jones_num_stations(exact) * oskar_jones_num_sources(exact);
+    a = oskar_mem_convert_precision(oskar_jones_mem_const(approx),
+            OSKAR_DOUBLE, status);
+    b = oskar_mem_convert_precision(oskar_jones_mem_const(exact),
+            OSKAR_DOUBLE, status);
+    if (oskar_mem_is_matrix(b)) num *= 4;
+
+    /* Return the largest error relative to the peak of the exact beam. */
+    if (!*status)
+    {
+        const double2 *a_ = (const double2*) oskar_mem_void_const(a);
+        const double2 *b_ = (const double2*) oskar_mem_void_const(b);
+        for (i = 0; i < num; ++i)
+        {
+            diff = (a_[i].x - b_[i].x) * (a_[i].x - b_[i].x) +
+                    (a_[i].y - b_[i].y) * (a_[i].y - b_[i].y);
+            val = b_[i].x * b_[i].x + b_[i].y * b_[i].y;
+            if (diff > max_diff) max_diff = diff;
+            if (val > max_val) max_val = val;
+        }
+    }
+    oskar_mem_free(a, status);
+    oskar_mem_free(b, status);
+    return (max_val > 0.0) ? sqrt(max_diff / max_val) : 0.0;
+}
+
+
+static void init_sky_image(oskar_Interferometer* h, int* status)
+{
+    int i, j, num_stations, type;
+    double max_len = 0.0, max_freq_hz, w_max;
+    oskar_Mem *x, *y, *z, *uu, *vv, *ww, *weight;
+    if (*status || !h->sky_image) return;
+
+    /* W-projection needs the range of baseline W coordinates in advance.
+     * Bound it by the longest baseline at the highest frequency. */
+    if (strcmp(oskar_imager_algorithm(h->sky_image), "W-projection")) return;
+    num_stations = oskar_telescope_num_stations(h->tel);
+    x = oskar_mem_convert_precision(
+            oskar_telescope_station_true_x_offset_ecef_metres_const(h->tel),
+            OSKAR_DOUBLE, status);
+    y = oskar_mem_convert_precision(
+            oskar_telescope_station_true_y_offset_ecef_metres_const(h->tel),
+            OSKAR_DOUBLE, status);
+    z = oskar_mem_convert_precision(
+            oskar_telescope_station_true_z_offset_ecef_metres_const(h->tel),
+            OSKAR_DOUBLE, status);
+    if (!*status)
+    {
+        const double *x_ = oskar_mem_double_const(x, status);
+        const double *y_ = oskar_mem_double_const(y, status);
+        const double *z_ = oskar_mem_double_const(z, status);
+        for (i = 0; i < num_stations; ++i)
+        {
+            for (j = i + 1; j < num_stations; ++j)
+            {
+                const double dx = x_[j] - x_[i], dy = y_[j] - y_[i];
+                const double dz = z_[j] - z_[i];
+                const double len = sqrt(dx * dx + dy * dy + dz * dz);
+                if (len > max_len) max_len = len;
+            }
+        }
+    }
+    oskar_mem_free(x, status);
+    oskar_mem_free(y, status);
+    oskar_mem_free(z, status);
+    max_freq_hz = h->freq_start_hz + (h->num_channels - 1) * h->freq_inc_hz;
+    if (h->freq_inc_hz < 0.0) max_freq_hz = h->freq_start_hz;
+    w_max = max_len * max_freq_hz / 299792458.0;
+
+    /* Pass the bounding coordinate to the imager. */
+    type = h->prec;
+    uu = oskar_mem_create(type, OSKAR_CPU, 1, status);
+    vv = oskar_mem_create(type, OSKAR_CPU, 1, status);
+    ww = oskar_mem_create(type, OSKAR_CPU, 1, status);
+    weight = oskar_mem_create(type, OSKAR_CPU, 1, status);
+    oskar_mem_clear_contents(uu, status);
+    oskar_mem_clear_contents(vv, status);
+    oskar_mem_set_value_real(ww, w_max, 0, 1, status);
+    oskar_mem_set_value_real(weight, 1.0, 0, 1, status);
+    oskar_imager_set_coords_only(h->sky_image, 1);
+    oskar_imager_update_plane(h->sky_image, 1, uu, vv, ww, 0, weight,
+            0, 0, 0, status);
+    oskar_imager_set_coords_only(h->sky_image, 0);
+    oskar_mem_free(uu, status);
+    oskar_mem_free(vv, status);
+    oskar_mem_free(ww, status);
+    oskar_mem_free(weight, status);
+}
+
+
+static void predict_sky_image(oskar_Interferometer* h, oskar_VisBlock* block,
+        int* status)
+{
+    int b, c, t, num_baselines, num_channels, num_times;
+    size_t i, num_vis;
+    oskar_Mem *xc;
+    if (*status || !oskar_vis_block_has_cross_correlations(block)) return;
+
+    /* Get dimensions. */
+    num_baselines = oskar_vis_block_num_baselines(block);
+    num_channels = oskar_vis_block_num_channels(block);
+    num_times = oskar_vis_block_num_times(block);
+    num_vis = (size_t)num_baselines * num_channels * num_times;
+    if (!h->pred_uu)
+    {
+        h->pred_uu = oskar_mem_create(h->prec, OSKAR_CPU, 0, status);
+        h->pred_vv = oskar_mem_create(h->prec, OSKAR_CPU, 0, status);
+        h->pred_ww = oskar_mem_create(h->prec, OSKAR_CPU, 0, status);
+        h->pred_vis = oskar_mem_create(h->prec | OSKAR_COMPLEX, OSKAR_CPU,
+                0, status);
+    }
+    oskar_mem_realloc(h->pred_uu, num_vis, status);
+    oskar_mem_realloc(h->pred_vv, num_vis, status);
+    oskar_mem_realloc(h->pred_ww, num_vis, status);
+    oskar_mem_realloc(h->pred_vis, num_vis, status);
+    oskar_mem_clear_contents(h->pred_vis, status);
+
+    /* Evaluate baseline coordinates using the true station positions,
+     * and scale them to wavelengths for every channel. The coordinates
+     * for the first channel are written in place, as they come last. */
+    oskar_convert_ecef_to_baseline_uvw(oskar_telescope_num_stations(h->tel),
+            oskar_telescope_station_true_x_offset_ecef_metres_const(h->tel),
+            oskar_telescope_station_true_y_offset_ecef_metres_const(h->tel),
+            oskar_telescope_station_true_z_offset_ecef_metres_const(h->tel),
+            oskar_telescope_phase_centre_ra_rad(h->tel),
+            oskar_telescope_phase_centre_dec_rad(h->tel), num_times,
+            h->time_start_mjd_utc, h->time_inc_sec / 86400.0,
+            oskar_vis_block_start_time_index(block),
+            h->pred_uu, h->pred_vv, h->pred_ww, h->temp, status);
+    if (*status) return;
+    for (t = num_times - 1; t >= 0; --t)
+    {
+        for (c = num_channels - 1; c >= 0; --c)
+        {
+            const double scale = (h->freq_start_hz + c * h->freq_inc_hz) /
+                    299792458.0;
+            const size_t in = (size_t)t * num_baselines;
+            const size_t out = ((size_t)t * num_channels + c) * num_baselines;
+            if (h->prec == OSKAR_DOUBLE)
+            {
+                double *u = oskar_mem_double(h->pred_uu, status);
+                double *v = oskar_mem_double(h->pred_vv, status);
+                double *w = oskar_mem_double(h->pred_ww, status);
+                for (b = 0; b < num_baselines; ++b)
+                {
+                    u[out + b] = u[in + b] * scale;
+                    v[out + b] = v[in + b] * scale;
+                    w[out + b] = w[in + b] * scale;
+                }
+            }
+            else
+            {
+                float *u = oskar_mem_float(h->pred_uu, status);
+                float *v = oskar_mem_float(h->pred_vv, status);
+                float *w = oskar_mem_float(h->pred_ww, status);
+                for (b = 0; b < num_baselines; ++b)
+                {
+                    u[out + b] = (float) (u[in + b] * scale);
+                    v[out + b] = (float) (v[in + b] * scale);
+                    w[out + b] = (float) (w[in + b] * scale);
+                }
+            }
+        }
+    }
+
+    /* Predict visibilities from the image. */
+    oskar_imager_predict(h->sky_image, num_vis, h->pred_uu, h->pred_vv,
+            h->pred_ww, h->pred_vis, status);
+
+    /* Add them to the unpolarised part of the cross-correlations,
+     * which have the same [time][channel][baseline] order. */
+    xc = oskar_vis_block_cross_correlations(block);
+    if (*status) return;
+    if (h->prec == OSKAR_DOUBLE)
+    {
+        const double2* p = oskar_mem_double2_const(h->pred_vis, status);
+        if (oskar_mem_is_matrix(xc))
+        {
+            double4c* v = oskar_mem_double4c(xc, status);
+            for (i = 0; i < num_vis; ++i)
+            {
+                v[i].a.x += p[i].x; v[i].a.y += p[i].y;
+                v[i].d.x += p[i].x; v[i].d.y += p[i].y;
+            }
+        }
+        else
+        {
+            double2* v = oskar_mem_double2(xc, status);
+            for (i = 0; i < num_vis; ++i)
+            {
+                v[i].x += p[i].x; v[i].y += p[i].y;
+            }
+        }
+    }
+    else
+    {
+        const float2* p = oskar_mem_float2_const(h->pred_vis, status);
+        if (oskar_mem_is_matrix(xc))
+        {
+            float4c* v = oskar_mem_float4c(xc, status);
+            for (i = 0; i < num_vis; ++i)
+            {
+                v[i].a.x += p[i].x; v[i].a.y += p[i].y;
+                v[i].d.x += p[i].x; v[i].d.y += p[i].y;
+            }
+        }
+        else
+        {
+            float2* v = oskar_mem_float2(xc, status);
+            for (i = 0; i < num_vis; ++i)
+            {
+                v[i].x += p[i].x; v[i].y += p[i].y;
+            }
+        }
+    }
+}
+
+
 static void set_up_vis_header(oskar_Interferometer* h, int* status)
 {
     int num_stations, vis_type;
@@ -1234,6 +1789,15 @@ static void set_up_device_data(oskar_Interferometer* h, int* status)
             d->K = oskar_jones_create(complx, dev_loc, num_stations, num_src,
                     status);
             d->Z = 0;
+            if (h->beam_interp_factor > 1)
+            {
+                d->E_node[0] = oskar_jones_create(vistype, dev_loc,
+                        num_stations, num_src, status);
+                d->E_node[1] = oskar_jones_create(vistype, dev_loc,
+                        num_stations, num_src, status);
+                d->E_check = oskar_jones_create(vistype, dev_loc,
+                        num_stations, num_src, status);
+            }
             d->station_work = oskar_station_work_create(h->prec, dev_loc,
                     status);
         }
@@ -1272,6 +1836,9 @@ static void free_device_data(oskar_Interferometer* h, int* status)
         oskar_jones_free(d->E, status);
         oskar_jones_free(d->K, status);
         oskar_jones_free(d->R, status);
+        oskar_jones_free(d->E_node[0], status);
+        oskar_jones_free(d->E_node[1], status);
+        oskar_jones_free(d->E_check, status);
         memset(d, 0, sizeof(DeviceData));
     }
 }
@@ -1322,6 +1889,10 @@ static void record_timing(oskar_Interferometer* h)
             (t_correlate / t_compute) * 100.0);
     oskar_log_value(h->log, 'M', 1, "Other", "%4.1f%%",
             ((t_compute - t_components) / t_compute) * 100.0);
+    if (h->beam_interp_factor > 1)
+        oskar_log_value(h->log, 'M', 0, "Beam interpolation error",
+                "%.3e (factor %d)", h->beam_interp_max_error,
+                h->beam_interp_factor);
     free(compute_times);
 }
 
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "interferometer/private_jones.h"
+#include "interferometer/oskar_jones.h"
+#include "interferometer/oskar_jones_interpolate_cuda.h"
+#include "utility/oskar_device_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Each Jones element is stride real values. If every value of an element
+ * is zero at one node (for example, because the source is below the
+ * horizon there), the value at the other node is used instead. */
+
+/* Single precision. */
+static void interpolate_f(int num, int stride, float frac,
+        const float* a, const float* b, float* out)
+{
+    int i, j, a_zero, b_zero;
+    for (i = 0; i < num; i += stride)
+    {
+        a_zero = b_zero = 1;
+        for (j = i; j < i + stride; ++j)
+        {
+            if (a[j] != 0.0f) a_zero = 0;
+            if (b[j] != 0.0f) b_zero = 0;
+        }
+        if (a_zero)
+            for (j = i; j < i + stride; ++j) out[j] = b[j];
+        else if (b_zero)
+            for (j = i; j < i + stride; ++j) out[j] = a[j];
+        else
+            for (j = i; j < i + stride; ++j)
+                out[j] = a[j] + frac * (b[j] - a[j]);
+    }
+}
+
+/* Double precision. */
+static void interpolate_d(int num, int stride, double frac,
+        const double* a, const double* b, double* out)
+{
+    int i, j, a_zero, b_zero;
+    for (i = 0; i < num; i += stride)
+    {
+        a_zero = b_zero = 1;
+        for (j = i; j < i + stride; ++j)
+        {
+            if (a[j] != 0.0) a_zero = 0;
+            if (b[j] != 0.0) b_zero = 0;
+        }
+        if (a_zero)
+            for (j = i; j < i + stride; ++j) out[j] = b[j];
+        else if (b_zero)
+            for (j = i; j < i + stride; ++j) out[j] = a[j];
+        else
+            for (j = i; j < i + stride; ++j)
+                out[j] = a[j] + frac * (b[j] - a[j]);
+    }
+}
+
+void oskar_jones_interpolate(oskar_Jones* out, const oskar_Jones* j0,
+        const oskar_Jones* j1, double frac, int* status)
+{
+    int num, stride, type, location;
+
+    /* Check if safe to proceed. */
+    if (*status) return;
+
+    /* Check the data dimensions. */
+    if (j0->num_sources != j1->num_sources ||
+            j0->num_sources != out->num_sources ||
+            j0->num_stations != j1->num_stations ||
+            j0->num_stations != out->num_stations)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+
+    /* Check the data types and locations. */
+    type = oskar_mem_type(out->data);
+    location = oskar_mem_location(out->data);
+    if (oskar_mem_type(j0->data) != type || oskar_mem_type(j1->data) != type)
+    {
+        *status = OSKAR_ERR_TYPE_MISMATCH;
+        return;
+    }
+    if (oskar_mem_location(j0->data) != location ||
+            oskar_mem_location(j1->data) != location)
+    {
+        *status = OSKAR_ERR_LOCATION_MISMATCH;
+        return;
+    }
+
+    /* Get the number of real values to interpolate, and the number of
+     * real values in each Jones element. */
+    stride = 1;
+    if (oskar_type_is_complex(type)) stride *= 2;
+    if (oskar_type_is_matrix(type)) stride *= 4;
+    num = j0->num_sources * j0->num_stations * stride;
+
+    /* Interpolate the real and imaginary parts independently. */
+    if (oskar_type_is_single(type))
+    {
+        float *o;
+        const float *a, *b;
+        const float f = (float) frac;
+        o = (float*) oskar_mem_void(out->data);
+        a = (const float*) oskar_mem_void_const(j0->data);
+        b = (const float*) oskar_mem_void_const(j1->data);
+        if (location == OSKAR_CPU)
+            interpolate_f(num, stride, f, a, b, o);
+        else if (location == OSKAR_GPU)
+        {
+#ifdef OSKAR_HAVE_CUDA
+            oskar_jones_interpolate_cuda_f(num, stride, f, a, b, o);
+            oskar_device_check_error(status);
+#else
+            *status = OSKAR_ERR_CUDA_NOT_AVAILABLE;
+#endif
+        }
+        else
+            *status = OSKAR_ERR_BAD_LOCATION;
+    }
+    else if (oskar_type_is_double(type))
+    {
+        double *o;
+        const double *a, *b;
+        o = (double*) oskar_mem_void(out->data);
+        a = (const double*) oskar_mem_void_const(j0->data);
+        b = (const double*) oskar_mem_void_const(j1->data);
+        if (location == OSKAR_CPU)
+            interpolate_d(num, stride, frac, a, b, o);
+        else if (location == OSKAR_GPU)
+        {
+#ifdef OSKAR_HAVE_CUDA
+            oskar_jones_interpolate_cuda_d(num, stride, frac, a, b, o);
+            oskar_device_check_error(status);
+#else
+            *status = OSKAR_ERR_CUDA_NOT_AVAILABLE;
+#endif
+        }
+        else
+            *status = OSKAR_ERR_BAD_LOCATION;
+    }
+    else
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "interferometer/oskar_jones_interpolate_cuda.h"
+
+/* Kernels. ================================================================ */
+
+/* Single precision. */
+__global__
+void oskar_jones_interpolate_cudak_f(const int num, const int stride,
+        const float frac, const float* restrict a, const float* restrict b,
+        float* restrict out)
+{
+    int j, a_zero = 1, b_zero = 1;
+    const int i = (blockDim.x * blockIdx.x + threadIdx.x) * stride;
+    if (i >= num) return;
+    for (j = i; j < i + stride; ++j)
+    {
+        if (a[j] != 0.0f) a_zero = 0;
+        if (b[j] != 0.0f) b_zero = 0;
+    }
+    if (a_zero)
+        for (j = i; j < i + stride; ++j) out[j] = b[j];
+    else if (b_zero)
+        for (j = i; j < i + stride; ++j) out[j] = a[j];
+    else
+        for (j = i; j < i + stride; ++j)
+            out[j] = a[j] + frac * (b[j] - a[j]);
+}
+
+/* Double precision. */
+__global__
+void oskar_jones_interpolate_cudak_d(const int num, const int stride,
+        const double frac, const double* restrict a, const double* restrict b,
+        double* restrict out)
+{
+    int j, a_zero = 1, b_zero = 1;
+    const int i = (blockDim.x * blockIdx.x + threadIdx.x) * stride;
+    if (i >= num) return;
+    for (j = i; j < i + stride; ++j)
+    {
+        if (a[j] != 0.0) a_zero = 0;
+        if (b[j] != 0.0) b_zero = 0;
+    }
+    if (a_zero)
+        for (j = i; j < i + stride; ++j) out[j] = b[j];
+    else if (b_zero)
+        for (j = i; j < i + stride; ++j) out[j] = a[j];
+    else
+        for (j = i; j < i + stride; ++j)
+            out[j] = a[j] + frac * (b[j] - a[j]);
+}
+
+/* Kernel wrappers. ======================================================== */
+
+/* Single precision. */
+void oskar_jones_interpolate_cuda_f(int num, int stride, float frac,
+        const float* d_a, const float* d_b, float* d_out)
+{
+    int num_blocks, num_threads = 256;
+    num_blocks = (num / stride + num_threads - 1) / num_threads;
+    oskar_jones_interpolate_cudak_f OSKAR_CUDAK_CONF(num_blocks, num_threads)
+            (num, stride, frac, d_a, d_b, d_out);
+}
+
+/* Double precision. */
+void oskar_jones_interpolate_cuda_d(int num, int stride, double frac,
+        const double* d_a, const double* d_b, double* d_out)
+{
+    int num_blocks, num_threads = 256;
+    num_blocks = (num / stride + num_threads - 1) / num_threads;
+    oskar_jones_interpolate_cudak_d OSKAR_CUDAK_CONF(num_blocks, num_threads)
+            (num, stride, frac, d_a, d_b, d_out);
+}
@@ -912,3 +912,120 @@ TEST(Jones, set_ones_doubleCPU)
     test_ones(OSKAR_DOUBLE, OSKAR_CPU);
 }
 
+
+static void t_interpolate(int type, int location)
+{
+    int status = 0;
+    const double frac = 0.3;
+    oskar_Jones *j0, *j1, *out;
+    oskar_Mem *expected, *out_cpu;
+
+    // Create the input and output blocks.
+    j0 = oskar_jones_create(type, OSKAR_CPU, stations, sources, &status);
+    j1 = oskar_jones_create(type, OSKAR_CPU, stations, sources, &status);
+    srand(2);
+    oskar_mem_random_range(oskar_jones_mem(j0), 1.0, 2.0, &status);
+    oskar_mem_random_range(oskar_jones_mem(j1), 1.0, 2.0, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // Evaluate the expected result: (1 - frac) * J0 + frac * J1.
+    expected = oskar_mem_create_copy(oskar_jones_mem(j1), OSKAR_CPU, &status);
+    oskar_mem_scale_real(expected, frac, &status);
+    out_cpu = oskar_mem_create_copy(oskar_jones_mem(j0), OSKAR_CPU, &status);
+    oskar_mem_scale_real(out_cpu, 1.0 - frac, &status);
+    oskar_mem_add(expected, expected, out_cpu,
+            oskar_mem_length(expected), &status);
+    oskar_mem_free(out_cpu, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // Interpolate at the requested location.
+    {
+        oskar_Jones *j0_, *j1_;
+        j0_ = oskar_jones_create_copy(j0, location, &status);
+        j1_ = oskar_jones_create_copy(j1, location, &status);
+        out = oskar_jones_create(type, location, stations, sources, &status);
+        oskar_jones_interpolate(out, j0_, j1_, frac, &status);
+        oskar_jones_free(j0_, &status);
+        oskar_jones_free(j1_, &status);
+    }
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // Check the values.
+    out_cpu = oskar_mem_create_copy(oskar_jones_mem(out), OSKAR_CPU, &status);
+    check_values(out_cpu, expected);
+
+    // Check end points are reproduced.
+    oskar_jones_interpolate(j0, j0, j1, 0.0, &status);
+    oskar_jones_free(out, &status);
+    out = oskar_jones_create(type, OSKAR_CPU, stations, sources, &status);
+    oskar_jones_interpolate(out, j0, j1, 1.0, &status);
+    check_values(oskar_jones_mem(out), oskar_jones_mem(j1));
+
+    // Check the other node is used where one node is zero (below horizon).
+    {
+        oskar_Mem *j0_cpu, *zero;
+        j0_cpu = oskar_mem_create_copy(oskar_jones_mem(j1), OSKAR_CPU, &status);
+        oskar_mem_random_range(j0_cpu, 1.0, 2.0, &status);
+        zero = oskar_mem_create_alias(j0_cpu, 0, sources, &status);
+        oskar_mem_clear_contents(zero, &status);
+        oskar_mem_copy(oskar_jones_mem(j0), j0_cpu, &status);
+        oskar_Jones *j0_ = oskar_jones_create_copy(j0, location, &status);
+        oskar_Jones *j1_ = oskar_jones_create_copy(j1, location, &status);
+        oskar_jones_free(out, &status);
+        out = oskar_jones_create(type, location, stations, sources, &status);
+        oskar_jones_interpolate(out, j0_, j1_, frac, &status);
+        oskar_mem_free(out_cpu, &status);
+        out_cpu = oskar_mem_create_copy(oskar_jones_mem(out), OSKAR_CPU,
+                &status);
+        oskar_Mem* out_zero = oskar_mem_create_alias(out_cpu, 0, sources,
+                &status);
+        oskar_Mem* j1_zero = oskar_mem_create_alias(oskar_jones_mem(j1), 0,
+                sources, &status);
+        ASSERT_EQ(0, status) << oskar_get_error_string(status);
+        EXPECT_FALSE(oskar_mem_different(out_zero, j1_zero, 0, &status));
+        oskar_mem_free(out_zero, &status);
+        oskar_mem_free(j1_zero, &status);
+        oskar_mem_free(zero, &status);
+        oskar_mem_free(j0_cpu, &status);
+        oskar_jones_free(j0_, &status);
+        oskar_jones_free(j1_, &status);
+        oskar_jones_free(out, &status);
+        out = oskar_jones_create(type, OSKAR_CPU, stations, sources, &status);
+    }
+
+    // Check dimension mismatch is reported.
+    oskar_jones_set_size(out, stations, sources - 1, &status);
+    oskar_jones_interpolate(out, j0, j1, 0.5, &status);
+    EXPECT_EQ((int)OSKAR_ERR_DIMENSION_MISMATCH, status);
+    status = 0;
+
+    // Free memory.
+    oskar_mem_free(expected, &status);
+    oskar_mem_free(out_cpu, &status);
+    oskar_jones_free(j0, &status);
+    oskar_jones_free(j1, &status);
+    oskar_jones_free(out, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+}
+
+TEST(Jones, interpolate_scal_singleCPU)
+{
+    t_interpolate(SC, CPU);
+}
+
+TEST(Jones, interpolate_matx_doubleCPU)
+{
+    t_interpolate(DCM, CPU);
+}
+
+#ifdef OSKAR_HAVE_CUDA
+TEST(Jones, interpolate_matx_singleGPU)
+{
+    t_interpolate(SCM, GPU);
+}
+
+TEST(Jones, interpolate_scal_doubleGPU)
+{
+    t_interpolate(DC, GPU);
+}
+#endif
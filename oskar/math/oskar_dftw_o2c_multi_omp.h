@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_DFTW_O2C_MULTI_OMP_H_
+#define OSKAR_DFTW_O2C_MULTI_OMP_H_
+
+/**
+ * @file oskar_dftw_o2c_multi_omp.h
+ */
+
+#include <oskar_global.h>
+#include <utility/oskar_vector_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Function to perform a real-to-complex single-precision DFT using
+ * supplied weights, for multiple wavenumbers at once.
+ *
+ * @details
+ * This function performs the same DFT as oskar_dftw_o2c_2d_omp_f() or
+ * oskar_dftw_o2c_3d_omp_f() (if \p z_in and \p z_out are both non-NULL),
+ * but for \p n_chan wavenumbers in a single pass.
+ *
+ * The geometric part of the phase (the dot product of the input and output
+ * positions) is computed once for each pair of points and scaled by the
+ * wavenumber of each channel, so the input and output coordinates are
+ * loaded only once for all channels.
+ *
+ * The weights for channel \p c start at
+ * \p weights_in + \p c * \p weights_stride, and the output for channel
+ * \p c is written to \p output + \p c * \p n_out, so \p output must be
+ * pre-sized to length \p n_chan * \p n_out.
+ *
+ * @param[in] n_in           Number of input points.
+ * @param[in] n_chan         Number of channels (wavenumbers).
+ * @param[in] wavenumber     Array of wavenumbers (2 pi / wavelength).
+ * @param[in] x_in           Array of input x positions.
+ * @param[in] y_in           Array of input y positions.
+ * @param[in] z_in           Array of input z positions (may be NULL).
+ * @param[in] weights_in     Array of complex DFT weights for all channels.
+ * @param[in] weights_stride Stride between the weights of each channel.
+ * @param[in] n_out          Number of output points.
+ * @param[in] x_out          Array of output 1/x positions.
+ * @param[in] y_out          Array of output 1/y positions.
+ * @param[in] z_out          Array of output 1/z positions (may be NULL).
+ * @param[out] output        Array of computed output points (see note, above).
+ */
+OSKAR_EXPORT
+void oskar_dftw_o2c_multi_omp_f(const int n_in, const int n_chan,
+        const double* wavenumber, const float* x_in, const float* y_in,
+        const float* z_in, const float2* weights_in, const int weights_stride,
+        const int n_out, const float* x_out, const float* y_out,
+        const float* z_out, float2* output);
+
+/**
+ * @brief
+ * Function to perform a real-to-complex double-precision DFT using
+ * supplied weights, for multiple wavenumbers at once.
+ *
+ * @details
+ * This function performs the same DFT as oskar_dftw_o2c_2d_omp_d() or
+ * oskar_dftw_o2c_3d_omp_d() (if \p z_in and \p z_out are both non-NULL),
+ * but for \p n_chan wavenumbers in a single pass.
+ *
+ * The geometric part of the phase (the dot product of the input and output
+ * positions) is computed once for each pair of points and scaled by the
+ * wavenumber of each channel, so the input and output coordinates are
+ * loaded only once for all channels.
+ *
+ * The weights for channel \p c start at
+ * \p weights_in + \p c * \p weights_stride, and the output for channel
+ * \p c is written to \p output + \p c * \p n_out, so \p output must be
+ * pre-sized to length \p n_chan * \p n_out.
+ *
+ * @param[in] n_in           Number of input points.
+ * @param[in] n_chan         Number of channels (wavenumbers).
+ * @param[in] wavenumber     Array of wavenumbers (2 pi / wavelength).
+ * @param[in] x_in           Array of input x positions.
+ * @param[in] y_in           Array of input y positions.
+ * @param[in] z_in           Array of input z positions (may be NULL).
+ * @param[in] weights_in     Array of complex DFT weights for all channels.
+ * @param[in] weights_stride Stride between the weights of each channel.
+ * @param[in] n_out          Number of output points.
+ * @param[in] x_out          Array of output 1/x positions.
+ * @param[in] y_out          Array of output 1/y positions.
+ * @param[in] z_out          Array of output 1/z positions (may be NULL).
+ * @param[out] output        Array of computed output points (see note, above).
+ */
+OSKAR_EXPORT
+void oskar_dftw_o2c_multi_omp_d(const int n_in, const int n_chan,
+        const double* wavenumber, const double* x_in, const double* y_in,
+        const double* z_in, const double2* weights_in,
+        const int weights_stride, const int n_out, const double* x_out,
+        const double* y_out, const double* z_out, double2* output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_DFTW_O2C_MULTI_OMP_H_ */
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_FFT_H_
+#define OSKAR_FFT_H_
+
+/**
+ * @file oskar_fft.h
+ */
+
+#include <oskar_global.h>
+#include <mem/oskar_mem.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct oskar_FFT;
+#ifndef OSKAR_FFT_TYPEDEF_
+#define OSKAR_FFT_TYPEDEF_
+typedef struct oskar_FFT oskar_FFT;
+#endif /* OSKAR_FFT_TYPEDEF_ */
+
+/**
+ * @brief
+ * Creates a plan for in-place complex FFTs of a given size.
+ *
+ * @details
+ * Creates a plan for in-place, forward, complex-to-complex FFTs of
+ * one- or two-dimensional square arrays of a given size.
+ *
+ * If \p location is OSKAR_CPU, the transforms are done using FFTPACK,
+ * with the rows and columns shared between threads using OpenMP.
+ * If \p location is OSKAR_GPU, the transforms are done using cuFFT
+ * on the current device.
+ *
+ * @param[in] precision  Enumerated precision (OSKAR_SINGLE or OSKAR_DOUBLE).
+ * @param[in] location   Enumerated location (OSKAR_CPU or OSKAR_GPU).
+ * @param[in] num_dim    Number of dimensions (1 or 2).
+ * @param[in] dim_size   Length of each dimension.
+ * @param[in,out] status Status return code.
+ *
+ * @return A handle to the new plan.
+ */
+OSKAR_EXPORT
+oskar_FFT* oskar_fft_create(int precision, int location, int num_dim,
+        int dim_size, int* status);
+
+/**
+ * @brief
+ * Performs an in-place forward FFT.
+ *
+ * @details
+ * Performs an in-place forward FFT of the supplied complex array, which
+ * must have the precision and size given when the plan was created.
+ *
+ * The result is not normalised, so it is the same for all locations.
+ * For data in CPU memory, this function may be called concurrently
+ * from multiple threads using the same plan.
+ *
+ * @param[in] h          Handle to FFT plan.
+ * @param[in,out] data   Complex array to transform.
+ * @param[in,out] status Status return code.
+ */
+OSKAR_EXPORT
+void oskar_fft_exec(oskar_FFT* h, oskar_Mem* data, int* status);
+
+/**
+ * @brief
+ * Performs an in-place forward 2D FFT of a region of the output.
+ *
+ * @details
+ * Performs an in-place forward FFT of the supplied complex array, as
+ * oskar_fft_exec(), when only a square region of the output is needed.
+ * This is useful if the output will be trimmed.
+ *
+ * For two-dimensional plans in CPU memory, rows that are entirely zero
+ * are not transformed, and only the columns that overlap the region are
+ * transformed. Elements of the output outside the region are undefined.
+ * Otherwise, this is the same as oskar_fft_exec().
+ *
+ * If \p real_only is set, only the real part of the output is computed.
+ * This transforms each pair of columns using a single complex FFT,
+ * and sets the imaginary part of the output in the region to zero.
+ *
+ * @param[in] h            Handle to FFT plan.
+ * @param[in,out] data     Complex array to transform.
+ * @param[in] region_start Index of the first row and column in the region.
+ * @param[in] region_size  Number of rows and columns in the region.
+ * @param[in] real_only    If set, compute only the real part of the output.
+ * @param[in,out] status   Status return code.
+ */
+OSKAR_EXPORT
+void oskar_fft_exec_pruned(oskar_FFT* h, oskar_Mem* data, int region_start,
+        int region_size, int real_only, int* status);
+
+/**
+ * @brief
+ * Performs an in-place forward FFT, keeping only the real part.
+ *
+ * @details
+ * Performs an in-place forward FFT of the supplied complex array, as
+ * oskar_fft_exec(), when only the real part of the result is needed.
+ * Only the real part of each output element is defined.
+ *
+ * For two-dimensional plans in CPU memory, rows that are entirely zero
+ * are not transformed, and the real part of the result is obtained by
+ * transforming each pair of columns using a single complex FFT.
+ * This halves the work done by the column transforms, and halves it
+ * again for the row transforms if half the grid is empty (for example,
+ * if visibilities have been folded into one half of the grid using
+ * Hermitian symmetry). The imaginary part of the output is set to zero.
+ * This is the same as calling oskar_fft_exec_pruned() for the whole
+ * array, with \p real_only set.
+ *
+ * @param[in] h          Handle to FFT plan.
+ * @param[in,out] data   Complex array to transform.
+ * @param[in,out] status Status return code.
+ */
+OSKAR_EXPORT
+void oskar_fft_exec_real(oskar_FFT* h, oskar_Mem* data, int* status);
+
+/**
+ * @brief
+ * Destroys the FFT plan.
+ *
+ * @param[in] h          Handle to FFT plan.
+ */
+OSKAR_EXPORT
+void oskar_fft_free(oskar_FFT* h);
+
+/**
+ * @brief
+ * Returns the enumerated location of the FFT plan.
+ *
+ * @param[in] h          Handle to FFT plan.
+ */
+OSKAR_EXPORT
+int oskar_fft_location(const oskar_FFT* h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_FFT_H_ */
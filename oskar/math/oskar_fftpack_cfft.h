@@ -50,6 +50,21 @@ void oskar_fftpack_cfft2f(const int ldim, const int l, const int m,
 OSKAR_EXPORT
 void oskar_fftpack_cfft2i(const int l, const int m, double *wsave);
 
+/* Multiple 1D transforms of length n: lot transforms, separated by jump
+ * complex elements, each with a stride of inc complex elements.
+ * The work array must hold at least 2 * lot * n values. */
+OSKAR_EXPORT
+void oskar_fftpack_cfftmb(const int lot, const int jump, const int n,
+        const int inc, double *c, double *wsave, double *work);
+
+OSKAR_EXPORT
+void oskar_fftpack_cfftmf(const int lot, const int jump, const int n,
+        const int inc, double *c, double *wsave, double *work);
+
+/* The wsave array must hold at least 2 * n + log2(n) + 4 values. */
+OSKAR_EXPORT
+void oskar_fftpack_cfftmi(const int n, double *wsave);
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,6 +50,21 @@ void oskar_fftpack_cfft2f_f(const int ldim, const int l, const int m,
 OSKAR_EXPORT
 void oskar_fftpack_cfft2i_f(const int l, const int m, float *wsave);
 
+/* Multiple 1D transforms of length n: lot transforms, separated by jump
+ * complex elements, each with a stride of inc complex elements.
+ * The work array must hold at least 2 * lot * n values. */
+OSKAR_EXPORT
+void oskar_fftpack_cfftmb_f(const int lot, const int jump, const int n,
+        const int inc, float *c, float *wsave, float *work);
+
+OSKAR_EXPORT
+void oskar_fftpack_cfftmf_f(const int lot, const int jump, const int n,
+        const int inc, float *c, float *wsave, float *work);
+
+/* The wsave array must hold at least 2 * n + log2(n) + 4 values. */
+OSKAR_EXPORT
+void oskar_fftpack_cfftmi_f(const int n, float *wsave);
+
 #ifdef __cplusplus
 }
 #endif
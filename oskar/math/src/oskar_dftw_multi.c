@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "math/oskar_dftw_multi.h"
+#include "math/oskar_dftw.h"
+#include "math/oskar_dftw_o2c_multi_omp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void oskar_dftw_multi(int num_in, int num_channels, const double* wavenumber,
+        const oskar_Mem* x_in, const oskar_Mem* y_in, const oskar_Mem* z_in,
+        const oskar_Mem* weights_in, int weights_stride, int num_out,
+        const oskar_Mem* x_out, const oskar_Mem* y_out,
+        const oskar_Mem* z_out, oskar_Mem* output, int* status)
+{
+    int c, location, type, is_3d;
+    if (*status) return;
+
+    /* Find out what we have. */
+    location = oskar_mem_location(output);
+    type = oskar_mem_precision(output);
+    is_3d = (z_in != NULL && z_out != NULL);
+    if (!oskar_mem_is_complex(output) || oskar_mem_is_matrix(output) ||
+            !oskar_mem_is_complex(weights_in) ||
+            oskar_mem_is_matrix(weights_in))
+    {
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+        return;
+    }
+    if ((int)oskar_mem_length(weights_in) <
+            (num_channels - 1) * weights_stride + num_in)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+
+    /* Resize output array if needed. */
+    if ((int)oskar_mem_length(output) < num_channels * num_out)
+        oskar_mem_realloc(output, (size_t) (num_channels * num_out), status);
+    if (*status) return;
+
+    /* Use the multi-channel kernel if the data are in CPU memory. */
+    if (location == OSKAR_CPU &&
+            oskar_mem_location(weights_in) == location &&
+            oskar_mem_location(x_in) == location &&
+            oskar_mem_location(y_in) == location &&
+            oskar_mem_location(x_out) == location &&
+            oskar_mem_location(y_out) == location &&
+            (!is_3d || (oskar_mem_location(z_in) == location &&
+                    oskar_mem_location(z_out) == location)))
+    {
+        if (oskar_mem_precision(weights_in) != type ||
+                oskar_mem_type(x_in) != type ||
+                oskar_mem_type(y_in) != type ||
+                oskar_mem_type(x_out) != type ||
+                oskar_mem_type(y_out) != type ||
+                (is_3d && (oskar_mem_type(z_in) != type ||
+                        oskar_mem_type(z_out) != type)))
+        {
+            *status = OSKAR_ERR_TYPE_MISMATCH;
+            return;
+        }
+        if (type == OSKAR_DOUBLE)
+            oskar_dftw_o2c_multi_omp_d(num_in, num_channels, wavenumber,
+                    oskar_mem_double_const(x_in, status),
+                    oskar_mem_double_const(y_in, status),
+                    is_3d ? oskar_mem_double_const(z_in, status) : 0,
+                    oskar_mem_double2_const(weights_in, status),
+                    weights_stride, num_out,
+                    oskar_mem_double_const(x_out, status),
+                    oskar_mem_double_const(y_out, status),
+                    is_3d ? oskar_mem_double_const(z_out, status) : 0,
+                    oskar_mem_double2(output, status));
+        else if (type == OSKAR_SINGLE)
+            oskar_dftw_o2c_multi_omp_f(num_in, num_channels, wavenumber,
+                    oskar_mem_float_const(x_in, status),
+                    oskar_mem_float_const(y_in, status),
+                    is_3d ? oskar_mem_float_const(z_in, status) : 0,
+                    oskar_mem_float2_const(weights_in, status),
+                    weights_stride, num_out,
+                    oskar_mem_float_const(x_out, status),
+                    oskar_mem_float_const(y_out, status),
+                    is_3d ? oskar_mem_float_const(z_out, status) : 0,
+                    oskar_mem_float2(output, status));
+        else
+            *status = OSKAR_ERR_BAD_DATA_TYPE;
+    }
+    else
+    {
+        /* Otherwise, do a separate DFT for each channel. */
+        oskar_Mem *w, *out;
+        w = oskar_mem_create_alias(0, 0, 0, status);
+        out = oskar_mem_create_alias(0, 0, 0, status);
+        for (c = 0; c < num_channels; ++c)
+        {
+            oskar_mem_set_alias(w, weights_in, c * weights_stride,
+                    num_in, status);
+            oskar_mem_set_alias(out, output, c * num_out, num_out, status);
+            oskar_dftw(num_in, wavenumber[c], x_in, y_in, z_in, w,
+                    num_out, x_out, y_out, z_out, 0, out, status);
+        }
+        oskar_mem_free(w, status);
+        oskar_mem_free(out, status);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "math/oskar_dftw_o2c_multi_omp.h"
+#include <math.h>
+
+/* Number of channels accumulated together by each thread. */
+#define MAX_CHAN_BLOCK 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Single precision. */
+void oskar_dftw_o2c_multi_omp_f(const int n_in, const int n_chan,
+        const double* wavenumber, const float* x_in, const float* y_in,
+        const float* z_in, const float2* weights_in, const int weights_stride,
+        const int n_out, const float* x_out, const float* y_out,
+        const float* z_out, float2* output)
+{
+    int i_out = 0;
+    const int is_3d = (z_in != 0 && z_out != 0);
+
+    /* Loop over output points. */
+    #pragma omp parallel for private(i_out)
+    for (i_out = 0; i_out < n_out; ++i_out)
+    {
+        int c, c_start, c_end, i;
+        float xp_out, yp_out, zp_out, k[MAX_CHAN_BLOCK];
+        float2 out[MAX_CHAN_BLOCK];
+
+        /* Get the output position. */
+        xp_out = x_out[i_out];
+        yp_out = y_out[i_out];
+        zp_out = is_3d ? z_out[i_out] : 0.0f;
+
+        /* Loop over blocks of channels. */
+        for (c_start = 0; c_start < n_chan; c_start += MAX_CHAN_BLOCK)
+        {
+            c_end = c_start + MAX_CHAN_BLOCK;
+            if (c_end > n_chan) c_end = n_chan;
+
+            /* Clear output values. */
+            for (c = c_start; c < c_end; ++c)
+            {
+                k[c - c_start] = (float) wavenumber[c];
+                out[c - c_start].x = 0.0f;
+                out[c - c_start].y = 0.0f;
+            }
+
+            /* Loop over input points. */
+            for (i = 0; i < n_in; ++i)
+            {
+                float g;
+
+                /* Calculate the geometric part of the phase once. */
+                g = xp_out * x_in[i] + yp_out * y_in[i];
+                if (is_3d) g += zp_out * z_in[i];
+
+                /* Scale the phase for each channel, and perform complex
+                 * multiply-accumulate. */
+                for (c = c_start; c < c_end; ++c)
+                {
+                    float a, signal_x, signal_y;
+                    float2 w;
+                    a = k[c - c_start] * g;
+                    signal_x = cosf(a);
+                    signal_y = sinf(a);
+                    w = weights_in[c * weights_stride + i];
+                    out[c - c_start].x += signal_x * w.x;
+                    out[c - c_start].x -= signal_y * w.y;
+                    out[c - c_start].y += signal_y * w.x;
+                    out[c - c_start].y += signal_x * w.y;
+                }
+            }
+
+            /* Store the output points. */
+            for (c = c_start; c < c_end; ++c)
+                output[c * n_out + i_out] = out[c - c_start];
+        }
+    }
+}
+
+/* Double precision. */
+void oskar_dftw_o2c_multi_omp_d(const int n_in, const int n_chan,
+        const double* wavenumber, const double* x_in, const double* y_in,
+        const double* z_in, const double2* weights_in, const int weights_stride,
+        const int n_out, const double* x_out, const double* y_out,
+        const double* z_out, double2* output)
+{
+    int i_out = 0;
+    const int is_3d = (z_in != 0 && z_out != 0);
+
+    /* Loop over output points. */
+    #pragma omp parallel for private(i_out)
+    for (i_out = 0; i_out < n_out; ++i_out)
+    {
+        int c, c_start, c_end, i;
+        double xp_out, yp_out, zp_out, k[MAX_CHAN_BLOCK];
+        double2 out[MAX_CHAN_BLOCK];
+
+        /* Get the output position. */
+        xp_out = x_out[i_out];
+        yp_out = y_out[i_out];
+        zp_out = is_3d ? z_out[i_out] : 0.0;
+
+        /* Loop over blocks of channels. */
+        for (c_start = 0; c_start < n_chan; c_start += MAX_CHAN_BLOCK)
+        {
+            c_end = c_start + MAX_CHAN_BLOCK;
+            if (c_end > n_chan) c_end = n_chan;
+
+            /* Clear output values. */
+            for (c = c_start; c < c_end; ++c)
+            {
+                k[c - c_start] = (double) wavenumber[c];
+                out[c - c_start].x = 0.0;
+                out[c - c_start].y = 0.0;
+            }
+
+            /* Loop over input points. */
+            for (i = 0; i < n_in; ++i)
+            {
+                double g;
+
+                /* Calculate the geometric part of the phase once. */
+                g = xp_out * x_in[i] + yp_out * y_in[i];
+                if (is_3d) g += zp_out * z_in[i];
+
+                /* Scale the phase for each channel, and perform complex
+                 * multiply-accumulate. */
+                for (c = c_start; c < c_end; ++c)
+                {
+                    double a, signal_x, signal_y;
+                    double2 w;
+                    a = k[c - c_start] * g;
+                    signal_x = cos(a);
+                    signal_y = sin(a);
+                    w = weights_in[c * weights_stride + i];
+                    out[c - c_start].x += signal_x * w.x;
+                    out[c - c_start].x -= signal_y * w.y;
+                    out[c - c_start].y += signal_y * w.x;
+                    out[c - c_start].y += signal_x * w.y;
+                }
+            }
+
+            /* Store the output points. */
+            for (c = c_start; c < c_end; ++c)
+                output[c * n_out + i_out] = out[c - c_start];
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
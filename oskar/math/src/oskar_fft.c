@@ -0,0 +1,540 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef OSKAR_HAVE_CUDA
+#include <cufft.h>
+#endif
+
+#include "math/oskar_fft.h"
+#include "math/oskar_fftpack_cfft.h"
+#include "math/oskar_fftpack_cfft_f.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of lines transformed together by each thread. */
+#define LINES_PER_CHUNK 16
+
+struct oskar_FFT
+{
+    int precision, location, num_dim, dim_size;
+    oskar_Mem* fftpack_wsave;
+#ifdef OSKAR_HAVE_CUDA
+    cufftHandle cufft_plan;
+#endif
+};
+
+/*
+ * Transforms lot lines of length n, in chunks of LINES_PER_CHUNK lines.
+ * Consecutive chunks start chunk_step complex elements apart, and each
+ * thread uses its own work array. If scale is not 1, each chunk is
+ * scaled after it has been transformed.
+ */
+static void fft_lines_d(const int lot, const int jump, const int n,
+        const int inc, const size_t chunk_step, const double scale,
+        double* data, double* wsave)
+{
+    int chunk;
+    const int num_chunks = (lot + LINES_PER_CHUNK - 1) / LINES_PER_CHUNK;
+#pragma omp parallel
+    {
+        double* work = (double*) malloc(
+                2 * LINES_PER_CHUNK * (size_t)n * sizeof(double));
+#pragma omp for schedule(static)
+        for (chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            const int start = chunk * LINES_PER_CHUNK;
+            const int num = (lot - start < LINES_PER_CHUNK) ?
+                    lot - start : LINES_PER_CHUNK;
+            double* c = data + 2 * start * chunk_step;
+            oskar_fftpack_cfftmf(num, jump, n, inc, c, wsave, work);
+            if (scale != 1.0)
+            {
+                size_t i;
+                const size_t num_values = 2 * (size_t)num * chunk_step;
+                for (i = 0; i < num_values; ++i) c[i] *= scale;
+            }
+        }
+        free(work);
+    }
+}
+
+static void fft_lines_f(const int lot, const int jump, const int n,
+        const int inc, const size_t chunk_step, const double scale,
+        float* data, float* wsave)
+{
+    int chunk;
+    const int num_chunks = (lot + LINES_PER_CHUNK - 1) / LINES_PER_CHUNK;
+#pragma omp parallel
+    {
+        float* work = (float*) malloc(
+                2 * LINES_PER_CHUNK * (size_t)n * sizeof(float));
+#pragma omp for schedule(static)
+        for (chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            const int start = chunk * LINES_PER_CHUNK;
+            const int num = (lot - start < LINES_PER_CHUNK) ?
+                    lot - start : LINES_PER_CHUNK;
+            float* c = data + 2 * start * chunk_step;
+            oskar_fftpack_cfftmf_f(num, jump, n, inc, c, wsave, work);
+            if (scale != 1.0)
+            {
+                size_t i;
+                const size_t num_values = 2 * (size_t)num * chunk_step;
+                for (i = 0; i < num_values; ++i) c[i] *= (float)scale;
+            }
+        }
+        free(work);
+    }
+}
+
+
+/*
+ * Transforms each row of an n-by-n array that is not entirely zero,
+ * and scales the rows that were transformed.
+ */
+static void fft_rows_d(const int n, const double scale,
+        double* data, double* wsave)
+{
+    int row;
+#pragma omp parallel
+    {
+        double* work = (double*) malloc(2 * (size_t)n * sizeof(double));
+#pragma omp for schedule(dynamic, LINES_PER_CHUNK)
+        for (row = 0; row < n; ++row)
+        {
+            int i;
+            double* c = data + 2 * (size_t)row * n;
+            for (i = 0; i < 2 * n; ++i) if (c[i] != 0.0) break;
+            if (i == 2 * n) continue;
+            oskar_fftpack_cfftmf(1, n, n, 1, c, wsave, work);
+            if (scale != 1.0)
+                for (i = 0; i < 2 * n; ++i) c[i] *= scale;
+        }
+        free(work);
+    }
+}
+
+static void fft_rows_f(const int n, const double scale,
+        float* data, float* wsave)
+{
+    int row;
+#pragma omp parallel
+    {
+        float* work = (float*) malloc(2 * (size_t)n * sizeof(float));
+#pragma omp for schedule(dynamic, LINES_PER_CHUNK)
+        for (row = 0; row < n; ++row)
+        {
+            int i;
+            float* c = data + 2 * (size_t)row * n;
+            for (i = 0; i < 2 * n; ++i) if (c[i] != 0.0f) break;
+            if (i == 2 * n) continue;
+            oskar_fftpack_cfftmf_f(1, n, n, 1, c, wsave, work);
+            if (scale != 1.0)
+                for (i = 0; i < 2 * n; ++i) c[i] *= (float)scale;
+        }
+        free(work);
+    }
+}
+
+/*
+ * Transforms num_x columns of an n-by-n array, starting at column x0,
+ * keeping only the real part.
+ *
+ * The real part of the transform of column x is half the transform of
+ * its Hermitian-symmetric part, C(j) = B(j) + conj(B(n - j)), which has
+ * a real transform. Columns x and x + 1 are therefore transformed
+ * together as C_x + i * C_x+1, and separated afterwards.
+ */
+static void fft_columns_real_d(const int n, const int x0,
+        const int num_x, const double scale, double* data, double* wsave)
+{
+    int chunk;
+    const int x_end = x0 + num_x, num_pairs = (num_x + 1) / 2;
+    const int num_chunks = (num_pairs + LINES_PER_CHUNK - 1) / LINES_PER_CHUNK;
+#pragma omp parallel
+    {
+        const size_t len = 2 * LINES_PER_CHUNK * (size_t)n;
+        double* z = (double*) malloc(len * sizeof(double));
+        double* work = (double*) malloc(len * sizeof(double));
+#pragma omp for schedule(static)
+        for (chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            int j, k;
+            const int start = chunk * LINES_PER_CHUNK;
+            const int num = (num_pairs - start < LINES_PER_CHUNK) ?
+                    num_pairs - start : LINES_PER_CHUNK;
+            for (j = 0; j < n; ++j)
+            {
+                const double* b1 = data + 2 * (size_t)j * n;
+                const double* b2 = data + 2 * (size_t)((n - j) % n) * n;
+                for (k = 0; k < num; ++k)
+                {
+                    double c2_re = 0.0, c2_im = 0.0;
+                    const int x = x0 + 2 * (start + k);
+                    const double c1_re = b1[2 * x] + b2[2 * x];
+                    const double c1_im = b1[2 * x + 1] - b2[2 * x + 1];
+                    if (x + 1 < x_end)
+                    {
+                        c2_re = b1[2 * x + 2] + b2[2 * x + 2];
+                        c2_im = b1[2 * x + 3] - b2[2 * x + 3];
+                    }
+                    z[2 * ((size_t)k * n + j)]     = c1_re - c2_im;
+                    z[2 * ((size_t)k * n + j) + 1] = c1_im + c2_re;
+                }
+            }
+            oskar_fftpack_cfftmf(num, n, n, 1, z, wsave, work);
+            for (j = 0; j < n; ++j)
+            {
+                double* out = data + 2 * (size_t)j * n;
+                for (k = 0; k < num; ++k)
+                {
+                    const int x = x0 + 2 * (start + k);
+                    out[2 * x]     = z[2 * ((size_t)k * n + j)] * scale;
+                    out[2 * x + 1] = 0.0;
+                    if (x + 1 < x_end)
+                    {
+                        out[2 * x + 2] =
+                                z[2 * ((size_t)k * n + j) + 1] * scale;
+                        out[2 * x + 3] = 0.0;
+                    }
+                }
+            }
+        }
+        free(work);
+        free(z);
+    }
+}
+
+static void fft_columns_real_f(const int n, const int x0,
+        const int num_x, const double scale, float* data, float* wsave)
+{
+    int chunk;
+    const int x_end = x0 + num_x, num_pairs = (num_x + 1) / 2;
+    const int num_chunks = (num_pairs + LINES_PER_CHUNK - 1) / LINES_PER_CHUNK;
+#pragma omp parallel
+    {
+        const size_t len = 2 * LINES_PER_CHUNK * (size_t)n;
+        float* z = (float*) malloc(len * sizeof(float));
+        float* work = (float*) malloc(len * sizeof(float));
+#pragma omp for schedule(static)
+        for (chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            int j, k;
+            const int start = chunk * LINES_PER_CHUNK;
+            const int num = (num_pairs - start < LINES_PER_CHUNK) ?
+                    num_pairs - start : LINES_PER_CHUNK;
+            for (j = 0; j < n; ++j)
+            {
+                const float* b1 = data + 2 * (size_t)j * n;
+                const float* b2 = data + 2 * (size_t)((n - j) % n) * n;
+                for (k = 0; k < num; ++k)
+                {
+                    float c2_re = 0.0f, c2_im = 0.0f;
+                    const int x = x0 + 2 * (start + k);
+                    const float c1_re = b1[2 * x] + b2[2 * x];
+                    const float c1_im = b1[2 * x + 1] - b2[2 * x + 1];
+                    if (x + 1 < x_end)
+                    {
+                        c2_re = b1[2 * x + 2] + b2[2 * x + 2];
+                        c2_im = b1[2 * x + 3] - b2[2 * x + 3];
+                    }
+                    z[2 * ((size_t)k * n + j)]     = c1_re - c2_im;
+                    z[2 * ((size_t)k * n + j) + 1] = c1_im + c2_re;
+                }
+            }
+            oskar_fftpack_cfftmf_f(num, n, n, 1, z, wsave, work);
+            for (j = 0; j < n; ++j)
+            {
+                float* out = data + 2 * (size_t)j * n;
+                for (k = 0; k < num; ++k)
+                {
+                    const int x = x0 + 2 * (start + k);
+                    out[2 * x]     = z[2 * ((size_t)k * n + j)] * (float)scale;
+                    out[2 * x + 1] = 0.0f;
+                    if (x + 1 < x_end)
+                    {
+                        out[2 * x + 2] =
+                                z[2 * ((size_t)k * n + j) + 1] * (float)scale;
+                        out[2 * x + 3] = 0.0f;
+                    }
+                }
+            }
+        }
+        free(work);
+        free(z);
+    }
+}
+
+
+oskar_FFT* oskar_fft_create(int precision, int location, int num_dim,
+        int dim_size, int* status)
+{
+    oskar_FFT* h;
+    if (*status) return 0;
+    if (num_dim != 1 && num_dim != 2)
+    {
+        *status = OSKAR_ERR_INVALID_ARGUMENT;
+        return 0;
+    }
+    if (precision != OSKAR_SINGLE && precision != OSKAR_DOUBLE)
+    {
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+        return 0;
+    }
+    h = (oskar_FFT*) calloc(1, sizeof(oskar_FFT));
+    h->precision = precision;
+    h->location = location;
+    h->num_dim = num_dim;
+    h->dim_size = dim_size;
+    if (location == OSKAR_CPU)
+    {
+        /* Both dimensions have the same length, so share the tables. */
+        const int len = 2 * dim_size +
+                (int)(log((double)dim_size) / log(2.0)) + 4;
+        h->fftpack_wsave = oskar_mem_create(precision, OSKAR_CPU, len,
+                status);
+        if (precision == OSKAR_DOUBLE)
+            oskar_fftpack_cfftmi(dim_size,
+                    oskar_mem_double(h->fftpack_wsave, status));
+        else
+            oskar_fftpack_cfftmi_f(dim_size,
+                    oskar_mem_float(h->fftpack_wsave, status));
+    }
+    else if (location == OSKAR_GPU)
+    {
+#ifdef OSKAR_HAVE_CUDA
+        const cufftType type =
+                (precision == OSKAR_DOUBLE) ? CUFFT_Z2Z : CUFFT_C2C;
+        if (num_dim == 1)
+            cufftPlan1d(&h->cufft_plan, dim_size, type, 1);
+        else
+            cufftPlan2d(&h->cufft_plan, dim_size, dim_size, type);
+#else
+        *status = OSKAR_ERR_CUDA_NOT_AVAILABLE;
+#endif
+    }
+    else
+        *status = OSKAR_ERR_BAD_LOCATION;
+    return h;
+}
+
+
+void oskar_fft_exec(oskar_FFT* h, oskar_Mem* data, int* status)
+{
+    size_t num_cells;
+    if (*status) return;
+    num_cells = (size_t) h->dim_size;
+    if (h->num_dim == 2) num_cells *= h->dim_size;
+    if (!oskar_mem_is_complex(data) || oskar_mem_is_matrix(data) ||
+            oskar_mem_precision(data) != h->precision)
+    {
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+        return;
+    }
+    if (oskar_mem_length(data) < num_cells)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+    if (h->location == OSKAR_CPU)
+    {
+        const int n = h->dim_size;
+        oskar_Mem* data_cpu = data;
+        if (oskar_mem_location(data) != OSKAR_CPU)
+            data_cpu = oskar_mem_create_copy(data, OSKAR_CPU, status);
+        if (*status) return;
+
+        /* FFTPACK normalises each forward transform, so undo it while
+         * the last set of lines is still in cache. */
+        if (h->precision == OSKAR_DOUBLE)
+        {
+            double *c = oskar_mem_double(data_cpu, status);
+            double *wsave = oskar_mem_double(h->fftpack_wsave, status);
+            if (h->num_dim == 1)
+                fft_lines_d(1, 1, n, 1, n, (double)num_cells, c, wsave);
+            else
+            {
+                /* Transform columns, then rows. */
+                fft_lines_d(n, 1, n, n, 1, 1.0, c, wsave);
+                fft_lines_d(n, n, n, 1, n, (double)num_cells, c, wsave);
+            }
+        }
+        else
+        {
+            float *c = oskar_mem_float(data_cpu, status);
+            float *wsave = oskar_mem_float(h->fftpack_wsave, status);
+            if (h->num_dim == 1)
+                fft_lines_f(1, 1, n, 1, n, (double)num_cells, c, wsave);
+            else
+            {
+                /* Transform columns, then rows. */
+                fft_lines_f(n, 1, n, n, 1, 1.0, c, wsave);
+                fft_lines_f(n, n, n, 1, n, (double)num_cells, c, wsave);
+            }
+        }
+        if (data_cpu != data)
+        {
+            oskar_mem_copy(data, data_cpu, status);
+            oskar_mem_free(data_cpu, status);
+        }
+    }
+#ifdef OSKAR_HAVE_CUDA
+    else if (h->location == OSKAR_GPU)
+    {
+        oskar_Mem* data_gpu = data;
+        if (oskar_mem_location(data) != OSKAR_GPU)
+            data_gpu = oskar_mem_create_copy(data, OSKAR_GPU, status);
+        if (*status) return;
+        if (h->precision == OSKAR_DOUBLE)
+            cufftExecZ2Z(h->cufft_plan, oskar_mem_void(data_gpu),
+                    oskar_mem_void(data_gpu), CUFFT_FORWARD);
+        else
+            cufftExecC2C(h->cufft_plan, oskar_mem_void(data_gpu),
+                    oskar_mem_void(data_gpu), CUFFT_FORWARD);
+        if (data_gpu != data)
+        {
+            oskar_mem_copy(data, data_gpu, status);
+            oskar_mem_free(data_gpu, status);
+        }
+    }
+#endif
+}
+
+
+void oskar_fft_exec_pruned(oskar_FFT* h, oskar_Mem* data, int region_start,
+        int region_size, int real_only, int* status)
+{
+    size_t num_cells;
+    oskar_Mem* data_cpu;
+    const int n = h->dim_size;
+    if (*status) return;
+
+    /* Only 2D transforms on the CPU are pruned. */
+    if (h->location != OSKAR_CPU || h->num_dim != 2)
+    {
+        oskar_fft_exec(h, data, status);
+        return;
+    }
+    num_cells = (size_t)n * n;
+    if (!oskar_mem_is_complex(data) || oskar_mem_is_matrix(data) ||
+            oskar_mem_precision(data) != h->precision)
+    {
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+        return;
+    }
+    if (oskar_mem_length(data) < num_cells)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+    if (region_start < 0 || region_size < 0 || region_start + region_size > n)
+    {
+        *status = OSKAR_ERR_INVALID_ARGUMENT;
+        return;
+    }
+    data_cpu = data;
+    if (oskar_mem_location(data) != OSKAR_CPU)
+        data_cpu = oskar_mem_create_copy(data, OSKAR_CPU, status);
+    if (*status) return;
+
+    /* Transform rows, then the columns in the region. Undo the FFTPACK
+     * normalisation, and the factor of 2 from the Hermitian-symmetric
+     * columns if only the real part is needed. */
+    if (h->precision == OSKAR_DOUBLE)
+    {
+        double *c = oskar_mem_double(data_cpu, status);
+        double *wsave = oskar_mem_double(h->fftpack_wsave, status);
+        if (real_only)
+        {
+            fft_rows_d(n, 1.0, c, wsave);
+            fft_columns_real_d(n, region_start, region_size,
+                    0.5 * num_cells, c, wsave);
+        }
+        else
+        {
+            fft_rows_d(n, (double)num_cells, c, wsave);
+            fft_lines_d(region_size, 1, n, n, 1, 1.0,
+                    c + 2 * region_start, wsave);
+        }
+    }
+    else
+    {
+        float *c = oskar_mem_float(data_cpu, status);
+        float *wsave = oskar_mem_float(h->fftpack_wsave, status);
+        if (real_only)
+        {
+            fft_rows_f(n, 1.0, c, wsave);
+            fft_columns_real_f(n, region_start, region_size,
+                    0.5 * num_cells, c, wsave);
+        }
+        else
+        {
+            fft_rows_f(n, (double)num_cells, c, wsave);
+            fft_lines_f(region_size, 1, n, n, 1, 1.0,
+                    c + 2 * region_start, wsave);
+        }
+    }
+    if (data_cpu != data)
+    {
+        oskar_mem_copy(data, data_cpu, status);
+        oskar_mem_free(data_cpu, status);
+    }
+}
+
+
+void oskar_fft_exec_real(oskar_FFT* h, oskar_Mem* data, int* status)
+{
+    oskar_fft_exec_pruned(h, data, 0, h->dim_size, 1, status);
+}
+
+void oskar_fft_free(oskar_FFT* h)
+{
+    int status = 0;
+    if (!h) return;
+    oskar_mem_free(h->fftpack_wsave, &status);
+#ifdef OSKAR_HAVE_CUDA
+    if (h->location == OSKAR_GPU)
+        cufftDestroy(h->cufft_plan);
+#endif
+    free(h);
+}
+
+
+int oskar_fft_location(const oskar_FFT* h)
+{
+    return h->location;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "math/oskar_dftw.h"
+#include "math/oskar_dftw_multi.h"
+#include "math/oskar_cmath.h"
+#include "utility/oskar_get_error_string.h"
+
+#include <cmath>
+#include <cstdlib>
+
+static void run_test(int is_3d, int* status)
+{
+    const int num_in = 100, num_out = 500, num_channels = 10;
+    double wavenumber[num_channels];
+    oskar_Mem *x_in, *y_in, *z_in, *x_out, *y_out, *z_out;
+    oskar_Mem *weights, *w, *out_multi, *out, *out_c;
+
+    // Generate input data.
+    x_in = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_in, status);
+    y_in = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_in, status);
+    z_in = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_in, status);
+    x_out = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_out, status);
+    y_out = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_out, status);
+    z_out = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_out, status);
+    weights = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_in * num_channels, status);
+    oskar_mem_random_range(x_in, -20., 20., status);
+    oskar_mem_random_range(y_in, -20., 20., status);
+    oskar_mem_random_range(z_in, -1., 1., status);
+    oskar_mem_random_range(x_out, -0.5, 0.5, status);
+    oskar_mem_random_range(y_out, -0.5, 0.5, status);
+    oskar_mem_random_range(z_out, 0.5, 1., status);
+    oskar_mem_random_range(weights, -1., 1., status);
+    for (int c = 0; c < num_channels; ++c)
+        wavenumber[c] = 2.0 * M_PI * (100e6 + c * 1e6) / 299792458.0;
+    ASSERT_EQ(0, *status) << oskar_get_error_string(*status);
+
+    // Run DFT for all channels at once.
+    out_multi = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU, 0, status);
+    oskar_dftw_multi(num_in, num_channels, wavenumber, x_in, y_in,
+            is_3d ? z_in : 0, weights, num_in, num_out, x_out, y_out,
+            is_3d ? z_out : 0, out_multi, status);
+    ASSERT_EQ(0, *status) << oskar_get_error_string(*status);
+    ASSERT_EQ((size_t)(num_channels * num_out), oskar_mem_length(out_multi));
+
+    // Compare with a separate DFT for each channel.
+    w = oskar_mem_create_alias(0, 0, 0, status);
+    out_c = oskar_mem_create_alias(0, 0, 0, status);
+    out = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU, num_out, status);
+    for (int c = 0; c < num_channels; ++c)
+    {
+        oskar_mem_set_alias(w, weights, c * num_in, num_in, status);
+        oskar_mem_set_alias(out_c, out_multi, c * num_out, num_out, status);
+        oskar_dftw(num_in, wavenumber[c], x_in, y_in, is_3d ? z_in : 0, w,
+                num_out, x_out, y_out, is_3d ? z_out : 0, 0, out, status);
+        ASSERT_EQ(0, *status) << oskar_get_error_string(*status);
+        const double2* a = oskar_mem_double2_const(out, status);
+        const double2* b = oskar_mem_double2_const(out_c, status);
+        for (int i = 0; i < num_out; ++i)
+        {
+            EXPECT_NEAR(a[i].x, b[i].x, 1e-10);
+            EXPECT_NEAR(a[i].y, b[i].y, 1e-10);
+        }
+    }
+
+    // Free memory.
+    oskar_mem_free(x_in, status);
+    oskar_mem_free(y_in, status);
+    oskar_mem_free(z_in, status);
+    oskar_mem_free(x_out, status);
+    oskar_mem_free(y_out, status);
+    oskar_mem_free(z_out, status);
+    oskar_mem_free(weights, status);
+    oskar_mem_free(w, status);
+    oskar_mem_free(out_multi, status);
+    oskar_mem_free(out, status);
+    oskar_mem_free(out_c, status);
+}
+
+TEST(dftw_multi, o2c_2d)
+{
+    int status = 0;
+    run_test(0, &status);
+    EXPECT_EQ(0, status) << oskar_get_error_string(status);
+}
+
+TEST(dftw_multi, o2c_3d)
+{
+    int status = 0;
+    run_test(1, &status);
+    EXPECT_EQ(0, status) << oskar_get_error_string(status);
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "math/oskar_fft.h"
+#include "math/oskar_fftpack_cfft.h"
+#include "utility/oskar_get_error_string.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <cmath>
+#include <vector>
+
+TEST(fft, matches_fftpack_2d)
+{
+    // Use a size that is not a multiple of the chunk size.
+    int status = 0;
+    const int size = 90;
+    const size_t num_cells = size * size;
+    oskar_Mem* data = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_cells, &status);
+    oskar_mem_random_gaussian(data, 1, 2, 3, 4, 1.0, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // Transform a copy using FFTPACK directly.
+    std::vector<double> ref(2 * num_cells), work(2 * num_cells);
+    std::vector<double> wsave(4 * size + 2 * (int)(log(size) / log(2)) + 8);
+    const double* d = oskar_mem_double_const(data, &status);
+    for (size_t i = 0; i < 2 * num_cells; ++i) ref[i] = d[i];
+    oskar_fftpack_cfft2i(size, size, &wsave[0]);
+    oskar_fftpack_cfft2f(size, size, size, &ref[0], &wsave[0], &work[0]);
+    for (size_t i = 0; i < 2 * num_cells; ++i) ref[i] *= num_cells;
+
+    // Transform using the plan, with more than one thread if possible.
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    oskar_FFT* fft = oskar_fft_create(OSKAR_DOUBLE, OSKAR_CPU, 2, size,
+            &status);
+    oskar_fft_exec(fft, data, &status);
+#ifdef _OPENMP
+    omp_set_num_threads(max_threads);
+#endif
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    size_t num_different = 0;
+    for (size_t i = 0; i < 2 * num_cells; ++i)
+        if (d[i] != ref[i]) num_different++;
+    EXPECT_EQ(0u, num_different);
+
+    // Check that a mismatched type is rejected.
+    oskar_Mem* bad = oskar_mem_create(OSKAR_SINGLE_COMPLEX, OSKAR_CPU,
+            num_cells, &status);
+    oskar_fft_exec(fft, bad, &status);
+    EXPECT_EQ((int) OSKAR_ERR_BAD_DATA_TYPE, status);
+    status = 0;
+
+    // Clean up.
+    oskar_fft_free(fft);
+    oskar_mem_free(data, &status);
+    oskar_mem_free(bad, &status);
+}
+
+TEST(fft, real_output_matches_complex)
+{
+    // Use an odd size, and leave half of the rows empty.
+    int status = 0;
+    const int size = 91;
+    const size_t num_cells = size * size;
+    oskar_Mem* data = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_cells, &status);
+    oskar_mem_random_gaussian(data, 1, 2, 3, 4, 1.0, &status);
+    double* d = oskar_mem_double(data, &status);
+    for (size_t i = 0; i < num_cells; ++i) d[i] = 0.0;
+    oskar_Mem* ref = oskar_mem_create_copy(data, OSKAR_CPU, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // Compare the real part against the full complex transform.
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    oskar_FFT* fft = oskar_fft_create(OSKAR_DOUBLE, OSKAR_CPU, 2, size,
+            &status);
+    oskar_fft_exec(fft, ref, &status);
+    oskar_fft_exec_real(fft, data, &status);
+#ifdef _OPENMP
+    omp_set_num_threads(max_threads);
+#endif
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    const double* r = oskar_mem_double_const(ref, &status);
+    for (size_t i = 0; i < num_cells; ++i)
+    {
+        ASSERT_NEAR(r[2 * i], d[2 * i], 1e-9 * size);
+        ASSERT_EQ(0.0, d[2 * i + 1]);
+    }
+
+    // Clean up.
+    oskar_fft_free(fft);
+    oskar_mem_free(data, &status);
+    oskar_mem_free(ref, &status);
+}
+
+TEST(fft, pruned_region_matches_full)
+{
+    // Use a grid with empty rows, and an odd-sized region.
+    int status = 0;
+    const int size = 96, region_size = 79, start = (size - region_size) / 2;
+    const size_t num_cells = size * size;
+    oskar_Mem* ref = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+            num_cells, &status);
+    oskar_mem_random_gaussian(ref, 1, 2, 3, 4, 1.0, &status);
+    double* r = oskar_mem_double(ref, &status);
+    for (int y = 0; y < size; y += 3)
+        for (int x = 0; x < 2 * size; ++x) r[2 * y * size + x] = 0.0;
+    oskar_Mem* data[2];
+    for (int i = 0; i < 2; ++i)
+        data[i] = oskar_mem_create_copy(ref, OSKAR_CPU, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // Compare the region against the full transform.
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    oskar_FFT* fft = oskar_fft_create(OSKAR_DOUBLE, OSKAR_CPU, 2, size,
+            &status);
+    oskar_fft_exec(fft, ref, &status);
+    for (int i = 0; i < 2; ++i)
+        oskar_fft_exec_pruned(fft, data[i], start, region_size, i, &status);
+#ifdef _OPENMP
+    omp_set_num_threads(max_threads);
+#endif
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    for (int i = 0; i < 2; ++i)
+    {
+        const double* d = oskar_mem_double_const(data[i], &status);
+        for (int y = start; y < start + region_size; ++y)
+        {
+            for (int x = start; x < start + region_size; ++x)
+            {
+                const size_t j = 2 * ((size_t)y * size + x);
+                ASSERT_NEAR(r[j], d[j], 1e-9 * size);
+                ASSERT_NEAR(i ? 0.0 : r[j + 1], d[j + 1], 1e-9 * size);
+            }
+        }
+    }
+
+    // Check that a region outside the array is rejected.
+    oskar_fft_exec_pruned(fft, data[0], start, size, 0, &status);
+    EXPECT_EQ((int) OSKAR_ERR_INVALID_ARGUMENT, status);
+    status = 0;
+
+    // Clean up.
+    oskar_fft_free(fft);
+    oskar_mem_free(ref, &status);
+    for (int i = 0; i < 2; ++i)
+        oskar_mem_free(data[i], &status);
+}
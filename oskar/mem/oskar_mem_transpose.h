@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_MEM_TRANSPOSE_H_
+#define OSKAR_MEM_TRANSPOSE_H_
+
+/**
+ * @file oskar_mem_transpose.h
+ */
+
+#include <oskar_global.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Transposes a batch of two-dimensional arrays.
+ *
+ * @details
+ * The input is treated as \p num_batches consecutive arrays, each with
+ * \p num_rows rows of \p num_cols elements, and each array is written
+ * transposed to the output. Element (r, c) of batch b therefore moves from
+ * index (b * num_rows + r) * num_cols + c in the input to index
+ * (b * num_cols + c) * num_rows + r in the output.
+ *
+ * Each element of the array type is moved as a whole, so for a complex
+ * matrix type all four polarisations stay together.
+ *
+ * The input and output types must be the same, apart from their precision.
+ * If the precisions differ, values are converted as they are copied.
+ *
+ * The arrays are processed in square tiles, so that both reads and writes
+ * stay in cache, and tiles are transposed in parallel using OpenMP.
+ * Both arrays must be in CPU memory, and must not overlap.
+ *
+ * @param[in] in           Input array.
+ * @param[in,out] out      Output array.
+ * @param[in] num_batches  Number of arrays to transpose.
+ * @param[in] num_rows     Number of rows in each input array.
+ * @param[in] num_cols     Number of columns in each input array.
+ * @param[in,out] status   Status return code.
+ */
+OSKAR_EXPORT
+void oskar_mem_transpose(const oskar_Mem* in, oskar_Mem* out,
+        size_t num_batches, size_t num_rows, size_t num_cols, int* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_MEM_TRANSPOSE_H_ */
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/oskar_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of elements along each side of a tile. */
+#define TILE_SIZE 16
+
+#define TRANSPOSE_TILE(NAME, IN_TYPE, OUT_TYPE)                             \
+static void NAME(const void* in_void, void* out_void, size_t n,             \
+        size_t num_rows, size_t num_cols, size_t batch,                     \
+        size_t r0, size_t r1, size_t c0, size_t c1)                         \
+{                                                                           \
+    size_t r, c, k;                                                         \
+    const IN_TYPE* in = (const IN_TYPE*) in_void +                          \
+            batch * num_rows * num_cols * n;                                \
+    OUT_TYPE* out = (OUT_TYPE*) out_void + batch * num_rows * num_cols * n; \
+    for (r = r0; r < r1; ++r)                                               \
+    {                                                                       \
+        for (c = c0; c < c1; ++c)                                           \
+        {                                                                   \
+            const IN_TYPE* src = in + (r * num_cols + c) * n;               \
+            OUT_TYPE* dst = out + (c * num_rows + r) * n;                   \
+            for (k = 0; k < n; ++k) dst[k] = (OUT_TYPE) src[k];             \
+        }                                                                   \
+    }                                                                       \
+}
+
+TRANSPOSE_TILE(transpose_tile_ff, float, float)
+TRANSPOSE_TILE(transpose_tile_fd, float, double)
+TRANSPOSE_TILE(transpose_tile_df, double, float)
+TRANSPOSE_TILE(transpose_tile_dd, double, double)
+
+#undef TRANSPOSE_TILE
+
+void oskar_mem_transpose(const oskar_Mem* in, oskar_Mem* out,
+        size_t num_batches, size_t num_rows, size_t num_cols, int* status)
+{
+    int tile, num_tiles;
+    size_t n, num_tile_rows, num_tile_cols, tiles_per_batch;
+    const void* in_data;
+    void* out_data;
+    void (*transpose_tile)(const void*, void*, size_t, size_t, size_t,
+            size_t, size_t, size_t, size_t, size_t) = 0;
+    if (*status) return;
+
+    /* Check types, locations and dimensions. */
+    if ((oskar_mem_type(in) & ~(OSKAR_SINGLE | OSKAR_DOUBLE)) !=
+            (oskar_mem_type(out) & ~(OSKAR_SINGLE | OSKAR_DOUBLE)))
+    {
+        *status = OSKAR_ERR_TYPE_MISMATCH;
+        return;
+    }
+    if (oskar_mem_location(in) != OSKAR_CPU ||
+            oskar_mem_location(out) != OSKAR_CPU)
+    {
+        *status = OSKAR_ERR_BAD_LOCATION;
+        return;
+    }
+    if (oskar_mem_length(in) < num_batches * num_rows * num_cols ||
+            oskar_mem_length(out) < num_batches * num_rows * num_cols)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+    if (num_batches == 0 || num_rows == 0 || num_cols == 0) return;
+
+    /* Select the tile function for the input and output precisions. */
+    if (oskar_mem_precision(in) == OSKAR_SINGLE)
+        transpose_tile = (oskar_mem_precision(out) == OSKAR_SINGLE) ?
+                transpose_tile_ff : transpose_tile_fd;
+    else if (oskar_mem_precision(in) == OSKAR_DOUBLE)
+        transpose_tile = (oskar_mem_precision(out) == OSKAR_SINGLE) ?
+                transpose_tile_df : transpose_tile_dd;
+    if (!transpose_tile ||
+            (oskar_mem_precision(out) != OSKAR_SINGLE &&
+                    oskar_mem_precision(out) != OSKAR_DOUBLE))
+    {
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+        return;
+    }
+
+    /* Get the number of real values in each element. */
+    n = 1;
+    if (oskar_mem_is_complex(in)) n *= 2;
+    if (oskar_mem_is_matrix(in)) n *= 4;
+
+    /* Transpose all tiles in parallel. */
+    num_tile_rows = (num_rows + TILE_SIZE - 1) / TILE_SIZE;
+    num_tile_cols = (num_cols + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_per_batch = num_tile_rows * num_tile_cols;
+    num_tiles = (int) (num_batches * tiles_per_batch);
+    in_data = oskar_mem_void_const(in);
+    out_data = oskar_mem_void(out);
+#pragma omp parallel for schedule(static)
+    for (tile = 0; tile < num_tiles; ++tile)
+    {
+        size_t batch, r0, c0, r1, c1, t;
+        batch = tile / tiles_per_batch;
+        t = tile % tiles_per_batch;
+        r0 = (t / num_tile_cols) * TILE_SIZE;
+        c0 = (t % num_tile_cols) * TILE_SIZE;
+        r1 = r0 + TILE_SIZE < num_rows ? r0 + TILE_SIZE : num_rows;
+        c1 = c0 + TILE_SIZE < num_cols ? c0 + TILE_SIZE : num_cols;
+        transpose_tile(in_data, out_data, n, num_rows, num_cols,
+                batch, r0, r1, c0, c1);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
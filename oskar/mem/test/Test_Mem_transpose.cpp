@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mem/oskar_mem.h"
+#include "utility/oskar_get_error_string.h"
+
+TEST(Mem, transpose_matrix)
+{
+    // Use dimensions that are not multiples of the tile size.
+    int status = 0;
+    const size_t num_batches = 3, num_rows = 37, num_cols = 21;
+    const size_t n = num_batches * num_rows * num_cols;
+    oskar_Mem *in, *out;
+    in = oskar_mem_create(OSKAR_DOUBLE_COMPLEX_MATRIX, OSKAR_CPU, n, &status);
+    out = oskar_mem_create(OSKAR_DOUBLE_COMPLEX_MATRIX, OSKAR_CPU, n, &status);
+    double* in_ = oskar_mem_double(in, &status);
+    for (size_t i = 0; i < 8 * n; ++i) in_[i] = (double) i;
+
+    // Transpose and check contents.
+    oskar_mem_transpose(in, out, num_batches, num_rows, num_cols, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    const double* out_ = oskar_mem_double_const(out, &status);
+    for (size_t b = 0; b < num_batches; ++b)
+        for (size_t r = 0; r < num_rows; ++r)
+            for (size_t c = 0; c < num_cols; ++c)
+                for (size_t k = 0; k < 8; ++k)
+                {
+                    const size_t i = ((b * num_rows + r) * num_cols + c) * 8;
+                    const size_t j = ((b * num_cols + c) * num_rows + r) * 8;
+                    ASSERT_EQ(in_[i + k], out_[j + k]);
+                }
+
+    // Free memory.
+    oskar_mem_free(in, &status);
+    oskar_mem_free(out, &status);
+}
+
+TEST(Mem, transpose_convert_precision)
+{
+    int status = 0;
+    const size_t num_rows = 50, num_cols = 70, n = num_rows * num_cols;
+    oskar_Mem *in, *out, *bad;
+    in = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU, n, &status);
+    out = oskar_mem_create(OSKAR_SINGLE_COMPLEX, OSKAR_CPU, n, &status);
+    oskar_mem_random_uniform(in, 1, 2, 3, 4, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // Transpose and check contents.
+    oskar_mem_transpose(in, out, 1, num_rows, num_cols, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    const double2* in_ = oskar_mem_double2_const(in, &status);
+    const float2* out_ = oskar_mem_float2_const(out, &status);
+    for (size_t r = 0; r < num_rows; ++r)
+        for (size_t c = 0; c < num_cols; ++c)
+        {
+            EXPECT_EQ((float) in_[r * num_cols + c].x,
+                    out_[c * num_rows + r].x);
+            EXPECT_EQ((float) in_[r * num_cols + c].y,
+                    out_[c * num_rows + r].y);
+        }
+
+    // Check that mismatched types are rejected.
+    bad = oskar_mem_create(OSKAR_SINGLE, OSKAR_CPU, n, &status);
+    oskar_mem_transpose(in, bad, 1, num_rows, num_cols, &status);
+    EXPECT_EQ((int) OSKAR_ERR_TYPE_MISMATCH, status);
+    status = 0;
+
+    // Free memory.
+    oskar_mem_free(in, &status);
+    oskar_mem_free(out, &status);
+    oskar_mem_free(bad, &status);
+}
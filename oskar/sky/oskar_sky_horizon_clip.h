@@ -60,6 +60,29 @@ void oskar_sky_horizon_clip(oskar_Sky* out, const oskar_Sky* in,
         const oskar_Telescope* telescope, double gast,
         oskar_StationWork* work, int* status);
 
+/**
+ * @brief
+ * Compacts a sky model into another one by removing sources below the
+ * horizon of all stations at all of the given times.
+ *
+ * @details
+ * Copies sources into another sky model that are above the horizon of
+ * stations at any of the given times, so that any source that rises or
+ * sets during the time range is retained.
+ *
+ * @param[out] out          The output sky model.
+ * @param[in]  in           The input sky model.
+ * @param[in]  telescope    The telescope model.
+ * @param[in]  num_times    The number of times.
+ * @param[in]  gast         The Greenwich Apparent Sidereal Time of each time.
+ * @param[in]  work         Work arrays.
+ * @param[in,out]  status   Status return code.
+ */
+OSKAR_EXPORT
+void oskar_sky_horizon_clip_times(oskar_Sky* out, const oskar_Sky* in,
+        const oskar_Telescope* telescope, int num_times, const double* gast,
+        oskar_StationWork* work, int* status);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,12 +36,29 @@ extern "C" {
 #endif
 
 static double ha0(double longitude, double ra0, double gast);
+static void horizon_clip(oskar_Sky* out, const oskar_Sky* in,
+        const oskar_Telescope* telescope, int num_times, const double* gast,
+        oskar_StationWork* work, int* status);
 
 void oskar_sky_horizon_clip(oskar_Sky* out, const oskar_Sky* in,
         const oskar_Telescope* telescope, double gast,
         oskar_StationWork* work, int* status)
 {
-    int i, num_stations, location, num_in;
+    horizon_clip(out, in, telescope, 1, &gast, work, status);
+}
+
+void oskar_sky_horizon_clip_times(oskar_Sky* out, const oskar_Sky* in,
+        const oskar_Telescope* telescope, int num_times, const double* gast,
+        oskar_StationWork* work, int* status)
+{
+    horizon_clip(out, in, telescope, num_times, gast, work, status);
+}
+
+static void horizon_clip(oskar_Sky* out, const oskar_Sky* in,
+        const oskar_Telescope* telescope, int num_times, const double* gast,
+        oskar_StationWork* work, int* status)
+{
+    int i, t, num_stations, location, num_in;
     oskar_Mem *horizon_mask, *source_indices;
     double ra0, dec0;
 
@@ -87,13 +104,17 @@ void oskar_sky_horizon_clip(oskar_Sky* out, const oskar_Sky* in,
     /* Create the horizon mask. */
     oskar_mem_clear_contents(horizon_mask, status);
     num_stations = oskar_telescope_num_stations(telescope);
-    for (i = 0; i < num_stations; ++i)
+    for (t = 0; t < num_times; ++t)
     {
-        const oskar_Station* s = oskar_telescope_station_const(telescope, i);
-        oskar_update_horizon_mask(num_in, oskar_sky_l_const(in),
-                oskar_sky_m_const(in), oskar_sky_n_const(in),
-                ha0(oskar_station_lon_rad(s), ra0, gast), dec0,
-                oskar_station_lat_rad(s), horizon_mask, status);
+        for (i = 0; i < num_stations; ++i)
+        {
+            const oskar_Station* s;
+            s = oskar_telescope_station_const(telescope, i);
+            oskar_update_horizon_mask(num_in, oskar_sky_l_const(in),
+                    oskar_sky_m_const(in), oskar_sky_n_const(in),
+                    ha0(oskar_station_lon_rad(s), ra0, gast[t]), dec0,
+                    oskar_station_lat_rad(s), horizon_mask, status);
+        }
     }
 
     /* Apply exclusive prefix sum to mask to get source output indices. */
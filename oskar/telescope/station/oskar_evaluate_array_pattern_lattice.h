@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_EVALUATE_ARRAY_PATTERN_LATTICE_H_
+#define OSKAR_EVALUATE_ARRAY_PATTERN_LATTICE_H_
+
+/**
+ * @file oskar_evaluate_array_pattern_lattice.h
+ */
+
+#include <oskar_global.h>
+#include <mem/oskar_mem.h>
+#include <telescope/station/oskar_station.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Evaluates the array pattern of a separable lattice (single precision).
+ *
+ * @details
+ * Evaluates the array pattern of a station made up of one or more
+ * sub-lattices, where each sub-lattice has an element at every combination
+ * of its x- and y-coordinates. The station must be planar, and the
+ * beamforming weights must be the geometric phases only.
+ *
+ * The pattern of each sub-lattice is the product of a sum over its
+ * x-coordinates and a sum over its y-coordinates, so the cost per point
+ * is proportional to (nx + ny) rather than (nx * ny).
+ *
+ * The result is not normalised.
+ *
+ * @param[in] num_groups   Number of sub-lattices.
+ * @param[in] size         Number of x- and y-coordinates in each sub-lattice.
+ * @param[in] lattice_x    x-coordinates of all sub-lattices, in metres.
+ * @param[in] lattice_y    y-coordinates of all sub-lattices, in metres.
+ * @param[in] wavenumber   Wavenumber (2 pi / wavelength).
+ * @param[in] beam_x       Beam x direction cosine.
+ * @param[in] beam_y       Beam y direction cosine.
+ * @param[in] num_points   Number of output points.
+ * @param[in] x            Output point x direction cosines.
+ * @param[in] y            Output point y direction cosines.
+ * @param[out] output      Output complex array pattern.
+ */
+OSKAR_EXPORT
+void oskar_evaluate_array_pattern_lattice_f(const int num_groups,
+        const int* size, const double* lattice_x, const double* lattice_y,
+        const double wavenumber, const double beam_x, const double beam_y,
+        const int num_points, const float* x, const float* y,
+        float2* output);
+
+/**
+ * @brief
+ * Evaluates the array pattern of a separable lattice (double precision).
+ *
+ * @details
+ * Evaluates the array pattern of a station made up of one or more
+ * sub-lattices, where each sub-lattice has an element at every combination
+ * of its x- and y-coordinates. The station must be planar, and the
+ * beamforming weights must be the geometric phases only.
+ *
+ * The pattern of each sub-lattice is the product of a sum over its
+ * x-coordinates and a sum over its y-coordinates, so the cost per point
+ * is proportional to (nx + ny) rather than (nx * ny).
+ *
+ * The result is not normalised.
+ *
+ * @param[in] num_groups   Number of sub-lattices.
+ * @param[in] size         Number of x- and y-coordinates in each sub-lattice.
+ * @param[in] lattice_x    x-coordinates of all sub-lattices, in metres.
+ * @param[in] lattice_y    y-coordinates of all sub-lattices, in metres.
+ * @param[in] wavenumber   Wavenumber (2 pi / wavelength).
+ * @param[in] beam_x       Beam x direction cosine.
+ * @param[in] beam_y       Beam y direction cosine.
+ * @param[in] num_points   Number of output points.
+ * @param[in] x            Output point x direction cosines.
+ * @param[in] y            Output point y direction cosines.
+ * @param[out] output      Output complex array pattern.
+ */
+OSKAR_EXPORT
+void oskar_evaluate_array_pattern_lattice_d(const int num_groups,
+        const int* size, const double* lattice_x, const double* lattice_y,
+        const double wavenumber, const double beam_x, const double beam_y,
+        const int num_points, const double* x, const double* y,
+        double2* output);
+
+/**
+ * @brief
+ * Evaluates the array pattern of a station with a separable lattice.
+ *
+ * @details
+ * Evaluates the (unnormalised) array pattern of a station for which
+ * oskar_station_num_lattice_groups() is greater than zero, using the
+ * sub-lattices found by oskar_station_analyse().
+ *
+ * This gives the same result as oskar_dftw() with the geometric
+ * beamforming weights for the station, but at a lower cost.
+ *
+ * Only CPU memory is currently supported.
+ *
+ * @param[in] station      Station model.
+ * @param[in] wavenumber   Wavenumber (2 pi / wavelength).
+ * @param[in] beam_x       Beam x direction cosine.
+ * @param[in] beam_y       Beam y direction cosine.
+ * @param[in] num_points   Number of output points.
+ * @param[in] x            Output point x direction cosines.
+ * @param[in] y            Output point y direction cosines.
+ * @param[out] output      Output complex array pattern.
+ * @param[in,out] status   Status return code.
+ */
+OSKAR_EXPORT
+void oskar_evaluate_array_pattern_lattice(const oskar_Station* station,
+        double wavenumber, double beam_x, double beam_y, int num_points,
+        const oskar_Mem* x, const oskar_Mem* y, oskar_Mem* output,
+        int* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_EVALUATE_ARRAY_PATTERN_LATTICE_H_ */
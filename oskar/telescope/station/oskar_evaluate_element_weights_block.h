@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OSKAR_EVALUATE_ELEMENT_WEIGHTS_BLOCK_H_
+#define OSKAR_EVALUATE_ELEMENT_WEIGHTS_BLOCK_H_
+
+/**
+ * @file oskar_evaluate_element_weights_block.h
+ */
+
+#include <oskar_global.h>
+#include <telescope/oskar_telescope.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief
+ * Evaluates element beamforming weights for a block of times and channels.
+ *
+ * @details
+ * This function evaluates the beamforming weights for the given stations
+ * (and all their child stations), for all the given times and channels,
+ * into a contiguous array held in the station work buffer.
+ * The weights are the same as those returned by
+ * oskar_evaluate_element_weights(), but the beam direction and the
+ * time-variable errors are evaluated only once per station and time,
+ * rather than once per station, time and channel.
+ *
+ * Subsequent station beam evaluations using the same work buffer
+ * use the stored weights if the station, time index, GAST and frequency
+ * all match; otherwise the weights are evaluated as before.
+ * Weights for any previous block are discarded.
+ *
+ * If the block would be too large, no weights are stored.
+ *
+ * @param[in,out] work         Station work buffer.
+ * @param[in] tel              Pointer to telescope model.
+ * @param[in] num_stations     Number of stations to include.
+ * @param[in] station_ids      Indices of stations to include.
+ *                             If NULL, stations 0 to num_stations-1 are used.
+ * @param[in] num_channels     Number of channels in the block.
+ * @param[in] frequency_hz     Frequency of each channel, in Hz.
+ * @param[in] start_time_index Time index of the first time in the block.
+ * @param[in] num_times        Number of times in the block.
+ * @param[in] gast             GAST of each time in the block, in radians.
+ * @param[in,out] status       Status return code.
+ */
+OSKAR_EXPORT
+void oskar_evaluate_element_weights_block(oskar_StationWork* work,
+        const oskar_Telescope* tel, int num_stations, const int* station_ids,
+        int num_channels, const double* frequency_hz, int start_time_index,
+        int num_times, const double* gast, int* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSKAR_EVALUATE_ELEMENT_WEIGHTS_BLOCK_H_ */
@@ -164,6 +164,9 @@ int oskar_station_apply_element_errors(const oskar_Station* model);
 OSKAR_EXPORT
 int oskar_station_apply_element_weight(const oskar_Station* model);
 
+OSKAR_EXPORT
+int oskar_station_num_lattice_groups(const oskar_Station* model);
+
 OSKAR_EXPORT
 unsigned int oskar_station_seed_time_variable_errors(const oskar_Station* model);
 
@@ -46,6 +46,12 @@ struct oskar_StationWork;
 typedef struct oskar_StationWork oskar_StationWork;
 #endif /* OSKAR_STATION_WORK_TYPEDEF_ */
 
+struct oskar_Station;
+#ifndef OSKAR_STATION_TYPEDEF_
+#define OSKAR_STATION_TYPEDEF_
+typedef struct oskar_Station oskar_Station;
+#endif /* OSKAR_STATION_TYPEDEF_ */
+
 /**
  * @brief Creates a station work buffer structure.
  *
@@ -100,6 +106,48 @@ OSKAR_EXPORT
 oskar_Mem* oskar_station_work_beam(oskar_StationWork* work,
         const oskar_Mem* output_beam, size_t length, int depth, int* status);
 
+/**
+ * @brief Sets whether array patterns are evaluated for all channels at once.
+ *
+ * @details
+ * If enabled, the array pattern of a station without child stations is
+ * evaluated for all channels of the current weights block
+ * (see oskar_evaluate_element_weights_block()) in a single pass,
+ * the first time it is required at each time index. The stored patterns
+ * are then used for the remaining channels at that time.
+ *
+ * This is only useful if successive calls for the same station differ
+ * only in their frequency. Any stored array patterns are discarded when
+ * this function is called, so it must be called again whenever the
+ * contents of the input coordinate arrays change.
+ *
+ * @param[in] work   Pointer to station work buffer structure.
+ * @param[in] value  If true, evaluate array patterns for all channels.
+ */
+OSKAR_EXPORT
+void oskar_station_work_set_multi_channel(oskar_StationWork* work,
+        int value);
+
+/**
+ * @brief Returns precomputed beamforming weights for a station, if available.
+ *
+ * @details
+ * Returns an alias to the beamforming weights for the given station,
+ * frequency and time, if they were evaluated by
+ * oskar_evaluate_element_weights_block(), or NULL if they were not.
+ *
+ * @param[in] work          Pointer to station work buffer structure.
+ * @param[in] station       Pointer to station model.
+ * @param[in] frequency_hz  Frequency, in Hz.
+ * @param[in] gast          Greenwich apparent sidereal time, in radians.
+ * @param[in] time_index    Time index of simulation.
+ * @param[in,out] status    Status return code.
+ */
+OSKAR_EXPORT
+const oskar_Mem* oskar_station_work_block_weights(oskar_StationWork* work,
+        const oskar_Station* station, double frequency_hz, double gast,
+        int time_index, int* status);
+
 #ifdef __cplusplus
 }
 #endif
@@ -76,6 +76,10 @@ struct oskar_Station
     int apply_element_errors;     /* True if element gain and phase errors should be applied (auto determined; default false). */
     int apply_element_weight;     /* True if weights should be modified by user-supplied complex beamforming weights (auto determined; default false). */
     unsigned int seed_time_variable_errors;   /* Seed for time variable errors. */
+    int num_lattice_groups;       /* Number of separable sub-lattices in the layout, or 0 if not separable (auto determined). */
+    oskar_Mem* lattice_size_cpu;  /* Integer array of number of x and y values in each separable sub-lattice, guaranteed to be in CPU memory. */
+    oskar_Mem* lattice_x_cpu;     /* X coordinate values of each separable sub-lattice, guaranteed to be in CPU memory. */
+    oskar_Mem* lattice_y_cpu;     /* Y coordinate values of each separable sub-lattice, guaranteed to be in CPU memory. */
     oskar_Mem* element_true_x_enu_metres;     /* True horizon element x-coordinates, in metres, towards East. */
     oskar_Mem* element_true_y_enu_metres;     /* True horizon element y-coordinates, in metres, towards North. */
     oskar_Mem* element_true_z_enu_metres;     /* True horizon element z-coordinates, in metres, towards the zenith. */
@@ -49,6 +49,25 @@ struct oskar_StationWork
 
     int num_depths;
     oskar_Mem** beam;            /* For hierarchical stations. */
+
+    /* Beamforming weights for a block of times and channels. */
+    oskar_Mem* weights_block;    /* Complex scalar. */
+    oskar_Mem* weights_block_alias; /* Alias into weights_block. */
+    int weights_block_start_time;
+    int weights_block_num_times;
+    int weights_block_num_channels;
+    int weights_block_num_offsets;
+    int* weights_block_offset;   /* Indexed by station unique ID. */
+    double* weights_block_gast;  /* Key: GAST of each time, in radians. */
+    double* weights_block_freq_hz; /* Key: Frequency of each channel. */
+
+    /* Array patterns for all channels of the weights block. */
+    int multi_channel;           /* True if enabled. */
+    int array_pattern_block_num; /* Length of the arrays below. */
+    oskar_Mem** array_pattern_block; /* Indexed by station unique ID. */
+    int* array_pattern_block_time;   /* Time index of each, or -1. */
+    int* array_pattern_block_points; /* Number of points in each. */
+    oskar_Mem* array_pattern_block_alias; /* Alias into a block. */
 };
 
 #ifndef OSKAR_STATION_WORK_TYPEDEF_
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "telescope/station/oskar_evaluate_array_pattern_lattice.h"
+#include "telescope/station/private_station.h"
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Single precision. */
+void oskar_evaluate_array_pattern_lattice_f(const int num_groups,
+        const int* size, const double* lattice_x, const double* lattice_y,
+        const double wavenumber, const double beam_x, const double beam_y,
+        const int num_points, const float* x, const float* y,
+        float2* output)
+{
+    int i = 0;
+
+    /* Loop over output points. */
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        int g, j;
+        float kx, ky;
+        float2 out;
+        const double *lx = lattice_x, *ly = lattice_y;
+
+        /* Get the phase gradients relative to the beam direction. */
+        kx = (float) (wavenumber * (x[i] - beam_x));
+        ky = (float) (wavenumber * (y[i] - beam_y));
+
+        /* Sum the product of the x and y sums of each sub-lattice. */
+        out.x = 0.0f;
+        out.y = 0.0f;
+        for (g = 0; g < num_groups; ++g)
+        {
+            float2 sx, sy;
+            sx.x = sx.y = sy.x = sy.y = 0.0f;
+            for (j = 0; j < size[2 * g]; ++j)
+            {
+                const float a = kx * (float)lx[j];
+                sx.x += cosf(a);
+                sx.y += sinf(a);
+            }
+            for (j = 0; j < size[2 * g + 1]; ++j)
+            {
+                const float a = ky * (float)ly[j];
+                sy.x += cosf(a);
+                sy.y += sinf(a);
+            }
+            out.x += sx.x * sy.x - sx.y * sy.y;
+            out.y += sx.x * sy.y + sx.y * sy.x;
+            lx += size[2 * g];
+            ly += size[2 * g + 1];
+        }
+        output[i] = out;
+    }
+}
+
+/* Double precision. */
+void oskar_evaluate_array_pattern_lattice_d(const int num_groups,
+        const int* size, const double* lattice_x, const double* lattice_y,
+        const double wavenumber, const double beam_x, const double beam_y,
+        const int num_points, const double* x, const double* y,
+        double2* output)
+{
+    int i = 0;
+
+    /* Loop over output points. */
+    #pragma omp parallel for private(i)
+    for (i = 0; i < num_points; ++i)
+    {
+        int g, j;
+        double kx, ky;
+        double2 out;
+        const double *lx = lattice_x, *ly = lattice_y;
+
+        /* Get the phase gradients relative to the beam direction. */
+        kx = wavenumber * (x[i] - beam_x);
+        ky = wavenumber * (y[i] - beam_y);
+
+        /* Sum the product of the x and y sums of each sub-lattice. */
+        out.x = 0.0;
+        out.y = 0.0;
+        for (g = 0; g < num_groups; ++g)
+        {
+            double2 sx, sy;
+            sx.x = sx.y = sy.x = sy.y = 0.0;
+            for (j = 0; j < size[2 * g]; ++j)
+            {
+                const double a = kx * lx[j];
+                sx.x += cos(a);
+                sx.y += sin(a);
+            }
+            for (j = 0; j < size[2 * g + 1]; ++j)
+            {
+                const double a = ky * ly[j];
+                sy.x += cos(a);
+                sy.y += sin(a);
+            }
+            out.x += sx.x * sy.x - sx.y * sy.y;
+            out.y += sx.x * sy.y + sx.y * sy.x;
+            lx += size[2 * g];
+            ly += size[2 * g + 1];
+        }
+        output[i] = out;
+    }
+}
+
+/* Wrapper. */
+void oskar_evaluate_array_pattern_lattice(const oskar_Station* station,
+        double wavenumber, double beam_x, double beam_y, int num_points,
+        const oskar_Mem* x, const oskar_Mem* y, oskar_Mem* output,
+        int* status)
+{
+    int type, num_groups;
+    const int* size;
+    const double *lattice_x, *lattice_y;
+
+    /* Check if safe to proceed. */
+    if (*status) return;
+
+    /* Check the station has a separable lattice. */
+    num_groups = station->num_lattice_groups;
+    if (num_groups <= 0)
+    {
+        *status = OSKAR_ERR_INVALID_ARGUMENT;
+        return;
+    }
+
+    /* Check location and types. */
+    type = oskar_mem_precision(output);
+    if (oskar_mem_location(output) != OSKAR_CPU ||
+            oskar_mem_location(x) != OSKAR_CPU ||
+            oskar_mem_location(y) != OSKAR_CPU)
+    {
+        *status = OSKAR_ERR_BAD_LOCATION;
+        return;
+    }
+    if (!oskar_mem_is_complex(output) || oskar_mem_is_matrix(output))
+    {
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+        return;
+    }
+    if (oskar_mem_type(x) != type || oskar_mem_type(y) != type)
+    {
+        *status = OSKAR_ERR_TYPE_MISMATCH;
+        return;
+    }
+    if ((int)oskar_mem_length(x) < num_points ||
+            (int)oskar_mem_length(y) < num_points)
+    {
+        *status = OSKAR_ERR_DIMENSION_MISMATCH;
+        return;
+    }
+
+    /* Resize output array if required. */
+    if ((int)oskar_mem_length(output) < num_points)
+        oskar_mem_realloc(output, num_points, status);
+    if (*status) return;
+
+    /* Evaluate the array pattern. */
+    size = oskar_mem_int_const(station->lattice_size_cpu, status);
+    lattice_x = oskar_mem_double_const(station->lattice_x_cpu, status);
+    lattice_y = oskar_mem_double_const(station->lattice_y_cpu, status);
+    if (type == OSKAR_DOUBLE)
+        oskar_evaluate_array_pattern_lattice_d(num_groups, size,
+                lattice_x, lattice_y, wavenumber, beam_x, beam_y,
+                num_points, oskar_mem_double_const(x, status),
+                oskar_mem_double_const(y, status),
+                oskar_mem_double2(output, status));
+    else if (type == OSKAR_SINGLE)
+        oskar_evaluate_array_pattern_lattice_f(num_groups, size,
+                lattice_x, lattice_y, wavenumber, beam_x, beam_y,
+                num_points, oskar_mem_float_const(x, status),
+                oskar_mem_float_const(y, status),
+                oskar_mem_float2(output, status));
+    else
+        *status = OSKAR_ERR_BAD_DATA_TYPE;
+}
+
+#ifdef __cplusplus
+}
+#endif
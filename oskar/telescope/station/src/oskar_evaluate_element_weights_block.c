@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2018, The University of Oxford
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of the University of Oxford nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "telescope/station/oskar_evaluate_element_weights_block.h"
+#include "telescope/station/oskar_evaluate_beam_horizon_direction.h"
+#include "telescope/station/oskar_evaluate_element_weights_dft.h"
+#include "telescope/station/oskar_evaluate_element_weights_errors.h"
+#include "telescope/station/private_station_work.h"
+#include "math/oskar_cmath.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Maximum number of weights to store in a block. */
+#define MAX_BLOCK_WEIGHTS (1 << 22)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void assign_offsets(oskar_StationWork* work, const oskar_Station* s,
+        int block_size, size_t* total);
+static void evaluate_weights(oskar_StationWork* work, const oskar_Station* s,
+        int num_channels, const double* frequency_hz, const double* gast,
+        int* status);
+
+void oskar_evaluate_element_weights_block(oskar_StationWork* work,
+        const oskar_Telescope* tel, int num_stations, const int* station_ids,
+        int num_channels, const double* frequency_hz, int start_time_index,
+        int num_times, const double* gast, int* status)
+{
+    int i;
+    size_t total = 0;
+
+    /* Discard any previous block, and array patterns evaluated using it. */
+    work->weights_block_num_channels = 0;
+    for (i = 0; i < work->weights_block_num_offsets; ++i)
+        work->weights_block_offset[i] = -1;
+    for (i = 0; i < work->array_pattern_block_num; ++i)
+        work->array_pattern_block_time[i] = -1;
+
+    /* Check if safe to proceed. */
+    if (*status || num_channels < 1 || num_times < 1) return;
+
+    /* Assign offsets for all stations in the block. */
+    for (i = 0; i < num_stations; ++i)
+        assign_offsets(work, oskar_telescope_station_const(tel,
+                station_ids ? station_ids[i] : i),
+                num_channels * num_times, &total);
+    if (total == 0 || total > MAX_BLOCK_WEIGHTS)
+    {
+        for (i = 0; i < work->weights_block_num_offsets; ++i)
+            work->weights_block_offset[i] = -1;
+        return;
+    }
+
+    /* Store the block key. */
+    work->weights_block_gast = (double*) realloc(work->weights_block_gast,
+            num_times * sizeof(double));
+    work->weights_block_freq_hz = (double*) realloc(
+            work->weights_block_freq_hz, num_channels * sizeof(double));
+    memcpy(work->weights_block_gast, gast, num_times * sizeof(double));
+    memcpy(work->weights_block_freq_hz, frequency_hz,
+            num_channels * sizeof(double));
+    work->weights_block_start_time = start_time_index;
+    work->weights_block_num_times = num_times;
+
+    /* Evaluate the weights. */
+    if (oskar_mem_length(work->weights_block) < total)
+        oskar_mem_realloc(work->weights_block, total, status);
+    for (i = 0; i < num_stations; ++i)
+        evaluate_weights(work, oskar_telescope_station_const(tel,
+                station_ids ? station_ids[i] : i),
+                num_channels, frequency_hz, gast, status);
+
+    /* Enable the block only if all weights were evaluated. */
+    if (!*status) work->weights_block_num_channels = num_channels;
+}
+
+static void assign_offsets(oskar_StationWork* work, const oskar_Station* s,
+        int block_size, size_t* total)
+{
+    int i, id;
+
+    /* Only aperture array stations use beamforming weights. */
+    if (!s || oskar_station_type(s) != OSKAR_STATION_TYPE_AA ||
+            !oskar_station_enable_array_pattern(s))
+        return;
+
+    /* Resize the offset array if required. */
+    id = oskar_station_unique_id(s);
+    if (id < 0) return;
+    if (id >= work->weights_block_num_offsets)
+    {
+        work->weights_block_offset = (int*) realloc(
+                work->weights_block_offset, (id + 1) * sizeof(int));
+        for (i = work->weights_block_num_offsets; i <= id; ++i)
+            work->weights_block_offset[i] = -1;
+        work->weights_block_num_offsets = id + 1;
+    }
+
+    /* Assign the offset for this station, if not already done. */
+    if (work->weights_block_offset[id] >= 0) return;
+    work->weights_block_offset[id] = (int) *total;
+    *total += (size_t)block_size * oskar_station_num_elements(s);
+
+    /* Assign offsets for child stations that will be evaluated. */
+    if (oskar_station_has_child(s))
+    {
+        const int num_children = oskar_station_identical_children(s) ?
+                1 : oskar_station_num_elements(s);
+        for (i = 0; i < num_children; ++i)
+            assign_offsets(work, oskar_station_child_const(s, i),
+                    block_size, total);
+    }
+}
+
+static void evaluate_weights(oskar_StationWork* work, const oskar_Station* s,
+        int num_channels, const double* frequency_hz, const double* gast,
+        int* status)
+{
+    int c, t, id, offset, num_elements, num_times;
+    oskar_Mem *weights, *weights_error;
+
+    /* Check if safe to proceed. */
+    if (*status || !s || oskar_station_type(s) != OSKAR_STATION_TYPE_AA ||
+            !oskar_station_enable_array_pattern(s))
+        return;
+
+    /* Evaluate weights for child stations first. */
+    num_elements = oskar_station_num_elements(s);
+    if (oskar_station_has_child(s))
+    {
+        const int num_children = oskar_station_identical_children(s) ?
+                1 : num_elements;
+        for (c = 0; c < num_children; ++c)
+            evaluate_weights(work, oskar_station_child_const(s, c),
+                    num_channels, frequency_hz, gast, status);
+    }
+
+    /* Resize the error work array if required. */
+    weights = work->weights_block_alias;
+    weights_error = work->weights_error;
+    if ((int)oskar_mem_length(weights_error) < num_elements)
+        oskar_mem_realloc(weights_error, num_elements, status);
+
+    /* Loop over times. */
+    id = oskar_station_unique_id(s);
+    offset = work->weights_block_offset[id];
+    num_times = work->weights_block_num_times;
+    for (t = 0; t < num_times; ++t)
+    {
+        double beam_x, beam_y, beam_z;
+        const int time_index = work->weights_block_start_time + t;
+
+        /* Compute direction cosines for the beam for this station. */
+        oskar_evaluate_beam_horizon_direction(&beam_x, &beam_y, &beam_z, s,
+                gast[t], status);
+
+        /* Generate weights errors for this time. */
+        if (oskar_station_apply_element_errors(s))
+            oskar_evaluate_element_weights_errors(num_elements,
+                    oskar_station_element_gain_const(s),
+                    oskar_station_element_gain_error_const(s),
+                    oskar_station_element_phase_offset_rad_const(s),
+                    oskar_station_element_phase_error_rad_const(s),
+                    oskar_station_seed_time_variable_errors(s), time_index,
+                    id, weights_error, status);
+
+        /* Loop over channels. */
+        for (c = 0; c < num_channels; ++c)
+        {
+            double wavenumber;
+            wavenumber = 2.0 * M_PI * frequency_hz[c] / 299792458.0;
+            oskar_mem_set_alias(weights, work->weights_block,
+                    offset + (c * num_times + t) * num_elements,
+                    num_elements, status);
+
+            /* Generate DFT weights. */
+            oskar_evaluate_element_weights_dft(num_elements,
+                    oskar_station_element_measured_x_enu_metres_const(s),
+                    oskar_station_element_measured_y_enu_metres_const(s),
+                    oskar_station_element_measured_z_enu_metres_const(s),
+                    wavenumber, beam_x, beam_y, beam_z, weights, status);
+
+            /* Apply time-variable errors. */
+            if (oskar_station_apply_element_errors(s))
+                oskar_mem_multiply(0, weights, weights_error, num_elements,
+                        status);
+
+            /* Modify the weights using the provided apodisation values. */
+            if (oskar_station_apply_element_weight(s))
+                oskar_mem_multiply(0, weights,
+                        oskar_station_element_weight_const(s), num_elements,
+                        status);
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
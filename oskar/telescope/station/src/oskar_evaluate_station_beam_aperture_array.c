@@ -28,6 +28,7 @@
 
 #include "telescope/station/oskar_evaluate_station_beam_aperture_array.h"
 
+#include "telescope/station/oskar_evaluate_array_pattern_lattice.h"
 #include "telescope/station/oskar_evaluate_beam_horizon_direction.h"
 #include "telescope/station/oskar_evaluate_element_weights.h"
 #include "telescope/station/element/oskar_element_evaluate.h"
@@ -36,6 +37,8 @@
 
 #include "math/oskar_cmath.h"
 #include "math/oskar_dftw.h"
+#include "math/oskar_dftw_multi.h"
+#include <stdlib.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,6 +46,9 @@ extern "C" {
 
 #define MAX_CHUNK_SIZE 49152
 
+/* Maximum memory used to hold multi-channel array patterns, in bytes. */
+#define MAX_ARRAY_PATTERN_BLOCK_BYTES (512.0 * 1024.0 * 1024.0)
+
 /* Private function, used for recursive calls. */
 static void oskar_evaluate_station_beam_aperture_array_private(oskar_Mem* beam,
         const oskar_Station* s, int num_points, const oskar_Mem* x,
@@ -50,6 +56,29 @@ static void oskar_evaluate_station_beam_aperture_array_private(oskar_Mem* beam,
         double frequency_hz, oskar_StationWork* work, int time_index,
         int depth, int* status);
 
+/* Evaluates the array pattern using the separable lattice, if possible.
+ * Returns 1 if the pattern was evaluated, or 0 if not. */
+static int lattice_array_pattern(const oskar_Station* s, int num_points,
+        const oskar_Mem* x, const oskar_Mem* y, double wavenumber,
+        double beam_x, double beam_y, oskar_Mem* array, int* status);
+
+/* Returns the array pattern evaluated for all channels of the current
+ * weights block, or NULL if not possible. */
+static const oskar_Mem* multi_channel_array_pattern(const oskar_Station* s,
+        int num_points, const oskar_Mem* x, const oskar_Mem* y,
+        const oskar_Mem* z, double frequency_hz, double gast,
+        oskar_StationWork* work, int time_index, int* status);
+
+/* Frees array pattern blocks that are not for the given time index,
+ * except for the given station, and returns the memory still used. */
+static double free_stale_array_patterns(oskar_StationWork* work,
+        int time_index, int keep_id, int* status);
+
+/* Returns beamforming weights, using the current block if possible. */
+static const oskar_Mem* element_weights(const oskar_Station* s,
+        double frequency_hz, double gast, double wavenumber, double beam_x,
+        double beam_y, double beam_z, oskar_StationWork* work,
+        int time_index, int* status);
 
 void oskar_evaluate_station_beam_aperture_array(oskar_Mem* beam,
         const oskar_Station* station, int num_points, const oskar_Mem* x,
@@ -114,13 +143,12 @@ static void oskar_evaluate_station_beam_aperture_array_private(oskar_Mem* beam,
         int depth, int* status)
 {
     double beam_x, beam_y, beam_z, wavenumber;
-    oskar_Mem *weights, *weights_error, *theta, *phi, *array;
+    const oskar_Mem* weights = 0;
+    oskar_Mem *theta, *phi, *array;
     int num_elements, is_3d;
 
     num_elements  = oskar_station_num_elements(s);
     is_3d         = oskar_station_array_is_3d(s);
-    weights       = work->weights;
-    weights_error = work->weights_error;
     theta         = work->theta_modified;
     phi           = work->phi_modified;
     array         = work->array_pattern;
@@ -154,23 +182,42 @@ static void oskar_evaluate_station_beam_aperture_array_private(oskar_Mem* beam,
             /* Check if array pattern is enabled. */
             if (oskar_station_enable_array_pattern(s))
             {
-                /* Generate beamforming weights and evaluate array pattern. */
-                oskar_evaluate_element_weights(weights, weights_error,
-                        wavenumber, s, beam_x, beam_y, beam_z,
-                        time_index, status);
-                oskar_dftw(num_elements, wavenumber,
-                        oskar_station_element_true_x_enu_metres_const(s),
-                        oskar_station_element_true_y_enu_metres_const(s),
-                        oskar_station_element_true_z_enu_metres_const(s),
-                        weights, num_points, x, y, (is_3d ? z : 0), 0, array,
-                        status);
-
-                /* Normalise array response if required. */
-                if (oskar_station_normalise_array_pattern(s))
-                    oskar_mem_scale_real(array, 1.0 / num_elements, status);
+                const oskar_Mem* array_c = 0;
+
+                /* Use the separable lattice, if possible. */
+                if (lattice_array_pattern(s, num_points, x, y, wavenumber,
+                        beam_x, beam_y, array, status))
+                    array_c = array;
+
+                /* Use the array pattern for all channels, if enabled. */
+                else if (depth == 0 && work->multi_channel)
+                    array_c = multi_channel_array_pattern(s, num_points,
+                            x, y, (is_3d ? z : 0), frequency_hz, gast,
+                            work, time_index, status);
+
+                /* Otherwise, generate beamforming weights and evaluate
+                 * array pattern. */
+                if (!array_c)
+                {
+                    weights = element_weights(s, frequency_hz, gast,
+                            wavenumber, beam_x, beam_y, beam_z, work,
+                            time_index, status);
+                    oskar_dftw(num_elements, wavenumber,
+                            oskar_station_element_true_x_enu_metres_const(s),
+                            oskar_station_element_true_y_enu_metres_const(s),
+                            oskar_station_element_true_z_enu_metres_const(s),
+                            weights, num_points, x, y, (is_3d ? z : 0), 0,
+                            array, status);
+
+                    /* Normalise array response if required. */
+                    if (oskar_station_normalise_array_pattern(s))
+                        oskar_mem_scale_real(array, 1.0 / num_elements,
+                                status);
+                    array_c = array;
+                }
 
                 /* Element-wise multiply to join array and element pattern. */
-                oskar_mem_multiply(beam, beam, array, num_points, status);
+                oskar_mem_multiply(beam, beam, array_c, num_points, status);
             }
         }
 
@@ -237,9 +284,8 @@ static void oskar_evaluate_station_beam_aperture_array_private(oskar_Mem* beam,
             }
 
             /* Generate beamforming weights. */
-            oskar_evaluate_element_weights(weights, weights_error,
-                    wavenumber, s, beam_x, beam_y, beam_z,
-                    time_index, status);
+            weights = element_weights(s, frequency_hz, gast, wavenumber,
+                    beam_x, beam_y, beam_z, work, time_index, status);
 
             /* Use DFT to evaluate array response. */
             oskar_dftw(num_elements, wavenumber,
@@ -274,53 +320,65 @@ static void oskar_evaluate_station_beam_aperture_array_private(oskar_Mem* beam,
             return;
         }
 
-        /* Get sized work array for this depth, with the correct type. */
-        signal = oskar_station_work_beam(work, beam, num_elements * num_points,
-                depth, status);
-
         /* Check if child stations are identical. */
         if (oskar_station_identical_children(s))
         {
-            /* Set up the output buffer for the first station. */
-            oskar_Mem* output0;
-            output0 = oskar_mem_create_alias(signal, 0, num_points, status);
-
-            /* Recursive call. */
-            oskar_evaluate_station_beam_aperture_array_private(output0,
+            /* Evaluate the beam of child station 0 only, into the work
+             * array for this depth. */
+            signal = oskar_station_work_beam(work, beam, num_points,
+                    depth, status);
+            oskar_evaluate_station_beam_aperture_array_private(signal,
                     oskar_station_child_const(s, 0), num_points,
                     x, y, z, gast, frequency_hz, work, time_index,
                     depth + 1, status);
 
-            /* Copy beam for child station 0 into memory for other stations. */
-            for (i = 1; i < num_elements; ++i)
+            /* Child beam and array pattern are separable, so evaluate the
+             * (scalar) array pattern of this station and multiply. */
+            if (!lattice_array_pattern(s, num_points, x, y, wavenumber,
+                    beam_x, beam_y, array, status))
             {
-                oskar_mem_copy_contents(signal, output0, i * num_points, 0,
-                        oskar_mem_length(output0), status);
+                weights = element_weights(s, frequency_hz, gast, wavenumber,
+                        beam_x, beam_y, beam_z, work, time_index, status);
+                oskar_dftw(num_elements, wavenumber,
+                        oskar_station_element_true_x_enu_metres_const(s),
+                        oskar_station_element_true_y_enu_metres_const(s),
+                        oskar_station_element_true_z_enu_metres_const(s),
+                        weights, num_points, x, y, (is_3d ? z : 0), 0, array,
+                        status);
+
+                /* Normalise array response if required. */
+                if (oskar_station_normalise_array_pattern(s))
+                    oskar_mem_scale_real(array, 1.0 / num_elements, status);
             }
-            oskar_mem_free(output0, status);
+
+            /* Element-wise multiply to join array and child pattern. */
+            oskar_mem_multiply(beam, signal, array, num_points, status);
+            return;
         }
-        else
+
+        /* Get sized work array for this depth, with the correct type. */
+        signal = oskar_station_work_beam(work, beam, num_elements * num_points,
+                depth, status);
+
+        /* Loop over child stations. */
+        for (i = 0; i < num_elements; ++i)
         {
-            /* Loop over child stations. */
-            for (i = 0; i < num_elements; ++i)
-            {
-                /* Set up the output buffer for this station. */
-                oskar_Mem* output;
-                output = oskar_mem_create_alias(signal, i * num_points,
-                        num_points, status);
+            /* Set up the output buffer for this station. */
+            oskar_Mem* output;
+            output = oskar_mem_create_alias(signal, i * num_points,
+                    num_points, status);
 
-                /* Recursive call. */
-                oskar_evaluate_station_beam_aperture_array_private(output,
-                        oskar_station_child_const(s, i), num_points,
-                        x, y, z, gast, frequency_hz, work, time_index,
-                        depth + 1, status);
-                oskar_mem_free(output, status);
-            }
+            /* Recursive call. */
+            oskar_evaluate_station_beam_aperture_array_private(output,
+                    oskar_station_child_const(s, i), num_points,
+                    x, y, z, gast, frequency_hz, work, time_index,
+                    depth + 1, status);
+            oskar_mem_free(output, status);
         }
 
         /* Generate beamforming weights and form beam from child stations. */
-        oskar_evaluate_element_weights(weights, weights_error, wavenumber,
-                s, beam_x, beam_y, beam_z, time_index, status);
+        weights = element_weights(s, frequency_hz, gast, wavenumber,
+                beam_x, beam_y, beam_z, work, time_index, status);
         oskar_dftw(num_elements, wavenumber,
                 oskar_station_element_true_x_enu_metres_const(s),
                 oskar_station_element_true_y_enu_metres_const(s),
@@ -334,6 +392,156 @@ static void oskar_evaluate_station_beam_aperture_array_private(oskar_Mem* beam,
     }
 }
 
+static int lattice_array_pattern(const oskar_Station* s, int num_points,
+        const oskar_Mem* x, const oskar_Mem* y, double wavenumber,
+        double beam_x, double beam_y, oskar_Mem* array, int* status)
+{
+    if (*status || oskar_station_num_lattice_groups(s) <= 0 ||
+            oskar_mem_location(array) != OSKAR_CPU)
+        return 0;
+    oskar_evaluate_array_pattern_lattice(s, wavenumber, beam_x, beam_y,
+            num_points, x, y, array, status);
+
+    /* Normalise array response if required. */
+    if (oskar_station_normalise_array_pattern(s))
+        oskar_mem_scale_real(array, 1.0 / oskar_station_num_elements(s),
+                status);
+    return 1;
+}
+
+static const oskar_Mem* multi_channel_array_pattern(const oskar_Station* s,
+        int num_points, const oskar_Mem* x, const oskar_Mem* y,
+        const oskar_Mem* z, double frequency_hz, double gast,
+        oskar_StationWork* work, int time_index, int* status)
+{
+    int c, i, id, t, num_elements, num_channels, num_times;
+    oskar_Mem* block;
+
+    /* Check the weights for this station and time are in the block. */
+    if (*status || !oskar_station_work_block_weights(work, s,
+            frequency_hz, gast, time_index, status)) return 0;
+    id = oskar_station_unique_id(s);
+    num_elements = oskar_station_num_elements(s);
+    num_channels = work->weights_block_num_channels;
+    num_times = work->weights_block_num_times;
+    t = time_index - work->weights_block_start_time;
+    for (c = 0; c < num_channels; ++c)
+        if (work->weights_block_freq_hz[c] == frequency_hz) break;
+
+    /* Resize the per-station arrays if required. */
+    if (id >= work->array_pattern_block_num)
+    {
+        work->array_pattern_block = (oskar_Mem**) realloc(
+                work->array_pattern_block, (id + 1) * sizeof(oskar_Mem*));
+        work->array_pattern_block_time = (int*) realloc(
+                work->array_pattern_block_time, (id + 1) * sizeof(int));
+        work->array_pattern_block_points = (int*) realloc(
+                work->array_pattern_block_points, (id + 1) * sizeof(int));
+        for (i = work->array_pattern_block_num; i <= id; ++i)
+        {
+            work->array_pattern_block[i] = 0;
+            work->array_pattern_block_time[i] = -1;
+            work->array_pattern_block_points[i] = 0;
+        }
+        work->array_pattern_block_num = id + 1;
+    }
+
+    /* Evaluate the array pattern for all channels if not already done. */
+    if (work->array_pattern_block_time[id] != time_index ||
+            work->array_pattern_block_points[id] != num_points)
+    {
+        double* wavenumber;
+        oskar_Mem* weights;
+
+        /* Blocks are kept for every station in the current time, so
+         * limit their total size. Free blocks for earlier times first.
+         * If there is still no room, evaluate one channel at a time. */
+        const double block_bytes = (double) num_channels * num_points *
+                oskar_mem_element_size(oskar_mem_type(work->array_pattern));
+        if (free_stale_array_patterns(work, time_index, id, status) +
+                block_bytes > MAX_ARRAY_PATTERN_BLOCK_BYTES)
+        {
+            oskar_mem_free(work->array_pattern_block[id], status);
+            work->array_pattern_block[id] = 0;
+            work->array_pattern_block_time[id] = -1;
+            return 0;
+        }
+        if (!work->array_pattern_block[id])
+            work->array_pattern_block[id] = oskar_mem_create(
+                    oskar_mem_type(work->array_pattern),
+                    oskar_mem_location(work->array_pattern), 0, status);
+        block = work->array_pattern_block[id];
+        wavenumber = (double*) malloc(num_channels * sizeof(double));
+        for (i = 0; i < num_channels; ++i)
+            wavenumber[i] = 2.0 * M_PI *
+                    work->weights_block_freq_hz[i] / 299792458.0;
+        weights = oskar_mem_create_alias(work->weights_block,
+                work->weights_block_offset[id] + t * num_elements,
+                (num_channels - 1) * num_times * num_elements + num_elements,
+                status);
+        oskar_dftw_multi(num_elements, num_channels, wavenumber,
+                oskar_station_element_true_x_enu_metres_const(s),
+                oskar_station_element_true_y_enu_metres_const(s),
+                oskar_station_element_true_z_enu_metres_const(s),
+                weights, num_times * num_elements, num_points, x, y, z,
+                block, status);
+        if (oskar_station_normalise_array_pattern(s))
+            oskar_mem_scale_real(block, 1.0 / num_elements, status);
+        oskar_mem_free(weights, status);
+        free(wavenumber);
+        if (*status) return 0;
+        work->array_pattern_block_time[id] = time_index;
+        work->array_pattern_block_points[id] = num_points;
+    }
+    block = work->array_pattern_block[id];
+
+    /* Return an alias to the pattern for this channel. */
+    oskar_mem_set_alias(work->array_pattern_block_alias, block,
+            c * num_points, num_points, status);
+    return work->array_pattern_block_alias;
+}
+
+static double free_stale_array_patterns(oskar_StationWork* work,
+        int time_index, int keep_id, int* status)
+{
+    int i;
+    double bytes = 0.0;
+    for (i = 0; i < work->array_pattern_block_num; ++i)
+    {
+        oskar_Mem* block = work->array_pattern_block[i];
+        if (!block || i == keep_id) continue;
+        if (work->array_pattern_block_time[i] != time_index)
+        {
+            oskar_mem_free(block, status);
+            work->array_pattern_block[i] = 0;
+            work->array_pattern_block_time[i] = -1;
+        }
+        else
+            bytes += (double) oskar_mem_length(block) *
+                    oskar_mem_element_size(oskar_mem_type(block));
+    }
+    return bytes;
+}
+
+static const oskar_Mem* element_weights(const oskar_Station* s,
+        double frequency_hz, double gast, double wavenumber, double beam_x,
+        double beam_y, double beam_z, oskar_StationWork* work,
+        int time_index, int* status)
+{
+    const oskar_Mem* weights;
+
+    /* Use weights evaluated by oskar_evaluate_element_weights_block(),
+     * if they are available. */
+    weights = oskar_station_work_block_weights(work, s, frequency_hz, gast,
+            time_index, status);
+    if (weights) return weights;
+
+    /* Otherwise evaluate the weights now. */
+    oskar_evaluate_element_weights(work->weights, work->weights_error,
+            wavenumber, s, beam_x, beam_y, beam_z, time_index, status);
+    return work->weights;
+}
+
 #ifdef __cplusplus
 }
 #endif
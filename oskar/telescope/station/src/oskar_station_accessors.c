@@ -180,6 +180,11 @@ int oskar_station_apply_element_weight(const oskar_Station* model)
     return model->apply_element_weight;
 }
 
+int oskar_station_num_lattice_groups(const oskar_Station* model)
+{
+    return model->num_lattice_groups;
+}
+
 unsigned int oskar_station_seed_time_variable_errors(const oskar_Station* model)
 {
     return model->seed_time_variable_errors;
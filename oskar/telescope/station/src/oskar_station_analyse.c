@@ -35,6 +35,8 @@
 extern "C" {
 #endif
 
+static void analyse_lattice(oskar_Station* station, int* status);
+
 void oskar_station_analyse(oskar_Station* station,
         int* finished_identical_station_check, int* status)
 {
@@ -151,6 +153,9 @@ void oskar_station_analyse(oskar_Station* station,
         }
     }
 
+    /* Check if the layout is a separable lattice. */
+    analyse_lattice(station, status);
+
     /* Check if station has child stations. */
     if (oskar_station_has_child(station))
     {
@@ -183,6 +188,147 @@ void oskar_station_analyse(oskar_Station* station,
     }
 }
 
+typedef struct
+{
+    double x, y;
+} LatticePoint;
+
+static int compare_points(const void* a, const void* b)
+{
+    const LatticePoint *p = (const LatticePoint*)a, *q = (const LatticePoint*)b;
+    if (p->y != q->y) return (p->y < q->y) ? -1 : 1;
+    if (p->x != q->x) return (p->x < q->x) ? -1 : 1;
+    return 0;
+}
+
+/*
+ * Checks if the (planar) element layout is the union of a few separable
+ * sub-lattices: sets of elements at every combination of a set of
+ * x-coordinates and a set of y-coordinates.
+ * Rows (elements with the same y-coordinate) with the same set of
+ * x-coordinates belong to the same sub-lattice. A rectangular grid has one
+ * sub-lattice, and a hexagonal grid has two.
+ * With plain geometric beamforming weights, the array pattern of each
+ * sub-lattice is then the product of a sum over x and a sum over y.
+ */
+static void analyse_lattice(oskar_Station* station, int* status)
+{
+    int i, j, g, num_rows = 0, num_groups = 0, num_x = 0, num_y = 0;
+    int num_elements, *row_start, *row_group, *group_row, *size;
+    double *lattice_x, *lattice_y;
+    LatticePoint* p;
+
+    station->num_lattice_groups = 0;
+    num_elements = station->num_elements;
+    if (*status || num_elements < 4 || station->array_is_3d ||
+            station->apply_element_errors || station->apply_element_weight)
+        return;
+
+    /* Get the element coordinates, which must be exactly known. */
+    p = (LatticePoint*) malloc(num_elements * sizeof(LatticePoint));
+    for (i = 0; i < num_elements; ++i)
+    {
+        double xt, yt, xm, ym;
+        if (oskar_station_precision(station) == OSKAR_DOUBLE)
+        {
+            xt = oskar_mem_double(station->element_true_x_enu_metres,
+                    status)[i];
+            yt = oskar_mem_double(station->element_true_y_enu_metres,
+                    status)[i];
+            xm = oskar_mem_double(station->element_measured_x_enu_metres,
+                    status)[i];
+            ym = oskar_mem_double(station->element_measured_y_enu_metres,
+                    status)[i];
+        }
+        else
+        {
+            xt = oskar_mem_float(station->element_true_x_enu_metres,
+                    status)[i];
+            yt = oskar_mem_float(station->element_true_y_enu_metres,
+                    status)[i];
+            xm = oskar_mem_float(station->element_measured_x_enu_metres,
+                    status)[i];
+            ym = oskar_mem_float(station->element_measured_y_enu_metres,
+                    status)[i];
+        }
+        if (xt != xm || yt != ym)
+        {
+            free(p);
+            return;
+        }
+        p[i].x = xt;
+        p[i].y = yt;
+    }
+
+    /* Sort the elements into rows, and reject repeated positions. */
+    qsort(p, num_elements, sizeof(LatticePoint), compare_points);
+    row_start = (int*) malloc((num_elements + 1) * sizeof(int));
+    row_group = (int*) malloc(num_elements * sizeof(int));
+    group_row = (int*) malloc(num_elements * sizeof(int));
+    for (i = 0; i < num_elements; ++i)
+    {
+        if (i > 0 && compare_points(&p[i], &p[i - 1]) == 0) break;
+        if (i == 0 || p[i].y != p[i - 1].y)
+            row_start[num_rows++] = i;
+    }
+    row_start[num_rows] = num_elements;
+
+    /* Put rows with the same x-coordinates into the same group. */
+    if (i == num_elements)
+    {
+        for (i = 0; i < num_rows; ++i)
+        {
+            const int len = row_start[i + 1] - row_start[i];
+            for (g = 0; g < num_groups; ++g)
+            {
+                const int r = group_row[g];
+                if (row_start[r + 1] - row_start[r] != len) continue;
+                for (j = 0; j < len; ++j)
+                    if (p[row_start[r] + j].x != p[row_start[i] + j].x)
+                        break;
+                if (j == len) break;
+            }
+            if (g == num_groups)
+            {
+                group_row[num_groups++] = i;
+                num_x += len;
+            }
+            row_group[i] = g;
+        }
+        num_y = num_rows;
+    }
+
+    /* Use the sub-lattices only if they save enough work. */
+    if (num_groups > 0 && 2 * (num_x + num_y) <= num_elements)
+    {
+        station->num_lattice_groups = num_groups;
+        oskar_mem_realloc(station->lattice_size_cpu, 2 * num_groups, status);
+        oskar_mem_realloc(station->lattice_x_cpu, num_x, status);
+        oskar_mem_realloc(station->lattice_y_cpu, num_y, status);
+        size = oskar_mem_int(station->lattice_size_cpu, status);
+        lattice_x = oskar_mem_double(station->lattice_x_cpu, status);
+        lattice_y = oskar_mem_double(station->lattice_y_cpu, status);
+        for (g = 0; g < num_groups; ++g)
+        {
+            const int r = group_row[g];
+            size[2 * g] = row_start[r + 1] - row_start[r];
+            size[2 * g + 1] = 0;
+            for (j = 0; j < size[2 * g]; ++j)
+                *(lattice_x++) = p[row_start[r] + j].x;
+            for (i = 0; i < num_rows; ++i)
+            {
+                if (row_group[i] != g) continue;
+                *(lattice_y++) = p[row_start[i]].y;
+                size[2 * g + 1]++;
+            }
+        }
+    }
+    free(p);
+    free(row_start);
+    free(row_group);
+    free(group_row);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -101,6 +101,12 @@ oskar_Station* oskar_station_create(int type, int location, int num_elements,
             oskar_mem_create(OSKAR_INT, OSKAR_CPU, num_elements, status);
     model->element_mount_types_cpu =
             oskar_mem_create(OSKAR_CHAR, OSKAR_CPU, num_elements, status);
+    model->lattice_size_cpu =
+            oskar_mem_create(OSKAR_INT, OSKAR_CPU, 0, status);
+    model->lattice_x_cpu =
+            oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 0, status);
+    model->lattice_y_cpu =
+            oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 0, status);
     model->permitted_beam_az_rad =
             oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 0, status);
     model->permitted_beam_el_rad =
@@ -135,6 +141,7 @@ oskar_Station* oskar_station_create(int type, int location, int num_elements,
     model->apply_element_errors = OSKAR_FALSE;
     model->apply_element_weight = OSKAR_FALSE;
     model->seed_time_variable_errors = 1;
+    model->num_lattice_groups = 0;
     model->child = 0;
     model->element = 0;
     model->num_permitted_beams = 0;
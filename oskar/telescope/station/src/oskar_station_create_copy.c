@@ -81,6 +81,7 @@ oskar_Station* oskar_station_create_copy(const oskar_Station* src,
     model->apply_element_errors = src->apply_element_errors;
     model->apply_element_weight = src->apply_element_weight;
     model->seed_time_variable_errors = src->seed_time_variable_errors;
+    model->num_lattice_groups = src->num_lattice_groups;
     model->num_permitted_beams = src->num_permitted_beams;
 
     /* Copy Gaussian station beam data. */
@@ -122,6 +123,9 @@ oskar_Station* oskar_station_create_copy(const oskar_Station* src,
     oskar_mem_copy(model->element_types, src->element_types, status);
     oskar_mem_copy(model->element_types_cpu, src->element_types_cpu, status);
     oskar_mem_copy(model->element_mount_types_cpu, src->element_mount_types_cpu, status);
+    oskar_mem_copy(model->lattice_size_cpu, src->lattice_size_cpu, status);
+    oskar_mem_copy(model->lattice_x_cpu, src->lattice_x_cpu, status);
+    oskar_mem_copy(model->lattice_y_cpu, src->lattice_y_cpu, status);
     oskar_mem_copy(model->permitted_beam_az_rad, src->permitted_beam_az_rad, status);
     oskar_mem_copy(model->permitted_beam_el_rad, src->permitted_beam_el_rad, status);
 
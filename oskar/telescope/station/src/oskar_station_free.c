@@ -61,6 +61,9 @@ void oskar_station_free(oskar_Station* model, int* status)
     oskar_mem_free(model->element_types, status);
     oskar_mem_free(model->element_types_cpu, status);
     oskar_mem_free(model->element_mount_types_cpu, status);
+    oskar_mem_free(model->lattice_size_cpu, status);
+    oskar_mem_free(model->lattice_x_cpu, status);
+    oskar_mem_free(model->lattice_y_cpu, status);
     oskar_mem_free(model->permitted_beam_az_rad, status);
     oskar_mem_free(model->permitted_beam_el_rad, status);
 
@@ -67,6 +67,7 @@ void oskar_station_override_element_xy_position_errors(oskar_Station* s,
         int type, id;
         type = oskar_station_precision(s);
         id = oskar_station_unique_id(s);
+        s->num_lattice_groups = 0;
         if (type == OSKAR_DOUBLE)
         {
             double *xs, *ys, *xw, *yw;
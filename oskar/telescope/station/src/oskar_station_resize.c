@@ -65,6 +65,7 @@ void oskar_station_resize(oskar_Station* station, int num_elements,
     oskar_mem_realloc(station->element_types, num_elements, status);
     oskar_mem_realloc(station->element_types_cpu, num_elements, status);
     oskar_mem_realloc(station->element_mount_types_cpu, num_elements, status);
+    station->num_lattice_groups = 0;
 
     /* Initialise any new elements with default values. */
     if (num_elements > station->num_elements)
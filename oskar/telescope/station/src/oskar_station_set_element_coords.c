@@ -53,6 +53,9 @@ void oskar_station_set_element_coords(oskar_Station* dst,
     if (measured_enu[2] != 0.0 || true_enu[2] != 0.0)
         dst->array_is_3d = OSKAR_TRUE;
 
+    /* Layout must be analysed again to use the separable lattice. */
+    dst->num_lattice_groups = 0;
+
     if (oskar_station_mem_location(dst) == OSKAR_CPU)
     {
         int type;
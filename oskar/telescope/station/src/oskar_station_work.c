@@ -28,6 +28,7 @@
 
 #include "telescope/station/oskar_station_work.h"
 #include "telescope/station/private_station_work.h"
+#include "telescope/station/oskar_station.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -65,6 +66,22 @@ oskar_StationWork* oskar_station_work_create(int type,
     work->normalised_beam = 0;
     work->num_depths = 0;
     work->beam = 0;
+    work->weights_block = oskar_mem_create((type | OSKAR_COMPLEX),
+            location, 0, status);
+    work->weights_block_alias = oskar_mem_create_alias(0, 0, 0, status);
+    work->weights_block_start_time = 0;
+    work->weights_block_num_times = 0;
+    work->weights_block_num_channels = 0;
+    work->weights_block_num_offsets = 0;
+    work->weights_block_offset = 0;
+    work->weights_block_gast = 0;
+    work->weights_block_freq_hz = 0;
+    work->multi_channel = 0;
+    work->array_pattern_block_num = 0;
+    work->array_pattern_block = 0;
+    work->array_pattern_block_time = 0;
+    work->array_pattern_block_points = 0;
+    work->array_pattern_block_alias = oskar_mem_create_alias(0, 0, 0, status);
 
     return work;
 }
@@ -85,6 +102,17 @@ void oskar_station_work_free(oskar_StationWork* work, int* status)
     oskar_mem_free(work->weights_error, status);
     oskar_mem_free(work->array_pattern, status);
     oskar_mem_free(work->normalised_beam, status);
+    oskar_mem_free(work->weights_block, status);
+    oskar_mem_free(work->weights_block_alias, status);
+    free(work->weights_block_offset);
+    free(work->weights_block_gast);
+    free(work->weights_block_freq_hz);
+    for (i = 0; i < work->array_pattern_block_num; ++i)
+        oskar_mem_free(work->array_pattern_block[i], status);
+    free(work->array_pattern_block);
+    free(work->array_pattern_block_time);
+    free(work->array_pattern_block_points);
+    oskar_mem_free(work->array_pattern_block_alias, status);
 
     for (i = 0; i < work->num_depths; ++i)
     {
@@ -147,6 +175,44 @@ oskar_Mem* oskar_station_work_beam(oskar_StationWork* work,
     return work->beam[depth];
 }
 
+void oskar_station_work_set_multi_channel(oskar_StationWork* work,
+        int value)
+{
+    int i;
+    work->multi_channel = value;
+    for (i = 0; i < work->array_pattern_block_num; ++i)
+        work->array_pattern_block_time[i] = -1;
+}
+
+const oskar_Mem* oskar_station_work_block_weights(oskar_StationWork* work,
+        const oskar_Station* station, double frequency_hz, double gast,
+        int time_index, int* status)
+{
+    int c, t, id, offset, num_elements;
+
+    /* Check if the station is in the block. */
+    if (*status || !work->weights_block_num_channels) return 0;
+    id = oskar_station_unique_id(station);
+    if (id < 0 || id >= work->weights_block_num_offsets) return 0;
+    offset = work->weights_block_offset[id];
+    if (offset < 0) return 0;
+
+    /* Check if the time and frequency are in the block. */
+    t = time_index - work->weights_block_start_time;
+    if (t < 0 || t >= work->weights_block_num_times ||
+            work->weights_block_gast[t] != gast) return 0;
+    for (c = 0; c < work->weights_block_num_channels; ++c)
+        if (work->weights_block_freq_hz[c] == frequency_hz) break;
+    if (c == work->weights_block_num_channels) return 0;
+
+    /* Return an alias to the weights. */
+    num_elements = oskar_station_num_elements(station);
+    offset += (c * work->weights_block_num_times + t) * num_elements;
+    oskar_mem_set_alias(work->weights_block_alias, work->weights_block,
+            (size_t)offset, (size_t)num_elements, status);
+    return work->weights_block_alias;
+}
+
 static void get_mem_from_template(oskar_Mem** b, const oskar_Mem* a,
         size_t length, int* status)
 {
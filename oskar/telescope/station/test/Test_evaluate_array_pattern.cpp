@@ -32,6 +32,7 @@
 #include "math/oskar_dftw.h"
 #include "convert/oskar_convert_lon_lat_to_relative_directions.h"
 #include "convert/oskar_convert_relative_directions_to_enu_directions.h"
+#include "telescope/station/oskar_evaluate_array_pattern_lattice.h"
 #include "telescope/station/oskar_evaluate_beam_horizon_direction.h"
 #include "telescope/station/oskar_evaluate_element_weights_dft.h"
 #include "telescope/station/oskar_station.h"
@@ -544,3 +545,125 @@ TEST(evaluate_array_pattern, test)
     oskar_station_free(station_cpu_d, &status);
     ASSERT_EQ(0, status) << oskar_get_error_string(status);
 }
+
+static oskar_Station* set_up_station_hex(int num_x, int num_y,
+        int type, double beam_ra_deg, double beam_dec_deg, int* status)
+{
+    oskar_Station* station;
+    double sep_m = 1.5;
+    int dummy = 0, ix, iy, i;
+
+    /* Generate a hexagonal station, with alternate rows offset. */
+    station = oskar_station_create(type, OSKAR_CPU, num_x * num_y, status);
+    for (iy = 0, i = 0; iy < num_y; ++iy)
+    {
+        for (ix = 0; ix < num_x; ++ix, ++i)
+        {
+            double xyz[3];
+            xyz[0] = (ix + 0.5 * (iy % 2)) * sep_m;
+            xyz[1] = iy * sep_m * sqrt(3.0) / 2.0;
+            xyz[2] = 0.0;
+            oskar_station_set_element_coords(station, i, xyz, xyz, status);
+            oskar_station_set_element_errors(station, i,
+                    1.0, 0.0, 0.0, 0.0, status);
+            oskar_station_set_element_weight(station, i,
+                    1.0, 0.0, status);
+        }
+    }
+    oskar_station_analyse(station, &dummy, status);
+    oskar_station_set_position(station, 0.0, 70.0 * M_PI / 180.0, 0.0);
+    oskar_station_set_phase_centre(station, OSKAR_SPHERICAL_TYPE_EQUATORIAL,
+            beam_ra_deg * M_PI / 180.0, beam_dec_deg * M_PI / 180.0);
+    return station;
+}
+
+static void check_lattice(const oskar_Station* station, const oskar_Mem* lon,
+        const oskar_Mem* lat, double gast, double freq_hz, double tol)
+{
+    oskar_Mem *w, *x, *y, *z, *pattern_dft, *pattern_lattice;
+    double beam_x, beam_y, beam_z, wavenumber;
+    double min_rel_error = 0., max_rel_error = 0.;
+    double avg_rel_error = 0., std_rel_error = 0.;
+    int num_pixels, type, status = 0;
+
+    num_pixels = (int)oskar_mem_length(lon);
+    type = oskar_station_precision(station) | OSKAR_COMPLEX;
+    wavenumber = 2.0 * M_PI * freq_hz / 299792458.0;
+    pattern_dft = oskar_mem_create(type, OSKAR_CPU, num_pixels, &status);
+    pattern_lattice = oskar_mem_create(type, OSKAR_CPU, 0, &status);
+    set_up_pointing(&w, &x, &y, &z, station, lon, lat, gast, freq_hz,
+            &status);
+    oskar_evaluate_beam_horizon_direction(&beam_x, &beam_y, &beam_z,
+            station, gast, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    /* Compare the separable lattice against the full DFT. */
+    oskar_dftw(oskar_station_num_elements(station), wavenumber,
+            oskar_station_element_true_x_enu_metres_const(station),
+            oskar_station_element_true_y_enu_metres_const(station),
+            oskar_station_element_true_z_enu_metres_const(station), w,
+            num_pixels, x, y, 0, 0, pattern_dft, &status);
+    oskar_evaluate_array_pattern_lattice(station, wavenumber,
+            beam_x, beam_y, num_pixels, x, y, pattern_lattice, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    oskar_mem_evaluate_relative_error(pattern_lattice, pattern_dft,
+            &min_rel_error, &max_rel_error,
+            &avg_rel_error, &std_rel_error, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    EXPECT_LT(avg_rel_error, tol);
+    oskar_mem_free(w, &status);
+    oskar_mem_free(x, &status);
+    oskar_mem_free(y, &status);
+    oskar_mem_free(z, &status);
+    oskar_mem_free(pattern_dft, &status);
+    oskar_mem_free(pattern_lattice, &status);
+}
+
+TEST(evaluate_array_pattern, lattice)
+{
+    int status = 0, image_side = 64, type, dummy = 0;
+    double ra_deg = 10.0, dec_deg = 75.0, fov_deg = 60.0;
+    double freq_hz = 150e6, gast = 0.1;
+    double xyz[3] = {0.3, 0.2, 0.0}, xyz_meas[3] = {0.3, 0.25, 0.0};
+    int num_pixels = image_side * image_side;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        double tol = (i == 0) ? 1e-10 : 1e-3;
+        type = (i == 0) ? OSKAR_DOUBLE : OSKAR_SINGLE;
+        oskar_Mem *lon, *lat;
+        oskar_Station *rect, *hex;
+        lon = oskar_mem_create(type, OSKAR_CPU, num_pixels, &status);
+        lat = oskar_mem_create(type, OSKAR_CPU, num_pixels, &status);
+        oskar_evaluate_image_lon_lat_grid(lon, lat, image_side, image_side,
+                fov_deg * M_PI / 180.0, fov_deg * M_PI / 180.0,
+                ra_deg * M_PI / 180.0, dec_deg * M_PI / 180.0, &status);
+        rect = set_up_station1(16, 12, type, ra_deg, dec_deg, &status);
+        hex = set_up_station_hex(12, 12, type, ra_deg, dec_deg, &status);
+        ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+        /* Check the sub-lattices were found. */
+        ASSERT_EQ(1, oskar_station_num_lattice_groups(rect));
+        ASSERT_EQ(2, oskar_station_num_lattice_groups(hex));
+        check_lattice(rect, lon, lat, gast, freq_hz, tol);
+        check_lattice(hex, lon, lat, gast, freq_hz, tol);
+
+        /* Check a moved element splits off into its own sub-lattices. */
+        oskar_station_set_element_coords(rect, 5, xyz, xyz, &status);
+        oskar_station_analyse(rect, &dummy, &status);
+        ASSERT_EQ(0, status) << oskar_get_error_string(status);
+        EXPECT_EQ(3, oskar_station_num_lattice_groups(rect));
+        check_lattice(rect, lon, lat, gast, freq_hz, tol);
+
+        /* Check a position error disables the lattice. */
+        oskar_station_set_element_coords(rect, 5, xyz_meas, xyz, &status);
+        oskar_station_analyse(rect, &dummy, &status);
+        ASSERT_EQ(0, status) << oskar_get_error_string(status);
+        EXPECT_EQ(0, oskar_station_num_lattice_groups(rect));
+
+        oskar_station_free(rect, &status);
+        oskar_station_free(hex, &status);
+        oskar_mem_free(lon, &status);
+        oskar_mem_free(lat, &status);
+    }
+}
@@ -34,6 +34,7 @@
 #include "math/oskar_meshgrid.h"
 #include "math/oskar_evaluate_image_lmn_grid.h"
 #include "interferometer/oskar_evaluate_jones_E.h"
+#include "telescope/station/oskar_evaluate_element_weights_block.h"
 #include "utility/oskar_get_error_string.h"
 
 #include "math/oskar_cmath.h"
@@ -168,3 +169,101 @@ TEST(evaluate_jones_E, evaluate_e)
     ASSERT_EQ(0, error) << oskar_get_error_string(error);
 }
 
+
+TEST(evaluate_jones_E, block_weights)
+{
+    int error = 0, num_stations = 3, num_antennas = 16, time_index = 1;
+    double gast[] = {0.1, 0.2, 0.3}, frequency[] = {50e6, 60e6};
+
+    // Construct telescope model with time-variable element errors.
+    oskar_Telescope* tel = oskar_telescope_create(OSKAR_DOUBLE,
+            OSKAR_CPU, num_stations, &error);
+    for (int i = 0; i < num_stations; ++i)
+    {
+        oskar_Station* s = oskar_telescope_station(tel, i);
+        oskar_station_resize(s, num_antennas, &error);
+        oskar_station_resize_element_types(s, 1, &error);
+        oskar_station_set_position(s, 0.0, -M_PI / 4.0, 0.0);
+        oskar_station_set_phase_centre(s,
+                OSKAR_SPHERICAL_TYPE_EQUATORIAL, 0.0, -M_PI / 3.0);
+        oskar_element_set_element_type(oskar_station_element(s, 0),
+                "Isotropic", &error);
+        for (int j = 0; j < num_antennas; ++j)
+        {
+            double xyz[] = {(j % 4) * 2.5 + i, (j / 4) * 2.5 - i, 0.0};
+            oskar_station_set_element_coords(s, j, xyz, xyz, &error);
+            oskar_station_set_element_errors(s, j, 1.0, 0.1, 0.0, 0.05,
+                    &error);
+        }
+        ASSERT_EQ(0, error) << oskar_get_error_string(error);
+    }
+    oskar_telescope_set_station_ids(tel);
+    oskar_telescope_analyse(tel, &error);
+    ASSERT_EQ(0, error) << oskar_get_error_string(error);
+    oskar_Telescope* tel_dev = oskar_telescope_create_copy(tel,
+            device_loc, &error);
+
+    // Create source positions (with space for the normalisation source).
+    int num_pts = 64;
+    oskar_Mem* l = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 1 + num_pts,
+            &error);
+    oskar_Mem* m = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 1 + num_pts,
+            &error);
+    oskar_Mem* n = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, 1 + num_pts,
+            &error);
+    oskar_evaluate_image_lmn_grid(8, 8, 30.0 * D2R, 30.0 * D2R,
+            1, l, m, n, &error);
+    oskar_Mem* l_dev = oskar_mem_create_copy(l, device_loc, &error);
+    oskar_Mem* m_dev = oskar_mem_create_copy(m, device_loc, &error);
+    oskar_Mem* n_dev = oskar_mem_create_copy(n, device_loc, &error);
+
+    // Evaluate Jones E with and without block weights.
+    oskar_Jones* E0 = oskar_jones_create(OSKAR_DOUBLE_COMPLEX,
+            device_loc, num_stations, num_pts, &error);
+    oskar_Jones* E1 = oskar_jones_create(OSKAR_DOUBLE_COMPLEX,
+            device_loc, num_stations, num_pts, &error);
+    oskar_StationWork* work0 = oskar_station_work_create(OSKAR_DOUBLE,
+            device_loc, &error);
+    oskar_StationWork* work1 = oskar_station_work_create(OSKAR_DOUBLE,
+            device_loc, &error);
+    oskar_evaluate_element_weights_block(work1, tel_dev, num_stations, 0,
+            2, frequency, time_index - 1, 3, gast, &error);
+    ASSERT_EQ(0, error) << oskar_get_error_string(error);
+    for (int c = 0; c < 2; ++c)
+    {
+        oskar_evaluate_jones_E(E0, num_pts, OSKAR_RELATIVE_DIRECTIONS,
+                l_dev, m_dev, n_dev, tel_dev, gast[1], frequency[c],
+                work0, time_index, &error);
+        oskar_evaluate_jones_E(E1, num_pts, OSKAR_RELATIVE_DIRECTIONS,
+                l_dev, m_dev, n_dev, tel_dev, gast[1], frequency[c],
+                work1, time_index, &error);
+        ASSERT_EQ(0, error) << oskar_get_error_string(error);
+        EXPECT_FALSE(oskar_mem_different(oskar_jones_mem(E0),
+                oskar_jones_mem(E1), 0, &error));
+    }
+
+    // Check weights are not used for a time outside the block.
+    for (int s = 0; s < num_stations; ++s)
+    {
+        EXPECT_TRUE(oskar_station_work_block_weights(work1,
+                oskar_telescope_station_const(tel_dev, s), frequency[0],
+                gast[0], time_index - 1, &error) != 0);
+        EXPECT_TRUE(oskar_station_work_block_weights(work1,
+                oskar_telescope_station_const(tel_dev, s), frequency[0],
+                gast[0], time_index + 2, &error) == 0);
+    }
+
+    oskar_jones_free(E0, &error);
+    oskar_jones_free(E1, &error);
+    oskar_mem_free(l, &error);
+    oskar_mem_free(m, &error);
+    oskar_mem_free(n, &error);
+    oskar_mem_free(l_dev, &error);
+    oskar_mem_free(m_dev, &error);
+    oskar_mem_free(n_dev, &error);
+    oskar_telescope_free(tel, &error);
+    oskar_telescope_free(tel_dev, &error);
+    oskar_station_work_free(work0, &error);
+    oskar_station_work_free(work1, &error);
+    ASSERT_EQ(0, error) << oskar_get_error_string(error);
+}
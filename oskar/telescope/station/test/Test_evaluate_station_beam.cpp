@@ -32,6 +32,7 @@
 #include "telescope/station/oskar_evaluate_station_beam_aperture_array.h"
 #include "telescope/station/oskar_evaluate_station_beam_gaussian.h"
 #include "telescope/station/oskar_evaluate_beam_horizon_direction.h"
+#include "telescope/station/private_station.h"
 #include "utility/oskar_get_error_string.h"
 #include "math/oskar_linspace.h"
 #include "math/oskar_meshgrid.h"
@@ -315,3 +316,143 @@ TEST(evaluate_station_beam, gaussian)
         oskar_mem_free(beam, &error);
     }
 }
+
+
+// Creates a station with 64 child stations of 16 isotropic elements.
+// The children are on a regular lattice unless irregular is set, and all
+// are identical unless differ is set.
+static oskar_Station* two_level_station(bool irregular, bool differ,
+        int* status)
+{
+    const double lat = 50.0 * M_PI / 180.0;
+    oskar_Station* s = oskar_station_create(OSKAR_DOUBLE, OSKAR_CPU, 0,
+            status);
+    oskar_station_resize(s, 64, status);
+    oskar_station_set_position(s, 0.0, lat, 0.0);
+    oskar_station_set_phase_centre(s, OSKAR_SPHERICAL_TYPE_EQUATORIAL,
+            0.3, lat - 0.2);
+    for (int i = 0; i < 64; ++i)
+    {
+        double xyz[] = {5.0 * (i % 8), 5.0 * (i / 8), 0.0};
+        if (irregular)
+        {
+            xyz[0] += 0.7 * sin(1.3 * i);
+            xyz[1] += 0.7 * cos(2.1 * i);
+        }
+        oskar_station_set_element_coords(s, i, xyz, xyz, status);
+    }
+    oskar_station_create_child_stations(s, status);
+    for (int i = 0; i < 64; ++i)
+    {
+        oskar_Station* c = oskar_station_child(s, i);
+        oskar_station_resize(c, 16, status);
+        oskar_station_resize_element_types(c, 1, status);
+        oskar_element_set_element_type(oskar_station_element(c, 0),
+                "Isotropic", status);
+        oskar_station_set_position(c, 0.0, lat, 0.0);
+        oskar_station_set_phase_centre(c, OSKAR_SPHERICAL_TYPE_EQUATORIAL,
+                0.3, lat - 0.2);
+        for (int j = 0; j < 16; ++j)
+        {
+            double xyz[] = {1.2 * (j % 4) + 0.1 * (j / 4), 1.1 * (j / 4),
+                    0.0};
+            if (differ && i == 5 && j == 3) xyz[0] += 0.4;
+            oskar_station_set_element_coords(c, j, xyz, xyz, status);
+        }
+    }
+    int finished_identical_station_check = 0;
+    oskar_station_analyse(s, &finished_identical_station_check, status);
+    return s;
+}
+
+static void two_level_beam(const oskar_Station* s, int num_points,
+        const oskar_Mem* x, const oskar_Mem* y, const oskar_Mem* z,
+        oskar_Mem* beam, int* status)
+{
+    oskar_StationWork* work = oskar_station_work_create(OSKAR_DOUBLE,
+            OSKAR_CPU, status);
+    oskar_evaluate_station_beam_aperture_array(beam, s, num_points,
+            x, y, z, 0.1, 100e6, work, 0, status);
+    oskar_station_work_free(work, status);
+}
+
+static double max_rel_diff(const oskar_Mem* a, const oskar_Mem* b)
+{
+    int status = 0;
+    double max_diff = 0.0, peak = 0.0;
+    const double* p = oskar_mem_double_const(a, &status);
+    const double* q = oskar_mem_double_const(b, &status);
+    for (size_t i = 0; i < 2 * oskar_mem_length(a); ++i)
+    {
+        if (fabs(p[i]) > peak) peak = fabs(p[i]);
+        if (fabs(p[i] - q[i]) > max_diff) max_diff = fabs(p[i] - q[i]);
+    }
+    return max_diff / peak;
+}
+
+TEST(evaluate_station_beam, identical_children)
+{
+    int status = 0;
+
+    // Evaluate the beam at points in the horizon frame.
+    const int size = 41, num_points = size * size;
+    oskar_Mem* x = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_points,
+            &status);
+    oskar_Mem* y = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_points,
+            &status);
+    oskar_Mem* z = oskar_mem_create(OSKAR_DOUBLE, OSKAR_CPU, num_points,
+            &status);
+    double* x_ = oskar_mem_double(x, &status);
+    double* y_ = oskar_mem_double(y, &status);
+    double* z_ = oskar_mem_double(z, &status);
+    for (int i = 0; i < num_points; ++i)
+    {
+        x_[i] = 0.9 * ((i % size) / (size - 1.0) - 0.5) * 2.0 / sqrt(2.0);
+        y_[i] = 0.9 * ((i / size) / (size - 1.0) - 0.5) * 2.0 / sqrt(2.0);
+        z_[i] = sqrt(1.0 - x_[i] * x_[i] - y_[i] * y_[i]);
+    }
+    oskar_Mem* beam[2];
+    for (int i = 0; i < 2; ++i)
+        beam[i] = oskar_mem_create(OSKAR_DOUBLE_COMPLEX, OSKAR_CPU,
+                num_points, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+
+    // With identical children, the factorised beam must match the beam
+    // formed from every child, for both array pattern methods.
+    for (int irregular = 0; irregular < 2; ++irregular)
+    {
+        oskar_Station* s = two_level_station(irregular, false, &status);
+        ASSERT_EQ(0, status) << oskar_get_error_string(status);
+        ASSERT_TRUE(oskar_station_identical_children(s));
+        if (irregular)
+            EXPECT_EQ(0, oskar_station_num_lattice_groups(s));
+        else
+            EXPECT_GT(oskar_station_num_lattice_groups(s), 0);
+        two_level_beam(s, num_points, x, y, z, beam[0], &status);
+        s->identical_children = 0;
+        two_level_beam(s, num_points, x, y, z, beam[1], &status);
+        ASSERT_EQ(0, status) << oskar_get_error_string(status);
+        EXPECT_LT(max_rel_diff(beam[0], beam[1]), 1e-10);
+        oskar_station_free(s, &status);
+    }
+
+    // With different children, the factorised beam is not used.
+    // (Forcing it would use only the first child, and give a different
+    // beam.)
+    oskar_Station* s = two_level_station(true, true, &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    EXPECT_FALSE(oskar_station_identical_children(s));
+    two_level_beam(s, num_points, x, y, z, beam[0], &status);
+    s->identical_children = 1;
+    two_level_beam(s, num_points, x, y, z, beam[1], &status);
+    ASSERT_EQ(0, status) << oskar_get_error_string(status);
+    EXPECT_GT(max_rel_diff(beam[0], beam[1]), 1e-4);
+
+    // Clean up.
+    oskar_station_free(s, &status);
+    oskar_mem_free(x, &status);
+    oskar_mem_free(y, &status);
+    oskar_mem_free(z, &status);
+    oskar_mem_free(beam[0], &status);
+    oskar_mem_free(beam[1], &status);
+}
@@ -157,6 +157,15 @@ class Imager(object):
         self.capsule_ensure()
         return _imager_lib.channel_snapshots(self._capsule)
 
+    def get_coords_index(self):
+        """Returns flag specifying whether to use coordinate index files.
+
+        Returns:
+            boolean: If true, use coordinate index files.
+        """
+        self.capsule_ensure()
+        return _imager_lib.coords_index(self._capsule)
+
     def get_coords_only(self):
         """Returns flag specifying whether imager is in coordinate-only mode.
 
@@ -211,6 +220,24 @@ class Imager(object):
         self.capsule_ensure()
         return _imager_lib.generate_w_kernels_on_gpu(self._capsule)
 
+    def get_grid_half_plane(self):
+        """Returns flag specifying whether to grid only half the UV plane.
+
+        Returns:
+            boolean: If true, grid only half of the UV plane.
+        """
+        self.capsule_ensure()
+        return _imager_lib.grid_half_plane(self._capsule)
+
+    def get_grid_kernel_accuracy(self):
+        """Returns the accuracy used to choose the gridding kernel support.
+
+        Returns:
+            float: Required accuracy, or 0 if not set.
+        """
+        self.capsule_ensure()
+        return _imager_lib.grid_kernel_accuracy(self._capsule)
+
     def get_image_size(self):
         """Returns the image side length, in pixels.
 
@@ -238,6 +265,15 @@ class Imager(object):
         self.capsule_ensure()
         return _imager_lib.input_file(self._capsule)
 
+    def get_memory_budget_gb(self):
+        """Returns the memory budget for the imager, in GB.
+
+        Returns:
+            float: The memory budget in GB, or 0 if not set.
+        """
+        self.capsule_ensure()
+        return _imager_lib.memory_budget_gb(self._capsule)
+
     def get_ms_column(self):
         """Returns a string containing the Measurement Set column to use.
 
@@ -277,6 +313,15 @@ class Imager(object):
         self.capsule_ensure()
         return _imager_lib.plane_size(self._capsule)
 
+    def get_robustness(self):
+        """Returns the robustness parameter used for Briggs weighting.
+
+        Returns:
+            float: The robustness parameter.
+        """
+        self.capsule_ensure()
+        return _imager_lib.robustness(self._capsule)
+
     def get_scale_norm_with_num_input_files(self):
         """Returns the option to scale image normalisation by the number of
         input files.
@@ -314,6 +359,17 @@ class Imager(object):
         self.capsule_ensure()
         return _imager_lib.time_min_utc(self._capsule)
 
+    def get_time_snapshot_interval_sec(self):
+        """Returns the interval used to make time snapshots, in seconds.
+
+        A value less than or equal to zero means no time snapshots.
+
+        Returns:
+            float: The length of each time snapshot, in seconds.
+        """
+        self.capsule_ensure()
+        return _imager_lib.time_snapshot_interval_sec(self._capsule)
+
     def get_uv_filter_max(self):
         """Returns the maximum UV baseline length to image, in wavelengths.
 
@@ -332,6 +388,15 @@ class Imager(object):
         self.capsule_ensure()
         return _imager_lib.uv_filter_min(self._capsule)
 
+    def get_w_kernel_cache_dir(self):
+        """Returns the directory used to cache W-projection kernels.
+
+        Returns:
+            str: Path to the W-kernel cache directory, or an empty string.
+        """
+        self.capsule_ensure()
+        return _imager_lib.w_kernel_cache_dir(self._capsule)
+
     def get_weighting(self):
         """Returns a string describing the weighting scheme.
 
@@ -441,7 +506,9 @@ class Imager(object):
             return _imager_lib.run(self._capsule, return_images, return_grids)
         else:
             self.reset_cache()
-            if self.weighting == 'Uniform' or self.algorithm == 'W-projection':
+            if self.weighting in ('Uniform', 'Briggs') or \
+                    self.algorithm in ('W-projection', 'W-stacking',
+                                       'NUFFT 3D'):
                 self.set_coords_only(True)
                 self.update(uu, vv, ww, amps, weight, time_centroid,
                             start_channel, end_channel, num_pols)
@@ -462,8 +529,9 @@ class Imager(object):
         """Sets the algorithm used by the imager.
 
         Args:
-            algorithm_type (str): Either 'FFT', 'DFT 2D', 'DFT 3D' or
-                'W-projection'.
+            algorithm_type (str): Either 'FFT', 'DFT 2D', 'DFT 3D',
+                'W-projection', 'W-stacking', 'IDG', 'NUFFT 2D'
+                or 'NUFFT 3D'.
         """
         self.capsule_ensure()
         _imager_lib.set_algorithm(self._capsule, algorithm_type)
@@ -491,6 +559,19 @@ class Imager(object):
         self.capsule_ensure()
         _imager_lib.set_channel_snapshots(self._capsule, value)
 
+    def set_coords_index(self, value):
+        """Sets whether to use coordinate index files for Measurement Sets.
+
+        If true, baseline coordinates read from a Measurement Set in the
+        coordinate-only pass are saved to an index file with the suffix
+        ".coords", which is read instead of the Measurement Set next time.
+
+        Args:
+            value (boolean): If true, use coordinate index files.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_coords_index(self._capsule, value)
+
     def set_coords_only(self, flag):
         """Sets the imager to ignore visibility data and use coordinates only.
 
@@ -578,12 +659,27 @@ class Imager(object):
         self.capsule_ensure()
         _imager_lib.set_generate_w_kernels_on_gpu(self._capsule, value)
 
+    def set_grid_half_plane(self, value):
+        """Sets whether to grid only half of the UV plane.
+
+        If set, the Hermitian symmetry of the visibilities is used to grid
+        them into one half of the UV plane, and only the real part of the
+        FFT is computed. The images are the same, but the image planes
+        need about half the memory, and the FFT does about half the work.
+
+        Args:
+            value (boolean): If true, grid only half of the UV plane.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_grid_half_plane(self._capsule, value)
+
     def set_grid_kernel(self, kernel_type, support, oversample):
         """Sets the convolution kernel used for gridding visibilities.
 
         Args:
             kernel_type (str): Type of convolution kernel;
-                either 'Spheroidal' or 'Pillbox'.
+                either 'Spheroidal', 'Pillbox' or 'ES'
+                (exponential of semicircle).
             support (int): Support size of kernel.
                 The kernel width is 2 * support + 1.
             oversample (int): Oversample factor used for look-up table.
@@ -592,6 +688,19 @@ class Imager(object):
         _imager_lib.set_grid_kernel(self._capsule, kernel_type,
                                     support, oversample)
 
+    def set_grid_kernel_accuracy(self, value):
+        """Sets the accuracy used to choose the gridding kernel support size.
+
+        If greater than zero, the support size of the exponential of
+        semicircle kernel is chosen to give this accuracy relative to the
+        peak, instead of using the support size given to set_grid_kernel().
+
+        Args:
+            value (float): Required accuracy (for example, 1e-5), or 0.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_grid_kernel_accuracy(self._capsule, value)
+
     def set_image_size(self, size):
         """Sets image side length.
 
@@ -621,6 +730,20 @@ class Imager(object):
         self.capsule_ensure()
         _imager_lib.set_input_file(self._capsule, filename)
 
+    def set_memory_budget_gb(self, value):
+        """Sets the memory budget for the imager, in GB.
+
+        If greater than zero, run() makes the image channels in batches,
+        so that the image planes of each batch, together with the scratch
+        arrays, W-kernels and input buffers, fit within this amount of
+        memory, reading the input data once for each batch.
+
+        Args:
+            value (float): Memory budget in GB, or 0 for no limit.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_memory_budget_gb(self._capsule, value)
+
     def set_ms_column(self, column):
         """Sets the data column to use from a Measurement Set.
 
@@ -650,6 +773,18 @@ class Imager(object):
         self.capsule_ensure()
         _imager_lib.set_output_root(self._capsule, filename)
 
+    def set_robustness(self, value):
+        """Sets the robustness parameter used for Briggs weighting.
+
+        Values range from about -2 (close to uniform weighting)
+        to +2 (close to natural weighting).
+
+        Args:
+            value (float): The robustness parameter.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_robustness(self._capsule, value)
+
     def set_scale_norm_with_num_input_files(self, value):
         """Sets the option to scale image normalisation with number of files.
 
@@ -695,6 +830,22 @@ class Imager(object):
         self.capsule_ensure()
         _imager_lib.set_time_min_utc(self._capsule, value)
 
+    def set_time_snapshot_interval_sec(self, value):
+        """Sets the interval used to make time snapshots, in seconds.
+
+        If greater than zero, visibilities are binned into intervals of this
+        length and each interval is imaged separately, using a single pass
+        through the data. The snapshots are written along the fourth axis
+        of the FITS image cube.
+        If using update(), the time range must be set using set_vis_time(),
+        and time centroids must be supplied.
+
+        Args:
+            value (float): The length of each time snapshot, in seconds.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_time_snapshot_interval_sec(self._capsule, value)
+
     def set_uv_filter_max(self, max_wavelength):
         """Sets the maximum UV baseline length to image, in wavelengths.
 
@@ -741,11 +892,42 @@ class Imager(object):
         self.capsule_ensure()
         _imager_lib.set_vis_phase_centre(self._capsule, ra_deg, dec_deg)
 
+    def set_vis_time(self, ref_mjd_utc, inc_sec=0.0, num_times=1):
+        """Sets the visibility start time.
+
+        This is required only if making time snapshots.
+
+        Args:
+            ref_mjd_utc (float):
+                Start time of the visibility data, as MJD(UTC).
+            inc_sec (Optional[float]):
+                Time increment, in seconds. Default 0.0.
+            num_times (Optional[int]):
+                Number of time samples in visibility data. Default 1.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_vis_time(self._capsule,
+                                 ref_mjd_utc, inc_sec, num_times)
+
+    def set_w_kernel_cache_dir(self, path):
+        """Sets the directory used to cache W-projection kernels.
+
+        If set, W-kernels are saved to this directory after they have been
+        generated, and are loaded from it on later runs with the same
+        kernel parameters. An empty string disables the cache.
+
+        Args:
+            path (str): Path to an existing directory.
+        """
+        self.capsule_ensure()
+        _imager_lib.set_w_kernel_cache_dir(self._capsule, path)
+
     def set_weighting(self, weighting):
         """Sets the type of visibility weighting to use.
 
         Args:
-            weighting (str): Either 'Natural', 'Radial' or 'Uniform'.
+            weighting (str): Either 'Natural', 'Radial', 'Uniform'
+                or 'Briggs'.
         """
         self.capsule_ensure()
         _imager_lib.set_weighting(self._capsule, weighting)
@@ -869,6 +1051,7 @@ class Imager(object):
     cell_size_arcsec = property(get_cellsize, set_cellsize)
     channel_snapshots = property(get_channel_snapshots,
                                  set_channel_snapshots)
+    coords_index = property(get_coords_index, set_coords_index)
     coords_only = property(get_coords_only, set_coords_only)
     fft_on_gpu = property(get_fft_on_gpu, set_fft_on_gpu)
     fov = property(get_fov, set_fov)
@@ -877,24 +1060,33 @@ class Imager(object):
     freq_min_hz = property(get_freq_min_hz, set_freq_min_hz)
     generate_w_kernels_on_gpu = property(get_generate_w_kernels_on_gpu,
                                          set_generate_w_kernels_on_gpu)
+    grid_half_plane = property(get_grid_half_plane, set_grid_half_plane)
+    grid_kernel_accuracy = property(get_grid_kernel_accuracy,
+                                    set_grid_kernel_accuracy)
     image_size = property(get_image_size, set_image_size)
     image_type = property(get_image_type, set_image_type)
     input_file = property(get_input_file, set_input_file)
     input_files = property(get_input_file, set_input_file)
     input_vis_data = property(get_input_file, set_input_file)
+    memory_budget_gb = property(get_memory_budget_gb, set_memory_budget_gb)
     ms_column = property(get_ms_column, set_ms_column)
     num_w_planes = property(get_num_w_planes, set_num_w_planes)
     output_root = property(get_output_root, set_output_root)
     plane_size = property(get_plane_size)
     root_path = property(get_output_root, set_output_root)
+    robustness = property(get_robustness, set_robustness)
     scale_norm_with_num_input_files = \
         property(get_scale_norm_with_num_input_files,
                  set_scale_norm_with_num_input_files)
     size = property(get_size, set_size)
     time_max_utc = property(get_time_max_utc, set_time_max_utc)
     time_min_utc = property(get_time_min_utc, set_time_min_utc)
+    time_snapshot_interval_sec = property(get_time_snapshot_interval_sec,
+                                          set_time_snapshot_interval_sec)
     uv_filter_max = property(get_uv_filter_max, set_uv_filter_max)
     uv_filter_min = property(get_uv_filter_min, set_uv_filter_min)
+    w_kernel_cache_dir = property(get_w_kernel_cache_dir,
+                                  set_w_kernel_cache_dir)
     weighting = property(get_weighting, set_weighting)
     wprojplanes = property(get_num_w_planes, set_num_w_planes)
 
@@ -1053,7 +1245,8 @@ class Imager(object):
 
     @staticmethod
     def make_image(uu, vv, ww, amps, fov_deg, size, weighting='Natural',
-                   algorithm='FFT', weight=None, wprojplanes=0):
+                   algorithm='FFT', weight=None, wprojplanes=0,
+                   robustness=0.0):
         """Makes an image from visibility data.
 
         Args:
@@ -1068,15 +1261,18 @@ class Imager(object):
             fov_deg (float): Image field of view, in degrees.
             size (int):      Image size along one dimension, in pixels.
             weighting (Optional[str]):
-                Either 'Natural', 'Radial' or 'Uniform'.
+                Either 'Natural', 'Radial', 'Uniform' or 'Briggs'.
             algorithm (Optional[str]):
-                Algorithm type: 'FFT', 'DFT 2D', 'DFT 3D' or 'W-projection'.
+                Algorithm type: 'FFT', 'DFT 2D', 'DFT 3D', 'W-projection',
+                'W-stacking', 'IDG', 'NUFFT 2D' or 'NUFFT 3D'.
             weight (Optional[float, array-like, shape (n,)]):
                 Visibility weights.
             wprojplanes (Optional[int]):
                 Number of W-projection planes to use, if using W-projection.
                 If <= 0, this will be determined automatically.
                 It will not be less than 16.
+            robustness (Optional[float]):
+                Robustness parameter, if using Briggs weighting.
 
         Returns:
             array: Image as a 2D numpy array.
@@ -1086,4 +1282,4 @@ class Imager(object):
             raise RuntimeError("OSKAR library not found.")
         return _imager_lib.make_image(uu, vv, ww, amps, fov_deg, size,
                                       weighting, algorithm, weight,
-                                      wprojplanes)
+                                      wprojplanes, robustness)
@@ -29,6 +29,7 @@
 #include <Python.h>
 
 #include <oskar.h>
+#include <imager/oskar_grid_weights.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -160,6 +161,18 @@ static PyObject* check_init(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* coords_index(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    int flag;
+    if (!PyArg_ParseTuple(args, "O", &capsule)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    flag = oskar_imager_coords_index(h);
+    return Py_BuildValue("O", flag ? Py_True : Py_False);
+}
+
+
 static PyObject* coords_only(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -395,6 +408,27 @@ static PyObject* generate_w_kernels_on_gpu(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* grid_half_plane(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    if (!PyArg_ParseTuple(args, "O", &capsule)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    return Py_BuildValue("O",
+            oskar_imager_grid_half_plane(h) ? Py_True : Py_False);
+}
+
+
+static PyObject* grid_kernel_accuracy(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    if (!PyArg_ParseTuple(args, "O", &capsule)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    return Py_BuildValue("d", oskar_imager_grid_kernel_accuracy(h));
+}
+
+
 static PyObject* image_size(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -438,6 +472,16 @@ static PyObject* input_file(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* memory_budget_gb(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    if (!PyArg_ParseTuple(args, "O", &capsule)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    return Py_BuildValue("d", oskar_imager_memory_budget_gb(h));
+}
+
+
 static PyObject* ms_column(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -499,6 +543,16 @@ static PyObject* reset_cache(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* robustness(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    if (!PyArg_ParseTuple(args, "O", &capsule)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    return Py_BuildValue("d", oskar_imager_robustness(h));
+}
+
+
 static PyObject* rotate_coords(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -768,6 +822,18 @@ static PyObject* set_channel_snapshots(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* set_coords_index(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    int value = 0;
+    if (!PyArg_ParseTuple(args, "Oi", &capsule, &value)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_coords_index(h, value);
+    return Py_BuildValue("");
+}
+
+
 static PyObject* set_coords_only(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -863,6 +929,18 @@ static PyObject* set_generate_w_kernels_on_gpu(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* set_grid_half_plane(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    int value = 0;
+    if (!PyArg_ParseTuple(args, "Oi", &capsule, &value)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_grid_half_plane(h, value);
+    return Py_BuildValue("");
+}
+
+
 static PyObject* set_grid_kernel(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -886,6 +964,18 @@ static PyObject* set_grid_kernel(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* set_grid_kernel_accuracy(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    double value = 0.0;
+    if (!PyArg_ParseTuple(args, "Od", &capsule, &value)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_grid_kernel_accuracy(h, value);
+    return Py_BuildValue("");
+}
+
+
 static PyObject* set_image_size(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -979,6 +1069,18 @@ static PyObject* set_input_file(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* set_memory_budget_gb(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    double value = 0.0;
+    if (!PyArg_ParseTuple(args, "Od", &capsule, &value)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_memory_budget_gb(h, value);
+    return Py_BuildValue("");
+}
+
+
 static PyObject* set_ms_column(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -1016,6 +1118,18 @@ static PyObject* set_output_root(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* set_robustness(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    double value = 0.0;
+    if (!PyArg_ParseTuple(args, "Od", &capsule, &value)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_robustness(h, value);
+    return Py_BuildValue("");
+}
+
+
 static PyObject* set_scale_norm_with_num_input_files(PyObject* self,
         PyObject* args)
 {
@@ -1074,6 +1188,19 @@ static PyObject* set_time_min_utc(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* set_time_snapshot_interval_sec(PyObject* self,
+        PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    double value = 0.0;
+    if (!PyArg_ParseTuple(args, "Od", &capsule, &value)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_time_snapshot_interval_sec(h, value);
+    return Py_BuildValue("");
+}
+
+
 static PyObject* set_uv_filter_max(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -1123,6 +1250,31 @@ static PyObject* set_vis_phase_centre(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* set_vis_time(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    int num = 0;
+    double ref = 0.0, inc = 0.0;
+    if (!PyArg_ParseTuple(args, "Oddi", &capsule, &ref, &inc, &num)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_vis_time(h, ref, inc, num);
+    return Py_BuildValue("");
+}
+
+
+static PyObject* set_w_kernel_cache_dir(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    const char* dir = 0;
+    if (!PyArg_ParseTuple(args, "Os", &capsule, &dir)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    oskar_imager_set_w_kernel_cache_dir(h, dir);
+    return Py_BuildValue("");
+}
+
+
 static PyObject* set_weighting(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -1175,6 +1327,16 @@ static PyObject* time_min_utc(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* time_snapshot_interval_sec(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    if (!PyArg_ParseTuple(args, "O", &capsule)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    return Py_BuildValue("d", oskar_imager_time_snapshot_interval_sec(h));
+}
+
+
 static PyObject* update(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -1549,6 +1711,18 @@ static PyObject* uv_filter_min(PyObject* self, PyObject* args)
 }
 
 
+static PyObject* w_kernel_cache_dir(PyObject* self, PyObject* args)
+{
+    oskar_Imager* h = 0;
+    PyObject* capsule = 0;
+    const char* dir = 0;
+    if (!PyArg_ParseTuple(args, "O", &capsule)) return 0;
+    if (!(h = (oskar_Imager*) get_handle(capsule, name))) return 0;
+    dir = oskar_imager_w_kernel_cache_dir(h);
+    return Py_BuildValue("s", dir ? dir : "");
+}
+
+
 static PyObject* weighting(PyObject* self, PyObject* args)
 {
     oskar_Imager* h = 0;
@@ -1567,16 +1741,17 @@ static PyObject* make_image(PyObject* self, PyObject* args)
     size_t num_cells, num_pixels, num_vis;
     int plane_size = 0, size = 0;
     int dft = 0, status = 0, type = 0, wproj = 0, uniform = 0, wprojplanes = -1;
-    double fov_deg = 0.0, norm = 0.0;
+    double fov_deg = 0.0, norm = 0.0, robustness = 0.0;
     const char *weighting_type = 0, *algorithm_type = 0;
     oskar_Mem *uu_c, *vv_c, *ww_c, *amp_c, *weight_c, *plane;
     oskar_Mem *weights_grid = 0;
     npy_intp dims[2];
 
     /* Parse inputs. */
-    if (!PyArg_ParseTuple(args, "OOOOdissOi",
+    if (!PyArg_ParseTuple(args, "OOOOdissOid",
             &obj[0], &obj[1], &obj[2], &obj[3], &fov_deg, &size,
-            &weighting_type, &algorithm_type, &obj[4], &wprojplanes))
+            &weighting_type, &algorithm_type, &obj[4], &wprojplanes,
+            &robustness))
         return 0;
 
     /* Make sure input objects are arrays. Convert if required. */
@@ -1645,16 +1820,21 @@ static PyObject* make_image(PyObject* self, PyObject* args)
     oskar_imager_set_algorithm(h, algorithm_type, &status);
     oskar_imager_set_num_w_planes(h, wprojplanes);
     oskar_imager_set_weighting(h, weighting_type, &status);
+    oskar_imager_set_robustness(h, robustness);
 
-    /* Check for DFT, W-projection or uniform weighting. */
+    /* Check for DFT, W-projection, 3D NUFFT, uniform or Briggs weighting. */
     if (!strncmp(algorithm_type, "DFT", 3) ||
             !strncmp(algorithm_type, "dft", 3))
         dft = 1;
     if (!strncmp(algorithm_type, "W", 1) ||
-            !strncmp(algorithm_type, "w", 1))
+            !strncmp(algorithm_type, "w", 1) ||
+            !strncmp(algorithm_type, "NUFFT 3", 7) ||
+            !strncmp(algorithm_type, "nufft 3", 7))
         wproj = 1;
     if (!strncmp(weighting_type, "U", 1) ||
-            !strncmp(weighting_type, "u", 1))
+            !strncmp(weighting_type, "u", 1) ||
+            !strncmp(weighting_type, "B", 1) ||
+            !strncmp(weighting_type, "b", 1))
         uniform = 1;
 
     /* Get the plane size. */
@@ -1669,6 +1849,18 @@ static PyObject* make_image(PyObject* self, PyObject* args)
         oskar_imager_update_plane(h, num_vis, uu_c, vv_c, ww_c, 0, weight_c,
                 0, 0, weights_grid, &status);
         oskar_imager_set_coords_only(h, 0);
+
+        /* Convert the completed grid if using Briggs weighting. */
+        if (!strncmp(weighting_type, "B", 1) ||
+                !strncmp(weighting_type, "b", 1))
+        {
+            if (type == OSKAR_DOUBLE)
+                oskar_grid_weights_briggs_d(plane_size, robustness,
+                        oskar_mem_double(weights_grid, &status), &status);
+            else
+                oskar_grid_weights_briggs_f(plane_size, robustness,
+                        oskar_mem_float(weights_grid, &status), &status);
+        }
     }
 
     /* Initialise the algorithm. */
@@ -1741,6 +1933,8 @@ static PyMethodDef methods[] =
         {"channel_snapshots", (PyCFunction)channel_snapshots,
                 METH_VARARGS, "channel_snapshots()"},
         {"check_init", (PyCFunction)check_init, METH_VARARGS, "check_init()"},
+        {"coords_index", (PyCFunction)coords_index,
+                METH_VARARGS, "coords_index()"},
         {"coords_only", (PyCFunction)coords_only,
                 METH_VARARGS, "coords_only()"},
         {"create", (PyCFunction)create, METH_VARARGS, "create(type)"},
@@ -1756,9 +1950,15 @@ static PyMethodDef methods[] =
                 METH_VARARGS, "freq_min_hz()"},
         {"generate_w_kernels_on_gpu", (PyCFunction)generate_w_kernels_on_gpu,
                 METH_VARARGS, "generate_w_kernels_on_gpu()"},
+        {"grid_half_plane", (PyCFunction)grid_half_plane,
+                METH_VARARGS, "grid_half_plane()"},
+        {"grid_kernel_accuracy", (PyCFunction)grid_kernel_accuracy,
+                METH_VARARGS, "grid_kernel_accuracy()"},
         {"image_size", (PyCFunction)image_size, METH_VARARGS, "image_size()"},
         {"image_type", (PyCFunction)image_type, METH_VARARGS, "image_type()"},
         {"input_file", (PyCFunction)input_file, METH_VARARGS, "input_file()"},
+        {"memory_budget_gb", (PyCFunction)memory_budget_gb,
+                METH_VARARGS, "memory_budget_gb()"},
         {"ms_column", (PyCFunction)ms_column, METH_VARARGS, "ms_column()"},
         {"make_image", (PyCFunction)make_image, METH_VARARGS,
                 "make_image(uu, vv, ww, amp, weight, fov_deg, size)"},
@@ -1769,6 +1969,8 @@ static PyMethodDef methods[] =
         {"plane_size", (PyCFunction)plane_size, METH_VARARGS, "plane_size()"},
         {"reset_cache", (PyCFunction)reset_cache,
                 METH_VARARGS, "reset_cache()"},
+        {"robustness", (PyCFunction)robustness,
+                METH_VARARGS, "robustness()"},
         {"rotate_coords", (PyCFunction)rotate_coords,
                 METH_VARARGS, "rotate_coords(uu, vv, ww)"},
         {"rotate_vis", (PyCFunction)rotate_vis,
@@ -1784,6 +1986,8 @@ static PyMethodDef methods[] =
                 METH_VARARGS, "set_cellsize(value)"},
         {"set_channel_snapshots", (PyCFunction)set_channel_snapshots,
                 METH_VARARGS, "set_channel_snapshots(value)"},
+        {"set_coords_index", (PyCFunction)set_coords_index,
+                METH_VARARGS, "set_coords_index(value)"},
         {"set_coords_only", (PyCFunction)set_coords_only,
                 METH_VARARGS, "set_coords_only(flag)"},
         {"set_default_direction", (PyCFunction)set_default_direction,
@@ -1800,20 +2004,28 @@ static PyMethodDef methods[] =
         {"set_generate_w_kernels_on_gpu",
                 (PyCFunction)set_generate_w_kernels_on_gpu,
                 METH_VARARGS, "set_generate_w_kernels_on_gpu(value)"},
+        {"set_grid_half_plane", (PyCFunction)set_grid_half_plane,
+                METH_VARARGS, "set_grid_half_plane(value)"},
         {"set_grid_kernel", (PyCFunction)set_grid_kernel,
                 METH_VARARGS, "set_grid_kernel(type, support, oversample)"},
+        {"set_grid_kernel_accuracy", (PyCFunction)set_grid_kernel_accuracy,
+                METH_VARARGS, "set_grid_kernel_accuracy(value)"},
         {"set_image_size", (PyCFunction)set_image_size,
                 METH_VARARGS, "set_image_size(value)"},
         {"set_image_type", (PyCFunction)set_image_type,
                 METH_VARARGS, "set_image_type(type)"},
         {"set_input_file", (PyCFunction)set_input_file,
                 METH_VARARGS, "set_input_file(filename)"},
+        {"set_memory_budget_gb", (PyCFunction)set_memory_budget_gb,
+                METH_VARARGS, "set_memory_budget_gb(value)"},
         {"set_ms_column", (PyCFunction)set_ms_column,
                 METH_VARARGS, "set_ms_column(column)"},
         {"set_num_w_planes", (PyCFunction)set_num_w_planes,
                 METH_VARARGS, "set_num_w_planes(value)"},
         {"set_output_root", (PyCFunction)set_output_root,
                 METH_VARARGS, "set_output_root(filename)"},
+        {"set_robustness", (PyCFunction)set_robustness,
+                METH_VARARGS, "set_robustness(value)"},
         {"set_scale_norm_with_num_input_files",
                 (PyCFunction)set_scale_norm_with_num_input_files,
                 METH_VARARGS, "set_scale_norm_with_num_input_files(value)"},
@@ -1822,6 +2034,9 @@ static PyMethodDef methods[] =
                 METH_VARARGS, "set_time_max_utc(value)"},
         {"set_time_min_utc", (PyCFunction)set_time_min_utc,
                 METH_VARARGS, "set_time_min_utc(value)"},
+        {"set_time_snapshot_interval_sec",
+                (PyCFunction)set_time_snapshot_interval_sec,
+                METH_VARARGS, "set_time_snapshot_interval_sec(value)"},
         {"set_uv_filter_max", (PyCFunction)set_uv_filter_max,
                 METH_VARARGS, "set_uv_filter_max(max_wavelengths)"},
         {"set_uv_filter_min", (PyCFunction)set_uv_filter_min,
@@ -1830,6 +2045,10 @@ static PyMethodDef methods[] =
                 "set_vis_frequency(ref_hz, inc_hz, num_channels)"},
         {"set_vis_phase_centre", (PyCFunction)set_vis_phase_centre,
                 METH_VARARGS, "set_vis_phase_centre(ra_deg, dec_deg)"},
+        {"set_vis_time", (PyCFunction)set_vis_time, METH_VARARGS,
+                "set_vis_time(ref_mjd_utc, inc_sec, num_times)"},
+        {"set_w_kernel_cache_dir", (PyCFunction)set_w_kernel_cache_dir,
+                METH_VARARGS, "set_w_kernel_cache_dir(dir)"},
         {"set_weighting", (PyCFunction)set_weighting,
                 METH_VARARGS, "set_weighting(type)"},
         {"size", (PyCFunction)size, METH_VARARGS, "size()"},
@@ -1837,6 +2056,9 @@ static PyMethodDef methods[] =
                 METH_VARARGS, "time_max_utc()"},
         {"time_min_utc", (PyCFunction)time_min_utc,
                 METH_VARARGS, "time_min_utc()"},
+        {"time_snapshot_interval_sec",
+                (PyCFunction)time_snapshot_interval_sec,
+                METH_VARARGS, "time_snapshot_interval_sec()"},
         {"update", (PyCFunction)update, METH_VARARGS,
                 "update(uu, vv, ww, amps, weight, time_centroid, "
                 "start_chan, end_chan, num_pols)"},
@@ -1848,6 +2070,8 @@ static PyMethodDef methods[] =
                 METH_VARARGS, "uv_filter_max()"},
         {"uv_filter_min", (PyCFunction)uv_filter_min,
                 METH_VARARGS, "uv_filter_min()"},
+        {"w_kernel_cache_dir", (PyCFunction)w_kernel_cache_dir,
+                METH_VARARGS, "w_kernel_cache_dir()"},
         {"weighting", (PyCFunction)weighting, METH_VARARGS, "weighting()"},
         {NULL, NULL, 0, NULL}
 };